@@ -39,13 +39,157 @@
 #include <ctype.h>
 #include <stdlib.h> /* strtod (C89), strtof (C99) */
 #include <string.h> /* strcasecmp (4.4BSD - compatibility), _stricmp (_WIN32) */
+#include <stdint.h>
+#include <float.h> /* FLT_EVAL_METHOD */
+#if defined(_MSC_VER)
+#include <intrin.h> /* _BitScanForward, _BitScanReverse64, _umul128 */
+#endif
 
 #ifndef SPINE_JSON_DEBUG
 /* Define this to do extra NULL and expected-character checking */
 #define SPINE_JSON_DEBUG 0
 #endif
 
-static const char* ep;
+#ifndef SPINE_JSON_SIMD
+/* Define this to 0 to scan whitespace and strings a byte at a time. */
+#define SPINE_JSON_SIMD 1
+#endif
+
+#if SPINE_JSON_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 32
+#elif SPINE_JSON_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+#else
+#define SIMD_WIDTH 0
+#endif
+
+#if SIMD_WIDTH
+#if defined(_MSC_VER)
+static unsigned simd_ctz (unsigned mask) {
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+}
+#else
+#define simd_ctz(mask) ((unsigned)__builtin_ctz(mask))
+#endif
+
+/* The kernels only do aligned loads. An aligned block never straddles a page, so reading the whole block that holds
+ * the terminating NUL can't fault even though it reads past the end of the input. Bytes before the start are masked off. */
+#define SIMD_BLOCK(ptr) ((const char*)((size_t)(ptr) & ~(size_t)(SIMD_WIDTH - 1)))
+
+#if SIMD_WIDTH == 32
+#define simd_vec __m256i
+#define simd_load(ptr) _mm256_load_si256((const __m256i*)(ptr))
+#define simd_set1(c) _mm256_set1_epi8(c)
+#define simd_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define simd_or(a, b) _mm256_or_si256(a, b)
+#define simd_min(a, b) _mm256_min_epu8(a, b)
+#define simd_andnot(a, b) _mm256_andnot_si256(a, b)
+#define simd_mask(v) ((unsigned)_mm256_movemask_epi8(v))
+#define SIMD_ALL 0xFFFFFFFFu
+#else
+#define simd_vec __m128i
+#define simd_load(ptr) _mm_load_si128((const __m128i*)(ptr))
+#define simd_set1(c) _mm_set1_epi8(c)
+#define simd_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define simd_or(a, b) _mm_or_si128(a, b)
+#define simd_min(a, b) _mm_min_epu8(a, b)
+#define simd_andnot(a, b) _mm_andnot_si128(a, b)
+#define simd_mask(v) ((unsigned)_mm_movemask_epi8(v))
+#define SIMD_ALL 0xFFFFu
+#endif
+
+/* Returns the first byte that isn't whitespace, which includes the terminating NUL, or end if that comes first. Only
+ * blocks holding bytes before end are read, so end needn't be followed by a NUL. 0 for no end. */
+static const char* simd_skip (const char* in, const char* end) {
+	const simd_vec space = simd_set1(32), zero = simd_set1(0);
+	const char* block = SIMD_BLOCK(in);
+	unsigned mask;
+	simd_vec v = simd_load(block);
+	/* min(v, 32) == v holds for bytes up to 32, the NUL is then taken back out. */
+	mask = ~simd_mask(simd_andnot(simd_eq(v, zero), simd_eq(simd_min(v, space), v))) & SIMD_ALL;
+	mask &= SIMD_ALL << (in - block);
+	while (!mask) {
+		block += SIMD_WIDTH;
+		if (end && block >= end) return end;
+		v = simd_load(block);
+		mask = ~simd_mask(simd_andnot(simd_eq(v, zero), simd_eq(simd_min(v, space), v))) & SIMD_ALL;
+	}
+	in = block + simd_ctz(mask);
+	return end && in > end ? end : in;
+}
+
+/* Returns the first '\"', '\\' or NUL, or end if that comes first, reading as simd_skip does. */
+static const char* simd_scan_string (const char* in, const char* end) {
+	const simd_vec quote = simd_set1('\"'), backslash = simd_set1('\\'), zero = simd_set1(0);
+	const char* block = SIMD_BLOCK(in);
+	unsigned mask;
+	simd_vec v = simd_load(block);
+	mask = simd_mask(simd_or(simd_or(simd_eq(v, quote), simd_eq(v, backslash)), simd_eq(v, zero)));
+	mask &= SIMD_ALL << (in - block);
+	while (!mask) {
+		block += SIMD_WIDTH;
+		if (end && block >= end) return end;
+		v = simd_load(block);
+		mask = simd_mask(simd_or(simd_or(simd_eq(v, quote), simd_eq(v, backslash)), simd_eq(v, zero)));
+	}
+	in = block + simd_ctz(mask);
+	return end && in > end ? end : in;
+}
+
+/* Returns the first '\"', bracket or NUL. Or-ing 0x20 takes '[' and ']' to '{' and '}', and nothing else to them. */
+static const char* simd_scan_structure (const char* in) {
+	const simd_vec quote = simd_set1('\"'), open = simd_set1('{'), close = simd_set1('}'), zero = simd_set1(0);
+	const simd_vec fold = simd_set1(0x20);
+	const char* block = SIMD_BLOCK(in);
+	unsigned mask;
+	simd_vec v = simd_load(block), folded = simd_or(v, fold);
+	mask = simd_mask(simd_or(simd_or(simd_eq(v, quote), simd_eq(v, zero)),
+		simd_or(simd_eq(folded, open), simd_eq(folded, close))));
+	mask &= SIMD_ALL << (in - block);
+	while (!mask) {
+		block += SIMD_WIDTH;
+		v = simd_load(block);
+		folded = simd_or(v, fold);
+		mask = simd_mask(simd_or(simd_or(simd_eq(v, quote), simd_eq(v, zero)),
+			simd_or(simd_eq(folded, open), simd_eq(folded, close))));
+	}
+	return block + simd_ctz(mask);
+}
+#endif
+
+/* Returns the first '\"', '\\' or NUL at or after in, or end if that comes first. 0 for no end. */
+static const char* scan_string_until (const char* in, const char* end) {
+#if SIMD_WIDTH
+	/* Keys and names are mostly short, only vectorize once a string has proven long. */
+	int n;
+	for (n = 0; n < 8; ++n, ++in)
+		if (in == end || *in == '\"' || *in == '\\' || !*in) return in;
+	return simd_scan_string(in, end);
+#else
+	while (in != end && *in != '\"' && *in != '\\' && *in)
+		in++;
+	return in;
+#endif
+}
+
+static const char* scan_string (const char* in) {
+	return scan_string_until(in, 0);
+}
+
+/* Each thread has its own error position, so threads can parse at the same time. */
+#if defined(_MSC_VER)
+#define JSON_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define JSON_THREAD_LOCAL __thread
+#else
+#define JSON_THREAD_LOCAL _Thread_local
+#endif
+
+static JSON_THREAD_LOCAL const char* ep;
 
 const char* Json_getError (void) {
 	return ep;
@@ -71,51 +215,624 @@ static int Json_strcasecmp (const char* s1, const char* s2) {
 	}
 }
 
+#ifndef SPINE_JSON_ARENA_BLOCK_SIZE
+#define SPINE_JSON_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+/* Every allocation is rounded up to this, which suits both Json nodes and strings. */
+#define ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+typedef struct Json_ArenaBlock {
+	struct Json_ArenaBlock* next;
+	size_t size; /* Usable bytes following the header. */
+} Json_ArenaBlock;
+
+#define ARENA_BLOCK_HEADER ARENA_ALIGN(sizeof(Json_ArenaBlock))
+
+struct Json_Arena {
+	Json_ArenaBlock* first;
+	Json_ArenaBlock* current; /* 0 after a reset, before anything is carved. */
+	char* cursor;
+	char* end;
+	size_t blockSize;
+	size_t blocks; /* Allocated since the arena was created. */
+};
+
+static void* (*allocFunc) (size_t size) = malloc;
+static void (*freeFunc) (void* ptr) = free;
+
+void Json_setAllocator (void* (*alloc) (size_t size), void (*dealloc) (void* ptr)) {
+	allocFunc = alloc ? alloc : malloc;
+	freeFunc = dealloc ? dealloc : free;
+}
+
+Json_Arena* Json_Arena_create (size_t blockSize) {
+	Json_Arena* arena = (Json_Arena*)allocFunc(sizeof(Json_Arena));
+	if (!arena) return 0;
+	memset(arena, 0, sizeof(Json_Arena));
+	arena->blockSize = blockSize ? ARENA_ALIGN(blockSize) : SPINE_JSON_ARENA_BLOCK_SIZE;
+	return arena;
+}
+
+void Json_Arena_reset (Json_Arena* arena) {
+	arena->current = 0;
+	arena->cursor = 0;
+	arena->end = 0;
+}
+
+void Json_Arena_dispose (Json_Arena* arena) {
+	Json_ArenaBlock* block;
+	if (!arena) return;
+	block = arena->first;
+	while (block) {
+		Json_ArenaBlock* next = block->next;
+		freeFunc(block);
+		block = next;
+	}
+	freeFunc(arena);
+}
+
+/* Moves to the next block that can hold size bytes, reusing the blocks kept by a reset before allocating a new one. */
+static void* Json_Arena_grow (Json_Arena* arena, size_t size) {
+	Json_ArenaBlock* block = arena->current ? arena->current->next : arena->first;
+	while (block && block->size < size)
+		block = block->next;
+	if (!block) {
+		size_t blockSize = size > arena->blockSize ? size : arena->blockSize;
+		block = (Json_ArenaBlock*)allocFunc(ARENA_BLOCK_HEADER + blockSize);
+		if (!block) return 0; /* memory fail */
+		block->size = blockSize;
+		++arena->blocks;
+		if (arena->current) {
+			block->next = arena->current->next;
+			arena->current->next = block;
+		} else {
+			block->next = arena->first;
+			arena->first = block;
+		}
+	}
+	arena->current = block;
+	arena->cursor = (char*)block + ARENA_BLOCK_HEADER + size;
+	arena->end = (char*)block + ARENA_BLOCK_HEADER + block->size;
+	return (char*)block + ARENA_BLOCK_HEADER;
+}
+
+size_t Json_Arena_blocks (const Json_Arena* arena) {
+	return arena->blocks;
+}
+
+void* Json_Arena_alloc (Json_Arena* arena, size_t size) {
+	char* ptr = arena->cursor;
+	size = ARENA_ALIGN(size);
+	if ((size_t)(arena->end - ptr) < size) return Json_Arena_grow(arena, size);
+	arena->cursor = ptr + size;
+	return ptr;
+}
+
+/* Parser state, threaded through the parse_ functions. */
+typedef struct Json_Parser {
+	Json_Arena* arena;
+	int inSitu; /* Strings are decoded over the input instead of copied. */
+} Json_Parser;
+
 /* Internal constructor. */
-static Json *Json_new (void) {
-	Json *json = (Json*)malloc(sizeof(Json));
-	memset(json, 0 ,sizeof(Json));
+static Json *Json_new (Json_Parser* parser) {
+	Json *json = (Json*)Json_Arena_alloc(parser->arena, sizeof(Json));
+	if (json) memset(json, 0, sizeof(Json));
 	return json;
 }
 
+/* Json_create places the owning arena just before the root, so Json_dispose can find it. */
+#define OWNED_ROOT_HEADER ARENA_ALIGN(sizeof(Json_Arena*))
+
 /* Delete a Json structure. */
 void Json_dispose (Json *c) {
-	Json *next;
-	while (c) {
-		next = c->next;
-		if (c->child) Json_dispose(c->child);
-		if (c->valueString) free(c->valueString);
-		if (c->name) free(c->name);
-		free(c);
-		c = next;
+	if (!c) return;
+	Json_Arena_dispose(*(Json_Arena**)((char*)c - OWNED_ROOT_HEADER));
+}
+
+/* Interned keys, see Json_setKeys. An open addressed table hashed case insensitively, with the full hash kept so a
+ * probe only compares strings once the hashes agree. */
+typedef struct Json_KeySlot {
+	unsigned hash;
+	int key; /* 0 for an empty slot */
+} Json_KeySlot;
+
+static const char* const* internKeys;
+static Json_KeySlot* internTable;
+static unsigned internMask;
+
+static unsigned hash_key (const char* key) {
+	unsigned hash = 2166136261u; /* FNV-1a over the lower cased bytes */
+	for (; *key; ++key) {
+		unsigned char c = (unsigned char)*key;
+		if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+		hash = (hash ^ c) * 16777619u;
 	}
+	return hash;
 }
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static const char* parse_number (Json *item, const char* num) {
-	char * endptr;
-	float n;
+void Json_setKeys (const char* const* keys, int count) {
+	unsigned size = 16;
+	int i;
+	if (internTable) freeFunc(internTable);
+	internKeys = 0;
+	internTable = 0;
+	internMask = 0;
+	if (!keys || count <= 0) return;
 
-	/* Using strtod and strtof is slightly more permissive than RFC4627,
-	 * accepting for example hex-encoded floating point, but either
-	 * is often leagues faster than any manual implementation.
-	 *
-	 * We also already know that this starts with [-0-9] from parse_value.
-	 */
+	while (size < (unsigned)count * 2)
+		size <<= 1;
+	internTable = (Json_KeySlot*)allocFunc(size * sizeof(Json_KeySlot));
+	if (!internTable) return; /* memory fail, nothing gets interned */
+	memset(internTable, 0, size * sizeof(Json_KeySlot));
+	for (i = 0; i < count; ++i) {
+		unsigned hash = hash_key(keys[i]);
+		unsigned slot = hash & (size - 1);
+		while (internTable[slot].key)
+			slot = (slot + 1) & (size - 1);
+		internTable[slot].hash = hash;
+		internTable[slot].key = i + 1;
+	}
+	internKeys = keys;
+	internMask = size - 1;
+}
+
+/* ASCII only, like hash_key, which is all JSON keys need and avoids the locale aware strcasecmp. */
+static int key_equals (const char* a, const char* b) {
+	for (;; ++a, ++b) {
+		unsigned char c1 = (unsigned char)*a, c2 = (unsigned char)*b;
+		if (c1 >= 'A' && c1 <= 'Z') c1 += 'a' - 'A';
+		if (c2 >= 'A' && c2 <= 'Z') c2 += 'a' - 'A';
+		if (c1 != c2) return 0;
+		if (!c1) return 1;
+	}
+}
+
+/* Returns the interned id of name, 0 when it isn't a key. */
+static int intern_key (const char* name) {
+	unsigned hash, slot;
+	if (!internTable || !name) return 0;
+	hash = hash_key(name);
+	for (slot = hash & internMask; internTable[slot].key; slot = (slot + 1) & internMask)
+		if (internTable[slot].hash == hash && key_equals(internKeys[internTable[slot].key - 1], name))
+			return internTable[slot].key;
+	return 0;
+}
+
+/* Number parsing. strtof is locale dependent and slow, and spine files are mostly numbers. JSON numbers are parsed into
+ * a 64 bit decimal significand and a power of ten, then converted with Clinger's fast path when both are exact in a
+ * float, else with the Eisel-Lemire algorithm, which is correctly rounded and so matches strtof bit for bit. Longer
+ * significands are cut to 19 digits as fast_float does, with an exact comparison of all their digits in the rare case
+ * the cut changes the float. Only forms strtof accepts beyond JSON (hex, inf, nan) still go to strtof. */
+
+/* 5^q for q in [-64, 38], normalized to 128 bits and truncated, high word first. Smaller powers make any float 0, larger ones infinite. */
+#define POW5_MIN -64
+#define POW5_MAX 38
+static const uint64_t pow5_128[(POW5_MAX - POW5_MIN + 1) * 2] = {
+	UINT64_C(0xa87fea27a539e9a5), UINT64_C(0x3f2398d747b36224), /* 5^-64 */
+	UINT64_C(0xd29fe4b18e88640e), UINT64_C(0x8eec7f0d19a03aad), /* 5^-63 */
+	UINT64_C(0x83a3eeeef9153e89), UINT64_C(0x1953cf68300424ac), /* 5^-62 */
+	UINT64_C(0xa48ceaaab75a8e2b), UINT64_C(0x5fa8c3423c052dd7), /* 5^-61 */
+	UINT64_C(0xcdb02555653131b6), UINT64_C(0x3792f412cb06794d), /* 5^-60 */
+	UINT64_C(0x808e17555f3ebf11), UINT64_C(0xe2bbd88bbee40bd0), /* 5^-59 */
+	UINT64_C(0xa0b19d2ab70e6ed6), UINT64_C(0x5b6aceaeae9d0ec4), /* 5^-58 */
+	UINT64_C(0xc8de047564d20a8b), UINT64_C(0xf245825a5a445275), /* 5^-57 */
+	UINT64_C(0xfb158592be068d2e), UINT64_C(0xeed6e2f0f0d56712), /* 5^-56 */
+	UINT64_C(0x9ced737bb6c4183d), UINT64_C(0x55464dd69685606b), /* 5^-55 */
+	UINT64_C(0xc428d05aa4751e4c), UINT64_C(0xaa97e14c3c26b886), /* 5^-54 */
+	UINT64_C(0xf53304714d9265df), UINT64_C(0xd53dd99f4b3066a8), /* 5^-53 */
+	UINT64_C(0x993fe2c6d07b7fab), UINT64_C(0xe546a8038efe4029), /* 5^-52 */
+	UINT64_C(0xbf8fdb78849a5f96), UINT64_C(0xde98520472bdd033), /* 5^-51 */
+	UINT64_C(0xef73d256a5c0f77c), UINT64_C(0x963e66858f6d4440), /* 5^-50 */
+	UINT64_C(0x95a8637627989aad), UINT64_C(0xdde7001379a44aa8), /* 5^-49 */
+	UINT64_C(0xbb127c53b17ec159), UINT64_C(0x5560c018580d5d52), /* 5^-48 */
+	UINT64_C(0xe9d71b689dde71af), UINT64_C(0xaab8f01e6e10b4a6), /* 5^-47 */
+	UINT64_C(0x9226712162ab070d), UINT64_C(0xcab3961304ca70e8), /* 5^-46 */
+	UINT64_C(0xb6b00d69bb55c8d1), UINT64_C(0x3d607b97c5fd0d22), /* 5^-45 */
+	UINT64_C(0xe45c10c42a2b3b05), UINT64_C(0x8cb89a7db77c506a), /* 5^-44 */
+	UINT64_C(0x8eb98a7a9a5b04e3), UINT64_C(0x77f3608e92adb242), /* 5^-43 */
+	UINT64_C(0xb267ed1940f1c61c), UINT64_C(0x55f038b237591ed3), /* 5^-42 */
+	UINT64_C(0xdf01e85f912e37a3), UINT64_C(0x6b6c46dec52f6688), /* 5^-41 */
+	UINT64_C(0x8b61313bbabce2c6), UINT64_C(0x2323ac4b3b3da015), /* 5^-40 */
+	UINT64_C(0xae397d8aa96c1b77), UINT64_C(0xabec975e0a0d081a), /* 5^-39 */
+	UINT64_C(0xd9c7dced53c72255), UINT64_C(0x96e7bd358c904a21), /* 5^-38 */
+	UINT64_C(0x881cea14545c7575), UINT64_C(0x7e50d64177da2e54), /* 5^-37 */
+	UINT64_C(0xaa242499697392d2), UINT64_C(0xdde50bd1d5d0b9e9), /* 5^-36 */
+	UINT64_C(0xd4ad2dbfc3d07787), UINT64_C(0x955e4ec64b44e864), /* 5^-35 */
+	UINT64_C(0x84ec3c97da624ab4), UINT64_C(0xbd5af13bef0b113e), /* 5^-34 */
+	UINT64_C(0xa6274bbdd0fadd61), UINT64_C(0xecb1ad8aeacdd58e), /* 5^-33 */
+	UINT64_C(0xcfb11ead453994ba), UINT64_C(0x67de18eda5814af2), /* 5^-32 */
+	UINT64_C(0x81ceb32c4b43fcf4), UINT64_C(0x80eacf948770ced7), /* 5^-31 */
+	UINT64_C(0xa2425ff75e14fc31), UINT64_C(0xa1258379a94d028d), /* 5^-30 */
+	UINT64_C(0xcad2f7f5359a3b3e), UINT64_C(0x096ee45813a04330), /* 5^-29 */
+	UINT64_C(0xfd87b5f28300ca0d), UINT64_C(0x8bca9d6e188853fc), /* 5^-28 */
+	UINT64_C(0x9e74d1b791e07e48), UINT64_C(0x775ea264cf55347e), /* 5^-27 */
+	UINT64_C(0xc612062576589dda), UINT64_C(0x95364afe032a819e), /* 5^-26 */
+	UINT64_C(0xf79687aed3eec551), UINT64_C(0x3a83ddbd83f52205), /* 5^-25 */
+	UINT64_C(0x9abe14cd44753b52), UINT64_C(0xc4926a9672793543), /* 5^-24 */
+	UINT64_C(0xc16d9a0095928a27), UINT64_C(0x75b7053c0f178294), /* 5^-23 */
+	UINT64_C(0xf1c90080baf72cb1), UINT64_C(0x5324c68b12dd6339), /* 5^-22 */
+	UINT64_C(0x971da05074da7bee), UINT64_C(0xd3f6fc16ebca5e04), /* 5^-21 */
+	UINT64_C(0xbce5086492111aea), UINT64_C(0x88f4bb1ca6bcf585), /* 5^-20 */
+	UINT64_C(0xec1e4a7db69561a5), UINT64_C(0x2b31e9e3d06c32e6), /* 5^-19 */
+	UINT64_C(0x9392ee8e921d5d07), UINT64_C(0x3aff322e62439fd0), /* 5^-18 */
+	UINT64_C(0xb877aa3236a4b449), UINT64_C(0x09befeb9fad487c3), /* 5^-17 */
+	UINT64_C(0xe69594bec44de15b), UINT64_C(0x4c2ebe687989a9b4), /* 5^-16 */
+	UINT64_C(0x901d7cf73ab0acd9), UINT64_C(0x0f9d37014bf60a11), /* 5^-15 */
+	UINT64_C(0xb424dc35095cd80f), UINT64_C(0x538484c19ef38c95), /* 5^-14 */
+	UINT64_C(0xe12e13424bb40e13), UINT64_C(0x2865a5f206b06fba), /* 5^-13 */
+	UINT64_C(0x8cbccc096f5088cb), UINT64_C(0xf93f87b7442e45d4), /* 5^-12 */
+	UINT64_C(0xafebff0bcb24aafe), UINT64_C(0xf78f69a51539d749), /* 5^-11 */
+	UINT64_C(0xdbe6fecebdedd5be), UINT64_C(0xb573440e5a884d1c), /* 5^-10 */
+	UINT64_C(0x89705f4136b4a597), UINT64_C(0x31680a88f8953031), /* 5^-9 */
+	UINT64_C(0xabcc77118461cefc), UINT64_C(0xfdc20d2b36ba7c3e), /* 5^-8 */
+	UINT64_C(0xd6bf94d5e57a42bc), UINT64_C(0x3d32907604691b4d), /* 5^-7 */
+	UINT64_C(0x8637bd05af6c69b5), UINT64_C(0xa63f9a49c2c1b110), /* 5^-6 */
+	UINT64_C(0xa7c5ac471b478423), UINT64_C(0x0fcf80dc33721d54), /* 5^-5 */
+	UINT64_C(0xd1b71758e219652b), UINT64_C(0xd3c36113404ea4a9), /* 5^-4 */
+	UINT64_C(0x83126e978d4fdf3b), UINT64_C(0x645a1cac083126ea), /* 5^-3 */
+	UINT64_C(0xa3d70a3d70a3d70a), UINT64_C(0x3d70a3d70a3d70a4), /* 5^-2 */
+	UINT64_C(0xcccccccccccccccc), UINT64_C(0xcccccccccccccccd), /* 5^-1 */
+	UINT64_C(0x8000000000000000), UINT64_C(0x0000000000000000), /* 5^0 */
+	UINT64_C(0xa000000000000000), UINT64_C(0x0000000000000000), /* 5^1 */
+	UINT64_C(0xc800000000000000), UINT64_C(0x0000000000000000), /* 5^2 */
+	UINT64_C(0xfa00000000000000), UINT64_C(0x0000000000000000), /* 5^3 */
+	UINT64_C(0x9c40000000000000), UINT64_C(0x0000000000000000), /* 5^4 */
+	UINT64_C(0xc350000000000000), UINT64_C(0x0000000000000000), /* 5^5 */
+	UINT64_C(0xf424000000000000), UINT64_C(0x0000000000000000), /* 5^6 */
+	UINT64_C(0x9896800000000000), UINT64_C(0x0000000000000000), /* 5^7 */
+	UINT64_C(0xbebc200000000000), UINT64_C(0x0000000000000000), /* 5^8 */
+	UINT64_C(0xee6b280000000000), UINT64_C(0x0000000000000000), /* 5^9 */
+	UINT64_C(0x9502f90000000000), UINT64_C(0x0000000000000000), /* 5^10 */
+	UINT64_C(0xba43b74000000000), UINT64_C(0x0000000000000000), /* 5^11 */
+	UINT64_C(0xe8d4a51000000000), UINT64_C(0x0000000000000000), /* 5^12 */
+	UINT64_C(0x9184e72a00000000), UINT64_C(0x0000000000000000), /* 5^13 */
+	UINT64_C(0xb5e620f480000000), UINT64_C(0x0000000000000000), /* 5^14 */
+	UINT64_C(0xe35fa931a0000000), UINT64_C(0x0000000000000000), /* 5^15 */
+	UINT64_C(0x8e1bc9bf04000000), UINT64_C(0x0000000000000000), /* 5^16 */
+	UINT64_C(0xb1a2bc2ec5000000), UINT64_C(0x0000000000000000), /* 5^17 */
+	UINT64_C(0xde0b6b3a76400000), UINT64_C(0x0000000000000000), /* 5^18 */
+	UINT64_C(0x8ac7230489e80000), UINT64_C(0x0000000000000000), /* 5^19 */
+	UINT64_C(0xad78ebc5ac620000), UINT64_C(0x0000000000000000), /* 5^20 */
+	UINT64_C(0xd8d726b7177a8000), UINT64_C(0x0000000000000000), /* 5^21 */
+	UINT64_C(0x878678326eac9000), UINT64_C(0x0000000000000000), /* 5^22 */
+	UINT64_C(0xa968163f0a57b400), UINT64_C(0x0000000000000000), /* 5^23 */
+	UINT64_C(0xd3c21bcecceda100), UINT64_C(0x0000000000000000), /* 5^24 */
+	UINT64_C(0x84595161401484a0), UINT64_C(0x0000000000000000), /* 5^25 */
+	UINT64_C(0xa56fa5b99019a5c8), UINT64_C(0x0000000000000000), /* 5^26 */
+	UINT64_C(0xcecb8f27f4200f3a), UINT64_C(0x0000000000000000), /* 5^27 */
+	UINT64_C(0x813f3978f8940984), UINT64_C(0x4000000000000000), /* 5^28 */
+	UINT64_C(0xa18f07d736b90be5), UINT64_C(0x5000000000000000), /* 5^29 */
+	UINT64_C(0xc9f2c9cd04674ede), UINT64_C(0xa400000000000000), /* 5^30 */
+	UINT64_C(0xfc6f7c4045812296), UINT64_C(0x4d00000000000000), /* 5^31 */
+	UINT64_C(0x9dc5ada82b70b59d), UINT64_C(0xf020000000000000), /* 5^32 */
+	UINT64_C(0xc5371912364ce305), UINT64_C(0x6c28000000000000), /* 5^33 */
+	UINT64_C(0xf684df56c3e01bc6), UINT64_C(0xc732000000000000), /* 5^34 */
+	UINT64_C(0x9a130b963a6c115c), UINT64_C(0x3c7f400000000000), /* 5^35 */
+	UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x4b9f100000000000), /* 5^36 */
+	UINT64_C(0xf0bdc21abb48db20), UINT64_C(0x1e86d40000000000), /* 5^37 */
+	UINT64_C(0x96769950b50d88f4), UINT64_C(0x1314448000000000) /* 5^38 */
+};
+
+static const float pow10_exact[11] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+static void full_multiply (uint64_t a, uint64_t b, uint64_t* high, uint64_t* low) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t)a * b;
+	*high = (uint64_t)(r >> 64);
+	*low = (uint64_t)r;
+#elif defined(_MSC_VER) && defined(_M_X64)
+	*low = _umul128(a, b, high);
+#else
+	uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32, bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+	uint64_t ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+	uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+	*low = (mid << 32) | (ll & 0xFFFFFFFF);
+	*high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+static int leading_zeroes (uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, w);
+	return 63 - (int)index;
+#elif defined(__GNUC__)
+	return __builtin_clzll(w);
+#else
+	int n = 0;
+	while (!(w & UINT64_C(0x8000000000000000))) {
+		w <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* Eisel-Lemire for binary32: w * 10^q correctly rounded, w != 0. Returns the float's bits without the sign. */
+static uint32_t eisel_lemire (uint64_t w, int q) {
+	const int mantissaBits = 23, minimumExponent = -127, infinitePower = 0xFF;
+	const uint64_t precisionMask = UINT64_C(0xFFFFFFFFFFFFFFFF) >> (mantissaBits + 3);
+	uint64_t high, low, mantissa;
+	int lz, upperBit, shift, power2;
+	const uint64_t* pow5;
+
+	if (q < POW5_MIN) return 0;
+	if (q > POW5_MAX) return (uint32_t)infinitePower << mantissaBits;
+
+	lz = leading_zeroes(w);
+	w <<= lz;
+	pow5 = pow5_128 + (q - POW5_MIN) * 2;
+	full_multiply(w, pow5[0], &high, &low);
+	if ((high & precisionMask) == precisionMask) { /* the truncated power may matter, take in its low word */
+		uint64_t high2, low2;
+		full_multiply(w, pow5[1], &high2, &low2);
+		low += high2;
+		if (high2 > low) high++;
+	}
+
+	upperBit = (int)(high >> 63);
+	shift = upperBit + 64 - mantissaBits - 3;
+	mantissa = high >> shift;
+	/* (((152170 + 65536) * q) >> 16) + 63 is floor(log2(10^q)) + 63 */
+	power2 = (int)((((152170 + 65536) * q) >> 16) + 63) + upperBit - lz - minimumExponent;
+
+	if (power2 <= 0) { /* subnormal */
+		if (-power2 + 1 >= 64) return 0;
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		power2 = mantissa < ((uint64_t)1 << mantissaBits) ? 0 : 1;
+		return ((uint32_t)power2 << mantissaBits) | (uint32_t)(mantissa & (((uint64_t)1 << mantissaBits) - 1));
+	}
+
+	/* Exactly halfway between two floats can only happen for small q, round to even then. */
+	if (low <= 1 && q >= -17 && q <= 10 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+		mantissa &= ~(uint64_t)1;
+
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= ((uint64_t)2 << mantissaBits)) {
+		mantissa = (uint64_t)1 << mantissaBits;
+		power2++;
+	}
+	mantissa &= ~((uint64_t)1 << mantissaBits);
+	if (power2 >= infinitePower) return (uint32_t)infinitePower << mantissaBits;
+	return ((uint32_t)power2 << mantissaBits) | (uint32_t)mantissa;
+}
+
+/* An unsigned integer of up to BIG_LIMBS 32 bit limbs, least significant first, for the digit comparison. */
+#define BIG_LIMBS 48
+#define BIG_DIGITS 128 /* more than the 113 significant digits of any halfway point between two floats */
+
+typedef struct {
+	uint32_t limb[BIG_LIMBS];
+	int size;
+} Big;
+
+static void big_multiply_add (Big* big, uint32_t factor, uint32_t addend) {
+	uint64_t carry = addend;
+	int i;
+	for (i = 0; i < big->size; i++) {
+		carry += (uint64_t)big->limb[i] * factor;
+		big->limb[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+	if (carry && big->size < BIG_LIMBS) big->limb[big->size++] = (uint32_t)carry;
+}
+
+static void big_multiply_pow5 (Big* big, int power) {
+	static const uint32_t pow5[14] = {1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125,
+		244140625, 1220703125};
+	for (; power >= 13; power -= 13)
+		big_multiply_add(big, pow5[13], 0);
+	if (power) big_multiply_add(big, pow5[power], 0);
+}
+
+static void big_shift_left (Big* big, int bits) {
+	int limbs = bits / 32, shift = bits % 32, i;
+	if (big->size == 0) return;
+	if (big->size + limbs + 1 > BIG_LIMBS) limbs = BIG_LIMBS - big->size - 1; /* can't happen for floats */
+	big->limb[big->size] = 0;
+	for (i = big->size; i >= 0; i--) {
+		uint32_t high = big->limb[i] << shift;
+		if (shift && i) high |= big->limb[i - 1] >> (32 - shift);
+		big->limb[i + limbs] = high;
+	}
+	for (i = 0; i < limbs; i++)
+		big->limb[i] = 0;
+	big->size += limbs + 1;
+	while (big->size && !big->limb[big->size - 1])
+		big->size--;
+}
+
+static int big_compare (const Big* a, const Big* b) {
+	int i;
+	if (a->size != b->size) return a->size > b->size ? 1 : -1;
+	for (i = a->size - 1; i >= 0; i--) {
+		if (a->limb[i] != b->limb[i]) return a->limb[i] > b->limb[i] ? 1 : -1;
+	}
+	return 0;
+}
+
+/* Whether the decimal significand d to end, maybe with a '.', times 10^q for its first 19 digits, rounds to the float
+ * above bits rather than to bits: it is compared exactly with the halfway point between the two. */
+static int above_halfway (const char* d, const char* end, int q, uint32_t bits) {
+	Big value, halfway;
+	int digits = 0, sticky = 0, exponent10, exponent2, order;
+	uint32_t significand = bits & 0x7FFFFF, biased = bits >> 23;
+	const char* p;
+
+	value.size = 0;
+	for (p = d; p < end; p++) {
+		if (*p == '.') continue;
+		if (digits < BIG_DIGITS) {
+			big_multiply_add(&value, 10, (uint32_t)(*p - '0'));
+			digits++;
+		} else if (*p != '0') {
+			sticky = 1;
+		}
+	}
+	exponent10 = q + 19 - digits;
+
+	/* the halfway point is (2 * significand + 1) * 2^(exponent2) */
+	if (biased) {
+		significand |= (uint32_t)1 << 23;
+		exponent2 = (int)biased - 151;
+	} else {
+		exponent2 = -150;
+	}
+	halfway.size = 1;
+	halfway.limb[0] = 2 * significand + 1;
+
+	/* value * 10^exponent10 against halfway * 2^exponent2, as integers times powers of two */
+	if (exponent10 >= 0) {
+		big_multiply_pow5(&value, exponent10);
+	} else {
+		big_multiply_pow5(&halfway, -exponent10);
+		exponent2 -= exponent10;
+		exponent10 = 0;
+	}
+	if (exponent10 > exponent2)
+		big_shift_left(&value, exponent10 - exponent2);
+	else
+		big_shift_left(&halfway, exponent2 - exponent10);
+
+	order = big_compare(&value, &halfway);
+	if (order) return order > 0;
+	return sticky || (bits & 1); /* exactly halfway rounds to even */
+}
+
+/* A significand of more than 19 significant digits, d to end, times 10^q once cut to its first 19 digits. The cut
+ * one and the one above it are converted, and only when they round apart are all the digits compared. */
+static uint32_t long_significand (const char* d, const char* end, int q) {
+	uint64_t w = 0;
+	int digits = 0, truncated = 0;
+	uint32_t bits;
+	const char* p;
+
+	for (p = d; p < end && !truncated; p++) {
+		if (*p == '.') continue;
+		if (digits < 19) {
+			w = w * 10 + (uint64_t)(*p - '0');
+			digits++;
+		} else if (*p != '0') {
+			truncated = 1;
+		}
+	}
+	bits = eisel_lemire(w, q);
+	if (!truncated || eisel_lemire(w + 1, q) == bits) return bits;
+	return above_halfway(d, end, q, bits) ? bits + 1 : bits;
+}
+
+static float strtof_fallback (const char* num, char** endptr) {
 #if __STDC_VERSION__ >= 199901L
-	n = strtof(num, &endptr);
+	return strtof(num, endptr);
 #else
-	n = (float)strtod( num, &endptr );
+	return (float)strtod(num, endptr);
 #endif
-	/* ignore errno's ERANGE, which returns +/-HUGE_VAL */
-	/* n is 0 on any other error */
+}
+
+/* Parses a number at num into *out and *outInt, the same as (int)*out. Returns the end of the number, num if there is none. */
+static const char* parse_float (const char* num, float* out, int* outInt) {
+	const char* p = num;
+	const char* digits;
+	const char* fractionEnd;
+	const char* end;
+	uint64_t w = 0;
+	int negative = 0, count, exponent = 0, integral;
+	uint32_t bits;
+	float n;
 
-	if (endptr != num) {
+	if (*p == '-') {
+		negative = 1;
+		p++;
+	}
+	if ((unsigned)(*p - '0') > 9 || (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))) goto fallback; /* inf, nan, hex or nothing */
+
+	digits = p;
+	while ((unsigned)(*p - '0') <= 9)
+		w = w * 10 + (uint64_t)(*p++ - '0');
+	count = (int)(p - digits);
+	integral = 1;
+	if (*p == '.') {
+		const char* fraction = ++p;
+		while ((unsigned)(*p - '0') <= 9)
+			w = w * 10 + (uint64_t)(*p++ - '0');
+		exponent = (int)(fraction - p);
+		count -= exponent;
+		integral = 0;
+	}
+	end = fractionEnd = p;
+	if (*p == 'e' || *p == 'E') {
+		int exponentNegative = 0, value = 0;
+		p++;
+		if (*p == '-' || *p == '+') exponentNegative = *p++ == '-';
+		if ((unsigned)(*p - '0') <= 9) { /* else the number ends before the 'e', as with strtof */
+			while ((unsigned)(*p - '0') <= 9) {
+				if (value < 0x10000) value = value * 10 + (*p - '0');
+				p++;
+			}
+			exponent += exponentNegative ? -value : value;
+			integral = 0;
+			end = p;
+		}
+	}
+
+	if (count > 19) { /* w overflowed unless the extra digits are leading zeros */
+		const char* d = digits;
+		while (*d == '0' || *d == '.') {
+			if (*d == '0') count--;
+			d++;
+		}
+		if (count > 19) {
+			bits = long_significand(d, fractionEnd, exponent + count - 19);
+			goto sign;
+		}
+	}
+
+	if (integral && w <= ((uint64_t)1 << 24)) { /* plain small integers, the most common number in spine files */
+		n = (float)w;
+		*out = negative ? -n : n;
+		*outInt = negative ? -(int)w : (int)w;
+		return end;
+	}
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+	if (w <= ((uint64_t)1 << 24) && exponent >= -10 && exponent <= 10) { /* both exact, one correctly rounded operation */
+		n = (float)w;
+		n = exponent < 0 ? n / pow10_exact[-exponent] : n * pow10_exact[exponent];
+		*out = negative ? -n : n;
+		*outInt = (int)*out;
+		return end;
+	}
+#endif
+	bits = w ? eisel_lemire(w, exponent) : 0;
+sign:
+	if (negative) bits |= UINT32_C(0x80000000);
+	memcpy(&n, &bits, sizeof(n));
+	*out = n;
+	*outInt = (int)n;
+	return end;
+
+fallback: {
+		char* endptr;
+		n = strtof_fallback(num, &endptr);
+		*out = n;
+		*outInt = (int)n;
+		return endptr;
+	}
+}
+
+/* Parse the input text to generate a number, and populate the result into item. */
+static const char* parse_number (Json *item, const char* num) {
+	const char* end = parse_float(num, &item->valueFloat, &item->valueInt);
+	/* ignore overflow, which gives +/-infinity like strtof's HUGE_VALF */
+
+	if (end != num) {
 		/* Parse success, number found. */
-		item->valueFloat = n;
-		item->valueInt = (int)n;
 		item->type = Json_Number;
-		return endptr;
+		return end;
 	} else {
 		/* Parse failure, ep is set. */
 		ep = num;
@@ -123,32 +840,37 @@ static const char* parse_number (Json *item, const char* num) {
 	}
 }
 
-/* Parse the input text into an unescaped cstring, and populate item. */
-static const unsigned char firstByteMark[7] = {0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC};
-static const char* parse_string (Json *item, const char* str) {
-	const char* ptr = str + 1;
-	char* ptr2;
-	char* out;
-	int len = 0;
-	unsigned uc, uc2;
-	if (*str != '\"') { /* TODO: don't need this check when called from parse_value, but do need from parse_object */
-		ep = str;
-		return 0;
-	} /* not a string! */
-
-	while (*ptr != '\"' && *ptr && ++len)
-		if (*ptr++ == '\\') ptr++; /* Skip escaped quotes. */
-
-	out = malloc(len + 1); /* The length needed for the string, roughly. */
-	memset(out, 0, len + 1);
-	if (!out) return 0;
+/* Parse the four hex digits of a \u escape, -1 if they aren't hex. */
+static int parse_hex4 (const char* str) {
+	int h = 0, i;
+	for (i = 0; i < 4; ++i) {
+		char c = str[i];
+		h <<= 4;
+		if (c >= '0' && c <= '9')
+			h |= c - '0';
+		else if (c >= 'A' && c <= 'F')
+			h |= c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			h |= c - 'a' + 10;
+		else
+			return -1;
+	}
+	return h;
+}
 
-	ptr = str + 1;
-	ptr2 = out;
+/* Decode the string body at ptr into out, up to the closing quote or the end of input. Decoding never makes the text
+ * longer, so out may be ptr itself. Returns the position of the closing quote and sets *outEnd past the last byte written. */
+static const unsigned char firstByteMark[7] = {0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC};
+static const char* decode_string (char* out, const char* ptr, char** outEnd) {
+	char* ptr2 = out;
+	int len, uc, uc2;
 	while (*ptr != '\"' && *ptr) {
-		if (*ptr != '\\')
-			*ptr2++ = *ptr++;
-		else {
+		if (*ptr != '\\') {
+			const char* run = scan_string(ptr);
+			memmove(ptr2, ptr, run - ptr); /* may overlap when decoding in place. */
+			ptr2 += run - ptr;
+			ptr = run;
+		} else {
 			ptr++;
 			switch (*ptr) {
 			case 'b':
@@ -167,7 +889,8 @@ static const char* parse_string (Json *item, const char* str) {
 				*ptr2++ = '\t';
 				break;
 			case 'u': /* transcode utf16 to utf8. */
-				sscanf(ptr + 1, "%4x", &uc);
+				uc = parse_hex4(ptr + 1);
+				if (uc < 0) break; /* not hex, keep the text. */
 				ptr += 4; /* get the unicode char. */
 
 				if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0) break; /* check for invalid.	*/
@@ -176,7 +899,8 @@ static const char* parse_string (Json *item, const char* str) {
 				if (uc >= 0xD800 && uc <= 0xDBFF) /* UTF16 surrogate pairs.	*/
 				{
 					if (ptr[1] != '\\' || ptr[2] != 'u') break; /* missing second-half of surrogate.	*/
-					sscanf(ptr + 3, "%4x", &uc2);
+					uc2 = parse_hex4(ptr + 3);
+					if (uc2 < 0) break; /* not hex, keep the text. */
 					ptr += 6;
 					if (uc2 < 0xDC00 || uc2 > 0xDFFF) break; /* invalid second-half of surrogate.	*/
 					uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
@@ -215,45 +939,168 @@ static const char* parse_string (Json *item, const char* str) {
 			ptr++;
 		}
 	}
-	*ptr2 = 0;
-	if (*ptr == '\"') ptr++; /* TODO error handling if not \" or \0 ? */
+	*outEnd = ptr2;
+	return ptr;
+}
+
+/* Parse the input text into an unescaped cstring, and populate item. */
+static const char* parse_string (Json_Parser* parser, Json *item, const char* str) {
+	const char* ptr = str + 1;
+	const char* next;
+	char* out;
+	char* end;
+	int len = 0;
+	if (*str != '\"') { /* TODO: don't need this check when called from parse_value, but do need from parse_object */
+		ep = str;
+		return 0;
+	} /* not a string! */
+
+	if (parser->inSitu) {
+		/* Strings without escapes are used where they lie, terminated over their closing quote. The rest are decoded in place. */
+		out = (char*)ptr;
+		ptr = scan_string(ptr);
+		end = (char*)ptr;
+		if (*ptr == '\\') ptr = decode_string(end, ptr, &end);
+	} else {
+		for (;;) {
+			const char* run = scan_string(ptr);
+			len += (int)(run - ptr);
+			ptr = run;
+			if (*ptr != '\\') break;
+			len++;
+			ptr += ptr[1] ? 2 : 1; /* Skip escaped quotes. */
+		}
+
+		out = (char*)Json_Arena_alloc(parser->arena, len + 1); /* The length needed for the string, roughly. */
+		if (!out) return 0; /* memory fail */
+		ptr = decode_string(out, str + 1, &end);
+	}
+	next = *ptr == '\"' ? ptr + 1 : ptr; /* TODO error handling if not \" or \0 ? */
+	*end = 0;
 	item->valueString = out;
 	item->type = Json_String;
-	return ptr;
+	return next;
 }
 
 /* Predeclare these prototypes. */
-static const char* parse_value (Json *item, const char* value);
-static const char* parse_array (Json *item, const char* value);
-static const char* parse_object (Json *item, const char* value);
+static const char* parse_value (Json_Parser* parser, Json *item, const char* value);
+static const char* parse_array (Json_Parser* parser, Json *item, const char* value);
+static const char* parse_object (Json_Parser* parser, Json *item, const char* value);
 
-/* Utility to jump whitespace and cr/lf */
-static const char* skip (const char* in) {
+/* Utility to jump whitespace and cr/lf, stopping at end if it comes first. 0 for no end. */
+static const char* skip_until (const char* in, const char* end) {
 	if (!in) return 0; /* must propagate NULL since it's often called in skip(f(...)) form */
-	while (*in && (unsigned char)*in <= 32)
+#if SIMD_WIDTH
+	{
+		/* Most values follow their separator directly or after a space, only vectorize the indentation runs. */
+		int n;
+		for (n = 0; n < 4; ++n, ++in)
+			if (in == end || !*in || (unsigned char)*in > 32) return in;
+		return simd_skip(in, end);
+	}
+#else
+	while (in != end && *in && (unsigned char)*in <= 32)
 		in++;
 	return in;
+#endif
 }
 
-/* Parse an object - create a new root, and populate. */
-Json *Json_create (const char* value) {
+static const char* skip (const char* in) {
+	return skip_until(in, 0);
+}
+
+const char* Json_skipValue (const char* value) {
+	int depth = 0;
+	if (!value) return 0;
+	value = skip(value);
+	do {
+		switch (*value) {
+		case 0:
+			return 0;
+		case '\"':
+			for (value = scan_string(value + 1); *value == '\\'; value = scan_string(value + 2))
+				if (!value[1]) return 0;
+			if (!*value) return 0;
+			value++;
+			break;
+		case '[': /* fallthrough */
+		case '{':
+			depth++;
+			value++;
+			break;
+		case ']': /* fallthrough */
+		case '}':
+			if (!depth) return 0;
+			depth--;
+			value++;
+			break;
+		default:
+			/* a run of numbers, literals, separators and whitespace, or a whole scalar at the top */
+			if (depth) {
+#if SIMD_WIDTH
+				value = simd_scan_structure(value);
+#else
+				while (*value && *value != '\"' && *value != '[' && *value != '{' && *value != ']' && *value != '}')
+					value++;
+#endif
+			} else {
+				while ((unsigned char)*value > 32 && *value != ',' && *value != ']' && *value != '}')
+					value++;
+			}
+			break;
+		}
+	} while (depth);
+	return value;
+}
+
+/* Parse an object - create a new root, and populate. Without an arena the tree gets its own, released by Json_dispose. */
+static Json *Json_parse (Json_Arena* arena, const char* value, int inSitu) {
+	Json_Parser parser;
 	Json *c;
 	ep = 0;
 	if (!value) return 0; /* only place we check for NULL other than skip() */
-	c = Json_new();
-	if (!c) return 0; /* memory fail */
+	parser.inSitu = inSitu;
+	if (arena) {
+		parser.arena = arena;
+		c = Json_new(&parser);
+		if (!c) return 0; /* memory fail */
+	} else {
+		char *owned;
+		parser.arena = Json_Arena_create(0);
+		if (!parser.arena) return 0; /* memory fail */
+		owned = (char*)Json_Arena_alloc(parser.arena, OWNED_ROOT_HEADER + sizeof(Json));
+		if (!owned) {
+			Json_Arena_dispose(parser.arena);
+			return 0;
+		}
+		*(Json_Arena**)owned = parser.arena;
+		c = (Json*)(owned + OWNED_ROOT_HEADER);
+		memset(c, 0, sizeof(Json));
+	}
 
-	value = parse_value(c, skip(value));
+	value = parse_value(&parser, c, skip(value));
 	if (!value) {
-		Json_dispose(c);
+		if (!arena) Json_dispose(c);
 		return 0;
-	} /* parse failure. ep is set. */
+	} /* parse failure. ep is set, an arena keeps the partial tree until it is reset. */
 
 	return c;
 }
 
+Json *Json_create (const char* value) {
+	return Json_parse(0, value, 0);
+}
+
+Json *Json_createInArena (Json_Arena* arena, const char* value) {
+	return Json_parse(arena, value, 0);
+}
+
+Json *Json_createInSitu (Json_Arena* arena, char* value) {
+	return Json_parse(arena, value, 1);
+}
+
 /* Parser core - when encountering text, process appropriately. */
-static const char* parse_value (Json *item, const char* value) {
+static const char* parse_value (Json_Parser* parser, Json *item, const char* value) {
 	/* Referenced by Json_create(), parse_array(), and parse_object(). */
 	/* Always called with the result of skip(). */
 #if SPINE_JSON_DEBUG /* Checked at entry to graph, Json_create, and after every parse_ call. */
@@ -285,11 +1132,11 @@ static const char* parse_value (Json *item, const char* value) {
 		break;
 	}
 	case '\"':
-		return parse_string(item, value);
+		return parse_string(parser, item, value);
 	case '[':
-		return parse_array(item, value);
+		return parse_array(parser, item, value);
 	case '{':
-		return parse_object(item, value);
+		return parse_object(parser, item, value);
 	case '-': /* fallthrough */
 	case '0': /* fallthrough */
 	case '1': /* fallthrough */
@@ -311,7 +1158,7 @@ static const char* parse_value (Json *item, const char* value) {
 }
 
 /* Build an array from input text. */
-static const char* parse_array (Json *item, const char* value) {
+static const char* parse_array (Json_Parser* parser, Json *item, const char* value) {
 	Json *child;
 
 #if SPINE_JSON_DEBUG /* unnecessary, only callsite (parse_value) verifies this */
@@ -325,21 +1172,21 @@ static const char* parse_array (Json *item, const char* value) {
 	value = skip(value + 1);
 	if (*value == ']') return value + 1; /* empty array. */
 
-	item->child = child = Json_new();
+	item->child = child = Json_new(parser);
 	if (!item->child) return 0; /* memory fail */
-	value = skip(parse_value(child, skip(value))); /* skip any spacing, get the value. */
+	value = skip(parse_value(parser, child, skip(value))); /* skip any spacing, get the value. */
 	if (!value) return 0;
 	item->size = 1;
 
 	while (*value == ',') {
-		Json *new_item = Json_new();
+		Json *new_item = Json_new(parser);
 		if (!new_item) return 0; /* memory fail */
 		child->next = new_item;
 #if SPINE_JSON_HAVE_PREV
 		new_item->prev = child;
 #endif
 		child = new_item;
-		value = skip(parse_value(child, skip(value + 1)));
+		value = skip(parse_value(parser, child, skip(value + 1)));
 		if (!value) return 0; /* parse fail */
 		item->size++;
 	}
@@ -350,7 +1197,7 @@ static const char* parse_array (Json *item, const char* value) {
 }
 
 /* Build an object from the text. */
-static const char* parse_object (Json *item, const char* value) {
+static const char* parse_object (Json_Parser* parser, Json *item, const char* value) {
 	Json *child;
 
 #if SPINE_JSON_DEBUG /* unnecessary, only callsite (parse_value) verifies this */
@@ -364,37 +1211,39 @@ static const char* parse_object (Json *item, const char* value) {
 	value = skip(value + 1);
 	if (*value == '}') return value + 1; /* empty array. */
 
-	item->child = child = Json_new();
+	item->child = child = Json_new(parser);
 	if (!item->child) return 0;
-	value = skip(parse_string(child, skip(value)));
+	value = skip(parse_string(parser, child, skip(value)));
 	if (!value) return 0;
 	child->name = child->valueString;
 	child->valueString = 0;
+	child->key = intern_key(child->name);
 	if (*value != ':') {
 		ep = value;
 		return 0;
 	} /* fail! */
-	value = skip(parse_value(child, skip(value + 1))); /* skip any spacing, get the value. */
+	value = skip(parse_value(parser, child, skip(value + 1))); /* skip any spacing, get the value. */
 	if (!value) return 0;
 	item->size = 1;
 
 	while (*value == ',') {
-		Json *new_item = Json_new();
+		Json *new_item = Json_new(parser);
 		if (!new_item) return 0; /* memory fail */
 		child->next = new_item;
 #if SPINE_JSON_HAVE_PREV
 		new_item->prev = child;
 #endif
 		child = new_item;
-		value = skip(parse_string(child, skip(value + 1)));
+		value = skip(parse_string(parser, child, skip(value + 1)));
 		if (!value) return 0;
 		child->name = child->valueString;
 		child->valueString = 0;
+		child->key = intern_key(child->name);
 		if (*value != ':') {
 			ep = value;
 			return 0;
 		} /* fail! */
-		value = skip(parse_value(child, skip(value + 1))); /* skip any spacing, get the value. */
+		value = skip(parse_value(parser, child, skip(value + 1))); /* skip any spacing, get the value. */
 		if (!value) return 0;
 		item->size++;
 	}
@@ -426,3 +1275,219 @@ int Json_getInt (Json* value, const char* name, int defaultValue) {
 	value = Json_getItem(value, name);
 	return value ? value->valueInt : defaultValue;
 }
+
+Json *Json_getItemKey (Json *object, int key) {
+	Json *c = object->child;
+	while (c && c->key != key)
+		c = c->next;
+	return c;
+}
+
+const char* Json_getStringKey (Json* object, int key, const char* defaultValue) {
+	object = Json_getItemKey(object, key);
+	if (object) return object->valueString;
+	return defaultValue;
+}
+
+float Json_getFloatKey (Json* value, int key, float defaultValue) {
+	value = Json_getItemKey(value, key);
+	return value ? value->valueFloat : defaultValue;
+}
+
+int Json_getIntKey (Json* value, int key, int defaultValue) {
+	value = Json_getItemKey(value, key);
+	return value ? value->valueInt : defaultValue;
+}
+
+/* Json_Reader states. */
+#define READER_START 0 /* Before the root value. */
+#define READER_FIRST 1 /* A container was just opened. */
+#define READER_NEXT 2 /* After a value in a container, a ',' or the end follows. */
+#define READER_DONE 3
+#define READER_ERROR 4
+
+#define READER_IN_OBJECT(reader) ((reader)->objects[((reader)->depth - 1) >> 3] & (1 << (((reader)->depth - 1) & 7)))
+
+/* Whether n bytes are left at value. Without an end the NUL stops every comparison in time. */
+#define READER_LEFT(reader, value, n) (!(reader)->end || (reader)->end - (value) >= (n))
+
+void Json_Reader_init (Json_Reader* reader, const char* value) {
+	Json_Reader_initRange(reader, value, 0);
+}
+
+void Json_Reader_initRange (Json_Reader* reader, const char* value, const char* end) {
+	memset(reader, 0, sizeof(Json_Reader));
+	reader->cursor = value;
+	reader->end = end;
+	ep = 0;
+	if (!value) reader->state = READER_ERROR;
+}
+
+void Json_Reader_dispose (Json_Reader* reader) {
+	if (reader->nameBuffer) freeFunc(reader->nameBuffer);
+	if (reader->stringBuffer) freeFunc(reader->stringBuffer);
+	reader->nameBuffer = reader->stringBuffer = 0;
+	reader->nameCapacity = reader->stringCapacity = 0;
+}
+
+/* Makes the buffer hold at least len + 1 bytes. 0 if memory fails. */
+static char* reserve (char** buffer, size_t* capacity, size_t len) {
+	if (len >= *capacity) {
+		size_t size = *capacity ? *capacity : 64;
+		char* grown;
+		while (size <= len)
+			size *= 2;
+		grown = (char*)allocFunc(size);
+		if (!grown) return 0; /* memory fail */
+		if (*buffer) freeFunc(*buffer);
+		*buffer = grown;
+		*capacity = size;
+	}
+	return *buffer;
+}
+
+/* Decode the string at str into a buffer that grows as needed, like parse_string. With an end, the closing quote must
+ * come before it, and decoding stops at that quote. */
+static const char* read_string (char** buffer, size_t* capacity, const char* str, const char* textEnd) {
+	const char* ptr = str + 1;
+	char* end;
+	size_t len = 0;
+	if (*str != '\"') {
+		ep = str;
+		return 0;
+	} /* not a string! */
+
+	for (;;) {
+		const char* run = scan_string_until(ptr, textEnd);
+		len += run - ptr;
+		ptr = run;
+		if (ptr == textEnd || *ptr != '\\') break;
+		len++;
+		if (ptr + 1 == textEnd) ptr++;
+		else ptr += ptr[1] ? 2 : 1; /* Skip escaped quotes. */
+	}
+	if (textEnd && (ptr == textEnd || *ptr != '\"')) {
+		ep = str;
+		return 0;
+	} /* not terminated */
+	if (!reserve(buffer, capacity, len)) return 0;
+	ptr = decode_string(*buffer, str + 1, &end);
+	*end = 0;
+	return *ptr == '\"' ? ptr + 1 : ptr;
+}
+
+static int reader_fail (Json_Reader* reader, const char* at) {
+	if (at) ep = at; /* else ep is set, or memory failed */
+	reader->state = READER_ERROR;
+	return Json_Error;
+}
+
+static int reader_close (Json_Reader* reader, const char* next) {
+	int inObject = READER_IN_OBJECT(reader);
+	reader->depth--;
+	reader->cursor = next;
+	reader->state = reader->depth ? READER_NEXT : READER_DONE;
+	return inObject ? Json_EndObject : Json_EndArray;
+}
+
+int Json_Reader_next (Json_Reader* reader) {
+	const char* value;
+	const char* end;
+	if (reader->state == READER_ERROR) return Json_Error;
+	if (reader->state == READER_DONE) return Json_End;
+	reader->name = 0;
+	reader->key = 0;
+	reader->valueString = 0;
+	reader->valueInt = 0;
+	reader->valueFloat = 0;
+
+	value = skip_until(reader->cursor, reader->end);
+	if (reader->state != READER_START) {
+		int inObject = READER_IN_OBJECT(reader);
+		if (value == reader->end) return reader_fail(reader, value);
+		if (*value == (inObject ? '}' : ']')) return reader_close(reader, value + 1);
+		if (reader->state == READER_NEXT) {
+			if (*value != ',') return reader_fail(reader, value);
+			value = skip_until(value + 1, reader->end);
+			if (value == reader->end) return reader_fail(reader, value);
+		}
+		if (inObject) {
+			value = skip_until(read_string(&reader->nameBuffer, &reader->nameCapacity, value, reader->end), reader->end);
+			if (!value) return reader_fail(reader, 0);
+			if (value == reader->end || *value != ':') return reader_fail(reader, value);
+			reader->name = reader->nameBuffer;
+			reader->key = intern_key(reader->name);
+			value = skip_until(value + 1, reader->end);
+		}
+	}
+	if (value == reader->end) return reader_fail(reader, value);
+
+	reader->start = value;
+	reader->state = reader->depth ? READER_NEXT : READER_DONE;
+	switch (*value) {
+	case 'n':
+		if (!READER_LEFT(reader, value, 4) || strncmp(value + 1, "ull", 3)) break;
+		reader->cursor = value + 4;
+		return Json_NULL;
+	case 'f':
+		if (!READER_LEFT(reader, value, 5) || strncmp(value + 1, "alse", 4)) break;
+		reader->cursor = value + 5;
+		return Json_False;
+	case 't':
+		if (!READER_LEFT(reader, value, 4) || strncmp(value + 1, "rue", 3)) break;
+		reader->valueInt = 1;
+		reader->cursor = value + 4;
+		return Json_True;
+	case '\"':
+		reader->cursor = read_string(&reader->stringBuffer, &reader->stringCapacity, value, reader->end);
+		if (!reader->cursor) return reader_fail(reader, 0);
+		reader->valueString = reader->stringBuffer;
+		return Json_String;
+	case '[': /* fallthrough */
+	case '{':
+		if (reader->depth == SPINE_JSON_READER_DEPTH) break; /* too deep */
+		reader->depth++;
+		if (*value == '{')
+			reader->objects[(reader->depth - 1) >> 3] |= 1 << ((reader->depth - 1) & 7);
+		else
+			reader->objects[(reader->depth - 1) >> 3] &= ~(1 << ((reader->depth - 1) & 7));
+		reader->state = READER_FIRST;
+		reader->cursor = value + 1;
+		return *value == '{' ? Json_Object : Json_Array;
+	case '-': /* fallthrough */
+	case '0': /* fallthrough */
+	case '1': /* fallthrough */
+	case '2': /* fallthrough */
+	case '3': /* fallthrough */
+	case '4': /* fallthrough */
+	case '5': /* fallthrough */
+	case '6': /* fallthrough */
+	case '7': /* fallthrough */
+	case '8': /* fallthrough */
+	case '9':
+		if (reader->end) {
+			/* parse_float runs until a byte that can't be in a number, a number at the very end has none after it */
+			const char* p = value;
+			while (p != reader->end && ((unsigned)(*p - '0') <= 9 || *p == '.' || *p == '-' || *p == '+'
+				|| (*p | 0x20) == 'e'))
+				p++;
+			if (p == reader->end) {
+				char* copy = reserve(&reader->stringBuffer, &reader->stringCapacity, (size_t)(p - value));
+				if (!copy) return reader_fail(reader, 0);
+				memcpy(copy, value, (size_t)(p - value));
+				copy[p - value] = 0;
+				end = parse_float(copy, &reader->valueFloat, &reader->valueInt);
+				if (end == copy) break;
+				reader->cursor = value + (end - copy);
+				return Json_Number;
+			}
+		}
+		end = parse_float(value, &reader->valueFloat, &reader->valueInt);
+		if (end == value) break;
+		reader->cursor = end;
+		return Json_Number;
+	default:
+		break;
+	}
+	return reader_fail(reader, value);
+}
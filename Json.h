@@ -25,6 +25,8 @@
 #ifndef SPINE_JSON_H_
 #define SPINE_JSON_H_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -59,12 +61,39 @@ typedef struct Json {
 	float valueFloat; /* The item's number, if type==Json_Number */
 
 	const char* name; /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
+	int key; /* The interned id of name, see Json_setKeys. 0 if name isn't one of the keys. */
 } Json;
 
+/* Region allocator for Json trees. Nodes and strings are carved from large blocks and all released at once by
+ * Json_Arena_reset. A reset arena keeps its blocks, so an arena reused across many parses stops growing once warm. */
+typedef struct Json_Arena Json_Arena;
+
+/* blockSize is the size of each block in bytes, 0 for the default. */
+Json_Arena* Json_Arena_create (size_t blockSize);
+void Json_Arena_reset (Json_Arena* arena);
+void Json_Arena_dispose (Json_Arena* arena);
+void* Json_Arena_alloc (Json_Arena* arena, size_t size);
+/* Number of blocks the arena has allocated since it was created. It stops growing once the arena is warm. */
+size_t Json_Arena_blocks (const Json_Arena* arena);
+
+/* Allocator hook for arena blocks. Defaults to malloc and free. Set it before any arena is created. */
+void Json_setAllocator (void* (*alloc) (size_t size), void (*dealloc) (void* ptr));
+
 /* Supply a block of JSON, and this returns a Json object you can interrogate. Call Json_dispose when finished. */
 Json* Json_create (const char* value);
 
-/* Delete a Json entity and all subentities. */
+/* Like Json_create, but the tree is carved from arena. Don't call Json_dispose on it, reset the arena instead. */
+Json* Json_createInArena (Json_Arena* arena, const char* value);
+
+/* Parses value in place: strings without escapes point straight into value, escaped ones are decoded over it. value
+ * must be writable and outlive the tree. With an arena, reset it when done, without one call Json_dispose. */
+Json* Json_createInSitu (Json_Arena* arena, char* value);
+
+/* Returns the end of the value at value, whitespace before it skipped, by matching brackets outside strings. Nothing
+ * is decoded or checked beyond that, so it is many times faster than parsing the value. 0 when the text ends first. */
+const char* Json_skipValue (const char* value);
+
+/* Delete a Json tree returned by Json_create or by Json_createInSitu without an arena. */
 void Json_dispose (Json* json);
 
 /* Get item "string" from object. Case insensitive. */
@@ -73,7 +102,61 @@ const char* Json_getString (Json* json, const char* name, const char* defaultVal
 float Json_getFloat (Json* json, const char* name, float defaultValue);
 int Json_getInt (Json* json, const char* name, int defaultValue);
 
-/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when Json_create() returns 0. 0 when Json_create() succeeds. */
+/* Interns keys: in trees parsed afterwards, an item named keys[i] (case insensitive, like Json_getItem) gets key i + 1,
+ * so hot lookups compare ints instead of strings. keys must stay valid. Call it before parsing, the table is only read
+ * while parsing so threads may share it. */
+void Json_setKeys (const char* const* keys, int count);
+
+/* Get item with the interned key from object. */
+Json* Json_getItemKey (Json* json, int key);
+const char* Json_getStringKey (Json* json, int key, const char* defaultValue);
+float Json_getFloatKey (Json* json, int key, float defaultValue);
+int Json_getIntKey (Json* json, int key, int defaultValue);
+
+#ifndef SPINE_JSON_READER_DEPTH
+/* The deepest nesting Json_Reader accepts. Spine files nest about 8 deep. */
+#define SPINE_JSON_READER_DEPTH 64
+#endif
+
+/* Json_Reader events. A value is reported by its type above, Json_Array and Json_Object open a container. */
+#define Json_EndArray 7
+#define Json_EndObject 8
+#define Json_End 9 /* The root value is complete. */
+#define Json_Error 10 /* Json_getError has the position. Reported again by every later call. */
+
+/* Pull parser: walks the text one event at a time without building a tree, so memory stays flat however large the
+ * input is. The public fields describe the value of the last event and are overwritten by the next one. */
+typedef struct Json_Reader {
+	const char* name; /* The member name if the value is in an object, else 0. */
+	int key; /* The interned id of name, see Json_setKeys. */
+	const char* valueString; /* The value's string, if Json_String */
+	int valueInt; /* As Json's valueInt, 1 for Json_True */
+	float valueFloat;
+	const char* start; /* Where the value begins in the text. */
+	int depth; /* The number of open containers. */
+
+	/* Private. */
+	const char* cursor;
+	const char* end;
+	int state;
+	unsigned char objects[SPINE_JSON_READER_DEPTH / 8]; /* A bit per level, set for objects. */
+	char* nameBuffer;
+	size_t nameCapacity;
+	char* stringBuffer;
+	size_t stringCapacity;
+} Json_Reader;
+
+/* value must stay valid while the reader is used. Call Json_Reader_dispose when finished. */
+void Json_Reader_init (Json_Reader* reader, const char* value);
+/* Like Json_Reader_init, but the text ends at end instead of a NUL, so it needn't be terminated, e.g. a mapped file. */
+void Json_Reader_initRange (Json_Reader* reader, const char* value, const char* end);
+void Json_Reader_dispose (Json_Reader* reader);
+
+/* Returns the next event. */
+int Json_Reader_next (Json_Reader* reader);
+
+/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when Json_create() returns 0. 0 when Json_create() succeeds.
+ * Per thread: it is the last parse of the calling thread. */
 const char* Json_getError (void);
 
 #ifdef __cplusplus
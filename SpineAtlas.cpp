@@ -0,0 +1,697 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#include "SpineAtlas.h"
+#include <stdlib.h>
+#include <string.h>
+#include <tuple>
+#include "SpineWriter.h"
+
+using namespace std;
+
+const unsigned char ATLAS_MAGIC[4] = { 'S', 'A', 'T', 'L' };
+const int ATLAS_VERSION = 1;
+const int ATLAS_SPLIT = 1;
+const int ATLAS_PAD = 2;
+
+const int ATLAS_MALFORMED = -1;
+const int ATLAS_SINK_FAILED = -21;
+
+bool SpineAtlasPage::operator==(const SpineAtlasPage &o) const
+{
+	return tie(name, width, height, format, minFilter, magFilter, uWrap, vWrap) ==
+		tie(o.name, o.width, o.height, o.format, o.minFilter, o.magFilter, o.uWrap, o.vWrap);
+}
+
+bool SpineAtlasRegion::operator==(const SpineAtlasRegion &o) const
+{
+	return tie(name, page, x, y, width, height, originalWidth, originalHeight, offsetX, offsetY, degrees, index) ==
+		tie(o.name, o.page, o.x, o.y, o.width, o.height, o.originalWidth, o.originalHeight, o.offsetX, o.offsetY,
+			o.degrees, o.index) &&
+		hasSplit == o.hasSplit && hasPad == o.hasPad && memcmp(split, o.split, sizeof(split)) == 0 &&
+		memcmp(pad, o.pad, sizeof(pad)) == 0;
+}
+
+bool SpineAtlasData::operator==(const SpineAtlasData &o) const
+{
+	return pages == o.pages && regions == o.regions;
+}
+
+unsigned int spine_atlas_hash(const char *name, size_t length)
+{
+	unsigned int h = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	return h;
+}
+
+int SpineAtlasData::find(const char *name) const
+{
+	size_t length = strlen(name);
+	if (buckets.empty())
+	{
+		for (size_t i = 0; i < regions.size(); ++i)
+		{
+			if (regions[i].name.size() == length && memcmp(regions[i].name.data(), name, length) == 0)
+				return (int)i;
+		}
+		return -1;
+	}
+	size_t mask = buckets.size() - 1;
+	for (size_t i = spine_atlas_hash(name, length) & mask;; i = (i + 1) & mask)
+	{
+		int region = buckets[i];
+		if (region == -1)
+			return -1;
+		const string &regionName = regions[region].name;
+		if (regionName.size() == length && memcmp(regionName.data(), name, length) == 0)
+			return region;
+	}
+}
+
+// The lines of an atlas text, trimmed, with the key and values of a field split out.
+class AtlasLines
+{
+public:
+	AtlasLines(const char *text, size_t len) : p(text), end(text + len) {}
+
+	// false at the end of the text
+	bool next()
+	{
+		if (p >= end)
+			return false;
+		++number;
+		const char *start = p;
+		while (p < end && *p != '\n' && *p != '\r')
+			++p;
+		const char *stop = p;
+		if (p < end && *p++ == '\r' && p < end && *p == '\n')
+			++p;
+		trim(start, stop);
+		line.assign(start, stop);
+
+		const char *colon = (const char *)memchr(start, ':', stop - start);
+		field = colon != nullptr;
+		values.clear();
+		if (field)
+		{
+			const char *keyEnd = colon;
+			trim(start, keyEnd);
+			key.assign(start, keyEnd);
+			for (const char *value = colon + 1;;)
+			{
+				const char *comma = (const char *)memchr(value, ',', stop - value);
+				const char *valueEnd = comma ? comma : stop;
+				trim(value, valueEnd);
+				values.push_back(string(value, valueEnd));
+				if (!comma)
+					break;
+				value = comma + 1;
+			}
+		}
+		return true;
+	}
+
+	int number = 0;
+	string line;
+	bool field = false;
+	string key;
+	vector<string> values;
+
+private:
+	const char *p, *end;
+
+	static void trim(const char *&start, const char *&stop)
+	{
+		while (start < stop && (*start == ' ' || *start == '\t'))
+			++start;
+		while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t'))
+			--stop;
+	}
+};
+
+class AtlasParser
+{
+public:
+	AtlasParser(const char *text, size_t len, SpineAtlasData &out) : lines(text, len), out(out) {}
+
+	bool parse()
+	{
+		bool more = lines.next();
+		while (more && ok)
+		{
+			if (lines.line.empty())
+			{
+				more = lines.next();
+				continue;
+			}
+			if (lines.field)
+				return fail("a field before any page");
+			more = parse_page();
+		}
+		return ok;
+	}
+
+	string error() const { return what + " on line " + to_string(lines.number); }
+
+private:
+	AtlasLines lines;
+	SpineAtlasData &out;
+	bool ok = true;
+	string what;
+
+	bool fail(const string &reason)
+	{
+		if (ok)
+		{
+			what = reason;
+			ok = false;
+		}
+		return false;
+	}
+
+	bool ints(int *values, size_t n)
+	{
+		if (lines.values.size() != n)
+			return fail(lines.key + " needs " + to_string(n) + " values");
+		for (size_t i = 0; i < n; ++i)
+		{
+			const string &value = lines.values[i];
+			char *stop;
+			long v = strtol(value.c_str(), &stop, 10);
+			if (value.empty() || *stop)
+				return fail("not a number in " + lines.key);
+			values[i] = (int)v;
+		}
+		return true;
+	}
+
+	bool named(const string &value, const char *const *names, int count, int first, int &result)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (value == names[i])
+			{
+				result = first + i;
+				return true;
+			}
+		}
+		return fail("unknown " + lines.key + " " + value);
+	}
+
+	// Reads the page at the current line and the regions after it. Returns whether there are lines left.
+	bool parse_page()
+	{
+		static const char *const formats[] = { "Alpha", "Intensity", "LuminanceAlpha", "RGB565", "RGBA4444", "RGB888",
+			"RGBA8888" };
+		static const char *const filters[] = { "Nearest", "Linear", "MipMap", "MipMapNearestNearest",
+			"MipMapLinearNearest", "MipMapNearestLinear", "MipMapLinearLinear" };
+
+		SpineAtlasPage page;
+		page.name = lines.line;
+		page.width = page.height = 0;
+		page.format = SPINE_ATLAS_RGBA8888;
+		page.minFilter = page.magFilter = SPINE_ATLAS_NEAREST;
+		page.uWrap = page.vWrap = SPINE_ATLAS_CLAMP_TO_EDGE;
+		int pageIndex = (int)out.pages.size();
+
+		bool more;
+		while ((more = lines.next()) && lines.field && ok)
+		{
+			const string &key = lines.key;
+			if (key == "size")
+			{
+				int size[2];
+				if (ints(size, 2))
+				{
+					page.width = size[0];
+					page.height = size[1];
+				}
+			}
+			else if (key == "format")
+			{
+				if (lines.values.size() != 1)
+					fail("format needs 1 value");
+				else
+					named(lines.values[0], formats, 7, SPINE_ATLAS_ALPHA, page.format);
+			}
+			else if (key == "filter")
+			{
+				if (lines.values.size() != 2)
+					fail("filter needs 2 values");
+				else if (named(lines.values[0], filters, 7, SPINE_ATLAS_NEAREST, page.minFilter))
+					named(lines.values[1], filters, 7, SPINE_ATLAS_NEAREST, page.magFilter);
+			}
+			else if (key == "repeat")
+			{
+				const string &repeat = lines.values.empty() ? string() : lines.values[0];
+				if (lines.values.size() != 1 || (repeat != "none" && repeat != "x" && repeat != "y" && repeat != "xy"))
+					fail("unknown repeat");
+				page.uWrap = repeat.find('x') != string::npos ? SPINE_ATLAS_REPEAT : SPINE_ATLAS_CLAMP_TO_EDGE;
+				page.vWrap = repeat.find('y') != string::npos ? SPINE_ATLAS_REPEAT : SPINE_ATLAS_CLAMP_TO_EDGE;
+			}
+			else
+				fail("unknown page field " + key);
+		}
+		out.pages.push_back(page);
+
+		while (more && ok && !lines.line.empty())
+		{
+			if (lines.field)
+				return fail("a field before any region");
+			more = parse_region(pageIndex);
+		}
+		return more;
+	}
+
+	bool parse_region(int pageIndex)
+	{
+		SpineAtlasRegion region = SpineAtlasRegion();
+		region.name = lines.line;
+		region.page = pageIndex;
+		region.index = -1;
+		bool hasOrig = false;
+
+		bool more;
+		while ((more = lines.next()) && lines.field && ok)
+		{
+			const string &key = lines.key;
+			int v[4];
+			if (key == "rotate")
+			{
+				const string &rotate = lines.values.empty() ? string() : lines.values[0];
+				if (rotate == "true")
+					region.degrees = 90;
+				else if (rotate == "false")
+					region.degrees = 0;
+				else if (ints(v, 1))
+					region.degrees = v[0];
+			}
+			else if (key == "xy")
+			{
+				if (ints(v, 2))
+				{
+					region.x = v[0];
+					region.y = v[1];
+				}
+			}
+			else if (key == "size")
+			{
+				if (ints(v, 2))
+				{
+					region.width = v[0];
+					region.height = v[1];
+				}
+			}
+			else if (key == "orig")
+			{
+				if (ints(v, 2))
+				{
+					region.originalWidth = v[0];
+					region.originalHeight = v[1];
+					hasOrig = true;
+				}
+			}
+			else if (key == "offset")
+			{
+				if (ints(v, 2))
+				{
+					region.offsetX = v[0];
+					region.offsetY = v[1];
+				}
+			}
+			else if (key == "index")
+			{
+				if (ints(v, 1))
+					region.index = v[0];
+			}
+			else if (key == "split")
+			{
+				region.hasSplit = ints(region.split, 4);
+			}
+			else if (key == "pad")
+			{
+				region.hasPad = ints(region.pad, 4);
+			}
+			else
+				fail("unknown region field " + key);
+		}
+		if (!hasOrig)
+		{
+			region.originalWidth = region.width;
+			region.originalHeight = region.height;
+		}
+		out.regions.push_back(region);
+		return more;
+	}
+};
+
+bool parse_spine_atlas(const char *atlas, size_t len, SpineAtlasData &out, string *error)
+{
+	out = SpineAtlasData();
+	AtlasParser parser(atlas, len, out);
+	if (parser.parse())
+		return true;
+	if (error)
+		*error = parser.error();
+	return false;
+}
+
+class AtlasOutput
+{
+public:
+	vector<unsigned char> bytes;
+
+	void push_byte(unsigned char c) { bytes.push_back(c); }
+
+	void push_varint(int value, int optimizePositive)
+	{
+		unsigned char c[5];
+		bytes.insert(bytes.end(), c, c + encode_varint(c, value, optimizePositive));
+	}
+
+	void push_int(int value)
+	{
+		unsigned char c[4];
+		encode_int(c, value);
+		bytes.insert(bytes.end(), c, c + 4);
+	}
+
+	void push_string(const string &str)
+	{
+		push_varint((int)str.size() + 1, 1);
+		bytes.insert(bytes.end(), str.begin(), str.end());
+	}
+};
+
+// The name index of the regions: the first region of each name, at its hash, probed linearly.
+static vector<int> atlas_buckets(const vector<SpineAtlasRegion> &regions)
+{
+	vector<int> buckets;
+	if (regions.empty())
+		return buckets;
+	size_t capacity = 8;
+	while (capacity < regions.size() * 2)
+		capacity <<= 1;
+	buckets.assign(capacity, -1);
+	size_t mask = capacity - 1;
+	for (size_t r = 0; r < regions.size(); ++r)
+	{
+		const string &name = regions[r].name;
+		for (size_t i = spine_atlas_hash(name.data(), name.size()) & mask;; i = (i + 1) & mask)
+		{
+			if (buckets[i] == -1)
+			{
+				buckets[i] = (int)r;
+				break;
+			}
+			if (regions[buckets[i]].name == name)
+				break;
+		}
+	}
+	return buckets;
+}
+
+static void write_atlas(const SpineAtlasData &atlas, AtlasOutput &o)
+{
+	o.bytes.insert(o.bytes.end(), ATLAS_MAGIC, ATLAS_MAGIC + 4);
+	o.push_varint(ATLAS_VERSION, 1);
+
+	o.push_varint((int)atlas.pages.size(), 1);
+	for (const SpineAtlasPage &page : atlas.pages)
+	{
+		o.push_string(page.name);
+		o.push_varint(page.width, 1);
+		o.push_varint(page.height, 1);
+		o.push_byte(page.format);
+		o.push_byte(page.minFilter);
+		o.push_byte(page.magFilter);
+		o.push_byte(page.uWrap);
+		o.push_byte(page.vWrap);
+	}
+
+	o.push_varint((int)atlas.regions.size(), 1);
+	for (const SpineAtlasRegion &region : atlas.regions)
+	{
+		o.push_string(region.name);
+		o.push_varint(region.page, 1);
+		o.push_varint(region.x, 1);
+		o.push_varint(region.y, 1);
+		o.push_varint(region.width, 1);
+		o.push_varint(region.height, 1);
+		o.push_varint(region.originalWidth, 1);
+		o.push_varint(region.originalHeight, 1);
+		o.push_varint(region.offsetX, 0);
+		o.push_varint(region.offsetY, 0);
+		o.push_varint(region.degrees, 1);
+		o.push_varint(region.index, 0);
+		o.push_byte((region.hasSplit ? ATLAS_SPLIT : 0) | (region.hasPad ? ATLAS_PAD : 0));
+		for (int i = 0; region.hasSplit && i < 4; ++i)
+			o.push_varint(region.split[i], 1);
+		for (int i = 0; region.hasPad && i < 4; ++i)
+			o.push_varint(region.pad[i], 1);
+	}
+
+	vector<int> buckets = atlas_buckets(atlas.regions);
+	o.push_varint((int)buckets.size(), 1);
+	for (int bucket : buckets)
+		o.push_int(bucket);
+}
+
+int convert_atlas_to_binary(const char *atlas, size_t len, SpineSink &sink)
+{
+	SpineAtlasData data;
+	if (!parse_spine_atlas(atlas, len, data))
+		return ATLAS_MALFORMED;
+	AtlasOutput o;
+	write_atlas(data, o);
+	if (!sink.write(o.bytes.data(), o.bytes.size()))
+		return ATLAS_SINK_FAILED;
+	return (int)o.bytes.size();
+}
+
+int convert_atlas_to_binary(const char *atlas, size_t len, unsigned char *outBuff)
+{
+	SpineBufferSink sink(outBuff, (size_t)-1);
+	return convert_atlas_to_binary(atlas, len, sink);
+}
+
+int convert_atlas_to_binary_size(const char *atlas, size_t len)
+{
+	SpineBufferSink sink(0, 0);
+	return convert_atlas_to_binary(atlas, len, sink);
+}
+
+class AtlasInput
+{
+public:
+	AtlasInput(const unsigned char *data, size_t size) : data(data), pos(0), size(size) {}
+
+	bool good() const { return ok; }
+	bool at_end() const { return pos == size; }
+	size_t position() const { return pos; }
+	const char *error() const { return what; }
+
+	void fail(const char *reason)
+	{
+		if (ok)
+		{
+			what = reason;
+			ok = false;
+		}
+	}
+
+	unsigned char read_byte()
+	{
+		if (pos >= size)
+		{
+			fail("cut short");
+			return 0;
+		}
+		return data[pos++];
+	}
+
+	int read_varint(bool optimizePositive)
+	{
+		unsigned int v = 0;
+		for (int i = 0; i < 5; ++i)
+		{
+			unsigned char b = read_byte();
+			v |= (unsigned int)(b & 0x7F) << (i * 7);
+			if (!(b & 0x80))
+				break;
+		}
+		if (!optimizePositive)
+			v = (v >> 1) ^ (0 - (v & 1));
+		return (int)v;
+	}
+
+	// A count of things that take at least min bytes each, so a corrupt count fails here instead of allocating.
+	int read_count(size_t min)
+	{
+		int n = read_varint(true);
+		if (n < 0 || (size_t)n > (size - pos) / min)
+		{
+			fail("count past the end");
+			return 0;
+		}
+		return n;
+	}
+
+	int read_int()
+	{
+		if (size - pos < 4)
+		{
+			fail("cut short");
+			pos = size;
+			return 0;
+		}
+		int v = (int)((unsigned int)data[pos] << 24 | data[pos + 1] << 16 | data[pos + 2] << 8 | data[pos + 3]);
+		pos += 4;
+		return v;
+	}
+
+	void read_string(string &out)
+	{
+		int length = read_varint(true);
+		if (length <= 0 || (size_t)length - 1 > size - pos)
+		{
+			fail(length == 0 ? "null name" : "string past the end");
+			return;
+		}
+		out.assign((const char *)data + pos, length - 1);
+		pos += length - 1;
+	}
+
+	// A byte that must be below limit.
+	int read_enum(int limit, const char *what)
+	{
+		int v = read_byte();
+		if (v >= limit)
+			fail(what);
+		return v;
+	}
+
+private:
+	const unsigned char *data;
+	size_t pos;
+	size_t size;
+	bool ok = true;
+	const char *what = 0;
+};
+
+static void read_atlas(AtlasInput &in, SpineAtlasData &atlas)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		if (in.read_byte() != ATLAS_MAGIC[i])
+			in.fail("not a binary atlas");
+	}
+	if (in.read_varint(true) != ATLAS_VERSION)
+		in.fail("unknown version");
+
+	int pageCount = in.read_count(8);
+	atlas.pages.resize(pageCount);
+	for (int i = 0; i < pageCount && in.good(); ++i)
+	{
+		SpineAtlasPage &page = atlas.pages[i];
+		in.read_string(page.name);
+		page.width = in.read_varint(true);
+		page.height = in.read_varint(true);
+		page.format = in.read_enum(SPINE_ATLAS_RGBA8888 + 1, "unknown format");
+		page.minFilter = in.read_enum(SPINE_ATLAS_MIPMAP_LINEAR_LINEAR + 1, "unknown filter");
+		page.magFilter = in.read_enum(SPINE_ATLAS_MIPMAP_LINEAR_LINEAR + 1, "unknown filter");
+		page.uWrap = in.read_enum(SPINE_ATLAS_REPEAT + 1, "unknown wrap");
+		page.vWrap = in.read_enum(SPINE_ATLAS_REPEAT + 1, "unknown wrap");
+	}
+
+	int regionCount = in.read_count(14);
+	atlas.regions.resize(regionCount);
+	for (int i = 0; i < regionCount && in.good(); ++i)
+	{
+		SpineAtlasRegion &region = atlas.regions[i];
+		in.read_string(region.name);
+		region.page = in.read_varint(true);
+		if (region.page < 0 || region.page >= pageCount)
+			in.fail("page out of range");
+		region.x = in.read_varint(true);
+		region.y = in.read_varint(true);
+		region.width = in.read_varint(true);
+		region.height = in.read_varint(true);
+		region.originalWidth = in.read_varint(true);
+		region.originalHeight = in.read_varint(true);
+		region.offsetX = in.read_varint(false);
+		region.offsetY = in.read_varint(false);
+		region.degrees = in.read_varint(true);
+		region.index = in.read_varint(false);
+		int flags = in.read_enum((ATLAS_SPLIT | ATLAS_PAD) + 1, "unknown flags");
+		region.hasSplit = (flags & ATLAS_SPLIT) != 0;
+		region.hasPad = (flags & ATLAS_PAD) != 0;
+		for (int j = 0; j < 4; ++j)
+			region.split[j] = region.hasSplit ? in.read_varint(true) : 0;
+		for (int j = 0; j < 4; ++j)
+			region.pad[j] = region.hasPad ? in.read_varint(true) : 0;
+	}
+
+	int bucketCount = in.read_count(4);
+	if (in.good() && (bucketCount & (bucketCount - 1)) != 0)
+		in.fail("bucket count not a power of two");
+	if (in.good() && regionCount > 0 && bucketCount <= regionCount)
+		in.fail("too few buckets");
+	atlas.buckets.resize(bucketCount);
+	for (int i = 0; i < bucketCount && in.good(); ++i)
+	{
+		atlas.buckets[i] = in.read_int();
+		if (atlas.buckets[i] < -1 || atlas.buckets[i] >= regionCount)
+			in.fail("bucket out of range");
+	}
+
+	// a probe must end, and every name must lead to a region of that name at or before its own, which makes it the
+	// first of the name
+	bool open = false;
+	for (int bucket : atlas.buckets)
+		open = open || bucket == -1;
+	if (in.good() && bucketCount > 0 && !open)
+		in.fail("no empty bucket");
+	for (int i = 0; i < regionCount && in.good(); ++i)
+	{
+		int found = atlas.find(atlas.regions[i].name.c_str());
+		if (found == -1 || found > i || atlas.regions[found].name != atlas.regions[i].name)
+			in.fail("name index doesn't match the regions");
+	}
+}
+
+bool read_spine_atlas_binary(const unsigned char *data, size_t size, SpineAtlasData &out, string *error)
+{
+	out = SpineAtlasData();
+	AtlasInput in(data, size);
+	read_atlas(in, out);
+	if (in.good() && !in.at_end())
+		in.fail("bytes after the name index");
+	if (!in.good())
+	{
+		out = SpineAtlasData();
+		if (error)
+			*error = string(in.error()) + " at byte " + to_string(in.position());
+	}
+	return in.good();
+}
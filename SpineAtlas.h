@@ -0,0 +1,130 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_ATLAS_H__
+#define __SPINE_ATLAS_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+
+// The atlas text as a binary, so a loader reads its pages and regions without parsing lines. Big endian like the
+// skeleton binary, strings and varints encoded the same way:
+//   "SATL", varint version 1
+//   varint page count, per page: name, varint width, height, byte format, min filter, mag filter, u wrap, v wrap
+//   varint region count, per region: name, varint page, x, y, width, height, original width, original height,
+//     zigzag varint offset x, offset y, varint degrees, zigzag varint index, byte flags (1 split, 2 pad), then
+//     4 varints of split and 4 of pad when flagged
+//   varint bucket count, a power of two or 0 without regions, then each bucket as a 4 byte int: a region or -1
+// The buckets are an open addressing table of the region names, hashed with spine_atlas_hash and probed linearly. It
+// holds the first region of each name, which is the one the runtimes' findRegion returns, so a loader can look names
+// up in place without building a map.
+
+// The values of spine-c's spAtlasFormat, spAtlasFilter and spAtlasWrap.
+enum SpineAtlasFormat
+{
+	SPINE_ATLAS_ALPHA = 1,
+	SPINE_ATLAS_INTENSITY,
+	SPINE_ATLAS_LUMINANCE_ALPHA,
+	SPINE_ATLAS_RGB565,
+	SPINE_ATLAS_RGBA4444,
+	SPINE_ATLAS_RGB888,
+	SPINE_ATLAS_RGBA8888
+};
+
+enum SpineAtlasFilter
+{
+	SPINE_ATLAS_NEAREST = 1,
+	SPINE_ATLAS_LINEAR,
+	SPINE_ATLAS_MIPMAP,
+	SPINE_ATLAS_MIPMAP_NEAREST_NEAREST,
+	SPINE_ATLAS_MIPMAP_LINEAR_NEAREST,
+	SPINE_ATLAS_MIPMAP_NEAREST_LINEAR,
+	SPINE_ATLAS_MIPMAP_LINEAR_LINEAR
+};
+
+enum SpineAtlasWrap
+{
+	SPINE_ATLAS_MIRRORED_REPEAT,
+	SPINE_ATLAS_CLAMP_TO_EDGE,
+	SPINE_ATLAS_REPEAT
+};
+
+struct SpineAtlasPage
+{
+	std::string name;
+	int width, height;
+	int format;
+	int minFilter, magFilter;
+	int uWrap, vWrap;
+
+	bool operator==(const SpineAtlasPage &o) const;
+};
+
+struct SpineAtlasRegion
+{
+	std::string name;
+	int page;
+	int x, y, width, height;
+	int originalWidth, originalHeight; // the size when orig is missing
+	int offsetX, offsetY;
+	int degrees; // rotate: true is 90
+	int index; // -1 when the region isn't part of a sequence
+	bool hasSplit, hasPad;
+	int split[4], pad[4];
+
+	bool operator==(const SpineAtlasRegion &o) const;
+};
+
+struct SpineAtlasData
+{
+	std::vector<SpineAtlasPage> pages;
+	std::vector<SpineAtlasRegion> regions;
+	std::vector<int> buckets; // the name index of a binary atlas, empty for one parsed from text
+
+	// The first region named name, -1 if there is none. Uses the buckets when there are any.
+	int find(const char *name) const;
+
+	// Same pages and regions. The buckets aren't compared.
+	bool operator==(const SpineAtlasData &o) const;
+};
+
+// FNV-1a, 32 bits, over the bytes of the name.
+unsigned int spine_atlas_hash(const char *name, size_t length);
+
+// Parses the atlas text: page blocks separated by blank lines, each the page name, its fields, then its regions with
+// their indented fields. Missing fields take the runtimes' defaults. Returns false on a field it doesn't know or a
+// malformed value, error then tells which line.
+bool parse_spine_atlas(const char *atlas, size_t len, SpineAtlasData &out, std::string *error = 0);
+
+// Reads a binary atlas. Returns false when it is malformed: cut short, a value out of range, a name index that doesn't
+// find its regions or bytes left over at the end.
+bool read_spine_atlas_binary(const unsigned char *data, size_t size, SpineAtlasData &out, std::string *error = 0);
+
+// Converts atlas text to the binary above. Returns the output size, -1 when the text is malformed, -21 when the sink
+// refuses a write. outBuff must hold the whole output, convert_atlas_to_binary_size tells how much that is.
+int convert_atlas_to_binary(const char *atlas, size_t len, unsigned char *outBuff);
+int convert_atlas_to_binary(const char *atlas, size_t len, SpineSink &sink);
+int convert_atlas_to_binary_size(const char *atlas, size_t len);
+
+#endif
@@ -0,0 +1,377 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#include "SpineCache.h"
+#include "SpineHash.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace std;
+
+// An entry file:
+//   "SCCH", 4 byte CACHE_FORMAT
+//   8 byte key hash, json size, output size, output checksum
+//   4 byte skeleton hash length, the skeleton hash
+//   the output
+// Numbers are big endian.
+const unsigned char CACHE_MAGIC[4] = { 'S', 'C', 'C', 'H' };
+const size_t CACHE_HEADER = 4 + 4 + 4 * 8 + 4;
+const size_t CACHE_MAX_SKELETON_HASH = 256;
+
+// The converter's format. Bump it with any change that changes the converter's output, so entries written before
+// aren't used.
+const uint32_t CACHE_FORMAT = 1;
+
+// A temporary file older than this was left by a writer that died.
+const time_t CACHE_STALE_SECONDS = 60 * 60;
+
+// The skeleton's "hash" from the head of the text, where Spine writes it. Empty when it isn't there.
+static string skeleton_hash(const char *json, size_t len)
+{
+	static const char key[] = "\"hash\"";
+	const char *end = json + (len < 512 ? len : 512);
+	const char *p = search(json, end, key, key + sizeof(key) - 1);
+	if (p == end)
+		return "";
+	for (p += sizeof(key) - 1; p < end && (*p == ':' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'); ++p)
+		;
+	if (p == end || *p != '"')
+		return "";
+	const char *q = find(++p, end, '"');
+	if (q == end || (size_t)(q - p) > CACHE_MAX_SKELETON_HASH)
+		return "";
+	return string(p, q);
+}
+
+static void put32(unsigned char *out, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+		out[i] = (unsigned char)(v >> (24 - 8 * i));
+}
+
+static void put64(unsigned char *out, uint64_t v)
+{
+	for (int i = 0; i < 8; ++i)
+		out[i] = (unsigned char)(v >> (56 - 8 * i));
+}
+
+static uint32_t get32(const unsigned char *in)
+{
+	uint32_t v = 0;
+	for (int i = 0; i < 4; ++i)
+		v = v << 8 | in[i];
+	return v;
+}
+
+static uint64_t get64(const unsigned char *in)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < 8; ++i)
+		v = v << 8 | in[i];
+	return v;
+}
+
+static bool ends_with(const string &str, const char *suffix)
+{
+	size_t n = strlen(suffix);
+	return str.size() >= n && str.compare(str.size() - n, n, suffix) == 0;
+}
+
+// A file of the cache directory, an entry or a writer's temporary file.
+struct CacheFile
+{
+	string path;
+	size_t size;
+	time_t time; // last modified, a hit touches its entry
+	bool temporary;
+};
+
+static bool make_directory(const string &dir)
+{
+#ifdef _WIN32
+	_mkdir(dir.c_str());
+	DWORD attributes = GetFileAttributesA(dir.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	mkdir(dir.c_str(), 0777);
+	struct stat st;
+	return stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+static void list_files(const string &dir, vector<CacheFile> &files)
+{
+	files.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &entry);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		string name = entry.cFileName;
+		bool temporary = ends_with(name, ".tmp");
+		if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || (!temporary && !ends_with(name, ".skel")))
+			continue;
+		// FILETIME counts 100 ns ticks since 1601
+		uint64_t ticks = (uint64_t)entry.ftLastWriteTime.dwHighDateTime << 32 | entry.ftLastWriteTime.dwLowDateTime;
+		CacheFile file = { dir + "/" + name, (size_t)((uint64_t)entry.nFileSizeHigh << 32 | entry.nFileSizeLow),
+			(time_t)(ticks / 10000000 - 11644473600ULL), temporary };
+		files.push_back(file);
+	} while (FindNextFileA(find, &entry));
+	FindClose(find);
+#else
+	DIR *d = opendir(dir.c_str());
+	if (!d)
+		return;
+	while (dirent *entry = readdir(d))
+	{
+		string name = entry->d_name;
+		bool temporary = ends_with(name, ".tmp");
+		if (!temporary && !ends_with(name, ".skel"))
+			continue;
+		string path = dir + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+			continue;
+		CacheFile file = { path, (size_t)st.st_size, st.st_mtime, temporary };
+		files.push_back(file);
+	}
+	closedir(d);
+#endif
+}
+
+// Renames from to to, replacing to if it exists.
+static bool replace_file(const string &from, const string &to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+static void touch_file(const string &path)
+{
+#ifdef _WIN32
+	_utime(path.c_str(), 0);
+#else
+	utime(path.c_str(), 0);
+#endif
+}
+
+static unsigned long process_id()
+{
+#ifdef _WIN32
+	return (unsigned long)_getpid();
+#else
+	return (unsigned long)getpid();
+#endif
+}
+
+struct SpineCache::Key
+{
+	uint64_t hash;
+	uint64_t jsonSize;
+	string skeletonHash;
+};
+
+SpineCache::SpineCache(const string &dir, size_t maxBytes) : dir(dir), maxBytes(maxBytes), usable(false),
+	totalBytes(0), hitCount(0), missCount(0), storeCount(0), evictionCount(0)
+{
+	usable = !dir.empty() && make_directory(dir);
+	if (usable && maxBytes)
+		evict();
+}
+
+SpineCache::Key SpineCache::make_key(const char *json, size_t len, const char *atlas, uint64_t options) const
+{
+	uint64_t parts[4] = { spine_hash(json, len, 0), atlas ? spine_hash(atlas, strlen(atlas), 1) : 0, options,
+		CACHE_FORMAT };
+	Key key;
+	key.hash = spine_hash(parts, sizeof(parts), 2);
+	key.jsonSize = len;
+	key.skeletonHash = skeleton_hash(json, len);
+	return key;
+}
+
+string SpineCache::entry_path(const Key &key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.skel", (unsigned long long)key.hash);
+	return dir + "/" + name;
+}
+
+int SpineCache::convert(SpineConverter &converter, const char *json, size_t len, const char *atlas,
+	vector<unsigned char> &out)
+{
+	Key key = make_key(json, len, atlas, converter.output_options());
+	if (load(key, out))
+		return (int)out.size();
+
+	converter.set_atlas(atlas);
+	out.clear();
+	SpineVectorSink sink(out);
+	int rt = converter.convert(json, len, sink);
+	if (rt >= 0)
+		store(key, out.data(), out.size());
+	return rt;
+}
+
+bool SpineCache::load(const char *json, size_t len, const char *atlas, uint64_t options, vector<unsigned char> &out)
+{
+	return load(make_key(json, len, atlas, options), out);
+}
+
+bool SpineCache::store(const char *json, size_t len, const char *atlas, uint64_t options, const unsigned char *data,
+	size_t size)
+{
+	return store(make_key(json, len, atlas, options), data, size);
+}
+
+bool SpineCache::load(const Key &key, vector<unsigned char> &out)
+{
+	string path = entry_path(key);
+	FILE *f = usable ? fopen(path.c_str(), "rb") : 0;
+	if (!f)
+	{
+		++missCount;
+		return false;
+	}
+
+	// the header first, the output is only read when the entry is this json's
+	unsigned char header[CACHE_HEADER];
+	bool ok = fread(header, 1, CACHE_HEADER, f) == CACHE_HEADER && memcmp(header, CACHE_MAGIC, 4) == 0 &&
+		get32(header + 4) == CACHE_FORMAT && get64(header + 8) == key.hash && get64(header + 16) == key.jsonSize &&
+		get32(header + 40) == key.skeletonHash.size();
+	uint64_t size = ok ? get64(header + 24) : 0;
+	char skeletonHash[CACHE_MAX_SKELETON_HASH];
+	ok = ok && size <= 0x7fffffff && fread(skeletonHash, 1, key.skeletonHash.size(), f) == key.skeletonHash.size() &&
+		key.skeletonHash.compare(0, string::npos, skeletonHash, key.skeletonHash.size()) == 0;
+	if (ok)
+	{
+		out.resize((size_t)size);
+		ok = fread(out.data(), 1, out.size(), f) == out.size() && fgetc(f) == EOF &&
+			spine_hash(out.data(), out.size(), 3) == get64(header + 32);
+	}
+	fclose(f);
+
+	if (!ok)
+	{
+		out.clear();
+		++missCount;
+		return false;
+	}
+	touch_file(path);
+	++hitCount;
+	return true;
+}
+
+bool SpineCache::store(const Key &key, const unsigned char *data, size_t size)
+{
+	if (!usable)
+		return false;
+	static atomic<unsigned> temporaries(0);
+	string path = entry_path(key);
+	char suffix[64];
+	snprintf(suffix, sizeof(suffix), ".%lu.%u.tmp", process_id(), temporaries++);
+	string temporary = path + suffix;
+
+	unsigned char header[CACHE_HEADER];
+	memcpy(header, CACHE_MAGIC, 4);
+	put32(header + 4, CACHE_FORMAT);
+	put64(header + 8, key.hash);
+	put64(header + 16, key.jsonSize);
+	put64(header + 24, size);
+	put64(header + 32, spine_hash(data, size, 3));
+	put32(header + 40, (uint32_t)key.skeletonHash.size());
+
+	FILE *f = fopen(temporary.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(header, 1, CACHE_HEADER, f) == CACHE_HEADER &&
+		fwrite(key.skeletonHash.data(), 1, key.skeletonHash.size(), f) == key.skeletonHash.size() &&
+		fwrite(data, 1, size, f) == size;
+	ok = fclose(f) == 0 && ok;
+	if (!ok || !replace_file(temporary, path))
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+
+	++storeCount;
+	if (maxBytes && (totalBytes += CACHE_HEADER + key.skeletonHash.size() + size) > maxBytes)
+		evict();
+	return true;
+}
+
+void SpineCache::evict()
+{
+	if (!usable)
+		return;
+	lock_guard<mutex> guard(evicting);
+	vector<CacheFile> files;
+	list_files(dir, files);
+
+	time_t now = time(0);
+	vector<CacheFile> entries;
+	size_t total = 0;
+	for (const CacheFile &file : files)
+	{
+		if (file.temporary)
+		{
+			if (now - file.time > CACHE_STALE_SECONDS)
+				remove(file.path.c_str());
+			continue;
+		}
+		entries.push_back(file);
+		total += file.size;
+	}
+
+	// down to three quarters of the bound, so the directory isn't scanned again on the next store
+	if (maxBytes && total > maxBytes)
+	{
+		sort(entries.begin(), entries.end(), [](const CacheFile &a, const CacheFile &b) { return a.time < b.time; });
+		size_t target = maxBytes / 4 * 3;
+		for (size_t i = 0; i < entries.size() && total > target; ++i)
+		{
+			// another process may have removed it already, it is gone either way
+			if (remove(entries[i].path.c_str()) == 0)
+				++evictionCount;
+			total -= entries[i].size;
+		}
+	}
+	totalBytes = total;
+}
@@ -0,0 +1,92 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_CACHE_H__
+#define __SPINE_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+
+// A cache of conversions on disk, so a build only converts the skeletons that changed. Each output is a file of the
+// directory named by a 64 bit hash of everything it depends on: the json, the atlas, the converter's output options
+// and the converter's format. A file holds the json's size and its skeleton hash too, which are compared before the
+// output is read, and a checksum of the output, so a hash collision, a damaged file or a file that isn't an entry is
+// a miss, never a wrong output.
+//
+// Entries are written to a temporary file and renamed into place, so a reader sees a whole entry or none. Any number
+// of threads and processes may share a directory: writers of one key write the same bytes and the last rename wins.
+// With a size bound, the entries least recently used go first. A hit touches its file, the file times are what every
+// process sharing the directory goes by.
+class SpineCache
+{
+public:
+	// dir is made if missing, its parent must exist. maxBytes bounds the entries' total size, 0 for no bound.
+	explicit SpineCache(const std::string &dir, size_t maxBytes = 0);
+	SpineCache(const SpineCache &) = delete;
+	SpineCache &operator=(const SpineCache &) = delete;
+
+	// false when the directory can't be made, every lookup is then a miss and nothing is stored.
+	bool ok() const { return usable; }
+
+	// Like converter.convert into out, but a hit returns the stored output without parsing the json or the atlas.
+	// atlas is the converter's atlas, 0 for none, it is set on the converter before a conversion. Errors aren't
+	// cached. A failed store only costs the next build a conversion, it isn't an error.
+	int convert(SpineConverter &converter, const char *json, size_t len, const char *atlas,
+		std::vector<unsigned char> &out);
+
+	// The output stored for json with atlas and options, see SpineConverter::output_options. false on a miss.
+	bool load(const char *json, size_t len, const char *atlas, uint64_t options, std::vector<unsigned char> &out);
+
+	// Stores the output of json with atlas and options, false when it couldn't be written.
+	bool store(const char *json, size_t len, const char *atlas, uint64_t options, const unsigned char *data,
+		size_t size);
+
+	// Removes the entries least recently used until the rest fit in three quarters of maxBytes, and the temporary
+	// files of writers that died. Stores call it once the entries outgrow the bound.
+	void evict();
+
+	size_t hits() const { return hitCount; }
+	size_t misses() const { return missCount; }
+	size_t stores() const { return storeCount; }
+	size_t evictions() const { return evictionCount; } // entries removed
+
+private:
+	struct Key;
+	Key make_key(const char *json, size_t len, const char *atlas, uint64_t options) const;
+	bool load(const Key &key, std::vector<unsigned char> &out);
+	bool store(const Key &key, const unsigned char *data, size_t size);
+	std::string entry_path(const Key &key) const;
+
+	std::string dir;
+	size_t maxBytes;
+	bool usable;
+	std::atomic<size_t> totalBytes; // of the entries, as of the last scan plus the stores since
+	std::atomic<size_t> hitCount, missCount, storeCount, evictionCount;
+	std::mutex evicting;
+};
+
+#endif
@@ -21,12 +21,21 @@ SOFTWARE.
 ****************************************************************************/
 
 #include "SpineExporter.h"
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
 #include "Json.h"
-#include <iostream>
+#include "SpineHash.h"
+#include "SpineWriter.h"
+#include <chrono>
 #include <map>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -77,59 +86,481 @@ const int PATH_ROTATE_TANGENT = 0;
 const int PATH_ROTATE_CHAIN = 1;
 const int PATH_ROTATE_CHAIN_SCALE = 2;
 
-static unsigned char *buff_data = nullptr;
-static unsigned int buff_pos = 0;
+// Keys the encoders look up. The parser interns them, so Json_get*Key compares ints instead of strings.
+// Ids are positions in JSON_KEYS plus one.
+enum JsonKey
+{
+	KEY_ANGLE = 1,
+	KEY_ANIMATIONS,
+	KEY_ATTACHMENT,
+	KEY_BEND_POSITIVE,
+	KEY_BLEND,
+	KEY_BONE,
+	KEY_BONES,
+	KEY_CLOSED,
+	KEY_COLOR,
+	KEY_CONSTANT_SPEED,
+	KEY_CURVE,
+	KEY_DARK,
+	KEY_DEFORM,
+	KEY_DRAW_ORDER,
+	KEY_END,
+	KEY_EVENTS,
+	KEY_FLOAT,
+	KEY_HASH,
+	KEY_HEIGHT,
+	KEY_HULL,
+	KEY_IK,
+	KEY_INT,
+	KEY_LENGTH,
+	KEY_LENGTHS,
+	KEY_LIGHT,
+	KEY_LOCAL,
+	KEY_MIX,
+	KEY_NAME,
+	KEY_OFFSET,
+	KEY_OFFSETS,
+	KEY_ORDER,
+	KEY_PARENT,
+	KEY_PATH,
+	KEY_PATHS,
+	KEY_POSITION,
+	KEY_POSITION_MODE,
+	KEY_RELATIVE,
+	KEY_ROTATE_MIX,
+	KEY_ROTATE_MODE,
+	KEY_ROTATION,
+	KEY_SCALE_MIX,
+	KEY_SCALE_X,
+	KEY_SCALE_Y,
+	KEY_SHEAR_MIX,
+	KEY_SHEAR_X,
+	KEY_SHEAR_Y,
+	KEY_SKELETON,
+	KEY_SKIN,
+	KEY_SKINS,
+	KEY_SLOT,
+	KEY_SLOTS,
+	KEY_SPACING,
+	KEY_SPACING_MODE,
+	KEY_SPINE,
+	KEY_STRING,
+	KEY_TARGET,
+	KEY_TIME,
+	KEY_TRANSFORM,
+	KEY_TRANSLATE_MIX,
+	KEY_TRIANGLES,
+	KEY_TYPE,
+	KEY_UVS,
+	KEY_VERTEX_COUNT,
+	KEY_VERTICES,
+	KEY_WIDTH,
+	KEY_X,
+	KEY_Y,
+};
+
+static const char *const JSON_KEYS[] =
+{
+	"angle", "animations", "attachment", "bendPositive", "blend", "bone", "bones", "closed", "color",
+	"constantSpeed", "curve", "dark", "deform", "drawOrder", "end", "events", "float", "hash",
+	"height", "hull", "ik", "int", "length", "lengths", "light", "local", "mix", "name", "offset",
+	"offsets", "order", "parent", "path", "paths", "position", "positionMode", "relative",
+	"rotateMix", "rotateMode", "rotation", "scaleMix", "scaleX", "scaleY", "shearMix", "shearX",
+	"shearY", "skeleton", "skin", "skins", "slot", "slots", "spacing", "spacingMode", "spine",
+	"string", "target", "time", "transform", "translateMix", "triangles", "type", "uvs",
+	"vertexCount", "vertices", "width", "x", "y"
+};
+
+// Names in document order with a hashed index. find gives the first index of a name, as a scan from the front would,
+// -1 when it isn't there.
+class NameTable
+{
+public:
+	void add(const string &name)
+	{
+		index.emplace(name, (int)names.size()); // keeps the first of duplicates
+		names.push_back(name);
+	}
+
+	int find(const string &name) const
+	{
+		auto it = index.find(name);
+		return it == index.end() ? -1 : it->second;
+	}
+
+	const string &name(int index) const { return names[index]; }
+	size_t size() const { return names.size(); }
+	bool empty() const { return names.empty(); }
+
+	void clear()
+	{
+		names.clear();
+		index.clear();
+	}
+
+private:
+	vector<string> names;
+	unordered_map<string, int> index;
+};
+
+// The region names of an atlas. The text is copied once and the names are views into the copy, indexed by an open
+// addressing hash table, so neither parsing nor a lookup allocates per name.
+class AtlasIndex
+{
+public:
+	// Replaces the index with the regions of the len bytes of atlas. Page names and the fields of pages and regions
+	// aren't regions.
+	void parse(const char *atlas, size_t len)
+	{
+		clear();
+		text.assign(atlas, atlas + len);
+
+		vector<AtlasName> found;
+		bool pageNext = true; // the first line of the text and of every block after a blank line names a page
+		const char *p = text.data(), *end = p + text.size();
+		while (p < end)
+		{
+			const char *line = p;
+			while (p < end && *p != '\n' && *p != '\r')
+				++p;
+			const char *lineEnd = p;
+			if (p < end && *p++ == '\r' && p < end && *p == '\n')
+				++p;
+
+			// trimmed like the runtimes do
+			while (line < lineEnd && (*line == ' ' || *line == '\t'))
+				++line;
+			while (lineEnd > line && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+				--lineEnd;
+			if (line == lineEnd)
+			{
+				pageNext = true;
+				continue;
+			}
+			if (memchr(line, ':', lineEnd - line))
+				continue;
+			if (pageNext)
+				pageNext = false;
+			else
+				found.push_back(AtlasName{ line, (size_t)(lineEnd - line) });
+		}
+
+		size_t capacity = 16;
+		while (capacity < found.size() * 2)
+			capacity <<= 1;
+		slots.assign(capacity, AtlasName{ nullptr, 0 });
+		for (const AtlasName &name : found)
+		{
+			size_t i = slot_of(name.data, name.size);
+			if (!slots[i].data)
+			{
+				slots[i] = name;
+				++count;
+			}
+		}
+	}
+
+	bool contains(const char *name) const
+	{
+		if (!count)
+			return false;
+		return slots[slot_of(name, strlen(name))].data != nullptr;
+	}
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+
+	void clear()
+	{
+		text.clear();
+		slots.clear();
+		count = 0;
+	}
+
+private:
+	struct AtlasName
+	{
+		const char *data;
+		size_t size;
+	};
+
+	static size_t hash(const char *data, size_t size)
+	{
+		uint64_t h = 14695981039346656037ull; // FNV-1a
+		for (size_t i = 0; i < size; ++i)
+			h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+		return (size_t)(h ^ (h >> 32));
+	}
+
+	// The slot holding the name, or the empty one where it would go.
+	size_t slot_of(const char *data, size_t size) const
+	{
+		size_t mask = slots.size() - 1;
+		for (size_t i = hash(data, size) & mask;; i = (i + 1) & mask)
+		{
+			const AtlasName &slot = slots[i];
+			if (!slot.data || (slot.size == size && memcmp(slot.data, data, size) == 0))
+				return i;
+		}
+	}
+
+	vector<char> text;
+	vector<AtlasName> slots; // a power of two, at most half full
+	size_t count = 0;
+};
+
+// The strings of a string table output, each given an id when first pushed.
+struct StringPool
+{
+	NameTable names;
+
+	// -1 for a null string
+	int intern(const char *str)
+	{
+		if (!str)
+			return -1;
+		int id = names.find(str);
+		if (id == -1)
+		{
+			id = (int)names.size();
+			names.add(str);
+		}
+		return id;
+	}
+};
+
+// A value written into an output when it is copied out: a count only known after its list has been read, or in string
+// table mode a string, whose table index is only known once the whole output is.
+struct OutputHole
+{
+	size_t pos;
+	int value; // the count, or the string's id in its StringPool
+	bool string;
+};
 
-static set<string> all_atlas;
+const int SINK_CHUNK = 64 * 1024;
+const int SINK_FAILED = -21;
+
+// The first byte of a string table output. A plain output starts with the skeleton hash, never a null string.
+const unsigned char STRING_TABLE_MARKER = 0;
+
+struct ChunkSources;
+
+// Everything a conversion changes. Each SpineConverter owns one.
+struct SpineConverterState
+{
+	// The output window. Raw output has no capacity limit, sink output goes through a staging window that is handed
+	// to the sink whenever it fills up.
+	unsigned char *data = nullptr;
+	size_t pos = 0;
+	size_t cap = 0;
+	SpineSink *sink = nullptr;
+	size_t flushed = 0; // bytes handed to the sink
+	bool failed = false; // the sink refused a write
+	vector<unsigned char> staging;
+
+	AtlasIndex atlas; // region names, empty when there is no atlas
+	uint64_t atlasHash = 0; // of its text, 0 without one
+	const AtlasIndex *regions = &atlas; // the atlas in use, a worker's points at its converter's
+	Json_Arena *arena = nullptr;
+	bool ownArena = false;
+	int threads = 1; // for the skins and animations of a skeleton
+	bool stringTable = false;
+	SpineDecimation tolerances;
+	const SpineDecimation *decimation = nullptr; // the tolerances when decimating
+	SpineStripping keepLists;
+	const SpineStripping *stripping = nullptr; // the keep lists when stripping
+	int vertexCache = 0; // the cache size meshes are optimized for, 0 for none
+	SpineInfluences influenceLimits;
+	const SpineInfluences *influences = nullptr; // the limits when limiting
+
+	// In string table mode strings aren't written, push_string interns them and leaves a hole in the output.
+	StringPool *strings = nullptr;
+	vector<OutputHole> *stringHoles = nullptr;
+
+	// json arrays are gathered here before a bulk push
+	vector<float> floats;
+	vector<int> ints;
+
+	SpineConverterStats *stats = nullptr;
+	SpineTimelineCount *timelines = nullptr; // where parse_animation counts, with stats
+
+	SpineChunksData *chunks = nullptr; // incremental conversion
+	ChunkSources *sources = nullptr; // the parts the running incremental conversion left out of its parse
+};
+
+// The conversion running on this thread, the encoders below write to it.
+static thread_local SpineConverterState *current = nullptr;
+
+// Makes state the running conversion of this thread for a scope. The previous one comes back after, so a sink may run
+// a conversion of its own.
+class ScopedState
+{
+public:
+	explicit ScopedState(SpineConverterState *state) : previous(current) { current = state; }
+	~ScopedState() { current = previous; }
+
+private:
+	SpineConverterState *previous;
+};
+
+static void set_output(SpineConverterState &out, unsigned char *data, size_t capacity, SpineSink *sink)
+{
+	out.data = data;
+	out.pos = 0;
+	out.cap = capacity;
+	out.sink = sink;
+	out.flushed = 0;
+	out.failed = false;
+}
+
+static void flush_output(SpineConverterState &out)
+{
+	if (out.sink && out.pos > 0 && !out.failed)
+		out.failed = !out.sink->write(out.data, out.pos);
+	out.flushed += out.pos;
+	out.pos = 0;
+}
+
+// Makes room for n bytes, at most 8.
+static inline void reserve_output(SpineConverterState &out, size_t n)
+{
+	if (out.cap - out.pos < n)
+		flush_output(out);
+}
+
+static size_t output_size()
+{
+	return current->flushed + current->pos;
+}
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Charges the time and output since its last charge to a section of the conversion's stats, if it keeps any.
+class SectionClock
+{
+public:
+	explicit SectionClock(SpineConverterStats *stats) : stats(stats) { skip(); }
+
+	void charge(int section)
+	{
+		if (!stats)
+			return;
+		stats->sectionSeconds[section] += seconds_since(start);
+		stats->sectionBytes[section] += output_size() - bytes;
+		skip();
+	}
+
+	// Starts over without charging, for work charged otherwise.
+	void skip()
+	{
+		if (!stats)
+			return;
+		start = chrono::steady_clock::now();
+		bytes = output_size();
+	}
+
+private:
+	SpineConverterStats *stats;
+	chrono::steady_clock::time_point start;
+	size_t bytes = 0;
+};
 
 static void push_byte(unsigned char c)
 {
-	buff_data[buff_pos++] = c;
+	SpineConverterState &out = *current;
+	reserve_output(out, 1);
+	out.data[out.pos++] = c;
 }
 
 static void push_float(float v)
 {
-	unsigned char cTemp[4];
-	memcpy(cTemp, &v, 4);
+	SpineConverterState &out = *current;
+	reserve_output(out, 4);
+	encode_float(out.data + out.pos, v);
+	out.pos += 4;
+}
+
+// Writes n floats, as many at a time as the output window takes.
+static void push_floats(const float *v, size_t n)
+{
+	SpineConverterState &out = *current;
+	while (n > 0)
+	{
+		reserve_output(out, 4);
+		size_t room = (out.cap - out.pos) / 4;
+		size_t k = n < room ? n : room;
+		encode_floats(out.data + out.pos, v, k);
+		out.pos += 4 * k;
+		v += k;
+		n -= k;
+	}
+}
 
-	push_byte(cTemp[3]);
-	push_byte(cTemp[2]);
-	push_byte(cTemp[1]);
-	push_byte(cTemp[0]);
+// Writes n values as big endian shorts.
+static void push_shorts(const int *v, size_t n)
+{
+	SpineConverterState &out = *current;
+	while (n > 0)
+	{
+		reserve_output(out, 2);
+		size_t room = (out.cap - out.pos) / 2;
+		size_t k = n < room ? n : room;
+		encode_shorts(out.data + out.pos, v, k);
+		out.pos += 2 * k;
+		v += k;
+		n -= k;
+	}
 }
 
 static void push_varint(int value, int optimizePositive)
 {
-	unsigned int v = value;
-	if (!optimizePositive)
-		v = (unsigned int)((value << 1) ^ (value >> 31));
+	SpineConverterState &out = *current;
+	reserve_output(out, 8);
+	// a sink's staging window is ours to scribble past the varint, a caller's buffer may end right after it
+	if (out.sink)
+		out.pos += encode_varint_wide(out.data + out.pos, value, optimizePositive);
+	else
+		out.pos += encode_varint(out.data + out.pos, value, optimizePositive);
+}
 
-	for (int i = 0; i < 5; ++i)
+static void push_bytes(const unsigned char *data, size_t size)
+{
+	SpineConverterState &out = *current;
+	while (size > 0)
 	{
-		buff_data[buff_pos++] = (v >> i * 7) & 0x7F;
-		if (v >> (i + 1) * 7)
-			buff_data[buff_pos - 1] |= 0x80;
-		else
-			break;
+		reserve_output(out, 1);
+		size_t n = size < out.cap - out.pos ? size : out.cap - out.pos;
+		memcpy(out.data + out.pos, data, n);
+		out.pos += n;
+		data += n;
+		size -= n;
 	}
 }
 
 static void push_boolen(unsigned char v)
 {
-	buff_data[buff_pos++] = v;
+	push_byte(v);
 }
 
 static void push_string(const char *str)
 {
+	if (current->strings)
+	{
+		current->stringHoles->push_back(OutputHole{ output_size(), current->strings->intern(str), true });
+		return;
+	}
 	if (!str)
 	{
 		push_varint(0, 1);
 		return;
 	}
-	int len = strlen(str);
+	size_t len = strlen(str);
 	push_varint(len+1, 1);
-	memcpy(buff_data + buff_pos, str, len);
-	buff_pos += len;
+	push_bytes((const unsigned char *)str, len);
 }
 
 unsigned char hex_value(const char c)
@@ -154,24 +585,33 @@ unsigned char hex_value(const char c)
 	return res;
 }
 
-static void push_color(const char * color)
+// rrggbbaa, white when there is no color
+static void encode_color(unsigned char *out, const char * color)
 {
 	if (color)
 	{
-		push_byte(hex_value(color[0]) << 4 | hex_value(color[1]));
-		push_byte(hex_value(color[2]) << 4 | hex_value(color[3]));
-		push_byte(hex_value(color[4]) << 4 | hex_value(color[5]));
-		push_byte(hex_value(color[6]) << 4 | hex_value(color[7]));
+		out[0] = hex_value(color[0]) << 4 | hex_value(color[1]);
+		out[1] = hex_value(color[2]) << 4 | hex_value(color[3]);
+		out[2] = hex_value(color[4]) << 4 | hex_value(color[5]);
+		out[3] = hex_value(color[6]) << 4 | hex_value(color[7]);
 	}
 	else
 	{
-		push_byte(255);
-		push_byte(255);
-		push_byte(255);
-		push_byte(255);
+		out[0] = 255;
+		out[1] = 255;
+		out[2] = 255;
+		out[3] = 255;
 	}
 }
 
+static void push_color(const char * color)
+{
+	SpineConverterState &out = *current;
+	reserve_output(out, 4);
+	encode_color(out.data + out.pos, color);
+	out.pos += 4;
+}
+
 struct BoneData {
 	string name;
 	int parent;
@@ -206,110 +646,100 @@ struct EventData {
 	string stringValue;
 };
 
-static vector<BoneData> process_bones(Json* bones)
+// What skins and animations refer to by name, built once per skeleton and then only read, so the encoders of a
+// skeleton share it across threads.
+struct SkeletonTables
 {
-	vector<BoneData> res;
-	for (Json* bone = bones->child; bone; bone = bone->next)
-	{
-		BoneData bd;
-		bd.name = Json_getString(bone, "name", "");
-		bd.parent_name = Json_getString(bone, "parent", "");
-		bd.rotation = Json_getFloat(bone, "rotation", .0f);
-		bd.x = Json_getFloat(bone, "x", .0f);
-		bd.y = Json_getFloat(bone, "y", .0f);
-		bd.scaleX = Json_getFloat(bone, "scaleX", 1.0f);
-		bd.scaleY = Json_getFloat(bone, "scaleY", 1.0f);
-		bd.shearX = Json_getFloat(bone, "shearX", .0f);
-		bd.shearY = Json_getFloat(bone, "shearY", .0f);
-		bd.length = Json_getFloat(bone, "length", .0f);
-		const char *transform = Json_getString(bone, "transform", "normal");
-		if (strcmp(transform, "normal") == 0)
-			bd.mode = 0;
-		if (strcmp(transform, "onlyTranslation") == 0)
-			bd.mode = 1;
-		if (strcmp(transform, "noRotationOrReflection") == 0)
-			bd.mode = 2;
-		if (strcmp(transform, "noScale") == 0)
-			bd.mode = 3;
-		if (strcmp(transform, "noScaleOrReflection") == 0)
-			bd.mode = 4;
-		res.push_back(std::move(bd));
-	}
+	vector<BoneData> bones;
+	NameTable boneNames;
+	NameTable slots;
+	NameTable ik;
+	NameTable transform;
+	NameTable paths;
+	NameTable skins;
+	vector<EventData> events;
+	NameTable eventNames;
+
+	// the setup pose the decimation compares to, by index as above
+	vector<Json *> slotMaps;
+	vector<Json *> ikMaps;
+	vector<Json *> transformMaps;
+	vector<Json *> pathMaps;
+};
 
-	for (size_t i = 0; i < res.size(); ++i)
-	{
-		if (res[i].parent_name.length() > 0)
-		{
-			for (size_t j = 0; j < res.size(); ++j)
-			{
-				if (res[i].parent_name == res[j].name)
-				{
-					res[i].parent = j;
-					break;
-				}
-			}
-		}
-	}
-	return res;
+static int bone_transform_mode(const char *transform)
+{
+	int mode = 0;
+	if (strcmp(transform, "normal") == 0)
+		mode = 0;
+	if (strcmp(transform, "onlyTranslation") == 0)
+		mode = 1;
+	if (strcmp(transform, "noRotationOrReflection") == 0)
+		mode = 2;
+	if (strcmp(transform, "noScale") == 0)
+		mode = 3;
+	if (strcmp(transform, "noScaleOrReflection") == 0)
+		mode = 4;
+	return mode;
 }
 
-static string get_line(const char *str, int &pos)
+// Indexes the bone names and points each bone at its parent.
+static void link_bone_parents(vector<BoneData> &bones, NameTable &names)
 {
-	int start = -1;
-	while (str[pos])
+	names.clear();
+	for (const BoneData &bone : bones)
+		names.add(bone.name);
+	for (BoneData &bone : bones)
 	{
-		if (start == -1)
-		{
-			if (str[pos] == '\r' || str[pos] == '\n')
-				pos++;
-			else
-				start = pos;
-		}
-		else
+		if (bone.parent_name.length() > 0)
 		{
-			if (str[pos] == '\r' || str[pos] == '\n')
-				return string(str+start, pos-start);
-			
-			pos++;
+			int parent = names.find(bone.parent_name);
+			if (parent != -1)
+				bone.parent = parent;
 		}
 	}
-	if (start != -1)
-		return string(str + start, pos - start);
-	return "";
 }
 
-static void parse_atlas(const char *atlas)
+static void process_bones(Json* bones, SkeletonTables &tables)
 {
-	int pos = 0;
-	do
+	vector<BoneData> &res = tables.bones;
+	for (Json* bone = bones->child; bone; bone = bone->next)
 	{
-		string line = get_line(atlas, pos);
-		if (line.length() > 0 && line.find(":") == string::npos)
-			all_atlas.insert(line);
+		BoneData bd;
+		bd.name = Json_getStringKey(bone, KEY_NAME, "");
+		bd.parent_name = Json_getStringKey(bone, KEY_PARENT, "");
+		bd.rotation = Json_getFloatKey(bone, KEY_ROTATION, .0f);
+		bd.x = Json_getFloatKey(bone, KEY_X, .0f);
+		bd.y = Json_getFloatKey(bone, KEY_Y, .0f);
+		bd.scaleX = Json_getFloatKey(bone, KEY_SCALE_X, 1.0f);
+		bd.scaleY = Json_getFloatKey(bone, KEY_SCALE_Y, 1.0f);
+		bd.shearX = Json_getFloatKey(bone, KEY_SHEAR_X, .0f);
+		bd.shearY = Json_getFloatKey(bone, KEY_SHEAR_Y, .0f);
+		bd.length = Json_getFloatKey(bone, KEY_LENGTH, .0f);
+		bd.mode = bone_transform_mode(Json_getStringKey(bone, KEY_TRANSFORM, "normal"));
+		res.push_back(std::move(bd));
+	}
 
-	} while (atlas[pos]);
+	link_bone_parents(res, tables.boneNames);
 }
 
-static int find_bone(vector<BoneData> &bones, string name)
+// The values of a json array, in the state's scratch vector.
+static const vector<float> &gather_floats(Json *array)
 {
-	for (int i = 0; i < bones.size(); ++i)
-	{
-		if (bones[i].name == name)
-		{
-			return i;
-		}
-	}
-	return -1;
+	vector<float> &values = current->floats;
+	values.clear();
+	for (Json *entry = array ? array->child : 0; entry; entry = entry->next)
+		values.push_back(entry->valueFloat);
+	return values;
 }
 
-static int find_string(vector<string> vcStr, string str)
+static const vector<int> &gather_ints(Json *array)
 {
-	for (int i = 0; i < vcStr.size(); ++i)
-	{
-		if (vcStr[i] == str)
-			return i;
-	}
-	return -1;
+	vector<int> &values = current->ints;
+	values.clear();
+	for (Json *entry = array ? array->child : 0; entry; entry = entry->next)
+		values.push_back(entry->valueInt);
+	return values;
 }
 
 static void push_vertices(Json *vertices, int verticesLength)
@@ -317,17 +747,12 @@ static void push_vertices(Json *vertices, int verticesLength)
 	int size = vertices->size;
 	if (size <= 0)
 		return;
-	float *vert = (float *)malloc(sizeof(float)*size);
-	
-	int i = 0;
-	for (Json *entry = vertices->child; entry; entry = entry->next)
-		vert[i++] = entry->valueFloat;
+	const vector<float> &vert = gather_floats(vertices);
 
 	if (verticesLength == size)
 	{
 		push_boolen(false);
-		for (i = 0; i < size; ++i)
-			push_float(vert[i]);
+		push_floats(vert.data(), size);
 	}
 	else
 	{
@@ -336,19 +761,46 @@ static void push_vertices(Json *vertices, int verticesLength)
 		{
 			int boneCount = (int)vert[i++];
 			push_varint(boneCount, 1);
-			for (int nn = i + boneCount * 4; i < nn; i += 4)
+			for (int nn = i + boneCount * 4; i < nn && i + 4 <= size; i += 4)
 			{
 				push_varint((int)vert[i], 1);
-				push_float(vert[i + 1]);
-				push_float(vert[i + 2]);
-				push_float(vert[i + 3]);
+				push_floats(&vert[i + 1], 3);
 			}
 		}
 	}
-	free(vert);
 }
 
-static int parse_skin(Json *skin, vector<string> slots)
+static int attachment_type(const string &typeString)
+{
+	int spAttachmentType = 0;
+	if (typeString == "mesh")
+		spAttachmentType = 2; // SP_ATTACHMENT_MESH
+	else if (typeString == "linkedmesh")
+		spAttachmentType = 3; // SP_ATTACHMENT_LINKED_MESH
+	else if (typeString == "boundingbox")
+		spAttachmentType = 1; // SP_ATTACHMENT_BOUNDING_BOX
+	else if (typeString == "path")
+		spAttachmentType = 4; // SP_ATTACHMENT_PATH
+	else if (typeString == "clipping")
+		spAttachmentType = 6; // SP_ATTACHMENT_CLIPPING
+	else
+		spAttachmentType = 0; // SP_ATTACHMENT_REGION
+	return spAttachmentType;
+}
+
+// Whether the attachment's region is in the atlas. Only region backed attachments are filtered, and nothing is when
+// no atlas was given.
+static bool attachment_in_atlas(const char *typeString, const char *attachmentPath)
+{
+	const AtlasIndex &regions = *current->regions;
+	if (regions.empty())
+		return true;
+	if (!strcmp(typeString, "region") || !strcmp(typeString, "mesh") || !strcmp(typeString, "linkedmesh"))
+		return regions.contains(attachmentPath);
+	return true;
+}
+
+static int parse_skin(Json *skin, const NameTable &slots)
 {
 	push_varint(skin->size, 1);
 	if (skin->size == 0)
@@ -356,7 +808,7 @@ static int parse_skin(Json *skin, vector<string> slots)
 
 	for (Json *attachments = skin->child; attachments; attachments = attachments->next)
 	{
-		int slot = find_string(slots, attachments->name);
+		int slot = slots.find(attachments->name);
 		if (slot == -1)
 			return -1;
 		push_varint(slot, 1);
@@ -364,19 +816,13 @@ static int parse_skin(Json *skin, vector<string> slots)
 		vector<Json *> validAttachment;
 		for (Json *attachment = attachments->child; attachment; attachment = attachment->next)
 		{
-			if (all_atlas.empty())
+			if (current->regions->empty())
 				validAttachment.push_back(attachment);
 			else
 			{
-				string typeString = Json_getString(attachment, "type", "region");
-				if (typeString == "region" || typeString == "mesh" || typeString == "linkedmesh")
-				{
-					const char *attachmentName = Json_getString(attachment, "name", attachment->name);
-					const char* attachmentPath = Json_getString(attachment, "path", attachmentName);
-					if (all_atlas.find(string(attachmentPath)) != all_atlas.end())
-						validAttachment.push_back(attachment);
-				}
-				else
+				const char *attachmentName = Json_getStringKey(attachment, KEY_NAME, attachment->name);
+				const char* attachmentPath = Json_getStringKey(attachment, KEY_PATH, attachmentName);
+				if (attachment_in_atlas(Json_getStringKey(attachment, KEY_TYPE, "region"), attachmentPath))
 					validAttachment.push_back(attachment);
 			}
 		}
@@ -384,26 +830,13 @@ static int parse_skin(Json *skin, vector<string> slots)
 
 		for (Json *attachment : validAttachment)
 		{
-			const char *attachmentName = Json_getString(attachment, "name", attachment->name);
+			const char *attachmentName = Json_getStringKey(attachment, KEY_NAME, attachment->name);
 			push_string(attachment->name);
 			push_string(attachmentName);
 
-			const char* attachmentPath = Json_getString(attachment, "path", NULL);
-
-			string typeString = Json_getString(attachment, "type", "region");
-			int spAttachmentType = 0;
-			if (typeString == "mesh")
-				spAttachmentType = 2; // SP_ATTACHMENT_MESH
-			else if (typeString == "linkedmesh")
-				spAttachmentType = 3; // SP_ATTACHMENT_LINKED_MESH
-			else if (typeString == "boundingbox")
-				spAttachmentType = 1; // SP_ATTACHMENT_BOUNDING_BOX
-			else if (typeString == "path")
-				spAttachmentType = 4; // SP_ATTACHMENT_PATH
-			else if (typeString == "clipping")
-				spAttachmentType = 6; // SP_ATTACHMENT_CLIPPING
-			else
-				spAttachmentType = 0; // SP_ATTACHMENT_REGION
+			const char* attachmentPath = Json_getStringKey(attachment, KEY_PATH, NULL);
+
+			int spAttachmentType = attachment_type(Json_getStringKey(attachment, KEY_TYPE, "region"));
 
 			push_byte(spAttachmentType);
 			if (spAttachmentType == 0) // SP_ATTACHMENT_REGION
@@ -412,20 +845,20 @@ static int parse_skin(Json *skin, vector<string> slots)
 					push_string(attachmentPath);
 				else
 					push_varint(0, 1);
-				push_float(Json_getFloat(attachment, "rotation", 0));
-				push_float(Json_getFloat(attachment, "x", 0));
-				push_float(Json_getFloat(attachment, "y", 0));
-				push_float(Json_getFloat(attachment, "scaleX", 1));
-				push_float(Json_getFloat(attachment, "scaleY", 1));
-				push_float(Json_getFloat(attachment, "width", 32));
-				push_float(Json_getFloat(attachment, "height", 32));
-				push_color(Json_getString(attachment, "color", 0));
+				push_float(Json_getFloatKey(attachment, KEY_ROTATION, 0));
+				push_float(Json_getFloatKey(attachment, KEY_X, 0));
+				push_float(Json_getFloatKey(attachment, KEY_Y, 0));
+				push_float(Json_getFloatKey(attachment, KEY_SCALE_X, 1));
+				push_float(Json_getFloatKey(attachment, KEY_SCALE_Y, 1));
+				push_float(Json_getFloatKey(attachment, KEY_WIDTH, 32));
+				push_float(Json_getFloatKey(attachment, KEY_HEIGHT, 32));
+				push_color(Json_getStringKey(attachment, KEY_COLOR, 0));
 			}
 			else if (spAttachmentType == 1) // SP_ATTACHMENT_BOUNDING_BOX
 			{
-				int vertexCount = Json_getInt(attachment, "vertexCount", 0);
+				int vertexCount = Json_getIntKey(attachment, KEY_VERTEX_COUNT, 0);
 				push_varint(vertexCount, 1);
-				Json *vertices = Json_getItem(attachment, "vertices");
+				Json *vertices = Json_getItemKey(attachment, KEY_VERTICES);
 				push_vertices(vertices, vertexCount << 1);
 				
 			}
@@ -436,28 +869,22 @@ static int parse_skin(Json *skin, vector<string> slots)
 				else
 					push_varint(0, 1);
 
-				push_color(Json_getString(attachment, "color", 0));
+				push_color(Json_getStringKey(attachment, KEY_COLOR, 0));
 
-				Json *uvs = Json_getItem(attachment, "uvs");
+				Json *uvs = Json_getItemKey(attachment, KEY_UVS);
 				int verticesLength = uvs->size;
 				push_varint(verticesLength >> 1, 1);
 
-				for (Json *uv = uvs->child; uv; uv = uv->next)
-					push_float(uv->valueFloat);
+				push_floats(gather_floats(uvs).data(), uvs->size);
 
-				Json *triangles = Json_getItem(attachment, "triangles");
+				Json *triangles = Json_getItemKey(attachment, KEY_TRIANGLES);
 				push_varint(triangles->size, 1);
-				for (Json *triangle = triangles->child; triangle; triangle = triangle->next)
-				{
-					unsigned short v = triangle->valueInt;
-					push_byte(v >> 8);
-					push_byte(v & 0xff);
-				}
+				push_shorts(gather_ints(triangles).data(), triangles->size);
 
-				Json *vertices = Json_getItem(attachment, "vertices");
+				Json *vertices = Json_getItemKey(attachment, KEY_VERTICES);
 				push_vertices(vertices, verticesLength);
 
-				push_varint(Json_getInt(attachment, "hull", 0) >> 1, 1);
+				push_varint(Json_getIntKey(attachment, KEY_HULL, 0) >> 1, 1);
 			}
 			else if (spAttachmentType == 3) // SP_ATTACHMENT_LINKED_MESH
 			{
@@ -466,9 +893,9 @@ static int parse_skin(Json *skin, vector<string> slots)
 				else
 					push_varint(0, 1);
 
-				push_color(Json_getString(attachment, "color", 0));
+				push_color(Json_getStringKey(attachment, KEY_COLOR, 0));
 
-				const char *skin = Json_getString(attachment, "skin", 0);
+				const char *skin = Json_getStringKey(attachment, KEY_SKIN, 0);
 				if (skin)
 					push_string(skin);
 				else
@@ -477,45 +904,43 @@ static int parse_skin(Json *skin, vector<string> slots)
 
 				// parent
 				//push_string(attachment->valueString);
-				push_string(Json_getString(attachment, "parent", 0));
+				push_string(Json_getStringKey(attachment, KEY_PARENT, 0));
 
-				int deform = Json_getInt(attachment, "deform", 1);
+				int deform = Json_getIntKey(attachment, KEY_DEFORM, 1);
 				push_boolen(deform);
 			}
 			else if (spAttachmentType == 4) // SP_ATTACHMENT_PATH
 			{
-				push_boolen(Json_getInt(attachment, "closed", 0));
-				push_boolen(Json_getInt(attachment, "constantSpeed", 0));
+				push_boolen(Json_getIntKey(attachment, KEY_CLOSED, 0));
+				push_boolen(Json_getIntKey(attachment, KEY_CONSTANT_SPEED, 0));
 
-				int vertexCount = Json_getInt(attachment, "vertexCount", 0);
+				int vertexCount = Json_getIntKey(attachment, KEY_VERTEX_COUNT, 0);
 				push_varint(vertexCount, 1);
-				Json *vertices = Json_getItem(attachment, "vertices");
+				Json *vertices = Json_getItemKey(attachment, KEY_VERTICES);
 				push_vertices(vertices, vertexCount << 1);
 
-				Json *lengths = Json_getItem(attachment, "lengths");
-				for (Json *length = lengths->child; length; length = length->next)
-				{
-					push_float(length->valueFloat);
-				}
+				Json *lengths = Json_getItemKey(attachment, KEY_LENGTHS);
+				push_floats(gather_floats(lengths).data(), lengths->size);
 			}
 			else if (spAttachmentType == 5) // SP_ATTACHMENT_POINT
 			{
-				push_float(Json_getFloat(attachment, "x", 0));
-				push_float(Json_getFloat(attachment, "y", 0));
-				push_float(Json_getFloat(attachment, "rotation", 0));
+				push_float(Json_getFloatKey(attachment, KEY_X, 0));
+				push_float(Json_getFloatKey(attachment, KEY_Y, 0));
+				push_float(Json_getFloatKey(attachment, KEY_ROTATION, 0));
 			}
 			else if (spAttachmentType == 6) // SP_ATTACHMENT_CLIPPING
 			{
-				const char* end = Json_getString(attachment, "end", 0);
-				if (end && find_string(slots, end) != -1) {
-					push_varint(find_string(slots, end), 1);
+				const char* end = Json_getStringKey(attachment, KEY_END, 0);
+				int endSlot = end ? slots.find(end) : -1;
+				if (endSlot != -1) {
+					push_varint(endSlot, 1);
 				}
 				else {
 					push_varint(0, 1);
 				}
-				int vertexCount = Json_getInt(attachment, "vertexCount", 0);
+				int vertexCount = Json_getIntKey(attachment, KEY_VERTEX_COUNT, 0);
 				push_varint(vertexCount, 1);
-				Json *vertices = Json_getItem(attachment, "vertices");
+				Json *vertices = Json_getItemKey(attachment, KEY_VERTICES);
 				push_vertices(vertices, vertexCount<<1);
 			}
 		}
@@ -552,22 +977,25 @@ static void push_curve(Json* curve)
 	}
 }
 
-static int parse_animation(
-	Json *animation, 
-	vector<string> &vcSlots, 
-	vector<BoneData> &vcBones, 
-	vector<string> &vcIK,
-	vector<string> &vcTransform,
-	vector<string> &vcPaths,
-	vector<string> &vcSkins,
-	vector<EventData> &vcEvents)
+// Counts a timeline of keys keys, when the conversion keeps stats.
+static inline void count_timeline(SpineTimelineType type, int keys)
+{
+	SpineTimelineCount *timelines = current->timelines;
+	if (timelines)
+	{
+		++timelines[type].timelines;
+		timelines[type].keys += keys;
+	}
+}
+
+static int parse_animation(Json *animation, const SkeletonTables &tables)
 {
 	/* Slot timelines. */
-	Json* slots = Json_getItem(animation, "slots");
+	Json* slots = Json_getItemKey(animation, KEY_SLOTS);
 	push_varint(slots ? slots->size : 0, 1);
 	for (Json *slotMap = slots ? slots->child : 0; slotMap; slotMap = slotMap->next)
 	{
-		int slotIndex = find_string(vcSlots, slotMap->name);
+		int slotIndex = tables.slots.find(slotMap->name);
 		if (slotIndex == -1)
 			return -1;
 		push_varint(slotIndex, 1);
@@ -580,35 +1008,38 @@ static int parse_animation(
 			{
 				push_byte(0);
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_ATTACHMENT, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_string(Json_getString(valueMap, "name", ""));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_string(Json_getStringKey(valueMap, KEY_NAME, ""));
 				}
 			}
 			else if (name == "color")
 			{
 				push_byte(1);
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_COLOR, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_color(Json_getString(valueMap, "color", 0));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_color(Json_getStringKey(valueMap, KEY_COLOR, 0));
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 			else if (name == "twoColor")
 			{
 				push_byte(2);
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_TWO_COLOR, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_color(Json_getString(valueMap, "light", 0));
-					push_color(Json_getString(valueMap, "dark", 0));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_color(Json_getStringKey(valueMap, KEY_LIGHT, 0));
+					push_color(Json_getStringKey(valueMap, KEY_DARK, 0));
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 			else
@@ -619,11 +1050,11 @@ static int parse_animation(
 	}
 
 	/* Bone timelines. */
-	Json* bones = Json_getItem(animation, "bones");
+	Json* bones = Json_getItemKey(animation, KEY_BONES);
 	push_varint(bones ? bones->size : 0,  1);
 	for (Json *boneMap = bones ? bones->child : 0; boneMap; boneMap = boneMap->next)
 	{
-		int boneIndex = find_bone(vcBones, boneMap->name);
+		int boneIndex = tables.boneNames.find(boneMap->name);
 		if (boneIndex == -1)
 			return -3;
 		push_varint(boneIndex, 1);
@@ -635,88 +1066,102 @@ static int parse_animation(
 			{
 				push_byte(0);
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_ROTATE, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_float(Json_getFloat(valueMap, "angle", 0));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_float(Json_getFloatKey(valueMap, KEY_ANGLE, 0));
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 			else
 			{
+				SpineTimelineType type;
 				if (string(timelineMap->name) == "scale")
+				{
 					push_byte(2);
+					type = SPINE_TIMELINE_SCALE;
+				}
 				else if (string(timelineMap->name) == "translate")
+				{
 					push_byte(1);
+					type = SPINE_TIMELINE_TRANSLATE;
+				}
 				else if (string(timelineMap->name) == "shear")
+				{
 					push_byte(3);
+					type = SPINE_TIMELINE_SHEAR;
+				}
 				else
 					return -4;
 
 				push_varint(timelineMap->size, 1);
+				count_timeline(type, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_float(Json_getFloat(valueMap, "x", 0));
-					push_float(Json_getFloat(valueMap, "y", 0));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_float(Json_getFloatKey(valueMap, KEY_X, 0));
+					push_float(Json_getFloatKey(valueMap, KEY_Y, 0));
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 		}
 	}
 
 	/* IK constraint timelines. */
-	Json* ik = Json_getItem(animation, "ik");
+	Json* ik = Json_getItemKey(animation, KEY_IK);
 	push_varint(ik ? ik->size : 0, 1);
 	for (Json *ikMap = ik ? ik->child : 0; ikMap; ikMap = ikMap->next)
 	{
-		int ikIndex = find_string(vcIK, ikMap->name);
+		int ikIndex = tables.ik.find(ikMap->name);
 		if (ikIndex == -1)
 			return -5;
 		push_varint(ikIndex, 1);
 
 		push_varint(ikMap->size, 1);
+		count_timeline(SPINE_TIMELINE_IK, ikMap->size);
 		for (Json *valueMap = ikMap->child; valueMap; valueMap = valueMap->next)
 		{
-			push_float(Json_getFloat(valueMap, "time", 0));
-			push_float(Json_getFloat(valueMap, "mix", 1));
-			push_byte(Json_getInt(valueMap, "bendPositive", 1) ? 1 : -1);
+			push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+			push_float(Json_getFloatKey(valueMap, KEY_MIX, 1));
+			push_byte(Json_getIntKey(valueMap, KEY_BEND_POSITIVE, 1) ? 1 : -1);
 			if (valueMap->next)
-				push_curve(Json_getItem(valueMap, "curve"));
+				push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 		}
 	}
 
 	/* Transform constraint timelines. */
-	Json* transform = Json_getItem(animation, "transform");
+	Json* transform = Json_getItemKey(animation, KEY_TRANSFORM);
 	push_varint(transform ? transform->size : 0, 1);
 	for (Json *transMap = transform ? transform->child : 0; transMap; transMap = transMap->next)
 	{
-		int index = find_string(vcTransform, transMap->name);
+		int index = tables.transform.find(transMap->name);
 		if (index == -1)
 			return -6;
 		push_varint(index, 1);
 
 		push_varint(transMap->size, 1);
+		count_timeline(SPINE_TIMELINE_TRANSFORM, transMap->size);
 		for (Json *valueMap = transMap->child; valueMap; valueMap = valueMap->next)
 		{
-			push_float(Json_getFloat(valueMap, "time", 0));
-			push_float(Json_getFloat(valueMap, "rotateMix", 1));
-			push_float(Json_getFloat(valueMap, "translateMix", 1));
-			push_float(Json_getFloat(valueMap, "scaleMix", 1));
-			push_float(Json_getFloat(valueMap, "shearMix", 1));
+			push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+			push_float(Json_getFloatKey(valueMap, KEY_ROTATE_MIX, 1));
+			push_float(Json_getFloatKey(valueMap, KEY_TRANSLATE_MIX, 1));
+			push_float(Json_getFloatKey(valueMap, KEY_SCALE_MIX, 1));
+			push_float(Json_getFloatKey(valueMap, KEY_SHEAR_MIX, 1));
 			if (valueMap->next)
-				push_curve(Json_getItem(valueMap, "curve"));
+				push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 		}
 	}
 
 	/* Path constraint timelines. */
-	Json* paths = Json_getItem(animation, "paths");
+	Json* paths = Json_getItemKey(animation, KEY_PATHS);
 	push_varint(paths ? paths->size : 0, 1);
 	for (Json *pathMap = paths ? paths->child : 0; pathMap; pathMap = pathMap->next)
 	{
-		int pathIndex = find_string(vcPaths, pathMap->name);
+		int pathIndex = tables.paths.find(pathMap->name);
 		if (pathIndex == -1)
 			return -7;
 		push_varint(pathIndex, 1);
@@ -733,26 +1178,29 @@ static int parse_animation(
 					push_byte(1);
 
 				push_varint(timelineMap->size, 1);
+				count_timeline(timelineName == "position" ? SPINE_TIMELINE_PATH_POSITION : SPINE_TIMELINE_PATH_SPACING,
+					timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_float(Json_getFloat(valueMap, timelineName.c_str(), 0));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_float(Json_getFloatKey(valueMap, timelineName == "position" ? KEY_POSITION : KEY_SPACING, 0));
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 			else if (string(timelineMap->name) == "mix")
 			{
 				push_byte(2);
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_PATH_MIX, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					push_float(Json_getFloat(valueMap, "rotateMix", 1));
-					push_float(Json_getFloat(valueMap, "translateMix", 1));
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					push_float(Json_getFloatKey(valueMap, KEY_ROTATE_MIX, 1));
+					push_float(Json_getFloatKey(valueMap, KEY_TRANSLATE_MIX, 1));
 
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 			else
@@ -762,11 +1210,11 @@ static int parse_animation(
 
 
 	/* Deform timelines. */
-	Json* deform = Json_getItem(animation, "deform");
+	Json* deform = Json_getItemKey(animation, KEY_DEFORM);
 	push_varint(deform ? deform->size : 0, 1);
 	for (Json *deformMap = deform ? deform->child : 0; deformMap; deformMap = deformMap->next)
 	{
-		int skinIndex = find_string(vcSkins, deformMap->name);
+		int skinIndex = tables.skins.find(deformMap->name);
 		if (skinIndex == -1)
 			return -9;
 		push_varint(skinIndex, 1);
@@ -774,7 +1222,7 @@ static int parse_animation(
 		push_varint(deformMap->size, 1);
 		for (Json *slotMap = deformMap->child; slotMap; slotMap = slotMap->next)
 		{
-			int slotIndex = find_string(vcSlots, slotMap->name);
+			int slotIndex = tables.slots.find(slotMap->name);
 			if (slotIndex == -1)
 				return -10;
 			push_varint(slotIndex, 1);
@@ -785,10 +1233,11 @@ static int parse_animation(
 				push_string(timelineMap->name);
 
 				push_varint(timelineMap->size, 1);
+				count_timeline(SPINE_TIMELINE_DEFORM, timelineMap->size);
 				for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
 				{
-					push_float(Json_getFloat(valueMap, "time", 0));
-					Json* vertices = Json_getItem(valueMap, "vertices");
+					push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+					Json* vertices = Json_getItemKey(valueMap, KEY_VERTICES);
 					if (!vertices)
 					{
 						push_varint(0, 1);
@@ -797,15 +1246,14 @@ static int parse_animation(
 					{
 						push_varint(vertices->size, 1);
 
-						int start = Json_getInt(valueMap, "offset", 0);
+						int start = Json_getIntKey(valueMap, KEY_OFFSET, 0);
 						push_varint(start, 1);
 
-						for (Json *vertex = vertices->child; vertex; vertex = vertex->next)
-							push_float(vertex->valueFloat);
+						push_floats(gather_floats(vertices).data(), vertices->size);
 					}
 
 					if (valueMap->next)
-						push_curve(Json_getItem(valueMap, "curve"));
+						push_curve(Json_getItemKey(valueMap, KEY_CURVE));
 				}
 			}
 		}
@@ -813,433 +1261,4502 @@ static int parse_animation(
 
 
 	/* Draw order timeline. */
-	Json* drawOrder = Json_getItem(animation, "drawOrder");
+	Json* drawOrder = Json_getItemKey(animation, KEY_DRAW_ORDER);
 	push_varint(drawOrder ? drawOrder->size : 0, 1);
+	if (drawOrder && drawOrder->size)
+		count_timeline(SPINE_TIMELINE_DRAW_ORDER, drawOrder->size);
 	for (Json *valueMap = drawOrder ? drawOrder->child : 0; valueMap; valueMap = valueMap->next)
 	{
-		push_float(Json_getFloat(valueMap, "time", 0));
+		push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
 
-		Json* offsets = Json_getItem(valueMap, "offsets");
+		Json* offsets = Json_getItemKey(valueMap, KEY_OFFSETS);
 		push_varint(offsets ? offsets->size : 0, 1);
 		for (Json *offsetMap = offsets ? offsets->child : 0; offsetMap; offsetMap = offsetMap->next)
 		{
-			int slotIndex = find_string(vcSlots, Json_getString(offsetMap, "slot", 0));
+			int slotIndex = tables.slots.find(Json_getStringKey(offsetMap, KEY_SLOT, 0));
 			if (slotIndex == -1)
 				return -11;
 			push_varint(slotIndex, 1);
-			push_varint(Json_getInt(offsetMap, "offset", 0), 1);
+			push_varint(Json_getIntKey(offsetMap, KEY_OFFSET, 0), 1);
 		}
 	}
 
 
 	/* Event timeline. */
-	Json* events = Json_getItem(animation, "events");
+	Json* events = Json_getItemKey(animation, KEY_EVENTS);
 	push_varint(events ? events->size : 0, 1);
+	if (events && events->size)
+		count_timeline(SPINE_TIMELINE_EVENT, events->size);
 	for (Json *valueMap = events ? events->child : 0; valueMap; valueMap = valueMap->next)
 	{
-		const char * name = Json_getString(valueMap, "name", 0);
+		const char * name = Json_getStringKey(valueMap, KEY_NAME, 0);
 		if (!name)
 			return -12;
-		push_float(Json_getFloat(valueMap, "time", 0));
-		int eventIndex = -1;
-		for (int i = 0; i < vcEvents.size(); ++i)
-		{
-			if (vcEvents[i].name == name)
-			{
-				eventIndex = i;
-				break;
-			}
-		}
+		push_float(Json_getFloatKey(valueMap, KEY_TIME, 0));
+		int eventIndex = tables.eventNames.find(name);
 		if (eventIndex == -1)
 			return -13;
 
 		push_varint(eventIndex, 1);
 
-		push_varint(Json_getInt(valueMap, "int", vcEvents[eventIndex].intValue), 0);
-		push_float(Json_getFloat(valueMap, "float", vcEvents[eventIndex].floatValue));
-		const char * str = Json_getString(valueMap, "string", 0);
+		push_varint(Json_getIntKey(valueMap, KEY_INT, tables.events[eventIndex].intValue), 0);
+		push_float(Json_getFloatKey(valueMap, KEY_FLOAT, tables.events[eventIndex].floatValue));
+		const char * str = Json_getStringKey(valueMap, KEY_STRING, 0);
 		push_boolen(str ? 1 : 0);
 		if(str)
 			push_string(str);
 	}
 
-	/*string log = "animation:"+string(animation->name);
-	log += " slots:" + to_string(slots ? slots->size : 0);
-	log += " bones:" + to_string(bones ? bones->size : 0);
-	log += " ik:" + to_string(ik ? ik->size : 0);
-	log += " transform:" + to_string(transform ? transform->size : 0);
-	log += " paths:" + to_string(paths ? paths->size : 0);
-	log += " deform:" + to_string(deform ? deform->size : 0);
-	log += " drawOrder:" + to_string(drawOrder ? drawOrder->size : 0);
-	log += " events:" + to_string(events ? events->size : 0);
-	cout << log << endl;*/
-
-	cout << "     \"" << animation->name<<"\",";
-
 	return 0;
 }
 
 
-int convert_json_to_binary(const char *json, size_t len, unsigned char *outBuff, const char *atlas)
+/* Keyframe decimation. */
+
+// A key of a timeline being decimated. Rotations are unwrapped, each angle within 180 degrees of the one before as the
+// runtime interpolates them, so keys compare along the way the bone turns.
+struct DecimatedKey
 {
-	buff_data = outBuff;
-	buff_pos = 0;
-	
-	if (len < 16)
-		return -1;
+	Json *map;
+	float time;
+	float values[8];
+	int curve; // to the next key
+	int bend; // ik
+	const char *name; // attachment, 0 for none
+	size_t bytes; // in the output, the curve left out
+};
 
-	if (json[0] != '{')
-		return -2;
-	
-	string head(json, 18);
-	if (head.find("\"skeleton\"") == head.npos)
-		return -3;
+// A timeline and the keys it keeps. It is dropped when it keeps none.
+struct DecimatedTimeline
+{
+	Json *map;
+	size_t header; // the bytes before the key count
+	int channels;
+	float tolerance[8];
+	bool rotation;
+	bool curves; // keys but the last have a curve
+	bool hasSetup; // setup holds the setup pose, the timeline may be dropped
+	DecimatedKey setup;
+	vector<DecimatedKey> keys;
+	vector<bool> kept;
+};
 
-	Json *root = Json_create(json);
-	if (!root)
-		return -4;
+// A slot, bone or path with its timelines, or an ik or transform timeline on its own.
+struct DecimatedEntry
+{
+	Json *map;
+	int index;
+	bool nested;
+	bool dropped = false; // with all its timelines
+	vector<DecimatedTimeline> timelines;
+};
 
-	all_atlas.clear();
-	if (atlas)
-		parse_atlas(atlas);
+struct DecimatedGroup
+{
+	Json *map;
+	vector<DecimatedEntry> entries;
+};
 
-	int rt = 0;
-	
-	// skeleton
-	Json* skeleton = Json_getItem(root, "skeleton");
-	if (!skeleton) {
-		Json_dispose(root);
-		return -5;
-	}
+static size_t varint_size(int value)
+{
+	unsigned char bytes[8];
+	return encode_varint(bytes, value, 1);
+}
 
-	const char *hash = Json_getString(skeleton, "hash", "");
-	if (!hash) {
-		Json_dispose(root);
-		return -6;
+static int curve_type(Json *curve)
+{
+	if (curve && curve->type == Json_String && strcmp(curve->valueString, "stepped") == 0)
+		return CURVE_STEPPED;
+	return curve && curve->type == Json_Array ? CURVE_BEZIER : CURVE_LINEAR;
+}
+
+static void color_values(const char *color, float *values)
+{
+	unsigned char bytes[4];
+	encode_color(bytes, color);
+	for (int i = 0; i < 4; ++i)
+		values[i] = bytes[i] / 255.0f;
+}
+
+// Reads the keys of timelineMap, their values as the encoder writes them.
+static void read_decimated_keys(DecimatedTimeline &timeline, SpineTimelineType type)
+{
+	float previous = 0;
+	for (Json *valueMap = timeline.map->child; valueMap; valueMap = valueMap->next)
+	{
+		DecimatedKey key = DecimatedKey();
+		key.map = valueMap;
+		key.time = Json_getFloatKey(valueMap, KEY_TIME, 0);
+		key.curve = timeline.curves ? curve_type(Json_getItemKey(valueMap, KEY_CURVE)) : CURVE_STEPPED;
+		key.name = "";
+		float *v = key.values;
+		switch (type)
+		{
+		case SPINE_TIMELINE_ATTACHMENT:
+			key.name = Json_getStringKey(valueMap, KEY_NAME, "");
+			key.bytes = 4 + (key.name ? varint_size((int)strlen(key.name) + 1) + strlen(key.name) : 1);
+			break;
+		case SPINE_TIMELINE_COLOR:
+			color_values(Json_getStringKey(valueMap, KEY_COLOR, 0), v);
+			key.bytes = 8;
+			break;
+		case SPINE_TIMELINE_TWO_COLOR:
+			color_values(Json_getStringKey(valueMap, KEY_LIGHT, 0), v);
+			color_values(Json_getStringKey(valueMap, KEY_DARK, 0), v + 4);
+			key.bytes = 12;
+			break;
+		case SPINE_TIMELINE_ROTATE:
+		{
+			float angle = Json_getFloatKey(valueMap, KEY_ANGLE, 0);
+			if (valueMap == timeline.map->child)
+				v[0] = angle - 360 * floorf(angle / 360 + 0.5f);
+			else
+			{
+				float delta = angle - previous;
+				v[0] = timeline.keys.back().values[0] + delta - 360 * floorf(delta / 360 + 0.5f);
+			}
+			previous = angle;
+			key.bytes = 8;
+			break;
+		}
+		case SPINE_TIMELINE_TRANSLATE:
+		case SPINE_TIMELINE_SCALE:
+		case SPINE_TIMELINE_SHEAR:
+			v[0] = Json_getFloatKey(valueMap, KEY_X, 0);
+			v[1] = Json_getFloatKey(valueMap, KEY_Y, 0);
+			key.bytes = 12;
+			break;
+		case SPINE_TIMELINE_IK:
+			v[0] = Json_getFloatKey(valueMap, KEY_MIX, 1);
+			key.bend = Json_getIntKey(valueMap, KEY_BEND_POSITIVE, 1) ? 1 : -1;
+			key.bytes = 9;
+			break;
+		case SPINE_TIMELINE_TRANSFORM:
+			v[0] = Json_getFloatKey(valueMap, KEY_ROTATE_MIX, 1);
+			v[1] = Json_getFloatKey(valueMap, KEY_TRANSLATE_MIX, 1);
+			v[2] = Json_getFloatKey(valueMap, KEY_SCALE_MIX, 1);
+			v[3] = Json_getFloatKey(valueMap, KEY_SHEAR_MIX, 1);
+			key.bytes = 20;
+			break;
+		case SPINE_TIMELINE_PATH_POSITION:
+			v[0] = Json_getFloatKey(valueMap, KEY_POSITION, 0);
+			key.bytes = 8;
+			break;
+		case SPINE_TIMELINE_PATH_SPACING:
+			v[0] = Json_getFloatKey(valueMap, KEY_SPACING, 0);
+			key.bytes = 8;
+			break;
+		default: // SPINE_TIMELINE_PATH_MIX
+			v[0] = Json_getFloatKey(valueMap, KEY_ROTATE_MIX, 1);
+			v[1] = Json_getFloatKey(valueMap, KEY_TRANSLATE_MIX, 1);
+			key.bytes = 12;
+			break;
+		}
+		timeline.keys.push_back(key);
 	}
-	push_string(hash);
+}
 
-	const char *version = Json_getString(skeleton, "spine", "");
-	if (!version) {
-		Json_dispose(root);
-		return -7;
+static bool same_values(const DecimatedTimeline &timeline, const DecimatedKey &a, const DecimatedKey &b)
+{
+	for (int c = 0; c < timeline.channels; ++c)
+	{
+		if (a.values[c] != b.values[c])
+			return false;
 	}
-	push_string(version);
+	return true;
+}
 
-	float width = Json_getFloat(skeleton, "width", 0);
-	push_float(width);
+// What a key holds apart from its values, which the runtime takes from the key a segment starts at.
+static bool same_tags(const DecimatedKey &a, const DecimatedKey &b)
+{
+	return a.bend == b.bend && (a.name == b.name || (a.name && b.name && strcmp(a.name, b.name) == 0));
+}
 
-	float height = Json_getFloat(skeleton, "height", 0);
-	push_float(height);
+static bool within(const DecimatedTimeline &timeline, const float *values, const DecimatedKey &key)
+{
+	for (int c = 0; c < timeline.channels; ++c)
+	{
+		if (!(fabsf(values[c] - key.values[c]) <= timeline.tolerance[c]))
+			return false;
+	}
+	return true;
+}
+
+// Whether the segment from key from to key to + 1 reproduces the keys between, so they can go.
+static bool reproduces(const DecimatedTimeline &timeline, size_t from, size_t to)
+{
+	const vector<DecimatedKey> &keys = timeline.keys;
+	const DecimatedKey &first = keys[from], &next = keys[to + 1];
+	bool equal = true, stepped = true, linear = true;
+	for (size_t i = from; i <= to; ++i)
+	{
+		if (!same_tags(keys[i], first))
+			return false;
+		equal = equal && same_values(timeline, keys[i], first);
+		stepped = stepped && keys[i].curve == CURVE_STEPPED;
+		linear = linear && keys[i].curve == CURVE_LINEAR;
+	}
+	if (equal && same_values(timeline, next, first))
+		return true; // constant whatever the curve
+	if (stepped)
+	{
+		for (size_t i = from + 1; i <= to; ++i)
+		{
+			if (!within(timeline, first.values, keys[i]))
+				return false;
+		}
+		return true;
+	}
+	float span = next.time - first.time;
+	if (!linear || !(span > 0) || (timeline.rotation && !(fabsf(next.values[0] - first.values[0]) < 180)))
+		return false;
+	for (size_t i = from + 1; i <= to; ++i)
+	{
+		float t = (keys[i].time - first.time) / span, values[8];
+		for (int c = 0; c < timeline.channels; ++c)
+			values[c] = first.values[c] + (next.values[c] - first.values[c]) * t;
+		if (!within(timeline, values, keys[i]))
+			return false;
+	}
+	return true;
+}
+
+// Whether holding key stands for the keys from first on, which the segments from first interpolate between.
+static bool holds(const DecimatedTimeline &timeline, const DecimatedKey &key, size_t first)
+{
+	const vector<DecimatedKey> &keys = timeline.keys;
+	bool equal = true, bezier = false;
+	for (size_t i = first; i < keys.size(); ++i)
+	{
+		if (!same_tags(keys[i], key) || !within(timeline, key.values, keys[i]))
+			return false;
+		equal = equal && same_values(timeline, keys[i], key);
+		bezier = bezier || (i + 1 < keys.size() && keys[i].curve == CURVE_BEZIER);
+	}
+	return equal || !bezier; // a bezier curve may overshoot
+}
+
+static void plan_keys(DecimatedTimeline &timeline)
+{
+	size_t n = timeline.keys.size();
+	timeline.kept.assign(n, true);
+	if (timeline.hasSetup && holds(timeline, timeline.setup, 0))
+	{
+		timeline.kept.assign(n, false);
+		return;
+	}
+	size_t last = 0;
+	for (size_t i = 1; i + 1 < n; ++i)
+	{
+		if (reproduces(timeline, last, i))
+			timeline.kept[i] = false;
+		else
+			last = i;
+	}
+	if (n > 1 && holds(timeline, timeline.keys[last], last))
+	{
+		for (size_t i = last + 1; i < n; ++i)
+			timeline.kept[i] = false;
+	}
+}
+
+// The bytes of a timeline with the keys it keeps, or all of them.
+static size_t timeline_bytes(const DecimatedTimeline &timeline, bool decimated)
+{
+	int count = 0;
+	size_t bytes = 0;
+	const DecimatedKey *last = 0;
+	for (size_t i = 0; i < timeline.keys.size(); ++i)
+	{
+		if (decimated && !timeline.kept[i])
+			continue;
+		if (last && timeline.curves)
+			bytes += last->curve == CURVE_BEZIER ? 17 : 1;
+		last = &timeline.keys[i];
+		bytes += last->bytes;
+		++count;
+	}
+	return count ? timeline.header + varint_size(count) + bytes : 0;
+}
+
+static size_t kept_keys(const DecimatedTimeline &timeline)
+{
+	size_t count = 0;
+	for (bool kept : timeline.kept)
+		count += kept;
+	return count;
+}
+
+// Unlinks the children of parent that drop says go, in order.
+template <class Drop>
+static void unlink_children(Json *parent, Drop drop)
+{
+	for (Json **link = &parent->child; *link;)
+	{
+		if (drop(*link))
+		{
+			*link = (*link)->next;
+			--parent->size;
+#if SPINE_JSON_HAVE_PREV
+			if (*link)
+				(*link)->prev = link == &parent->child ? 0 : (Json *)((char *)link - offsetof(Json, next));
+#endif
+		}
+		else
+			link = &(*link)->next;
+	}
+}
+
+// The last key time of a timeline, an array of keys.
+static float last_time(Json *timelineMap, float duration)
+{
+	for (Json *valueMap = timelineMap ? timelineMap->child : 0; valueMap; valueMap = valueMap->next)
+	{
+		float time = Json_getFloatKey(valueMap, KEY_TIME, 0);
+		if (time > duration)
+			duration = time;
+	}
+	return duration;
+}
+
+// Plans a timeline of entry. setupMap is the slot or constraint it animates, 0 for a bone.
+static void plan_timeline(const SpineDecimation &tolerances, DecimatedEntry &entry, Json *timelineMap,
+	SpineTimelineType type, Json *setupMap)
+{
+	entry.timelines.push_back(DecimatedTimeline());
+	DecimatedTimeline &timeline = entry.timelines.back();
+	timeline.map = timelineMap;
+	timeline.header = entry.nested ? 1 : varint_size(entry.index);
+	timeline.curves = type != SPINE_TIMELINE_ATTACHMENT;
+	timeline.rotation = type == SPINE_TIMELINE_ROTATE;
+	timeline.hasSetup = true;
+	DecimatedKey &setup = timeline.setup;
+	setup.name = "";
+	setup.bend = 0;
+	float *v = setup.values;
+	switch (type)
+	{
+	case SPINE_TIMELINE_ATTACHMENT:
+		timeline.channels = 0;
+		setup.name = Json_getStringKey(setupMap, KEY_ATTACHMENT, "");
+		break;
+	case SPINE_TIMELINE_COLOR:
+	case SPINE_TIMELINE_TWO_COLOR:
+		timeline.channels = type == SPINE_TIMELINE_COLOR ? 4 : 8;
+		color_values(Json_getStringKey(setupMap, KEY_COLOR, 0), v);
+		color_values(Json_getStringKey(setupMap, KEY_DARK, 0), v + 4);
+		// a slot without a dark color has none to go back to
+		timeline.hasSetup = type == SPINE_TIMELINE_COLOR || Json_getStringKey(setupMap, KEY_DARK, 0);
+		for (int c = 0; c < timeline.channels; ++c)
+			timeline.tolerance[c] = tolerances.color;
+		break;
+	case SPINE_TIMELINE_ROTATE:
+		timeline.channels = 1;
+		timeline.tolerance[0] = tolerances.rotation;
+		break;
+	case SPINE_TIMELINE_TRANSLATE:
+	case SPINE_TIMELINE_SCALE:
+	case SPINE_TIMELINE_SHEAR:
+		timeline.channels = 2;
+		timeline.tolerance[0] = timeline.tolerance[1] = type == SPINE_TIMELINE_TRANSLATE ? tolerances.translation :
+			type == SPINE_TIMELINE_SCALE ? tolerances.scale : tolerances.shear;
+		v[0] = v[1] = type == SPINE_TIMELINE_SCALE ? 1.0f : 0.0f; // keys are relative to the setup pose
+		break;
+	case SPINE_TIMELINE_IK:
+		timeline.channels = 1;
+		timeline.tolerance[0] = tolerances.mix;
+		v[0] = Json_getFloatKey(setupMap, KEY_MIX, 1);
+		setup.bend = Json_getIntKey(setupMap, KEY_BEND_POSITIVE, 1) ? 1 : -1;
+		break;
+	case SPINE_TIMELINE_TRANSFORM:
+		timeline.channels = 4;
+		for (int c = 0; c < 4; ++c)
+			timeline.tolerance[c] = tolerances.mix;
+		v[0] = Json_getFloatKey(setupMap, KEY_ROTATE_MIX, 1);
+		v[1] = Json_getFloatKey(setupMap, KEY_TRANSLATE_MIX, 1);
+		v[2] = Json_getFloatKey(setupMap, KEY_SCALE_MIX, 1);
+		v[3] = Json_getFloatKey(setupMap, KEY_SHEAR_MIX, 1);
+		break;
+	case SPINE_TIMELINE_PATH_POSITION:
+		timeline.channels = 1;
+		timeline.tolerance[0] = strcmp(Json_getStringKey(setupMap, KEY_POSITION_MODE, "percent"), "fixed") == 0 ?
+			tolerances.translation : tolerances.mix;
+		v[0] = Json_getFloatKey(setupMap, KEY_POSITION, 0);
+		break;
+	case SPINE_TIMELINE_PATH_SPACING:
+		timeline.channels = 1;
+		timeline.tolerance[0] = strcmp(Json_getStringKey(setupMap, KEY_SPACING_MODE, "length"), "percent") == 0 ?
+			tolerances.mix : tolerances.translation;
+		v[0] = Json_getFloatKey(setupMap, KEY_SPACING, 0);
+		break;
+	default: // SPINE_TIMELINE_PATH_MIX
+		timeline.channels = 2;
+		timeline.tolerance[0] = timeline.tolerance[1] = tolerances.mix;
+		v[0] = Json_getFloatKey(setupMap, KEY_ROTATE_MIX, 1);
+		v[1] = Json_getFloatKey(setupMap, KEY_TRANSLATE_MIX, 1);
+		break;
+	}
+	read_decimated_keys(timeline, type);
+	plan_keys(timeline);
+}
+
+// Plans a group of the animation, an object of slots, bones or constraints by name. false for a name the encoder
+// would fail on.
+static bool plan_group(const SpineDecimation &tolerances, vector<DecimatedGroup> &groups, Json *group,
+	const NameTable &names, const vector<Json *> *setupMaps, bool nested, SpineTimelineType (*type_of)(const char *name))
+{
+	if (!group)
+		return true;
+	groups.push_back(DecimatedGroup());
+	groups.back().map = group;
+	for (Json *entryMap = group->child; entryMap; entryMap = entryMap->next)
+	{
+		DecimatedEntry entry;
+		entry.map = entryMap;
+		entry.index = names.find(entryMap->name);
+		entry.nested = nested;
+		if (entry.index == -1)
+			return false;
+		Json *setupMap = setupMaps ? (*setupMaps)[entry.index] : 0;
+		if (!nested)
+			plan_timeline(tolerances, entry, entryMap, type_of(0), setupMap);
+		for (Json *timelineMap = nested ? entryMap->child : 0; timelineMap; timelineMap = timelineMap->next)
+		{
+			SpineTimelineType type = type_of(timelineMap->name);
+			if (type == SPINE_TIMELINE_COUNT)
+				return false;
+			plan_timeline(tolerances, entry, timelineMap, type, setupMap);
+		}
+		groups.back().entries.push_back(std::move(entry));
+	}
+	return true;
+}
+
+static SpineTimelineType slot_timeline(const char *name)
+{
+	return strcmp(name, "attachment") == 0 ? SPINE_TIMELINE_ATTACHMENT : strcmp(name, "color") == 0 ?
+		SPINE_TIMELINE_COLOR : strcmp(name, "twoColor") == 0 ? SPINE_TIMELINE_TWO_COLOR : SPINE_TIMELINE_COUNT;
+}
+
+static SpineTimelineType bone_timeline(const char *name)
+{
+	return strcmp(name, "rotate") == 0 ? SPINE_TIMELINE_ROTATE : strcmp(name, "translate") == 0 ?
+		SPINE_TIMELINE_TRANSLATE : strcmp(name, "scale") == 0 ? SPINE_TIMELINE_SCALE : strcmp(name, "shear") == 0 ?
+		SPINE_TIMELINE_SHEAR : SPINE_TIMELINE_COUNT;
+}
+
+static SpineTimelineType path_timeline(const char *name)
+{
+	return strcmp(name, "position") == 0 ? SPINE_TIMELINE_PATH_POSITION : strcmp(name, "spacing") == 0 ?
+		SPINE_TIMELINE_PATH_SPACING : strcmp(name, "mix") == 0 ? SPINE_TIMELINE_PATH_MIX : SPINE_TIMELINE_COUNT;
+}
+
+static SpineTimelineType ik_timeline(const char *) { return SPINE_TIMELINE_IK; }
+static SpineTimelineType transform_timeline(const char *) { return SPINE_TIMELINE_TRANSFORM; }
+
+// Drops the keys and timelines of animation that the decimation can do without, before it is encoded, and counts them.
+// An animation with a name the encoder fails on is left as it is.
+static void decimate_animation(Json *animation, const SpineDecimation &tolerances, const SkeletonTables &tables,
+	SpineDecimationCount &count)
+{
+	vector<DecimatedGroup> groups;
+	if (!plan_group(tolerances, groups, Json_getItemKey(animation, KEY_SLOTS), tables.slots, &tables.slotMaps, true,
+			slot_timeline) ||
+		!plan_group(tolerances, groups, Json_getItemKey(animation, KEY_BONES), tables.boneNames, 0, true,
+			bone_timeline) ||
+		!plan_group(tolerances, groups, Json_getItemKey(animation, KEY_IK), tables.ik, &tables.ikMaps, false,
+			ik_timeline) ||
+		!plan_group(tolerances, groups, Json_getItemKey(animation, KEY_TRANSFORM), tables.transform,
+			&tables.transformMaps, false, transform_timeline) ||
+		!plan_group(tolerances, groups, Json_getItemKey(animation, KEY_PATHS), tables.paths, &tables.pathMaps, true,
+			path_timeline))
+		return;
+
+	// The runtime takes the duration from the last key of all timelines, one of them must keep it. The one kept holds
+	// the value its keys before were checked against.
+	float duration = 0, kept = 0;
+	Json *deform = Json_getItemKey(animation, KEY_DEFORM);
+	for (Json *skinMap = deform ? deform->child : 0; skinMap; skinMap = skinMap->next)
+	{
+		for (Json *slotMap = skinMap->child; slotMap; slotMap = slotMap->next)
+		{
+			for (Json *timelineMap = slotMap->child; timelineMap; timelineMap = timelineMap->next)
+				kept = last_time(timelineMap, kept);
+		}
+	}
+	kept = last_time(Json_getItemKey(animation, KEY_DRAW_ORDER), kept);
+	kept = last_time(Json_getItemKey(animation, KEY_EVENTS), kept);
+	for (DecimatedGroup &group : groups)
+	{
+		for (DecimatedEntry &entry : group.entries)
+		{
+			for (DecimatedTimeline &timeline : entry.timelines)
+			{
+				for (size_t i = 0; i < timeline.keys.size(); ++i)
+				{
+					duration = max(duration, timeline.keys[i].time);
+					if (timeline.kept[i])
+						kept = max(kept, timeline.keys[i].time);
+				}
+			}
+		}
+	}
+	for (DecimatedGroup &group : groups)
+	{
+		for (DecimatedEntry &entry : group.entries)
+		{
+			for (DecimatedTimeline &timeline : entry.timelines)
+			{
+				if (kept < duration && !timeline.keys.empty() && timeline.keys.back().time == duration)
+				{
+					timeline.kept.back() = true;
+					kept = duration;
+				}
+			}
+		}
+	}
+
+	for (DecimatedGroup &group : groups)
+	{
+		int groupSize = group.map->size;
+		for (DecimatedEntry &entry : group.entries)
+		{
+			size_t before = 0, after = 0;
+			for (DecimatedTimeline &timeline : entry.timelines)
+			{
+				before += timeline_bytes(timeline, false);
+				after += timeline_bytes(timeline, true);
+				size_t keys = kept_keys(timeline);
+				count.keys += timeline.keys.size() - keys;
+				size_t i = 0;
+				unlink_children(timeline.map, [&](Json *) { return !timeline.kept[i++]; });
+				if (!timeline.keys.empty() && keys == 0)
+					++count.timelines;
+			}
+			// a timeline without keys is left out, so is a slot, bone or path left without timelines
+			if (entry.nested)
+			{
+				size_t i = 0;
+				int timelines = entry.map->size;
+				unlink_children(entry.map, [&](Json *) {
+					const DecimatedTimeline &timeline = entry.timelines[i++];
+					return !timeline.keys.empty() && timeline.map->size == 0;
+				});
+				before += varint_size(entry.index) + varint_size(timelines);
+				entry.dropped = timelines && entry.map->size == 0;
+				if (!entry.dropped)
+					after += varint_size(entry.index) + varint_size(entry.map->size);
+			}
+			else
+				entry.dropped = !entry.timelines[0].keys.empty() && entry.map->size == 0;
+			count.bytes += before - after;
+		}
+		size_t i = 0;
+		unlink_children(group.map, [&](Json *) { return group.entries[i++].dropped; });
+		count.bytes += varint_size(groupSize) - varint_size(group.map->size);
+	}
+}
+
+// A skin or an animation. Each is encoded on its own, so with threads they run on workers into bytes and are joined in
+// document order.
+struct SkeletonPart
+{
+	Json *map;
+	bool animation;
+	bool named; // the default skin has no name
+	bool encoded = false;
+	vector<unsigned char> bytes;
+	StringPool strings; // string table mode, the strings of bytes
+	vector<OutputHole> stringHoles;
+	int rt = 0;
+
+	// incremental conversion, the key of its chunk when map is a placeholder
+	bool keyed = false;
+	uint64_t key = 0;
+
+	// stats, kept when timed
+	bool timed = false;
+	double seconds = 0;
+	SpineTimelineCount timelines[SPINE_TIMELINE_COUNT];
+	SpineDecimationCount decimated;
+
+	SkeletonPart(Json *map, bool animation, bool named) : map(map), animation(animation), named(named) {}
+};
+
+static int encode_part(SkeletonPart &part, const SkeletonTables &tables)
+{
+	chrono::steady_clock::time_point start;
+	SpineTimelineCount *timelines = current->timelines;
+	if (part.timed)
+	{
+		start = chrono::steady_clock::now();
+		current->timelines = part.timelines;
+	}
+	if (part.named)
+		push_string(part.map->name);
+	int rt;
+	if (part.animation && current->decimation)
+		decimate_animation(part.map, *current->decimation, tables, part.decimated);
+	if (part.animation)
+		rt = parse_animation(part.map, tables);
+	else
+		rt = parse_skin(part.map, tables.slots);
+	if (part.timed)
+	{
+		part.seconds = seconds_since(start);
+		current->timelines = timelines;
+	}
+	return rt;
+}
+
+// Encodes the parts into their bytes on up to threads threads, the calling one included. Parts already encoded are
+// left alone.
+static void encode_parts(vector<SkeletonPart> &parts, const SkeletonTables &tables, int threads)
+{
+	const AtlasIndex *regions = current->regions;
+	const SpineDecimation *decimation = current->decimation;
+	bool stringTable = current->strings != nullptr;
+	atomic<size_t> next(0);
+	auto work = [&]()
+	{
+		SpineConverterState state;
+		state.regions = regions;
+		state.decimation = decimation;
+		state.staging.resize(SINK_CHUNK);
+		ScopedState scope(&state);
+		for (size_t i; (i = next++) < parts.size();)
+		{
+			SkeletonPart &part = parts[i];
+			if (part.encoded)
+				continue;
+			SpineVectorSink sink(part.bytes);
+			set_output(state, state.staging.data(), state.staging.size(), &sink);
+			if (stringTable)
+			{
+				state.strings = &part.strings;
+				state.stringHoles = &part.stringHoles;
+			}
+			part.rt = encode_part(part, tables);
+			flush_output(state);
+			part.encoded = true;
+		}
+	};
+
+	vector<thread> workers;
+	for (int t = 1; t < threads && t < (int)parts.size(); ++t)
+		workers.push_back(thread(work));
+	work();
+	for (auto &worker : workers)
+		worker.join();
+}
+
+// Writes a part, encoding it now unless a worker did. A worker's strings move to the pool of the conversion.
+static int push_part(SkeletonPart &part, const SkeletonTables &tables)
+{
+	if (!part.encoded)
+		return encode_part(part, tables);
+	size_t base = output_size();
+	push_bytes(part.bytes.data(), part.bytes.size());
+	for (const OutputHole &hole : part.stringHoles)
+	{
+		const char *str = hole.value == -1 ? 0 : part.strings.names.name(hole.value).c_str();
+		current->stringHoles->push_back(OutputHole{ base + hole.pos, current->strings->intern(str), true });
+	}
+	return part.rt;
+}
+
+// Adds a pushed part to the stats: the time a worker took on it, which the section clock didn't see, and an
+// animation's own figures. start is the output size before the part.
+static void record_part(const SkeletonPart &part, SpineSection section, size_t start)
+{
+	SpineConverterStats *stats = current->stats;
+	if (!stats)
+		return;
+	if (part.encoded)
+		stats->sectionSeconds[section] += part.seconds;
+	if (!part.animation)
+		return;
+	stats->animations.push_back(SpineAnimationStats());
+	SpineAnimationStats &animation = stats->animations.back();
+	animation.name = part.map->name;
+	animation.seconds = part.seconds;
+	animation.bytes = output_size() - start;
+	animation.decimated = part.decimated;
+	stats->decimated.keys += part.decimated.keys;
+	stats->decimated.timelines += part.decimated.timelines;
+	stats->decimated.bytes += part.decimated.bytes;
+	for (int i = 0; i < SPINE_TIMELINE_COUNT; ++i)
+	{
+		animation.timelines[i] = part.timelines[i];
+		stats->timelines[i].timelines += part.timelines[i].timelines;
+		stats->timelines[i].keys += part.timelines[i].keys;
+	}
+}
+
+/* Incremental conversion. */
+
+// The format of chunks and of their sidecar. Bump it with any change to how skins or animations are encoded, so
+// chunks of an older converter aren't spliced in.
+const uint32_t CHUNK_FORMAT = 1;
+const unsigned char CHUNK_MAGIC[4] = { 'S', 'C', 'H', 'K' };
+
+// A skin or an animation as a conversion encoded it, what its SkeletonPart had.
+struct EncodedChunk
+{
+	vector<unsigned char> bytes;
+	vector<string> strings; // string table mode, the part's pool
+	vector<OutputHole> stringHoles;
+};
+
+struct SpineChunksData
+{
+	unordered_map<uint64_t, EncodedChunk> chunks;
+	size_t reused = 0;
+	size_t encoded = 0;
+};
+
+// The text of a part left out of the parse as an empty object, in the conversion's copy of the json.
+struct ChunkSource
+{
+	char *start;
+	char *end; // just past the value
+};
+
+struct ChunkSources
+{
+	Json_Arena *arena;
+	unordered_map<const Json *, ChunkSource> parts; // by placeholder
+};
+
+static uint64_t hash_names(const NameTable &names, uint64_t h)
+{
+	for (size_t i = 0; i < names.size(); ++i)
+		h = spine_hash(names.name(i).c_str(), names.name(i).size() + 1, h); // the NUL keeps "ab", "c" from "a", "bc"
+	uint64_t count = names.size();
+	return spine_hash(&count, sizeof(count), h);
+}
+
+// The setup pose and tolerances the decimation of an animation depends on.
+static uint64_t hash_decimation(const SpineDecimation &tolerances, const SkeletonTables &tables, uint64_t h)
+{
+	h = spine_hash(&tolerances, sizeof(tolerances), h);
+	for (Json *slot : tables.slotMaps)
+	{
+		float values[9];
+		color_values(Json_getStringKey(slot, KEY_COLOR, 0), values);
+		color_values(Json_getStringKey(slot, KEY_DARK, 0), values + 4);
+		values[8] = Json_getStringKey(slot, KEY_DARK, 0) ? 1.0f : 0.0f;
+		const char *attachment = Json_getStringKey(slot, KEY_ATTACHMENT, "");
+		h = spine_hash(attachment, strlen(attachment) + 1, spine_hash(values, sizeof(values), h));
+	}
+	for (Json *ik : tables.ikMaps)
+	{
+		float values[2] = { Json_getFloatKey(ik, KEY_MIX, 1), (float)Json_getIntKey(ik, KEY_BEND_POSITIVE, 1) };
+		h = spine_hash(values, sizeof(values), h);
+	}
+	for (Json *transform : tables.transformMaps)
+	{
+		float values[4] = { Json_getFloatKey(transform, KEY_ROTATE_MIX, 1),
+			Json_getFloatKey(transform, KEY_TRANSLATE_MIX, 1), Json_getFloatKey(transform, KEY_SCALE_MIX, 1),
+			Json_getFloatKey(transform, KEY_SHEAR_MIX, 1) };
+		h = spine_hash(values, sizeof(values), h);
+	}
+	for (Json *path : tables.pathMaps)
+	{
+		float values[6] = { Json_getFloatKey(path, KEY_POSITION, 0), Json_getFloatKey(path, KEY_SPACING, 0),
+			Json_getFloatKey(path, KEY_ROTATE_MIX, 1), Json_getFloatKey(path, KEY_TRANSLATE_MIX, 1),
+			strcmp(Json_getStringKey(path, KEY_POSITION_MODE, "percent"), "fixed") == 0 ? 1.0f : 0.0f,
+			strcmp(Json_getStringKey(path, KEY_SPACING_MODE, "length"), "percent") == 0 ? 1.0f : 0.0f };
+		h = spine_hash(values, sizeof(values), h);
+	}
+	return h;
+}
+
+// Incremental conversion: splices in the chunk of each placeholder part that has one and parses the text of the
+// others. A chunk is only a part's when the part's text, its name and all its encoding looks up are the same, which is
+// the slots and the atlas for a skin and every table for an animation, with the setup pose when decimating. Returns -4 when a part's text doesn't parse.
+static int reuse_chunks(vector<SkeletonPart> &parts, const SkeletonTables &tables)
+{
+	SpineConverterState &state = *current;
+	uint64_t options[3] = { CHUNK_FORMAT, state.strings != nullptr, state.atlasHash };
+	uint64_t skinDeps = hash_names(tables.slots, spine_hash(options, sizeof(options), 4));
+	uint64_t animationDeps = spine_hash(options, 2 * sizeof(options[0]), 5);
+	for (const NameTable *names : { &tables.boneNames, &tables.slots, &tables.ik, &tables.transform, &tables.paths,
+		&tables.skins, &tables.eventNames })
+		animationDeps = hash_names(*names, animationDeps);
+	for (const EventData &event : tables.events)
+	{
+		// the values keys leave out
+		animationDeps = spine_hash(&event.intValue, sizeof(event.intValue), animationDeps);
+		animationDeps = spine_hash(&event.floatValue, sizeof(event.floatValue), animationDeps);
+	}
+	if (state.decimation)
+		animationDeps = hash_decimation(*state.decimation, tables, animationDeps);
+
+	for (SkeletonPart &part : parts)
+	{
+		auto source = state.sources->parts.find(part.map);
+		if (source == state.sources->parts.end())
+			continue;
+		ChunkSource &text = source->second;
+		const char *name = part.map->name;
+		part.key = spine_hash(text.start, text.end - text.start,
+			spine_hash(name, strlen(name), part.animation ? animationDeps : skinDeps));
+		part.keyed = true;
+
+		auto chunk = state.chunks->chunks.find(part.key);
+		if (chunk != state.chunks->chunks.end())
+		{
+			part.bytes = chunk->second.bytes;
+			for (const string &str : chunk->second.strings)
+				part.strings.names.add(str);
+			part.stringHoles = chunk->second.stringHoles;
+			part.encoded = true;
+			++state.chunks->reused;
+			continue;
+		}
+
+		*text.end = 0; // the text after the value isn't needed anymore
+		Json *map = Json_createInSitu(state.sources->arena, text.start);
+		if (!map)
+			return -4;
+		map->name = name;
+		part.map = map;
+		++state.chunks->encoded;
+	}
+	return 0;
+}
+
+// Replaces the chunks with the parts of a conversion that succeeded. Their bytes have been pushed, they are moved.
+static void keep_chunks(vector<SkeletonPart> &parts)
+{
+	unordered_map<uint64_t, EncodedChunk> kept;
+	for (SkeletonPart &part : parts)
+	{
+		if (!part.keyed || !part.encoded)
+			continue;
+		EncodedChunk &chunk = kept[part.key];
+		chunk.bytes = std::move(part.bytes);
+		chunk.strings.clear();
+		for (size_t i = 0; i < part.strings.names.size(); ++i)
+			chunk.strings.push_back(part.strings.names.name(i));
+		chunk.stringHoles = std::move(part.stringHoles);
+	}
+	current->chunks->chunks.swap(kept);
+}
+
+/* Dead data stripping. */
+
+// A string member, "" when it is missing or null.
+static const char *name_of(Json *map, int key)
+{
+	const char *name = Json_getStringKey(map, key, "");
+	return name ? name : "";
+}
+
+static bool keeps(const vector<string> &names, const char *name)
+{
+	return names.empty() || find(names.begin(), names.end(), name) != names.end();
+}
+
+static Json *find_child(Json *parent, const char *name)
+{
+	for (Json *child = parent ? parent->child : 0; child; child = child->next)
+	{
+		if (child->name && strcmp(child->name, name) == 0)
+			return child;
+	}
+	return 0;
+}
+
+// Whether map, when there is one, is an object, and so are its members down to depth levels, so each has a name.
+static bool objects(Json *map, int depth)
+{
+	if (!map)
+		return true;
+	if (map->type != Json_Object)
+		return false;
+	for (Json *child = depth > 1 ? map->child : 0; child; child = child->next)
+	{
+		if (!objects(child, depth - 1))
+			return false;
+	}
+	return true;
+}
+
+// Whether the maps the passes look up by name are objects, down to the names they read. When one isn't, a pass
+// leaves the skeleton alone and the conversion fails on it as usual.
+static bool named_maps(Json *root)
+{
+	Json *animations = Json_getItemKey(root, KEY_ANIMATIONS);
+	if (!objects(Json_getItemKey(root, KEY_SKINS), 3) || !objects(Json_getItemKey(root, KEY_EVENTS), 1) ||
+		!objects(animations, 2))
+		return false;
+	for (Json *animation = animations ? animations->child : 0; animation; animation = animation->next)
+	{
+		if (!objects(Json_getItemKey(animation, KEY_SLOTS), 2) || !objects(Json_getItemKey(animation, KEY_BONES), 2) ||
+			!objects(Json_getItemKey(animation, KEY_DEFORM), 3))
+			return false;
+	}
+	return true;
+}
+
+// The vertices of attachment when they are weighted, as push_vertices tells them apart. Only those whose bone counts
+// walk to the end of the array, one per vertex, so a pass never rewrites what isn't a bone index.
+static Json *weighted_vertices(Json *attachment)
+{
+	Json *vertices = Json_getItemKey(attachment, KEY_VERTICES);
+	int type = attachment_type(Json_getStringKey(attachment, KEY_TYPE, "region"));
+	int verticesLength;
+	if (type == ATTACHMENT_MESH)
+	{
+		Json *uvs = Json_getItemKey(attachment, KEY_UVS);
+		verticesLength = uvs ? uvs->size : 0;
+	}
+	else if (type == ATTACHMENT_BOUNDING_BOX || type == ATTACHMENT_PATH || type == ATTACHMENT_CLIPPING)
+		verticesLength = Json_getIntKey(attachment, KEY_VERTEX_COUNT, 0) << 1;
+	else
+		return 0;
+	if (!vertices || vertices->size <= 0 || vertices->size == verticesLength)
+		return 0;
+	int vertexCount = 0;
+	for (Json *entry = vertices->child; entry; ++vertexCount)
+	{
+		int count = (int)entry->valueFloat;
+		if (count < 0 || count > vertices->size)
+			return 0;
+		for (int skip = 0; skip <= count * 4; ++skip)
+		{
+			if (!entry)
+				return 0;
+			entry = entry->next;
+		}
+	}
+	return vertexCount << 1 == verticesLength ? vertices : 0;
+}
+
+// Calls bone with each bone index entry of weighted vertices: per vertex a bone count, then bone, x, y, weight each.
+template <class Bone>
+static void for_each_weight(Json *vertices, Bone bone)
+{
+	for (Json *entry = vertices->child; entry;)
+	{
+		int count = (int)entry->valueFloat;
+		entry = entry->next;
+		for (int i = 0; i < count && entry; ++i)
+		{
+			bone(entry);
+			for (int skip = 0; skip < 4 && entry; ++skip)
+				entry = entry->next;
+		}
+	}
+}
+
+// The order of the slots a draw order key sets, as the runtime reads its offsets. false when they don't make one.
+static bool draw_order(Json *offsets, const NameTable &slots, vector<int> &order)
+{
+	int slotCount = (int)slots.size();
+	order.assign(slotCount, -1);
+	vector<int> unchanged;
+	int original = 0;
+	for (Json *offsetMap = offsets->child; offsetMap; offsetMap = offsetMap->next)
+	{
+		int slot = slots.find(name_of(offsetMap, KEY_SLOT));
+		if (slot < original)
+			return false;
+		while (original != slot)
+			unchanged.push_back(original++);
+		int position = original + Json_getIntKey(offsetMap, KEY_OFFSET, 0);
+		if (position < 0 || position >= slotCount || order[position] != -1)
+			return false;
+		order[position] = original++;
+	}
+	while (original < slotCount)
+		unchanged.push_back(original++);
+	for (int i = slotCount - 1; i >= 0; --i)
+	{
+		if (order[i] == -1)
+			order[i] = unchanged.back(), unchanged.pop_back();
+	}
+	return true;
+}
+
+static Json *new_node(Json_Arena *arena, int type, const char *name, int key)
+{
+	Json *node = (Json *)Json_Arena_alloc(arena, sizeof(Json));
+	if (!node)
+		return 0;
+	memset(node, 0, sizeof(Json));
+	node->type = type;
+	node->name = name;
+	node->key = key;
+	return node;
+}
+
+// Rewrites the offsets of a draw order key for the slots kept, newIndex by old index, -1 for a slot removed.
+static void remap_draw_order(Json *offsets, const NameTable &slots, const vector<const char *> &slotNames,
+	const vector<int> &newIndex, Json_Arena *arena)
+{
+	vector<int> order;
+	if (!draw_order(offsets, slots, order))
+		return; // the encoder writes it as it is
+	vector<int> position(slots.size());
+	int kept = 0;
+	for (int slot : order)
+	{
+		if (newIndex[slot] != -1)
+			position[newIndex[slot]] = kept++;
+	}
+	Json *first = 0, **link = &first;
+	int size = 0;
+	for (size_t slot = 0; slot < slots.size(); ++slot)
+	{
+		int index = newIndex[slot];
+		if (index == -1 || position[index] == index)
+			continue;
+		Json *offsetMap = new_node(arena, Json_Object, "", 0);
+		Json *slotName = new_node(arena, Json_String, "slot", KEY_SLOT);
+		Json *offset = new_node(arena, Json_Number, "offset", KEY_OFFSET);
+		if (!offsetMap || !slotName || !offset)
+			return;
+		slotName->valueString = slotNames[slot];
+		offset->valueInt = position[index] - index;
+		offset->valueFloat = (float)offset->valueInt;
+		slotName->next = offset;
+		offsetMap->child = slotName;
+		offsetMap->size = 2;
+		*link = offsetMap;
+		link = &offsetMap->next;
+		++size;
+	}
+	offsets->child = first;
+	offsets->size = size;
+}
+
+// Cuts the parsed skeleton at root down to what keep and the skeleton reach. Leaves alone what the conversion fails
+// on, so the error is the same. New draw order offsets are carved from arena.
+static void strip_skeleton(Json *root, const SpineStripping &keep, Json_Arena *arena, SpineStrippedCount &count)
+{
+	Json *bones = Json_getItemKey(root, KEY_BONES), *slots = Json_getItemKey(root, KEY_SLOTS);
+	Json *skins = Json_getItemKey(root, KEY_SKINS), *events = Json_getItemKey(root, KEY_EVENTS);
+	Json *animations = Json_getItemKey(root, KEY_ANIMATIONS);
+	if (!bones || !slots || !skins || !arena || !named_maps(root))
+		return;
+	NameTable boneNames, slotNames, skinNames;
+	vector<const char *> slotNameStrings; // outlive the tables, in the parsed json
+	for (Json *bone = bones->child; bone; bone = bone->next)
+		boneNames.add(name_of(bone, KEY_NAME));
+	for (Json *slot = slots->child; slot; slot = slot->next)
+	{
+		slotNameStrings.push_back(name_of(slot, KEY_NAME));
+		slotNames.add(slotNameStrings.back());
+	}
+	for (Json *skin = skins->child; skin; skin = skin->next)
+		skinNames.add(skin->name);
+
+	// Names kept that aren't there, likely misspelt.
+	NameTable animationNames;
+	for (Json *animation = animations ? animations->child : 0; animation; animation = animation->next)
+		animationNames.add(animation->name);
+	auto unmatched = [&](const vector<string> &names, const NameTable &table, const char *list) {
+		for (const string &name : names)
+		{
+			if (table.find(name) == -1)
+				count.unmatched.push_back(list + ("/" + name));
+		}
+	};
+	unmatched(keep.animations, animationNames, "animations");
+	unmatched(keep.skins, skinNames, "skins");
+	unmatched(keep.bones, boneNames, "bones");
+
+	if (animations)
+	{
+		unlink_children(animations, [&](Json *animation) {
+			bool removed = !keeps(keep.animations, animation->name);
+			count.animations += removed;
+			return removed;
+		});
+	}
+
+	// The attachment names each slot shows, and the events fired.
+	vector<unordered_set<string>> shown(slotNames.size());
+	unordered_set<string> fired;
+	int slot = 0;
+	for (Json *slotMap = slots->child; slotMap; slotMap = slotMap->next, ++slot)
+	{
+		const char *attachment = Json_getStringKey(slotMap, KEY_ATTACHMENT, 0);
+		if (attachment)
+			shown[slot].insert(attachment);
+	}
+	for (Json *animation = animations ? animations->child : 0; animation; animation = animation->next)
+	{
+		Json *slotTimelines = Json_getItemKey(animation, KEY_SLOTS);
+		for (Json *slotMap = slotTimelines ? slotTimelines->child : 0; slotMap; slotMap = slotMap->next)
+		{
+			int index = slotNames.find(slotMap->name);
+			Json *keys = Json_getItemKey(slotMap, KEY_ATTACHMENT);
+			for (Json *valueMap = index != -1 && keys ? keys->child : 0; valueMap; valueMap = valueMap->next)
+			{
+				const char *name = Json_getStringKey(valueMap, KEY_NAME, 0);
+				if (name)
+					shown[index].insert(name);
+			}
+		}
+		Json *eventKeys = Json_getItemKey(animation, KEY_EVENTS);
+		for (Json *valueMap = eventKeys ? eventKeys->child : 0; valueMap; valueMap = valueMap->next)
+		{
+			const char *name = Json_getStringKey(valueMap, KEY_NAME, 0);
+			if (name)
+				fired.insert(name);
+		}
+	}
+
+	// The attachments reached, then the parents of the linked meshes among them, with their skins.
+	unordered_set<const Json *> keptSkins, keptAttachments;
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{
+		if (strcmp(skin->name, "default") == 0 || keeps(keep.skins, skin->name))
+			keptSkins.insert(skin);
+	}
+	vector<pair<Json *, const char *>> linked; // with its slot
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{
+		for (Json *slotMap = keptSkins.count(skin) ? skin->child : 0; slotMap; slotMap = slotMap->next)
+		{
+			int index = slotNames.find(slotMap->name);
+			for (Json *attachment = index != -1 ? slotMap->child : 0; attachment; attachment = attachment->next)
+			{
+				const char *type = Json_getStringKey(attachment, KEY_TYPE, "region");
+				const char *name = Json_getStringKey(attachment, KEY_NAME, attachment->name);
+				if (!shown[index].count(attachment->name) ||
+					!attachment_in_atlas(type, Json_getStringKey(attachment, KEY_PATH, name)))
+					continue;
+				keptAttachments.insert(attachment);
+				if (attachment_type(type) == ATTACHMENT_LINKED_MESH)
+					linked.push_back(make_pair(attachment, slotMap->name));
+			}
+		}
+	}
+	for (auto &mesh : linked)
+	{
+		// a linked mesh is in the same slot as its parent
+		const char *skinName = Json_getStringKey(mesh.first, KEY_SKIN, 0);
+		const char *parentName = Json_getStringKey(mesh.first, KEY_PARENT, 0);
+		Json *skin = find_child(skins, skinName ? skinName : "default");
+		Json *parent = parentName ? find_child(find_child(skin, mesh.second), parentName) : 0;
+		if (parent)
+		{
+			keptAttachments.insert(parent);
+			keptSkins.insert(skin);
+		}
+	}
+
+	// The slots and bones reached.
+	vector<bool> keptSlots(slotNames.size()), keptBones(boneNames.size());
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{
+		for (Json *slotMap = keptSkins.count(skin) ? skin->child : 0; slotMap; slotMap = slotMap->next)
+		{
+			int index = slotNames.find(slotMap->name);
+			for (Json *attachment = index != -1 ? slotMap->child : 0; attachment; attachment = attachment->next)
+			{
+				if (!keptAttachments.count(attachment))
+					continue;
+				keptSlots[index] = true;
+				int end = slotNames.find(name_of(attachment, KEY_END));
+				if (end != -1)
+					keptSlots[end] = true;
+				if (Json *vertices = weighted_vertices(attachment))
+				{
+					for_each_weight(vertices, [&](Json *bone) {
+						int index = (int)bone->valueFloat;
+						if (index >= 0 && index < (int)keptBones.size())
+							keptBones[index] = true;
+					});
+				}
+			}
+		}
+	}
+	Json *paths = Json_getItemKey(root, KEY_PATH);
+	for (Json *pathMap = paths ? paths->child : 0; pathMap; pathMap = pathMap->next)
+	{
+		int target = slotNames.find(name_of(pathMap, KEY_TARGET));
+		if (target != -1)
+			keptSlots[target] = true;
+	}
+	slot = 0;
+	for (Json *slotMap = slots->child; slotMap; slotMap = slotMap->next, ++slot)
+	{
+		int bone = boneNames.find(name_of(slotMap, KEY_BONE));
+		if (keptSlots[slot] && bone != -1)
+			keptBones[bone] = true;
+	}
+	for (Json *constraints : { Json_getItemKey(root, KEY_IK), Json_getItemKey(root, KEY_TRANSFORM), paths })
+	{
+		for (Json *constraint = constraints ? constraints->child : 0; constraint; constraint = constraint->next)
+		{
+			Json *constrained = Json_getItemKey(constraint, KEY_BONES);
+			for (Json *bone = constrained ? constrained->child : 0; bone; bone = bone->next)
+			{
+				int index = bone->valueString ? boneNames.find(bone->valueString) : -1;
+				if (index != -1)
+					keptBones[index] = true;
+			}
+			int target = boneNames.find(name_of(constraint, KEY_TARGET));
+			if (target != -1 && constraints != paths) // a path's target is a slot
+				keptBones[target] = true;
+		}
+	}
+	for (const string &name : keep.bones)
+	{
+		int index = boneNames.find(name);
+		if (index != -1)
+			keptBones[index] = true;
+	}
+	if (!keptBones.empty())
+		keptBones[0] = true; // the root
+	vector<Json *> boneMaps;
+	for (Json *boneMap = bones->child; boneMap; boneMap = boneMap->next)
+		boneMaps.push_back(boneMap);
+	for (bool changed = true; changed;) // parents usually come first, then a pass from the end is enough
+	{
+		changed = false;
+		for (int bone = (int)boneMaps.size() - 1; bone >= 0; --bone)
+		{
+			int parent = boneNames.find(name_of(boneMaps[bone], KEY_PARENT));
+			if (keptBones[bone] && parent != -1 && !keptBones[parent])
+				changed = keptBones[parent] = true;
+		}
+	}
+
+	// What is left, by old index.
+	vector<int> newSlot(slotNames.size(), -1), newBone(boneNames.size(), -1);
+	int kept = 0;
+	for (size_t i = 0; i < newSlot.size(); ++i)
+		newSlot[i] = keptSlots[i] ? kept++ : -1;
+	kept = 0;
+	for (size_t i = 0; i < newBone.size(); ++i)
+		newBone[i] = keptBones[i] ? kept++ : -1;
+	bool slotsRemoved = find(keptSlots.begin(), keptSlots.end(), false) != keptSlots.end();
+
+	// Removes them.
+	unlink_children(skins, [&](Json *skin) {
+		bool removed = !keptSkins.count(skin);
+		count.skins += removed;
+		return removed;
+	});
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{
+		unlink_children(skin, [&](Json *slotMap) {
+			if (slotNames.find(slotMap->name) == -1)
+				return false;
+			unlink_children(slotMap, [&](Json *attachment) {
+				bool removed = !keptAttachments.count(attachment);
+				const char *name = Json_getStringKey(attachment, KEY_NAME, attachment->name);
+				if (removed && attachment_in_atlas(Json_getStringKey(attachment, KEY_TYPE, "region"),
+					Json_getStringKey(attachment, KEY_PATH, name)))
+					++count.attachments; // not one the atlas filters out anyway
+				return removed;
+			});
+			return slotMap->size == 0;
+		});
+		for (Json *slotMap = skin->child; slotMap; slotMap = slotMap->next)
+		{
+			for (Json *attachment = slotMap->child; attachment; attachment = attachment->next)
+			{
+				if (Json *vertices = weighted_vertices(attachment))
+				{
+					for_each_weight(vertices, [&](Json *bone) {
+						int index = (int)bone->valueFloat;
+						if (index >= 0 && index < (int)newBone.size())
+						{
+							bone->valueInt = newBone[index];
+							bone->valueFloat = (float)newBone[index];
+						}
+					});
+				}
+			}
+		}
+	}
+	slot = 0;
+	unlink_children(slots, [&](Json *) {
+		bool removed = !keptSlots[slot++];
+		count.slots += removed;
+		return removed;
+	});
+	int bone = 0;
+	unlink_children(bones, [&](Json *) {
+		bool removed = !keptBones[bone++];
+		count.bones += removed;
+		return removed;
+	});
+	if (events)
+	{
+		unlink_children(events, [&](Json *event) {
+			bool removed = !fired.count(event->name);
+			count.events += removed;
+			return removed;
+		});
+	}
+
+	for (Json *animation = animations ? animations->child : 0; animation; animation = animation->next)
+	{
+		auto drop_timelines = [&](Json *group, const NameTable &names, const vector<int> &newIndex) {
+			if (!group)
+				return;
+			unlink_children(group, [&](Json *map) {
+				int index = names.find(map->name);
+				bool removed = index != -1 && newIndex[index] == -1;
+				if (removed)
+					count.timelines += map->size;
+				return removed;
+			});
+		};
+		drop_timelines(Json_getItemKey(animation, KEY_SLOTS), slotNames, newSlot);
+		drop_timelines(Json_getItemKey(animation, KEY_BONES), boneNames, newBone);
+
+		Json *deform = Json_getItemKey(animation, KEY_DEFORM);
+		if (deform)
+		{
+			unlink_children(deform, [&](Json *skinMap) {
+				if (skinNames.find(skinMap->name) == -1)
+					return false;
+				Json *skin = find_child(skins, skinMap->name);
+				unlink_children(skinMap, [&](Json *slotMap) {
+					int index = slotNames.find(slotMap->name);
+					if (index == -1)
+						return false;
+					Json *attachments = find_child(skin, slotMap->name);
+					unlink_children(slotMap, [&](Json *timelineMap) {
+						bool removed = newSlot[index] == -1 || !find_child(attachments, timelineMap->name);
+						count.timelines += removed;
+						return removed;
+					});
+					return slotMap->size == 0;
+				});
+				return skinMap->size == 0;
+			});
+		}
+
+		Json *drawOrder = Json_getItemKey(animation, KEY_DRAW_ORDER);
+		for (Json *valueMap = drawOrder && slotsRemoved ? drawOrder->child : 0; valueMap; valueMap = valueMap->next)
+		{
+			Json *offsets = Json_getItemKey(valueMap, KEY_OFFSETS);
+			if (offsets)
+				remap_draw_order(offsets, slotNames, slotNameStrings, newSlot, arena);
+		}
+	}
+}
+
+
+/* Meshes and their deform keys. */
+
+// A mesh attachment of the parsed skeleton with the arrays the encoder writes, and the deform keys with vertices of it
+// and its linked meshes. valid when they all fit its vertices, so a pass can rewrite them.
+struct DeformedMesh
+{
+	const char *skin, *slot;
+	Json *attachment;
+	Json *uvs, *triangles, *vertices;
+	int vertexCount;
+	int hull; // the first vertices
+	vector<int> influences; // per vertex when weighted
+	vector<Json *> deformKeys;
+	bool valid;
+};
+
+static bool read_mesh(Json *attachment, DeformedMesh &mesh)
+{
+	mesh.attachment = attachment;
+	mesh.uvs = Json_getItemKey(attachment, KEY_UVS);
+	mesh.triangles = Json_getItemKey(attachment, KEY_TRIANGLES);
+	mesh.vertices = Json_getItemKey(attachment, KEY_VERTICES);
+	if (!mesh.uvs || !mesh.triangles || !mesh.vertices || mesh.uvs->size <= 0 || mesh.uvs->size & 1 ||
+		mesh.triangles->size % 3)
+		return false;
+	mesh.vertexCount = mesh.uvs->size >> 1;
+	mesh.hull = Json_getIntKey(attachment, KEY_HULL, 0) >> 1;
+	if (mesh.hull < 0 || mesh.hull > mesh.vertexCount)
+		return false;
+	for (Json *index = mesh.triangles->child; index; index = index->next)
+	{
+		if (index->valueInt < 0 || index->valueInt >= mesh.vertexCount)
+			return false;
+	}
+	mesh.influences.clear();
+	if (mesh.vertices->size != mesh.uvs->size)
+	{
+		for (Json *entry = mesh.vertices->child; entry;)
+		{
+			int count = (int)entry->valueFloat;
+			if (count < 0 || count > mesh.vertices->size)
+				return false;
+			mesh.influences.push_back(count);
+			for (int skip = 0; skip <= count * 4; ++skip)
+			{
+				if (!entry)
+					return false;
+				entry = entry->next;
+			}
+		}
+		if ((int)mesh.influences.size() != mesh.vertexCount)
+			return false;
+	}
+	mesh.deformKeys.clear();
+	mesh.valid = true;
+	return true;
+}
+
+// The values of a deform key of mesh, two per vertex, or per influence when it is weighted.
+static int deform_length(const DeformedMesh &mesh)
+{
+	if (mesh.influences.empty())
+		return mesh.vertexCount * 2;
+	int length = 0;
+	for (int influences : mesh.influences)
+		length += influences * 2;
+	return length;
+}
+
+// The mesh a deform timeline of skin and slot names, the attachment it holds or the parent of that linked mesh.
+static Json *deformed_mesh(Json *skins, const char *skin, const char *slot, const char *attachment)
+{
+	Json *found = find_child(find_child(find_child(skins, skin), slot), attachment);
+	if (found && attachment_type(Json_getStringKey(found, KEY_TYPE, "region")) == ATTACHMENT_LINKED_MESH)
+	{
+		const char *parentSkin = Json_getStringKey(found, KEY_SKIN, 0);
+		const char *parent = Json_getStringKey(found, KEY_PARENT, 0);
+		found = parent ? find_child(find_child(find_child(skins, parentSkin ? parentSkin : "default"), slot), parent) : 0;
+	}
+	return found && attachment_type(Json_getStringKey(found, KEY_TYPE, "region")) == ATTACHMENT_MESH ? found : 0;
+}
+
+// The meshes of the parsed skeleton at root the encoder writes, those in the atlas, in skin order, with their deform
+// keys. None when its maps aren't objects.
+static void gather_meshes(Json *root, vector<DeformedMesh> &meshes)
+{
+	if (!named_maps(root))
+		return;
+	Json *skins = Json_getItemKey(root, KEY_SKINS), *animations = Json_getItemKey(root, KEY_ANIMATIONS);
+	unordered_map<const Json *, size_t> meshIndex;
+	for (Json *skin = skins ? skins->child : 0; skin; skin = skin->next)
+	{
+		for (Json *slotMap = skin->child; slotMap; slotMap = slotMap->next)
+		{
+			for (Json *attachment = slotMap->child; attachment; attachment = attachment->next)
+			{
+				DeformedMesh mesh;
+				const char *type = Json_getStringKey(attachment, KEY_TYPE, "region");
+				const char *name = Json_getStringKey(attachment, KEY_NAME, attachment->name);
+				if (attachment_type(type) != ATTACHMENT_MESH ||
+					!attachment_in_atlas(type, Json_getStringKey(attachment, KEY_PATH, name)) || !read_mesh(attachment, mesh))
+					continue;
+				mesh.skin = skin->name;
+				mesh.slot = slotMap->name;
+				meshIndex[attachment] = meshes.size();
+				meshes.push_back(std::move(mesh));
+			}
+		}
+	}
+
+	for (Json *animation = animations && skins ? animations->child : 0; animation; animation = animation->next)
+	{
+		Json *deform = Json_getItemKey(animation, KEY_DEFORM);
+		for (Json *skinMap = deform ? deform->child : 0; skinMap; skinMap = skinMap->next)
+		{
+			for (Json *slotMap = skinMap->child; slotMap; slotMap = slotMap->next)
+			{
+				for (Json *timelineMap = slotMap->child; timelineMap; timelineMap = timelineMap->next)
+				{
+					auto found = meshIndex.find(deformed_mesh(skins, skinMap->name, slotMap->name, timelineMap->name));
+					if (found == meshIndex.end())
+						continue;
+					DeformedMesh &mesh = meshes[found->second];
+					int length = deform_length(mesh);
+					for (Json *valueMap = timelineMap->child; valueMap; valueMap = valueMap->next)
+					{
+						Json *vertices = Json_getItemKey(valueMap, KEY_VERTICES);
+						if (!vertices || vertices->size == 0)
+							continue; // written without vertices, or as the encoder writes an empty array
+						int start = Json_getIntKey(valueMap, KEY_OFFSET, 0);
+						if (start < 0 || start + vertices->size > length)
+							mesh.valid = false;
+						mesh.deformKeys.push_back(valueMap);
+					}
+				}
+			}
+		}
+	}
+}
+
+static void write_values(Json *array, const vector<float> &values)
+{
+	size_t i = 0;
+	for (Json *entry = array->child; entry && i < values.size(); entry = entry->next, ++i)
+	{
+		entry->valueFloat = values[i];
+		entry->valueInt = (int)values[i];
+	}
+}
+
+// Sets the values of array to count values, reusing its entries and carving more from arena. false when out of memory.
+static bool set_values(Json *array, const float *values, int count, Json_Arena *arena)
+{
+	Json **link = &array->child, *previous = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		if (!*link && !(*link = new_node(arena, Json_Number, "", 0)))
+			return false;
+#if SPINE_JSON_HAVE_PREV
+		(*link)->prev = previous;
+#endif
+		(*link)->valueFloat = values[i];
+		(*link)->valueInt = (int)values[i];
+		previous = *link;
+		link = &previous->next;
+	}
+	*link = 0;
+	array->size = count;
+	return true;
+}
+
+// All length values of a deform key, 0 outside the span it sets.
+static vector<float> deform_values(Json *valueMap, int length)
+{
+	vector<float> values(length);
+	Json *vertices = Json_getItemKey(valueMap, KEY_VERTICES);
+	int i = Json_getIntKey(valueMap, KEY_OFFSET, 0);
+	for (Json *entry = vertices ? vertices->child : 0; entry && i < length; entry = entry->next)
+		values[i++] = entry->valueFloat;
+	return values;
+}
+
+// Sets a deform key to values, keeping only the span between the first and last non-zero ones. false when out of
+// memory.
+static bool set_deform(Json *valueMap, const vector<float> &values, Json_Arena *arena)
+{
+	size_t first = 0, end = values.size();
+	while (first < end && values[first] == 0)
+		++first;
+	while (end > first && values[end - 1] == 0)
+		--end;
+	if (first == end)
+	{
+		// no deform left, which the encoder writes as a key without vertices
+		unlink_children(valueMap, [](Json *member) {
+			return member->key == KEY_VERTICES || member->key == KEY_OFFSET;
+		});
+		return true;
+	}
+	Json *offset = Json_getItemKey(valueMap, KEY_OFFSET);
+	if (!offset && first)
+	{
+		if (!(offset = new_node(arena, Json_Number, "offset", KEY_OFFSET)))
+			return false;
+		offset->next = valueMap->child;
+#if SPINE_JSON_HAVE_PREV
+		if (valueMap->child)
+			valueMap->child->prev = offset;
+#endif
+		valueMap->child = offset;
+		++valueMap->size;
+	}
+	if (offset)
+	{
+		offset->valueInt = (int)first;
+		offset->valueFloat = (float)first;
+	}
+	return set_values(Json_getItemKey(valueMap, KEY_VERTICES), values.data() + first, (int)(end - first), arena);
+}
+
+
+/* Vertex cache optimization. */
+
+// The misses of triangles, vertex indices by three, on a FIFO post-transform cache of cacheSize vertices.
+static size_t cache_misses(const vector<int> &triangles, int vertexCount, int cacheSize)
+{
+	vector<size_t> stamp(vertexCount); // the misses when it went in, 0 for never
+	size_t misses = 0;
+	for (int v : triangles)
+	{
+		if (!stamp[v] || misses - stamp[v] >= (size_t)cacheSize)
+			stamp[v] = ++misses;
+	}
+	return misses;
+}
+
+// Tipsify, Sander, Nehab and Barczak 2007: the triangles are emitted in fans around a vertex, the next one chosen among
+// the vertices of the fan for how likely they still are in the cache once its own triangles are emitted.
+static vector<int> tipsify(const vector<int> &triangles, int vertexCount, int cacheSize)
+{
+	vector<int> live(vertexCount), start(vertexCount + 1), adjacent(triangles.size());
+	for (int v : triangles)
+		++live[v];
+	for (int v = 0; v < vertexCount; ++v)
+		start[v + 1] = start[v] + live[v];
+	vector<int> next(start.begin(), start.end() - 1);
+	for (size_t i = 0; i < triangles.size(); ++i)
+		adjacent[next[triangles[i]]++] = (int)i / 3;
+
+	vector<int> out, stamp(vertexCount), deadEnd, candidates;
+	vector<bool> emitted(triangles.size() / 3);
+	out.reserve(triangles.size());
+	int time = cacheSize + 1, cursor = 0;
+	for (int fan = 0; fan != -1;)
+	{
+		candidates.clear();
+		for (int i = start[fan]; i < start[fan + 1]; ++i)
+		{
+			int triangle = adjacent[i];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				int v = triangles[triangle * 3 + corner];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - stamp[v] > cacheSize)
+					stamp[v] = time++;
+			}
+		}
+		int best = -1;
+		fan = -1;
+		for (int v : candidates)
+		{
+			if (live[v] <= 0)
+				continue;
+			int priority = time - stamp[v] + 2 * live[v] <= cacheSize ? time - stamp[v] : 0;
+			if (priority > best)
+				best = priority, fan = v;
+		}
+		while (fan == -1 && !deadEnd.empty())
+		{
+			if (live[deadEnd.back()] > 0)
+				fan = deadEnd.back();
+			deadEnd.pop_back();
+		}
+		for (; fan == -1 && cursor < vertexCount; ++cursor)
+		{
+			if (live[cursor] > 0)
+				fan = cursor;
+		}
+	}
+	return out;
+}
+
+// Where the floats of each vertex of mesh start, head of them and width per influence when it is weighted, two
+// otherwise. The total is last.
+static vector<int> vertex_starts(const DeformedMesh &mesh, int head, int width)
+{
+	vector<int> starts(1, 0);
+	for (int v = 0; v < mesh.vertexCount; ++v)
+		starts.push_back(starts.back() + (mesh.influences.empty() ? 2 : head + width * mesh.influences[v]));
+	return starts;
+}
+
+// Renumbers the vertices of mesh, order holding the old index of each new one, and lays its deform keys out to match.
+static bool reorder_vertices(DeformedMesh &mesh, const vector<int> &order, Json_Arena *arena)
+{
+	vector<float> values = gather_floats(mesh.uvs), out;
+	for (int v : order)
+		out.insert(out.end(), values.begin() + v * 2, values.begin() + v * 2 + 2);
+	write_values(mesh.uvs, out);
+
+	vector<int> starts = vertex_starts(mesh, 1, 4);
+	values = gather_floats(mesh.vertices);
+	out.clear();
+	for (int v : order)
+		out.insert(out.end(), values.begin() + starts[v], values.begin() + starts[v + 1]);
+	write_values(mesh.vertices, out);
+
+	starts = vertex_starts(mesh, 0, 2);
+	for (Json *valueMap : mesh.deformKeys)
+	{
+		values = deform_values(valueMap, starts.back());
+		out.clear();
+		for (int v : order)
+			out.insert(out.end(), values.begin() + starts[v], values.begin() + starts[v + 1]);
+		if (!set_deform(valueMap, out, arena))
+			return false;
+	}
+	return true;
+}
+
+// Reorders the triangles and vertices of the meshes of the parsed skeleton at root for a cache of cacheSize vertices.
+// A mesh whose arrays or deform keys don't fit its vertices is left alone. New json values are carved from arena.
+static void optimize_vertex_cache(Json *root, int cacheSize, Json_Arena *arena, SpineVertexCacheCount &count)
+{
+	vector<DeformedMesh> meshes;
+	gather_meshes(root, meshes);
+	for (DeformedMesh &mesh : meshes)
+	{
+		if (!mesh.valid)
+			continue;
+		vector<int> triangles = gather_ints(mesh.triangles);
+		vector<int> optimized = tipsify(triangles, mesh.vertexCount, cacheSize);
+		size_t before = cache_misses(triangles, mesh.vertexCount, cacheSize);
+		size_t after = cache_misses(optimized, mesh.vertexCount, cacheSize);
+		if (after >= before)
+			optimized = triangles, after = before;
+
+		// hull vertices in place, then the others as the triangles first use them
+		vector<int> order, newIndex(mesh.vertexCount, -1);
+		for (int v = 0; v < mesh.hull; ++v)
+			newIndex[v] = v, order.push_back(v);
+		for (int v : optimized)
+		{
+			if (newIndex[v] == -1)
+				newIndex[v] = (int)order.size(), order.push_back(v);
+		}
+		for (int v = mesh.hull; v < mesh.vertexCount; ++v)
+		{
+			if (newIndex[v] == -1)
+				newIndex[v] = (int)order.size(), order.push_back(v);
+		}
+		vector<float> indices;
+		for (int v : optimized)
+			indices.push_back((float)newIndex[v]);
+		write_values(mesh.triangles, indices);
+		if (!reorder_vertices(mesh, order, arena))
+			return;
+
+		++count.meshes;
+		count.triangles += triangles.size() / 3;
+		count.missesBefore += before;
+		count.missesAfter += after;
+	}
+}
+
+
+/* Influence limits. */
+
+// A bone a weighted vertex follows: its index, x, y and weight as authored, and where it was among all of the mesh's.
+struct Influence
+{
+	float values[4];
+	int index;
+};
+
+// Limits the influences of the weighted vertices of mesh, and lays its deform keys out to match. false when out of
+// memory.
+static bool limit_mesh(DeformedMesh &mesh, const SpineInfluences &limits, Json_Arena *arena,
+	SpineMeshInfluences &count)
+{
+	vector<float> values = gather_floats(mesh.vertices), out;
+	vector<int> kept; // the influences left, by their index
+	vector<Influence> influences;
+	size_t at = 0;
+	int index = 0;
+	bool changed = false;
+	for (int v = 0; v < mesh.vertexCount; ++v)
+	{
+		int authored = (int)values[at++];
+		influences.clear();
+		float total = 0;
+		for (int i = 0; i < authored; ++i, at += 4)
+		{
+			Influence influence;
+			copy(&values[at], &values[at] + 4, influence.values);
+			influence.index = index++;
+			total += influence.values[3];
+			influences.push_back(influence);
+		}
+
+		// the heaviest first, then the light ones and those past the limit go, but never the heaviest
+		stable_sort(influences.begin(), influences.end(), [](const Influence &a, const Influence &b) {
+			return a.values[3] > b.values[3];
+		});
+		size_t left = influences.size();
+		while (left > 1 && influences[left - 1].values[3] < limits.minWeight)
+			--left;
+		if (limits.max > 0 && left > (size_t)limits.max)
+			left = limits.max;
+		if (left < influences.size())
+		{
+			influences.resize(left);
+			float sum = 0;
+			for (const Influence &influence : influences)
+				sum += influence.values[3];
+			for (Influence &influence : influences)
+				influence.values[3] = sum > 0 ? influence.values[3] * total / sum : influence.values[3];
+		}
+		stable_sort(influences.begin(), influences.end(), [](const Influence &a, const Influence &b) {
+			return (int)a.values[0] < (int)b.values[0];
+		});
+
+		out.push_back((float)influences.size());
+		for (const Influence &influence : influences)
+		{
+			out.insert(out.end(), influence.values, influence.values + 4);
+			changed = changed || influence.index != (int)kept.size();
+			kept.push_back(influence.index);
+		}
+		++count.vertices;
+		count.before += authored;
+		count.after += influences.size();
+	}
+	if (!changed && (int)kept.size() == index)
+		return true;
+	if (!set_values(mesh.vertices, out.data(), (int)out.size(), arena))
+		return false;
+
+	for (Json *valueMap : mesh.deformKeys)
+	{
+		vector<float> deform = deform_values(valueMap, index * 2);
+		out.clear();
+		for (int influence : kept)
+			out.insert(out.end(), deform.begin() + influence * 2, deform.begin() + influence * 2 + 2);
+		if (!set_deform(valueMap, out, arena))
+			return false;
+	}
+	return true;
+}
+
+// Limits the influences of the weighted meshes of the parsed skeleton at root, counting them in counts. A mesh whose
+// arrays or deform keys don't fit its vertices is left alone. New json values are carved from arena.
+static void limit_influences(Json *root, const SpineInfluences &limits, Json_Arena *arena,
+	vector<SpineMeshInfluences> &counts)
+{
+	vector<DeformedMesh> meshes;
+	gather_meshes(root, meshes);
+	for (DeformedMesh &mesh : meshes)
+	{
+		if (!mesh.valid || mesh.influences.empty())
+			continue;
+		SpineMeshInfluences count;
+		count.name = string(mesh.skin) + '/' + mesh.slot + '/' + mesh.attachment->name;
+		if (!limit_mesh(mesh, limits, arena, count))
+			return;
+		counts.push_back(count);
+	}
+}
+
+
+static int convert_skeleton(Json *root)
+{
+	SectionClock clock(current->stats);
+
+	// skeleton
+	Json* skeleton = Json_getItemKey(root, KEY_SKELETON);
+	if (!skeleton) {
+		return -5;
+	}
+
+	const char *hash = Json_getStringKey(skeleton, KEY_HASH, "");
+	if (!hash) {
+		return -6;
+	}
+	push_string(hash);
+
+	const char *version = Json_getStringKey(skeleton, KEY_SPINE, "");
+	if (!version) {
+		return -7;
+	}
+	push_string(version);
+
+	float width = Json_getFloatKey(skeleton, KEY_WIDTH, 0);
+	push_float(width);
+
+	float height = Json_getFloatKey(skeleton, KEY_HEIGHT, 0);
+	push_float(height);
 
 	push_boolen(false);
+	clock.charge(SPINE_SECTION_HEADER);
+		
+	// bones
+	Json* bones = Json_getItemKey(root, KEY_BONES);
+	if (!bones || bones->size == 0) {
+		return -8;
+	}
+	SkeletonTables tables;
+	process_bones(bones, tables);
+	push_varint(tables.bones.size(), 1);
+	for (size_t i=0;i<tables.bones.size();++i)
+	{
+		const BoneData &bone = tables.bones[i];
+		push_string(bone.name.c_str());
+		if (i > 0)
+			push_varint(bone.parent, 1);
+		push_float(bone.rotation);
+		push_float(bone.x);
+		push_float(bone.y);
+		push_float(bone.scaleX);
+		push_float(bone.scaleY);
+		push_float(bone.shearX);
+		push_float(bone.shearY);
+		push_float(bone.length);
+		push_varint(bone.mode, 1);
+	}
+	clock.charge(SPINE_SECTION_BONES);
+
+	// Slots
+	Json* slots = Json_getItemKey(root, KEY_SLOTS);
+	if (!slots || slots->size == 0) {
+		return -9;
+	}
+	push_varint(slots->size, 1);
+
+	for (Json *slot = slots->child; slot; slot = slot->next)
+	{
+		const char *name = Json_getStringKey(slot, KEY_NAME, "");
+		push_string(name);
+		tables.slots.add(name);
+		tables.slotMaps.push_back(slot);
+
+		string boneName = Json_getStringKey(slot, KEY_BONE, "");
+		int boneIndex = tables.boneNames.find(boneName);
+		if (boneIndex == -1) {
+			return -10;
+		}
+		push_varint(boneIndex, 1);
+			
+		const char *color = Json_getStringKey(slot, KEY_COLOR, 0);
+		push_color(color);
+
+		const char *dark = Json_getStringKey(slot, KEY_DARK, 0);
+		push_color(dark);
+
+		const char *attachment = Json_getStringKey(slot, KEY_ATTACHMENT, "");
+		push_string(attachment);
+
+		Json *blend = Json_getItemKey(slot, KEY_BLEND);
+		int blendMode = 0;
+		if (blend) {
+			if (string(blend->valueString) == "additive")
+				blendMode = 1;
+			else if (string(blend->valueString) == "multiply")
+				blendMode = 2;
+			else if (string(blend->valueString) == "screen")
+				blendMode = 3;
+		}
+		push_varint(blendMode, 1);
+	}
+	clock.charge(SPINE_SECTION_SLOTS);
+
+
+	/* IK constraints. */
+	Json *ik = Json_getItemKey(root, KEY_IK);
+	push_varint(ik ? ik->size : 0, 1);
+	for (Json *ikMap = ik ? ik->child : 0; ikMap; ikMap = ikMap->next)
+	{
+		push_string(Json_getStringKey(ikMap, KEY_NAME, ""));
+		tables.ik.add(Json_getStringKey(ikMap, KEY_NAME, ""));
+		tables.ikMaps.push_back(ikMap);
+
+		push_varint(Json_getIntKey(ikMap, KEY_ORDER, 0), 1);
+				
+		Json *bones = Json_getItemKey(ikMap, KEY_BONES);
+		if (!bones)
+		{
+			return -11;
+		}
+		push_varint(bones->size, 1);
+		for (Json *bone = bones->child; bone; bone = bone->next)
+		{
+			int boneIndex = tables.boneNames.find(bone->valueString);
+			if (boneIndex == -1) {
+				return -12;
+			}
+			push_varint(boneIndex, 1);
+		}
+				
+		string targetName = Json_getStringKey(ikMap, KEY_TARGET, "");
+		int boneIndex = tables.boneNames.find(targetName);
+		if (boneIndex == -1)
+		{
+			return -13;
+		}
+		push_varint(boneIndex, 1);
+
+		push_float(Json_getFloatKey(ikMap, KEY_MIX, 1));
+		push_byte(Json_getIntKey(ikMap, KEY_BEND_POSITIVE, 1) ? 1 : -1);
+	}
+	clock.charge(SPINE_SECTION_IK);
+
 		
-	// bones
-	Json* bones = Json_getItem(root, "bones");
-	if (!bones || bones->size == 0) {
-		Json_dispose(root);
-		return -8;
+	/* Transform constraints. */
+	Json *transform = Json_getItemKey(root, KEY_TRANSFORM);
+	push_varint(transform ? transform->size : 0, 1);
+	for (Json *transformMap = transform ? transform->child : 0; transformMap; transformMap = transformMap->next)
+	{
+		push_string(Json_getStringKey(transformMap, KEY_NAME, ""));
+		tables.transform.add(Json_getStringKey(transformMap, KEY_NAME, ""));
+		tables.transformMaps.push_back(transformMap);
+
+		push_varint(Json_getIntKey(transformMap, KEY_ORDER, 0), 1);
+
+		Json *bones = Json_getItemKey(transformMap, KEY_BONES);
+		if (!bones)
+		{
+			return -15;
+		}
+		push_varint(bones->size, 1);
+		for (Json *bone = bones->child; bone; bone = bone->next)
+		{
+			int boneIndex = tables.boneNames.find(bone->valueString);
+			if (boneIndex == -1) {
+				return -15;
+			}
+			push_varint(boneIndex, 1);
+		}
+		string targetName = Json_getStringKey(transformMap, KEY_TARGET, "");
+		int boneIndex = tables.boneNames.find(targetName);
+		if (boneIndex == -1) {
+			return -16;
+		}
+		push_varint(boneIndex, 1);
+
+		push_boolen(Json_getIntKey(transformMap, KEY_LOCAL, 0));
+		push_boolen(Json_getIntKey(transformMap, KEY_RELATIVE, 0));
+
+		push_float(Json_getFloatKey(transformMap, KEY_ROTATION, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_X, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_Y, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_SCALE_X, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_SCALE_Y, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_SHEAR_Y, 0));
+		push_float(Json_getFloatKey(transformMap, KEY_ROTATE_MIX, 1));
+		push_float(Json_getFloatKey(transformMap, KEY_TRANSLATE_MIX, 1));
+		push_float(Json_getFloatKey(transformMap, KEY_SCALE_MIX, 1));
+		push_float(Json_getFloatKey(transformMap, KEY_SHEAR_MIX, 1));
+	}
+	clock.charge(SPINE_SECTION_TRANSFORM);
+
+	/* Path constraints */
+	Json *path = Json_getItemKey(root, KEY_PATH);
+	push_varint(path ? path->size : 0, 1);
+	for (Json *pathMap = path ? path->child : 0; pathMap; pathMap = pathMap->next)
+	{
+		push_string(Json_getStringKey(pathMap, KEY_NAME, ""));
+		tables.paths.add(Json_getStringKey(pathMap, KEY_NAME, ""));
+		tables.pathMaps.push_back(pathMap);
+
+		push_varint(Json_getIntKey(pathMap, KEY_ORDER, 0), 1);
+
+		Json *bones = Json_getItemKey(pathMap, KEY_BONES);
+		if (!bones)
+		{
+			return -17;
+		}
+		push_varint(bones->size, 1);
+		for (Json *bone = bones->child; bone; bone = bone->next)
+		{
+			int boneIndex = tables.boneNames.find(bone->valueString);
+			if (boneIndex == -1) {
+				return -18;
+			}
+			push_varint(boneIndex, 1);
+		}
+
+		string targetName = Json_getStringKey(pathMap, KEY_TARGET, "");
+		int slotIndex = tables.slots.find(targetName);
+		if (slotIndex == -1) {
+			return -19;
+		}
+		push_varint(slotIndex, 1);
+
+		string positionMode = Json_getStringKey(pathMap, KEY_POSITION_MODE, "percent");
+		if (positionMode == "fixed")
+			push_varint(0, 1);
+		else
+			push_varint(1, 1);
+
+		string spacingMode = Json_getStringKey(pathMap, KEY_SPACING_MODE, "length");
+		if (spacingMode == "fixed")
+			push_varint(1, 1);
+		else if (spacingMode == "percent")
+			push_varint(2, 1);
+		else
+			push_varint(0, 1);
+
+		string rotateMode = Json_getStringKey(pathMap, KEY_ROTATE_MODE, "tangent");
+		if (rotateMode == "chain")
+			push_varint(1, 1);
+		else if (rotateMode == "chainScale")
+			push_varint(2, 1);
+		else
+			push_varint(0, 1);
+
+		push_float(Json_getFloatKey(pathMap, KEY_ROTATION, 0));
+		push_float(Json_getFloatKey(pathMap, KEY_POSITION, 0));
+		push_float(Json_getFloatKey(pathMap, KEY_SPACING, 0));
+		push_float(Json_getFloatKey(pathMap, KEY_ROTATE_MIX, 1));
+		push_float(Json_getFloatKey(pathMap, KEY_TRANSLATE_MIX, 1));
+	}
+	clock.charge(SPINE_SECTION_PATH);
+
+
+	/* Skins. */
+	Json *skins = Json_getItemKey(root, KEY_SKINS);
+	if (!skins || skins->size <= 0) {
+		return -20;
+	}
+	vector<SkeletonPart> parts;
+	Json *defaultSkin = NULL;
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{ 
+		if (string(skin->name) == "default")
+		{
+			defaultSkin = skin;
+			break;
+		}
+	}
+	if (defaultSkin)
+	{
+		parts.push_back(SkeletonPart(defaultSkin, false, false));
+		tables.skins.add("default");
+	}
+	for (Json *skin = skins->child; skin; skin = skin->next)
+	{
+		if (string(skin->name) != "default")
+		{
+			tables.skins.add(skin->name);
+			parts.push_back(SkeletonPart(skin, false, true));
+		}
+	}
+	size_t skinParts = parts.size();
+	clock.charge(SPINE_SECTION_SKINS);
+
+
+	/* Events. */
+	Json *events = Json_getItemKey(root, KEY_EVENTS);
+	for (Json *eventMap = events ? events->child : 0; eventMap; eventMap = eventMap->next)
+	{
+		EventData ed;
+		ed.name = eventMap->name;
+		ed.intValue = Json_getIntKey(eventMap, KEY_INT, 0);
+		ed.floatValue = Json_getFloatKey(eventMap, KEY_FLOAT, 0);
+		ed.stringValue = Json_getStringKey(eventMap, KEY_STRING, "");
+		tables.events.push_back(ed);
+		tables.eventNames.add(ed.name);
+	}
+	clock.charge(SPINE_SECTION_EVENTS);
+
+
+	/* Animations. */
+	Json  *animations = Json_getItemKey(root, KEY_ANIMATIONS);
+	for (Json *aniMap = animations ? animations->child : 0; aniMap; aniMap = aniMap->next)
+		parts.push_back(SkeletonPart(aniMap, true, true));
+	for (SkeletonPart &part : parts)
+		part.timed = current->stats != nullptr;
+	clock.charge(SPINE_SECTION_ANIMATIONS);
+
+
+	/* Skins, events and animations are written in this order, the skins and animations encoded ahead on workers when
+	 * the converter has threads. An incremental conversion encodes the parts it couldn't splice ahead, to keep them. */
+	if (current->sources)
+	{
+		int rt = reuse_chunks(parts, tables);
+		if (rt != 0)
+			return rt;
+		encode_parts(parts, tables, current->threads);
+	}
+	else if (current->threads > 1 && parts.size() > 1)
+		encode_parts(parts, tables, current->threads);
+	clock.skip(); // the workers' time is charged part by part
+
+	size_t part = 0;
+	if (defaultSkin)
+	{
+		int rt = push_part(parts[part], tables);
+		if (rt != 0)
+		{
+			return -100+ rt;
+		}
+		record_part(parts[part++], SPINE_SECTION_SKINS, 0);
+	}
+
+	push_varint(skins->size-1, 1);
+	for (; part < skinParts; ++part)
+	{
+		int rt = push_part(parts[part], tables);
+		if (rt != 0)
+			return -200 + rt;
+		record_part(parts[part], SPINE_SECTION_SKINS, 0);
+	}
+	clock.charge(SPINE_SECTION_SKINS);
+
+	push_varint(events ? events->size : 0, 1);
+	for (const EventData &ed : tables.events)
+	{
+		push_string(ed.name.c_str());
+		push_varint(ed.intValue, 0);
+		push_float(ed.floatValue);
+		push_string(ed.stringValue.c_str());
+	}
+	clock.charge(SPINE_SECTION_EVENTS);
+
+	push_varint(animations ? animations->size : 0, 1);	
+	for (; part < parts.size(); ++part)
+	{
+		size_t start = output_size();
+		int rt = push_part(parts[part], tables);
+		if (rt != 0)
+		{
+			return -300 + rt;
+		}
+		record_part(parts[part], SPINE_SECTION_ANIMATIONS, start);
+	}
+	clock.charge(SPINE_SECTION_ANIMATIONS);
+
+	if (current->sources)
+		keep_chunks(parts);
+	return (int)output_size();
+}
+
+static char *skip_space(char *p)
+{
+	while (*p && (unsigned char)*p <= 32)
+		++p;
+	return p;
+}
+
+// Calls member with the name and the start of the value of each member of the object at p. The name is still quoted.
+// member returns the end of the value, or 0 to stop. Returns the end of the object, 0 when the scan stopped early or
+// the text is malformed.
+template <typename Member>
+static char *scan_members(char *p, Member member)
+{
+	for (p = skip_space(p + 1); *p == '"';)
+	{
+		char *name = p;
+		char *nameEnd = (char *)Json_skipValue(p);
+		if (!nameEnd || *(p = skip_space(nameEnd)) != ':')
+			return 0;
+		char *end = member(name, nameEnd, skip_space(p + 1));
+		if (!end)
+			return 0;
+		if (*(p = skip_space(end)) != ',')
+			break;
+		p = skip_space(p + 1);
+	}
+	return *p == '}' ? p + 1 : 0;
+}
+
+static bool is_name(const char *name, const char *nameEnd, const char *key)
+{
+	size_t n = strlen(key);
+	if ((size_t)(nameEnd - name) != n + 2)
+		return false;
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (tolower((unsigned char)name[i + 1]) != key[i])
+			return false;
+	}
+	return true;
+}
+
+// Incremental conversion: parses text with every skin and animation that is an object left as an empty one, their
+// text found by a bracket matching scan and kept in sources by placeholder. Malformed text is parsed whole, for the
+// parser to fail on.
+static Json *parse_without_parts(Json_Arena *arena, char *text, size_t len, ChunkSources &sources)
+{
+	char *reduced = (char *)Json_Arena_alloc(arena, len + 1);
+	if (!reduced)
+		return 0;
+	char *out = reduced;
+	const char *copied = text;
+	vector<ChunkSource> members[2]; // of the skins and the animations, start 0 where a member isn't an object
+	bool seen[2] = { false, false };
+
+	// lookups get the first of duplicate members, only that one is left out
+	char *root = skip_space(text);
+	if (*root == '{')
+	{
+		scan_members(root, [&](char *name, char *nameEnd, char *value) -> char *
+		{
+			int group = is_name(name, nameEnd, "skins") ? 0 : is_name(name, nameEnd, "animations") ? 1 : -1;
+			if (group == -1 || seen[group] || *value != '{')
+			{
+				if (group != -1)
+					seen[group] = true;
+				return (char *)Json_skipValue(value);
+			}
+			seen[group] = true;
+			return scan_members(value, [&](char *, char *, char *partValue) -> char *
+			{
+				char *partEnd = (char *)Json_skipValue(partValue);
+				if (!partEnd || *partValue != '{')
+				{
+					members[group].push_back(ChunkSource{ 0, 0 });
+					return partEnd;
+				}
+				memcpy(out, copied, partValue - copied);
+				out += partValue - copied;
+				*out++ = '{';
+				*out++ = '}';
+				copied = partEnd;
+				members[group].push_back(ChunkSource{ partValue, partEnd });
+				return partEnd;
+			});
+		});
+	}
+	memcpy(out, copied, text + len + 1 - copied);
+
+	Json *json = Json_createInSitu(arena, reduced);
+	if (!json)
+		return 0;
+	static const int keys[2] = { KEY_SKINS, KEY_ANIMATIONS };
+	for (int group = 0; group < 2; ++group)
+	{
+		if (members[group].empty())
+			continue;
+		Json *map = Json_getItemKey(json, keys[group]);
+		if (!map || map->type != Json_Object || (size_t)map->size != members[group].size())
+		{
+			// the scan and the parser disagree, placeholders must never be encoded
+			sources.parts.clear();
+			return Json_createInSitu(arena, text);
+		}
+		size_t i = 0;
+		for (Json *part = map->child; part; part = part->next, ++i)
+		{
+			if (members[group][i].start)
+				sources.parts[part] = members[group][i];
+		}
+	}
+	return json;
+}
+
+// Interns JSON_KEYS once, thread safe.
+static void intern_json_keys()
+{
+	static const bool interned = (Json_setKeys(JSON_KEYS, sizeof(JSON_KEYS) / sizeof(JSON_KEYS[0])), true);
+	(void)interned;
+}
+
+static size_t count_nodes(const Json *json)
+{
+	size_t n = 0;
+	for (; json; json = json->next)
+		n += 1 + count_nodes(json->child);
+	return n;
+}
+
+static int convert_json(const char *json, size_t len, Json_Arena *arena)
+{
+	if (len < 16)
+		return -1;
+
+	if (json[0] != '{')
+		return -2;
+	
+	string head(json, len < 18 ? len : 18); // json may end right after len
+	if (head.find("\"skeleton\"") == head.npos)
+		return -3;
+
+	intern_json_keys();
+
+	// parse a copy in place, so escape-free keys and strings are used where they lie instead of copied out one by one
+	Json_Arena *ownArena = arena ? 0 : Json_Arena_create(0);
+	Json_Arena *parseArena = arena ? arena : ownArena;
+	char *text = parseArena ? (char *)Json_Arena_alloc(parseArena, len + 1) : 0;
+	Json *root = 0;
+	SpineConverterStats *stats = current->stats;
+	size_t blocks = parseArena ? Json_Arena_blocks(parseArena) : 0;
+	auto start = chrono::steady_clock::now();
+	ChunkSources sources;
+	sources.arena = parseArena;
+	if (text)
+	{
+		memcpy(text, json, len);
+		text[len] = 0;
+		if (current->chunks && !current->stripping && !current->influences && !current->vertexCache)
+		{
+			current->chunks->reused = current->chunks->encoded = 0;
+			root = parse_without_parts(parseArena, text, len, sources);
+			current->sources = &sources;
+		}
+		else
+			root = Json_createInSitu(parseArena, text);
+	}
+	if (stats)
+	{
+		stats->parseSeconds = seconds_since(start);
+		stats->jsonNodes = count_nodes(root);
+		stats->arenaBlocks = parseArena ? Json_Arena_blocks(parseArena) - blocks : 0;
+	}
+
+	int rt = -4;
+	if (root && current->stripping)
+	{
+		SpineStrippedCount count;
+		strip_skeleton(root, *current->stripping, parseArena, count);
+		if (stats)
+			stats->stripped = count;
+	}
+	if (root && current->influences)
+	{
+		vector<SpineMeshInfluences> counts;
+		limit_influences(root, *current->influences, parseArena, counts);
+		if (stats)
+			stats->influences.swap(counts);
+	}
+	if (root && current->vertexCache)
+	{
+		SpineVertexCacheCount count;
+		optimize_vertex_cache(root, current->vertexCache, parseArena, count);
+		if (stats)
+			stats->vertexCache = count;
+	}
+	if (root)
+		rt = convert_skeleton(root);
+	current->sources = nullptr;
+
+	if (arena)
+		Json_Arena_reset(arena);
+	else
+		Json_Arena_dispose(ownArena);
+	return rt;
+}
+
+SpineConverter::SpineConverter(Json_Arena *arena) : state(new SpineConverterState())
+{
+	state->arena = arena;
+}
+
+SpineConverter::~SpineConverter()
+{
+	if (state->ownArena)
+		Json_Arena_dispose(state->arena);
+	delete state;
+}
+
+void SpineConverter::set_threads(int threads)
+{
+	state->threads = threads > 0 ? threads : (int)thread::hardware_concurrency();
+	if (state->threads < 1)
+		state->threads = 1;
+}
+
+void SpineConverter::set_atlas(const char *atlas)
+{
+	set_atlas(atlas, atlas ? strlen(atlas) : 0);
+}
+
+void SpineConverter::set_atlas(const char *atlas, size_t len)
+{
+	state->atlas.clear();
+	state->atlasHash = 0;
+	if (atlas)
+	{
+		state->atlas.parse(atlas, len);
+		state->atlasHash = spine_hash(atlas, len, 1);
+	}
+}
+
+// The arena of the converter, made on first use and kept warm for the next conversions.
+static Json_Arena *converter_arena(SpineConverterState &state)
+{
+	if (!state.arena)
+	{
+		state.arena = Json_Arena_create(0);
+		state.ownArena = state.arena != 0;
+	}
+	return state.arena;
+}
+
+static int convert_string_table(SpineConverterState &state, const char *json, size_t len, SpineSink &sink);
+
+void SpineConverter::set_string_table(bool stringTable)
+{
+	state->stringTable = stringTable;
+}
+
+void SpineConverter::set_stats(SpineConverterStats *stats)
+{
+	state->stats = stats;
+}
+
+void SpineConverter::set_chunks(SpineChunks *chunks)
+{
+	state->chunks = chunks ? chunks->data : nullptr;
+}
+
+void SpineConverter::set_decimation(const SpineDecimation *decimation)
+{
+	if (decimation)
+		state->tolerances = *decimation;
+	state->decimation = decimation ? &state->tolerances : nullptr;
+}
+
+void SpineConverter::set_stripping(const SpineStripping *stripping)
+{
+	if (stripping)
+		state->keepLists = *stripping;
+	state->stripping = stripping ? &state->keepLists : nullptr;
+}
+
+void SpineConverter::set_vertex_cache(int cacheSize)
+{
+	state->vertexCache = cacheSize > 0 ? cacheSize : 0;
+}
+
+void SpineConverter::set_influences(const SpineInfluences *influences)
+{
+	if (influences)
+		state->influenceLimits = *influences;
+	state->influences = influences ? &state->influenceLimits : nullptr;
+}
+
+uint64_t SpineConverter::output_options() const
+{
+	uint64_t options = state->stringTable ? 1 : 0;
+	uint64_t h = 7;
+	if (state->decimation)
+	{
+		options |= 2;
+		h = spine_hash(&state->tolerances, sizeof(state->tolerances), h);
+	}
+	if (state->stripping)
+	{
+		options |= 4;
+		for (const vector<string> *names : { &state->keepLists.animations, &state->keepLists.skins, &state->keepLists.bones })
+		{
+			for (const string &name : *names)
+				h = spine_hash(name.c_str(), name.size() + 1, h); // with its nul, so the lists can't run together
+			h = spine_hash("", 1, h);
+		}
+	}
+	if (state->vertexCache)
+	{
+		options |= 8;
+		h = spine_hash(&state->vertexCache, sizeof(state->vertexCache), h);
+	}
+	if (state->influences)
+	{
+		options |= 16;
+		h = spine_hash(&state->influenceLimits, sizeof(state->influenceLimits), h);
+	}
+	if (options & 30)
+		options |= h << 5;
+	return options;
+}
+
+// Clears the stats of a conversion and takes its total time, if it keeps stats.
+class StatsScope
+{
+public:
+	explicit StatsScope(SpineConverterStats *stats) : stats(stats)
+	{
+		if (stats)
+		{
+			stats->clear();
+			start = chrono::steady_clock::now();
+		}
+	}
+	~StatsScope()
+	{
+		if (stats)
+			stats->totalSeconds = seconds_since(start);
+	}
+
+private:
+	SpineConverterStats *stats;
+	chrono::steady_clock::time_point start;
+};
+
+int SpineConverter::convert(const char *json, size_t len, unsigned char *outBuff)
+{
+	if (state->stringTable)
+	{
+		SpineBufferSink sink(outBuff, (size_t)-1);
+		return convert(json, len, sink);
+	}
+	ScopedState scope(state);
+	StatsScope stats(state->stats);
+	set_output(*state, outBuff, (size_t)-1, nullptr);
+	return convert_json(json, len, converter_arena(*state));
+}
+
+int SpineConverter::convert(const char *json, size_t len, SpineSink &sink)
+{
+	ScopedState scope(state);
+	StatsScope stats(state->stats);
+	if (state->stringTable)
+		return convert_string_table(*state, json, len, sink);
+	state->staging.resize(SINK_CHUNK);
+	set_output(*state, state->staging.data(), state->staging.size(), &sink);
+	int rt = convert_json(json, len, converter_arena(*state));
+	if (rt >= 0)
+		flush_output(*state);
+	if (rt >= 0 && state->failed)
+		rt = SINK_FAILED;
+	set_output(*state, nullptr, 0, nullptr);
+	return rt;
+}
+
+int SpineConverter::convert_size(const char *json, size_t len)
+{
+	SpineBufferSink sink(nullptr, 0);
+	return convert(json, len, sink);
+}
+
+int convert_json_to_binary(const char *json, size_t len, unsigned char *outBuff, const char *atlas, Json_Arena *arena)
+{
+	SpineConverter converter(arena);
+	converter.set_atlas(atlas);
+	return converter.convert(json, len, outBuff);
+}
+
+int convert_json_to_binary(const char *json, size_t len, SpineSink &sink, const char *atlas, Json_Arena *arena)
+{
+	SpineConverter converter(arena);
+	converter.set_atlas(atlas);
+	return converter.convert(json, len, sink);
+}
+
+int convert_json_to_binary_size(const char *json, size_t len, const char *atlas, Json_Arena *arena)
+{
+	SpineConverter converter(arena);
+	converter.set_atlas(atlas);
+	return converter.convert_size(json, len);
+}
+
+void SpineConverterStats::clear()
+{
+	totalSeconds = 0;
+	parseSeconds = 0;
+	for (int i = 0; i < SPINE_SECTION_COUNT; ++i)
+	{
+		sectionSeconds[i] = 0;
+		sectionBytes[i] = 0;
+	}
+	jsonNodes = 0;
+	arenaBlocks = 0;
+	for (int i = 0; i < SPINE_TIMELINE_COUNT; ++i)
+		timelines[i] = SpineTimelineCount();
+	decimated = SpineDecimationCount();
+	stripped = SpineStrippedCount();
+	vertexCache = SpineVertexCacheCount();
+	influences.clear();
+	animations.clear();
+}
+
+// A sidecar:
+//   "SCHK", 4 byte CHUNK_FORMAT, 4 byte chunk count
+//   each chunk: 8 byte key, 4 byte size and the bytes, 4 byte string count and each string as a 4 byte size and its
+//   bytes, 4 byte hole count and each hole as a 4 byte position and a 4 byte string, 0xFFFFFFFF for null
+//   8 byte checksum of everything before it
+// Numbers are big endian.
+static void append32(vector<unsigned char> &out, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+		out.push_back((unsigned char)(v >> (24 - 8 * i)));
+}
+
+static void append64(vector<unsigned char> &out, uint64_t v)
+{
+	append32(out, (uint32_t)(v >> 32));
+	append32(out, (uint32_t)v);
+}
+
+// Reads a sidecar front to back, failing once anything runs past its end.
+struct SidecarReader
+{
+	const unsigned char *p;
+	const unsigned char *end;
+	bool ok;
+
+	SidecarReader(const unsigned char *p, const unsigned char *end) : p(p), end(end), ok(true) {}
+
+	uint32_t get32()
+	{
+		if (!ok || end - p < 4)
+		{
+			ok = false;
+			return 0;
+		}
+		uint32_t v = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+		p += 4;
+		return v;
+	}
+
+	uint64_t get64()
+	{
+		uint64_t high = get32();
+		return high << 32 | get32();
+	}
+
+	const unsigned char *get(size_t size)
+	{
+		if (!ok || (size_t)(end - p) < size)
+		{
+			ok = false;
+			return 0;
+		}
+		p += size;
+		return p - size;
+	}
+};
+
+SpineChunks::SpineChunks() : data(new SpineChunksData())
+{
+}
+
+SpineChunks::~SpineChunks()
+{
+	delete data;
+}
+
+bool SpineChunks::load(const string &path)
+{
+	clear();
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return false;
+	vector<unsigned char> file;
+	unsigned char buffer[64 * 1024];
+	for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0;)
+		file.insert(file.end(), buffer, buffer + n);
+	fclose(f);
+	if (file.size() < 20 || memcmp(file.data(), CHUNK_MAGIC, 4) != 0)
+		return false;
+
+	SidecarReader in(file.data() + 4, file.data() + file.size() - 8);
+	SidecarReader checksum(in.end, in.end + 8);
+	if (checksum.get64() != spine_hash(file.data(), file.size() - 8, 6) || in.get32() != CHUNK_FORMAT)
+		return false;
+	for (uint32_t count = in.get32(); in.ok && count > 0; --count)
+	{
+		uint64_t key = in.get64();
+		EncodedChunk chunk;
+		uint32_t size = in.get32();
+		if (const unsigned char *bytes = in.get(size))
+			chunk.bytes.assign(bytes, bytes + size);
+		for (uint32_t strings = in.get32(); in.ok && strings > 0; --strings)
+		{
+			uint32_t length = in.get32();
+			if (const unsigned char *str = in.get(length))
+				chunk.strings.push_back(string((const char *)str, length));
+		}
+		for (uint32_t holes = in.get32(); in.ok && holes > 0; --holes)
+		{
+			uint32_t pos = in.get32();
+			uint32_t str = in.get32();
+			in.ok = in.ok && pos <= chunk.bytes.size() && (str == 0xFFFFFFFF || str < chunk.strings.size());
+			chunk.stringHoles.push_back(OutputHole{ pos, str == 0xFFFFFFFF ? -1 : (int)str, true });
+		}
+		data->chunks[key] = std::move(chunk);
+	}
+	if (!in.ok || in.p != in.end)
+	{
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool SpineChunks::save(const string &path) const
+{
+	vector<unsigned char> file(CHUNK_MAGIC, CHUNK_MAGIC + 4);
+	append32(file, CHUNK_FORMAT);
+	append32(file, (uint32_t)data->chunks.size());
+	for (const auto &entry : data->chunks)
+	{
+		const EncodedChunk &chunk = entry.second;
+		append64(file, entry.first);
+		append32(file, (uint32_t)chunk.bytes.size());
+		file.insert(file.end(), chunk.bytes.begin(), chunk.bytes.end());
+		append32(file, (uint32_t)chunk.strings.size());
+		for (const string &str : chunk.strings)
+		{
+			append32(file, (uint32_t)str.size());
+			file.insert(file.end(), str.begin(), str.end());
+		}
+		append32(file, (uint32_t)chunk.stringHoles.size());
+		for (const OutputHole &hole : chunk.stringHoles)
+		{
+			append32(file, (uint32_t)hole.pos);
+			append32(file, (uint32_t)hole.value);
+		}
+	}
+	append64(file, spine_hash(file.data(), file.size(), 6));
+
+	string temporary = path + ".tmp";
+	FILE *f = fopen(temporary.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(file.data(), 1, file.size(), f) == file.size();
+	ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+	if (ok)
+		remove(path.c_str()); // rename doesn't replace a file there
+#endif
+	if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+void SpineChunks::clear()
+{
+	data->chunks.clear();
+	data->reused = 0;
+	data->encoded = 0;
+}
+
+size_t SpineChunks::size() const
+{
+	return data->chunks.size();
+}
+
+size_t SpineChunks::reused() const
+{
+	return data->reused;
+}
+
+size_t SpineChunks::encoded() const
+{
+	return data->encoded;
+}
+
+const char *spine_section_name(int section)
+{
+	static const char *const names[SPINE_SECTION_COUNT] = { "header", "bones", "slots", "ik", "transform", "path",
+		"skins", "events", "animations" };
+	return section >= 0 && section < SPINE_SECTION_COUNT ? names[section] : "";
+}
+
+const char *spine_timeline_name(int type)
+{
+	static const char *const names[SPINE_TIMELINE_COUNT] = { "attachment", "color", "twoColor", "rotate", "translate",
+		"scale", "shear", "ik", "transform", "position", "spacing", "mix", "deform", "drawOrder", "events" };
+	return type >= 0 && type < SPINE_TIMELINE_COUNT ? names[type] : "";
+}
+
+bool SpineBufferSink::write(const unsigned char *data, size_t size)
+{
+	if (total < capacity)
+		memcpy(buffer + total, data, size < capacity - total ? size : capacity - total);
+	total += size;
+	return true;
+}
+
+bool SpineVectorSink::write(const unsigned char *data, size_t size)
+{
+	out.insert(out.end(), data, data + size);
+	return true;
+}
+
+bool SpineFileSink::write(const unsigned char *data, size_t size)
+{
+	return fwrite(data, 1, size, file) == size;
+}
+
+
+/* Streaming engine. */
+
+struct StreamCurve
+{
+	bool present;
+	int type; // CURVE_*
+	float values[4];
+};
+
+// Gathers small writes into chunks for a sink.
+struct SinkBuffer
+{
+	SpineSink &sink;
+	vector<unsigned char> chunk;
+	size_t total;
+	bool ok;
+
+	explicit SinkBuffer(SpineSink &sink) : sink(sink), total(0), ok(true) {}
+
+	void put(const unsigned char *data, size_t size)
+	{
+		if (chunk.size() + size > SINK_CHUNK)
+			flush();
+		if (size >= SINK_CHUNK)
+			ok = ok && sink.write(data, size);
+		else
+			chunk.insert(chunk.end(), data, data + size);
+		total += size;
+	}
+
+	void flush()
+	{
+		if (!chunk.empty())
+			ok = ok && sink.write(chunk.data(), chunk.size());
+		chunk.clear();
+	}
+};
+
+// Output of the streaming engine. A count precedes its list but is only known once the list has been read, so counts
+// are left as holes and spliced in when the output is copied out. In string table mode strings are holes too.
+struct StreamOutput
+{
+	vector<unsigned char> bytes;
+	vector<OutputHole> holes;
+	StringPool *strings = nullptr; // string table mode
+
+	void push_byte(unsigned char c)
+	{
+		bytes.push_back(c);
+	}
+
+	void push_float(float v)
+	{
+		unsigned char c[4];
+		encode_float(c, v);
+		bytes.insert(bytes.end(), c, c + 4);
+	}
+
+	void push_floats(const float *v, size_t n)
+	{
+		size_t at = bytes.size();
+		bytes.resize(at + 4 * n);
+		encode_floats(bytes.data() + at, v, n);
+	}
+
+	void push_shorts(const int *v, size_t n)
+	{
+		size_t at = bytes.size();
+		bytes.resize(at + 2 * n);
+		encode_shorts(bytes.data() + at, v, n);
+	}
+
+	void push_varint(int value, int optimizePositive)
+	{
+		size_t at = bytes.size();
+		bytes.resize(at + 8);
+		bytes.resize(at + encode_varint_wide(bytes.data() + at, value, optimizePositive));
+	}
+
+	void push_boolen(unsigned char v)
+	{
+		bytes.push_back(v);
+	}
+
+	void push_string(const char *str)
+	{
+		if (strings)
+		{
+			holes.push_back(OutputHole{ bytes.size(), strings->intern(str), true });
+			return;
+		}
+		if (!str)
+		{
+			push_varint(0, 1);
+			return;
+		}
+		size_t len = strlen(str);
+		push_varint(len + 1, 1);
+		bytes.insert(bytes.end(), str, str + len);
+	}
+
+	void push_color(const char *color)
+	{
+		unsigned char c[4];
+		encode_color(c, color);
+		bytes.insert(bytes.end(), c, c + 4);
+	}
+
+	void push_curve(const StreamCurve &curve)
+	{
+		push_byte(curve.present ? curve.type : 0);
+		if (curve.present && curve.type == CURVE_BEZIER)
+		{
+			for (int i = 0; i < 4; ++i)
+				push_float(curve.values[i]);
+		}
+	}
+
+	size_t begin_count()
+	{
+		holes.push_back(OutputHole{ bytes.size(), 0, false });
+		return holes.size() - 1;
+	}
+
+	void end_count(size_t count, int value)
+	{
+		holes[count].value = value;
+	}
+
+	void append(const StreamOutput &other)
+	{
+		size_t offset = bytes.size();
+		bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+		for (const auto &hole : other.holes)
+			holes.push_back(OutputHole{ hole.pos + offset, hole.value, hole.string });
+	}
+
+	void clear()
+	{
+		bytes.clear();
+		holes.clear();
+	}
+
+	// Writes the output with the holes filled, strings by the table index write_string_table gave them.
+	void write(SinkBuffer &sink, const vector<int> &stringIndex) const
+	{
+		size_t pos = 0;
+		unsigned char varint[5];
+		for (const auto &hole : holes)
+		{
+			sink.put(bytes.data() + pos, hole.pos - pos);
+			pos = hole.pos;
+			int value = hole.value;
+			if (hole.string)
+				value = value == -1 ? 0 : stringIndex[value] + 1;
+			sink.put(varint, encode_varint(varint, value, 1));
+		}
+		sink.put(bytes.data() + pos, bytes.size() - pos);
+	}
+};
+
+// String table mode: writes the marker and the table, the strings of outputs in the order they first appear in them.
+// Pool strings that no output uses are left out. stringIndex gets each pool id's table index for StreamOutput::write.
+static void write_string_table(SinkBuffer &sink, const StringPool &pool, const vector<const StreamOutput *> &outputs,
+	vector<int> &stringIndex)
+{
+	stringIndex.assign(pool.names.size(), -1);
+	vector<int> table;
+	for (const StreamOutput *output : outputs)
+	{
+		for (const auto &hole : output->holes)
+		{
+			if (hole.string && hole.value != -1 && stringIndex[hole.value] == -1)
+			{
+				stringIndex[hole.value] = (int)table.size();
+				table.push_back(hole.value);
+			}
+		}
+	}
+
+	unsigned char varint[5];
+	const unsigned char marker = STRING_TABLE_MARKER;
+	sink.put(&marker, 1);
+	sink.put(varint, encode_varint(varint, (int)table.size(), 1));
+	for (int id : table)
+	{
+		const string &str = pool.names.name(id);
+		sink.put(varint, encode_varint(varint, (int)str.size() + 1, 1));
+		sink.put((const unsigned char *)str.data(), str.size());
+	}
+}
+
+// Runs a DOM conversion in string table mode. The output is kept with its strings as holes, then written to sink
+// after the table.
+static int convert_string_table(SpineConverterState &state, const char *json, size_t len, SpineSink &sink)
+{
+	StringPool strings;
+	StreamOutput body;
+	SpineVectorSink bodySink(body.bytes);
+	state.staging.resize(SINK_CHUNK);
+	set_output(state, state.staging.data(), state.staging.size(), &bodySink);
+	state.strings = &strings;
+	state.stringHoles = &body.holes;
+	int rt = convert_json(json, len, converter_arena(state));
+	flush_output(state);
+	state.strings = nullptr;
+	state.stringHoles = nullptr;
+	set_output(state, nullptr, 0, nullptr);
+	if (rt < 0)
+		return rt;
+
+	SinkBuffer output(sink);
+	vector<int> stringIndex;
+	write_string_table(output, strings, vector<const StreamOutput *>(1, &body), stringIndex);
+	body.write(output, stringIndex);
+	output.flush();
+	return output.ok ? (int)output.total : SINK_FAILED;
+}
+
+// A member read by StreamConverter::read_object. It answers like Json_get*Key on the object it came from.
+struct StreamField
+{
+	int key;
+	bool present;
+	bool isString;
+	string str;
+	int intValue;
+	float floatValue;
+
+	StreamField(int key) : key(key), present(false), isString(false), intValue(0), floatValue(0) {}
+
+	const char *get_string(const char *defaultValue) const
+	{
+		return present ? (isString ? str.c_str() : 0) : defaultValue;
 	}
-	auto vcBones = process_bones(bones);
-	push_varint(vcBones.size(), 1);
-	for (size_t i=0;i<vcBones.size();++i)
+
+	float get_float(float defaultValue) const
 	{
-		BoneData bone = vcBones[i];
-		push_string(bone.name.c_str());
-		if (i > 0)
-			push_varint(bone.parent, 1);
-		push_float(bone.rotation);
-		push_float(bone.x);
-		push_float(bone.y);
-		push_float(bone.scaleX);
-		push_float(bone.scaleY);
-		push_float(bone.shearX);
-		push_float(bone.shearY);
-		push_float(bone.length);
-		push_varint(bone.mode, 1);
+		return present ? floatValue : defaultValue;
 	}
 
-	// Slots
-	Json* slots = Json_getItem(root, "slots");
-	if (!slots || slots->size == 0) {
-		Json_dispose(root);
-		return -9;
+	int get_int(int defaultValue) const
+	{
+		return present ? intValue : defaultValue;
 	}
-	push_varint(slots->size, 1);
+};
 
-	vector<string> vcSlots;
-	for (Json *slot = slots->child; slot; slot = slot->next)
+// An array member read by StreamConverter::read_object, numbers or names.
+struct StreamArray
+{
+	int key;
+	bool names;
+	bool present;
+	vector<float> floats;
+	vector<int> ints;
+	vector<string> strings;
+
+	StreamArray(int key, bool names = false) : key(key), names(names), present(false) {}
+
+	void clear()
 	{
-		const char *name = Json_getString(slot, "name", "");
-		push_string(name);
-		vcSlots.push_back(name);
+		present = false;
+		floats.clear();
+		ints.clear();
+		strings.clear();
+	}
+};
 
-		string boneName = Json_getString(slot, "bone", "");
-		int boneIndex = find_bone(vcBones, boneName);
-		if (boneIndex == -1) {
-			Json_dispose(root);
-			return -10;
+// Encodes while a Json_Reader walks the text, without building a tree. Sections are written to their own outputs and
+// joined in the binary's order at the end, so they may come in any order. A section that looks up a name in a section
+// not read yet is dropped and read again from its start once the whole text has been read.
+class StreamConverter
+{
+public:
+	// strings: the pool of string table mode, 0 for a plain output
+	explicit StreamConverter(StringPool *strings = 0);
+	int convert(const char *json, const char *end, SpineSink &sink);
+
+private:
+	enum Section
+	{
+		SECTION_SKELETON,
+		SECTION_BONES,
+		SECTION_SLOTS,
+		SECTION_IK,
+		SECTION_TRANSFORM,
+		SECTION_PATH,
+		SECTION_SKINS,
+		SECTION_EVENTS,
+		SECTION_ANIMATIONS,
+		SECTION_COUNT
+	};
+
+	// Animation timelines, in the binary's order.
+	enum Group
+	{
+		GROUP_SLOTS,
+		GROUP_BONES,
+		GROUP_IK,
+		GROUP_TRANSFORM,
+		GROUP_PATHS,
+		GROUP_DEFORM,
+		GROUP_DRAW_ORDER,
+		GROUP_EVENTS,
+		GROUP_COUNT
+	};
+
+	static const int FAILED = -4; // the text is malformed, failed is set
+
+	Json_Reader *r;
+	bool failed;
+	bool deferred; // a lookup missed a table whose section hasn't been read yet
+	bool done[SECTION_COUNT]; // the section's table is complete
+	StreamOutput out[SECTION_COUNT];
+	StreamOutput otherSkins;
+	StreamOutput groups[GROUP_COUNT];
+	StringPool *strings;
+
+	SkeletonTables tables;
+
+	static bool is_open(int ev) { return ev == Json_Array || ev == Json_Object; }
+	static int section_of(int key);
+	bool next_member(int &ev);
+	bool skip_to(int depth);
+	bool skip_value(int ev);
+	int lookup(const NameTable &table, const string &name, Section section);
+	int bone_index(const string &name);
+
+	int read_object(int ev, StreamField *fields, int fieldCount, StreamArray *arrays = 0, int arrayCount = 0, StreamCurve *curve = 0);
+	void capture(int ev, StreamField &field);
+	void read_array(int ev, StreamArray &array);
+	void read_curve(int ev, StreamCurve &curve);
+	template <class Emit>
+	int read_keys(int ev, StreamOutput &o, StreamField *fields, int fieldCount, StreamArray *arrays, int arrayCount, bool curves, Emit emit);
+
+	void reset_section(int section);
+	int read_section(int section, int ev);
+	int read_skeleton(int ev);
+	int read_bones(int ev);
+	int read_slots(int ev);
+	int read_ik(int ev);
+	int read_transform(int ev);
+	int read_path(int ev);
+	int read_skins(int ev);
+	int read_skin(int ev, StreamOutput &o);
+	void push_vertices(StreamOutput &o, const StreamArray &vertices, int verticesLength);
+	int read_events(int ev);
+	int read_animations(int ev);
+	int read_animation(int ev);
+	int read_slot_timelines(int ev, StreamOutput &o);
+	int read_bone_timelines(int ev, StreamOutput &o);
+	int read_constraint_timelines(int ev, StreamOutput &o, Group group);
+	int read_path_timelines(int ev, StreamOutput &o);
+	int read_deform_timelines(int ev, StreamOutput &o);
+	int read_draw_order(int ev, StreamOutput &o);
+	int read_event_timeline(int ev, StreamOutput &o);
+};
+
+StreamConverter::StreamConverter(StringPool *strings) : r(0), failed(false), deferred(false), strings(strings)
+{
+	for (int i = 0; i < SECTION_COUNT; ++i)
+	{
+		done[i] = false;
+		out[i].strings = strings;
+	}
+	otherSkins.strings = strings;
+	for (int i = 0; i < GROUP_COUNT; ++i)
+		groups[i].strings = strings;
+}
+
+int StreamConverter::section_of(int key)
+{
+	switch (key)
+	{
+	case KEY_SKELETON: return SECTION_SKELETON;
+	case KEY_BONES: return SECTION_BONES;
+	case KEY_SLOTS: return SECTION_SLOTS;
+	case KEY_IK: return SECTION_IK;
+	case KEY_TRANSFORM: return SECTION_TRANSFORM;
+	case KEY_PATH: return SECTION_PATH;
+	case KEY_SKINS: return SECTION_SKINS;
+	case KEY_EVENTS: return SECTION_EVENTS;
+	case KEY_ANIMATIONS: return SECTION_ANIMATIONS;
+	default: return -1;
+	}
+}
+
+// Reads the next member of the open container into ev, false at its end.
+bool StreamConverter::next_member(int &ev)
+{
+	ev = Json_Reader_next(r);
+	if (ev == Json_Error)
+	{
+		failed = true;
+		return false;
+	}
+	return ev != Json_EndArray && ev != Json_EndObject && ev != Json_End;
+}
+
+// Reads on until only depth containers are open. Skipped text is still checked, so malformed input fails like it
+// does on the DOM path.
+bool StreamConverter::skip_to(int depth)
+{
+	while (r->depth > depth)
+	{
+		if (Json_Reader_next(r) == Json_Error)
+		{
+			failed = true;
+			return false;
 		}
-		push_varint(boneIndex, 1);
-			
-		const char *color = Json_getString(slot, "color", 0);
-		push_color(color);
+	}
+	return true;
+}
 
-		const char *dark = Json_getString(slot, "dark", 0);
-		push_color(dark);
+bool StreamConverter::skip_value(int ev)
+{
+	return is_open(ev) ? skip_to(r->depth - 1) : true;
+}
 
-		const char *attachment = Json_getString(slot, "attachment", "");
-		push_string(attachment);
+int StreamConverter::lookup(const NameTable &table, const string &name, Section section)
+{
+	int index = table.find(name);
+	if (index == -1 && !done[section])
+		deferred = true;
+	return index;
+}
+
+int StreamConverter::bone_index(const string &name)
+{
+	int index = tables.boneNames.find(name);
+	if (index == -1 && !done[SECTION_BONES])
+		deferred = true;
+	return index;
+}
+
+// Reads the object opened by ev. The first member with each field's, array's or the curve's key is kept, like
+// Json_getItemKey finds it, the rest are skipped. Anything but an object reads as an empty one.
+int StreamConverter::read_object(int ev, StreamField *fields, int fieldCount, StreamArray *arrays, int arrayCount, StreamCurve *curve)
+{
+	for (int i = 0; i < fieldCount; ++i)
+		fields[i].present = false;
+	for (int i = 0; i < arrayCount; ++i)
+		arrays[i].clear();
+	if (curve)
+		curve->present = false;
+
+	for (int item; is_open(ev) && next_member(item);)
+	{
+		int key = r->key;
+		StreamField *field = 0;
+		StreamArray *array = 0;
+		for (int i = 0; key && i < fieldCount && !field; ++i)
+		{
+			if (fields[i].key == key)
+				field = &fields[i];
+		}
+		for (int i = 0; key && i < arrayCount && !field && !array; ++i)
+		{
+			if (arrays[i].key == key)
+				array = &arrays[i];
+		}
+
+		if (field && !field->present)
+			capture(item, *field);
+		else if (array && !array->present)
+			read_array(item, *array);
+		else if (curve && key == KEY_CURVE && !curve->present)
+			read_curve(item, *curve);
+		else
+			skip_value(item);
+	}
+	return failed ? FAILED : 0;
+}
+
+void StreamConverter::capture(int ev, StreamField &field)
+{
+	field.present = true;
+	field.isString = ev == Json_String;
+	if (field.isString)
+		field.str = r->valueString;
+	field.intValue = r->valueInt;
+	field.floatValue = r->valueFloat;
+	skip_value(ev);
+}
+
+void StreamConverter::read_array(int ev, StreamArray &array)
+{
+	array.present = true;
+	for (int item; is_open(ev) && next_member(item);)
+	{
+		if (array.names)
+			array.strings.push_back(r->valueString ? r->valueString : "");
+		else
+		{
+			array.floats.push_back(r->valueFloat);
+			array.ints.push_back(r->valueInt);
+		}
+		skip_value(item);
+	}
+}
+
+void StreamConverter::read_curve(int ev, StreamCurve &curve)
+{
+	curve.present = true;
+	curve.type = CURVE_LINEAR;
+	if (ev == Json_String && strcmp(r->valueString, "stepped") == 0)
+		curve.type = CURVE_STEPPED;
+	else if (ev == Json_Array)
+	{
+		curve.type = CURVE_BEZIER;
+		for (int i = 0; i < 4; ++i)
+			curve.values[i] = 0;
+		int n = 0;
+		for (int item; next_member(item); ++n)
+		{
+			if (n < 4)
+				curve.values[n] = r->valueFloat;
+			skip_value(item);
+		}
+		return;
+	}
+	skip_value(ev);
+}
+
+// Reads the keys of a timeline: the count, then for each key what emit writes and, if curves, the curve of the key
+// before it, as only keys that have a next one write their curve.
+template <class Emit>
+int StreamConverter::read_keys(int ev, StreamOutput &o, StreamField *fields, int fieldCount, StreamArray *arrays, int arrayCount, bool curves, Emit emit)
+{
+	size_t count = o.begin_count();
+	int n = 0;
+	StreamCurve curve = {}, previous = {};
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		if (read_object(item, fields, fieldCount, arrays, arrayCount, curves ? &curve : 0))
+			return FAILED;
+		if (curves && n > 0)
+			o.push_curve(previous);
+		emit();
+		previous = curve;
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+void StreamConverter::reset_section(int section)
+{
+	out[section].clear();
+	switch (section)
+	{
+	case SECTION_BONES: tables.bones.clear(); tables.boneNames.clear(); break;
+	case SECTION_SLOTS: tables.slots.clear(); break;
+	case SECTION_IK: tables.ik.clear(); break;
+	case SECTION_TRANSFORM: tables.transform.clear(); break;
+	case SECTION_PATH: tables.paths.clear(); break;
+	case SECTION_SKINS: tables.skins.clear(); otherSkins.clear(); break;
+	case SECTION_EVENTS: tables.events.clear(); tables.eventNames.clear(); break;
+	default: break;
+	}
+}
+
+int StreamConverter::read_section(int section, int ev)
+{
+	switch (section)
+	{
+	case SECTION_SKELETON: return read_skeleton(ev);
+	case SECTION_BONES: return read_bones(ev);
+	case SECTION_SLOTS: return read_slots(ev);
+	case SECTION_IK: return read_ik(ev);
+	case SECTION_TRANSFORM: return read_transform(ev);
+	case SECTION_PATH: return read_path(ev);
+	case SECTION_SKINS: return read_skins(ev);
+	case SECTION_EVENTS: return read_events(ev);
+	default: return read_animations(ev);
+	}
+}
+
+int StreamConverter::read_skeleton(int ev)
+{
+	StreamField fields[] = { KEY_HASH, KEY_SPINE, KEY_WIDTH, KEY_HEIGHT };
+	if (read_object(ev, fields, 4))
+		return FAILED;
+	StreamOutput &o = out[SECTION_SKELETON];
+
+	const char *hash = fields[0].get_string("");
+	if (!hash)
+		return -6;
+	o.push_string(hash);
+
+	const char *version = fields[1].get_string("");
+	if (!version)
+		return -7;
+	o.push_string(version);
+
+	o.push_float(fields[2].get_float(0));
+	o.push_float(fields[3].get_float(0));
+	o.push_boolen(false);
+	return 0;
+}
+
+int StreamConverter::read_bones(int ev)
+{
+	StreamField fields[] = { KEY_NAME, KEY_PARENT, KEY_ROTATION, KEY_X, KEY_Y, KEY_SCALE_X, KEY_SCALE_Y, KEY_SHEAR_X,
+		KEY_SHEAR_Y, KEY_LENGTH, KEY_TRANSFORM };
+	for (int item; is_open(ev) && next_member(item);)
+	{
+		if (read_object(item, fields, 11))
+			return FAILED;
+		BoneData bd;
+		bd.name = fields[0].get_string("");
+		bd.parent_name = fields[1].get_string("");
+		bd.rotation = fields[2].get_float(.0f);
+		bd.x = fields[3].get_float(.0f);
+		bd.y = fields[4].get_float(.0f);
+		bd.scaleX = fields[5].get_float(1.0f);
+		bd.scaleY = fields[6].get_float(1.0f);
+		bd.shearX = fields[7].get_float(.0f);
+		bd.shearY = fields[8].get_float(.0f);
+		bd.length = fields[9].get_float(.0f);
+		bd.mode = bone_transform_mode(fields[10].get_string("normal"));
+		tables.bones.push_back(std::move(bd));
+	}
+	if (failed)
+		return FAILED;
+	if (tables.bones.empty())
+		return -8;
+	link_bone_parents(tables.bones, tables.boneNames);
+
+	StreamOutput &o = out[SECTION_BONES];
+	o.push_varint(tables.bones.size(), 1);
+	for (size_t i = 0; i < tables.bones.size(); ++i)
+	{
+		const BoneData &bone = tables.bones[i];
+		o.push_string(bone.name.c_str());
+		if (i > 0)
+			o.push_varint(bone.parent, 1);
+		o.push_float(bone.rotation);
+		o.push_float(bone.x);
+		o.push_float(bone.y);
+		o.push_float(bone.scaleX);
+		o.push_float(bone.scaleY);
+		o.push_float(bone.shearX);
+		o.push_float(bone.shearY);
+		o.push_float(bone.length);
+		o.push_varint(bone.mode, 1);
+	}
+	return 0;
+}
+
+int StreamConverter::read_slots(int ev)
+{
+	StreamField fields[] = { KEY_NAME, KEY_BONE, KEY_COLOR, KEY_DARK, KEY_ATTACHMENT, KEY_BLEND };
+	StreamOutput &o = out[SECTION_SLOTS];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		if (read_object(item, fields, 6))
+			return FAILED;
+		const char *name = fields[0].get_string("");
+		o.push_string(name);
+		tables.slots.add(name);
+
+		int boneIndex = bone_index(fields[1].get_string(""));
+		if (boneIndex == -1)
+			return -10;
+		o.push_varint(boneIndex, 1);
+
+		o.push_color(fields[2].get_string(0));
+		o.push_color(fields[3].get_string(0));
+		o.push_string(fields[4].get_string(""));
 
-		Json *blend = Json_getItem(slot, "blend");
 		int blendMode = 0;
-		if (blend) {
-			if (string(blend->valueString) == "additive")
+		if (fields[5].present)
+		{
+			string blend = fields[5].get_string("");
+			if (blend == "additive")
 				blendMode = 1;
-			else if (string(blend->valueString) == "multiply")
+			else if (blend == "multiply")
 				blendMode = 2;
-			else if (string(blend->valueString) == "screen")
+			else if (blend == "screen")
 				blendMode = 3;
 		}
-		push_varint(blendMode, 1);
+		o.push_varint(blendMode, 1);
+	}
+	o.end_count(count, n);
+	if (failed)
+		return FAILED;
+	return n == 0 ? -9 : 0;
+}
+
+int StreamConverter::read_ik(int ev)
+{
+	StreamField fields[] = { KEY_NAME, KEY_ORDER, KEY_TARGET, KEY_MIX, KEY_BEND_POSITIVE };
+	StreamArray bones(KEY_BONES, true);
+	StreamOutput &o = out[SECTION_IK];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		if (read_object(item, fields, 5, &bones, 1))
+			return FAILED;
+		const char *name = fields[0].get_string("");
+		o.push_string(name);
+		tables.ik.add(name);
+
+		o.push_varint(fields[1].get_int(0), 1);
+
+		if (!bones.present)
+			return -11;
+		o.push_varint(bones.strings.size(), 1);
+		for (const string &bone : bones.strings)
+		{
+			int boneIndex = bone_index(bone);
+			if (boneIndex == -1)
+				return -12;
+			o.push_varint(boneIndex, 1);
+		}
+
+		int boneIndex = bone_index(fields[2].get_string(""));
+		if (boneIndex == -1)
+			return -13;
+		o.push_varint(boneIndex, 1);
+
+		o.push_float(fields[3].get_float(1));
+		o.push_byte(fields[4].get_int(1) ? 1 : -1);
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+int StreamConverter::read_transform(int ev)
+{
+	StreamField fields[] = { KEY_NAME, KEY_ORDER, KEY_TARGET, KEY_LOCAL, KEY_RELATIVE, KEY_ROTATION, KEY_X, KEY_Y,
+		KEY_SCALE_X, KEY_SCALE_Y, KEY_SHEAR_Y, KEY_ROTATE_MIX, KEY_TRANSLATE_MIX, KEY_SCALE_MIX, KEY_SHEAR_MIX };
+	StreamArray bones(KEY_BONES, true);
+	StreamOutput &o = out[SECTION_TRANSFORM];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		if (read_object(item, fields, 15, &bones, 1))
+			return FAILED;
+		const char *name = fields[0].get_string("");
+		o.push_string(name);
+		tables.transform.add(name);
+
+		o.push_varint(fields[1].get_int(0), 1);
+
+		if (!bones.present)
+			return -15;
+		o.push_varint(bones.strings.size(), 1);
+		for (const string &bone : bones.strings)
+		{
+			int boneIndex = bone_index(bone);
+			if (boneIndex == -1)
+				return -15;
+			o.push_varint(boneIndex, 1);
+		}
+
+		int boneIndex = bone_index(fields[2].get_string(""));
+		if (boneIndex == -1)
+			return -16;
+		o.push_varint(boneIndex, 1);
+
+		o.push_boolen(fields[3].get_int(0));
+		o.push_boolen(fields[4].get_int(0));
+		o.push_float(fields[5].get_float(0));
+		o.push_float(fields[6].get_float(0));
+		o.push_float(fields[7].get_float(0));
+		o.push_float(fields[8].get_float(0));
+		o.push_float(fields[9].get_float(0));
+		o.push_float(fields[10].get_float(0));
+		o.push_float(fields[11].get_float(1));
+		o.push_float(fields[12].get_float(1));
+		o.push_float(fields[13].get_float(1));
+		o.push_float(fields[14].get_float(1));
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+int StreamConverter::read_path(int ev)
+{
+	StreamField fields[] = { KEY_NAME, KEY_ORDER, KEY_TARGET, KEY_POSITION_MODE, KEY_SPACING_MODE, KEY_ROTATE_MODE,
+		KEY_ROTATION, KEY_POSITION, KEY_SPACING, KEY_ROTATE_MIX, KEY_TRANSLATE_MIX };
+	StreamArray bones(KEY_BONES, true);
+	StreamOutput &o = out[SECTION_PATH];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		if (read_object(item, fields, 11, &bones, 1))
+			return FAILED;
+		const char *name = fields[0].get_string("");
+		o.push_string(name);
+		tables.paths.add(name);
+
+		o.push_varint(fields[1].get_int(0), 1);
+
+		if (!bones.present)
+			return -17;
+		o.push_varint(bones.strings.size(), 1);
+		for (const string &bone : bones.strings)
+		{
+			int boneIndex = bone_index(bone);
+			if (boneIndex == -1)
+				return -18;
+			o.push_varint(boneIndex, 1);
+		}
+
+		int slotIndex = lookup(tables.slots, fields[2].get_string(""), SECTION_SLOTS);
+		if (slotIndex == -1)
+			return -19;
+		o.push_varint(slotIndex, 1);
+
+		string positionMode = fields[3].get_string("percent");
+		o.push_varint(positionMode == "fixed" ? 0 : 1, 1);
+
+		string spacingMode = fields[4].get_string("length");
+		if (spacingMode == "fixed")
+			o.push_varint(1, 1);
+		else if (spacingMode == "percent")
+			o.push_varint(2, 1);
+		else
+			o.push_varint(0, 1);
+
+		string rotateMode = fields[5].get_string("tangent");
+		if (rotateMode == "chain")
+			o.push_varint(1, 1);
+		else if (rotateMode == "chainScale")
+			o.push_varint(2, 1);
+		else
+			o.push_varint(0, 1);
+
+		o.push_float(fields[6].get_float(0));
+		o.push_float(fields[7].get_float(0));
+		o.push_float(fields[8].get_float(0));
+		o.push_float(fields[9].get_float(1));
+		o.push_float(fields[10].get_float(1));
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+// The default skin goes first whatever its place in the text, then the count and the other skins. As on the DOM path
+// an error in the default skin wins over one in another skin.
+int StreamConverter::read_skins(int ev)
+{
+	StreamOutput &o = out[SECTION_SKINS];
+	int depth = r->depth;
+	bool haveDefault = false;
+	int defaultError = 0, otherError = 0;
+	vector<string> otherNames;
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		string name = r->name ? r->name : "";
+		int rt = 0;
+		if (name != "default")
+		{
+			otherNames.push_back(name);
+			otherSkins.push_string(name.c_str());
+			rt = otherError ? 0 : read_skin(item, otherSkins);
+			if (rt && !failed && !deferred)
+				otherError = -200 + rt;
+		}
+		else if (!haveDefault)
+		{
+			haveDefault = true;
+			rt = read_skin(item, o);
+			if (rt && !failed && !deferred)
+				defaultError = -100 + rt;
+		}
+		if (failed || deferred)
+			return rt;
+		if (!skip_to(depth)) // the rest of a skin left by an error, or a second default skin
+			return FAILED;
+	}
+	if (haveDefault)
+		tables.skins.add("default");
+	for (const string &name : otherNames)
+		tables.skins.add(name);
+	if (failed)
+		return FAILED;
+	if (n == 0)
+		return -20;
+	if (defaultError)
+		return defaultError;
+	if (otherError)
+		return otherError;
+	o.push_varint(n - 1, 1);
+	o.append(otherSkins);
+	return 0;
+}
+
+int StreamConverter::read_skin(int ev, StreamOutput &o)
+{
+	enum { NAME, PATH, TYPE, COLOR, ROTATION, X, Y, SCALE_X, SCALE_Y, WIDTH, HEIGHT, VERTEX_COUNT, HULL, SKIN, PARENT,
+		DEFORM, CLOSED, CONSTANT_SPEED, END, FIELD_COUNT };
+	StreamField fields[] = { KEY_NAME, KEY_PATH, KEY_TYPE, KEY_COLOR, KEY_ROTATION, KEY_X, KEY_Y, KEY_SCALE_X,
+		KEY_SCALE_Y, KEY_WIDTH, KEY_HEIGHT, KEY_VERTEX_COUNT, KEY_HULL, KEY_SKIN, KEY_PARENT, KEY_DEFORM, KEY_CLOSED,
+		KEY_CONSTANT_SPEED, KEY_END };
+	StreamArray arrays[] = { KEY_UVS, KEY_TRIANGLES, KEY_VERTICES, KEY_LENGTHS };
+	const StreamArray &uvs = arrays[0], &triangles = arrays[1], &vertices = arrays[2], &lengths = arrays[3];
+
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int attachments; is_open(ev) && next_member(attachments); ++n)
+	{
+		int slot = lookup(tables.slots, r->name ? r->name : "", SECTION_SLOTS);
+		if (slot == -1)
+			return -1;
+		o.push_varint(slot, 1);
+
+		size_t validCount = o.begin_count();
+		int valid = 0;
+		for (int attachment; is_open(attachments) && next_member(attachment);)
+		{
+			string key = r->name ? r->name : "";
+			if (read_object(attachment, fields, FIELD_COUNT, arrays, 4))
+				return FAILED;
+			const char *attachmentName = fields[NAME].get_string(key.c_str());
+			const char *typeString = fields[TYPE].get_string("region");
+			if (!attachment_in_atlas(typeString, fields[PATH].get_string(attachmentName)))
+				continue;
+			valid++;
+
+			o.push_string(key.c_str());
+			o.push_string(attachmentName);
+
+			const char* attachmentPath = fields[PATH].get_string(NULL);
+			int spAttachmentType = attachment_type(typeString);
+			o.push_byte(spAttachmentType);
+			if (spAttachmentType == 0) // SP_ATTACHMENT_REGION
+			{
+				o.push_string(attachmentPath);
+				o.push_float(fields[ROTATION].get_float(0));
+				o.push_float(fields[X].get_float(0));
+				o.push_float(fields[Y].get_float(0));
+				o.push_float(fields[SCALE_X].get_float(1));
+				o.push_float(fields[SCALE_Y].get_float(1));
+				o.push_float(fields[WIDTH].get_float(32));
+				o.push_float(fields[HEIGHT].get_float(32));
+				o.push_color(fields[COLOR].get_string(0));
+			}
+			else if (spAttachmentType == 1) // SP_ATTACHMENT_BOUNDING_BOX
+			{
+				int vertexCount = fields[VERTEX_COUNT].get_int(0);
+				o.push_varint(vertexCount, 1);
+				push_vertices(o, vertices, vertexCount << 1);
+			}
+			else if (spAttachmentType == 2) // SP_ATTACHMENT_MESH
+			{
+				o.push_string(attachmentPath);
+				o.push_color(fields[COLOR].get_string(0));
+
+				int verticesLength = uvs.floats.size();
+				o.push_varint(verticesLength >> 1, 1);
+				o.push_floats(uvs.floats.data(), uvs.floats.size());
+
+				o.push_varint(triangles.ints.size(), 1);
+				o.push_shorts(triangles.ints.data(), triangles.ints.size());
+
+				push_vertices(o, vertices, verticesLength);
+				o.push_varint(fields[HULL].get_int(0) >> 1, 1);
+			}
+			else if (spAttachmentType == 3) // SP_ATTACHMENT_LINKED_MESH
+			{
+				o.push_string(attachmentPath);
+				o.push_color(fields[COLOR].get_string(0));
+				o.push_string(fields[SKIN].get_string(0));
+				o.push_string(fields[PARENT].get_string(0));
+				o.push_boolen(fields[DEFORM].get_int(1));
+			}
+			else if (spAttachmentType == 4) // SP_ATTACHMENT_PATH
+			{
+				o.push_boolen(fields[CLOSED].get_int(0));
+				o.push_boolen(fields[CONSTANT_SPEED].get_int(0));
+
+				int vertexCount = fields[VERTEX_COUNT].get_int(0);
+				o.push_varint(vertexCount, 1);
+				push_vertices(o, vertices, vertexCount << 1);
+
+				o.push_floats(lengths.floats.data(), lengths.floats.size());
+			}
+			else if (spAttachmentType == 6) // SP_ATTACHMENT_CLIPPING
+			{
+				const char* end = fields[END].get_string(0);
+				int endSlot = end ? tables.slots.find(end) : -1;
+				o.push_varint(endSlot != -1 ? endSlot : 0, 1);
+
+				int vertexCount = fields[VERTEX_COUNT].get_int(0);
+				o.push_varint(vertexCount, 1);
+				push_vertices(o, vertices, vertexCount << 1);
+			}
+		}
+		o.end_count(validCount, valid);
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+void StreamConverter::push_vertices(StreamOutput &o, const StreamArray &vertices, int verticesLength)
+{
+	int size = vertices.floats.size();
+	if (size <= 0)
+		return;
+	const vector<float> &vert = vertices.floats;
+
+	if (verticesLength == size)
+	{
+		o.push_boolen(false);
+		o.push_floats(vert.data(), size);
+	}
+	else
+	{
+		o.push_boolen(true);
+		for (int i = 0; i < size;)
+		{
+			int boneCount = (int)vert[i++];
+			o.push_varint(boneCount, 1);
+			for (int nn = i + boneCount * 4; i < nn && i + 4 <= size; i += 4)
+			{
+				o.push_varint((int)vert[i], 1);
+				o.push_floats(&vert[i + 1], 3);
+			}
+		}
 	}
+}
 
+int StreamConverter::read_events(int ev)
+{
+	StreamField fields[] = { KEY_INT, KEY_FLOAT, KEY_STRING };
+	StreamOutput &o = out[SECTION_EVENTS];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
+	{
+		EventData ed;
+		ed.name = r->name ? r->name : "";
+		if (read_object(item, fields, 3))
+			return FAILED;
+		ed.intValue = fields[0].get_int(0);
+		ed.floatValue = fields[1].get_float(0);
+		ed.stringValue = fields[2].get_string("");
+		tables.events.push_back(ed);
+		tables.eventNames.add(ed.name);
+
+		o.push_string(ed.name.c_str());
+		o.push_varint(ed.intValue, 0);
+		o.push_float(ed.floatValue);
+		o.push_string(ed.stringValue.c_str());
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
-	/* IK constraints. */
-	vector<string> vcIK;
-	Json *ik = Json_getItem(root, "ik");
-	push_varint(ik ? ik->size : 0, 1);
-	for (Json *ikMap = ik ? ik->child : 0; ikMap; ikMap = ikMap->next)
+int StreamConverter::read_animations(int ev)
+{
+	StreamOutput &o = out[SECTION_ANIMATIONS];
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int item; is_open(ev) && next_member(item); ++n)
 	{
-		push_string(Json_getString(ikMap, "name", ""));
-		vcIK.push_back(Json_getString(ikMap, "name", ""));
+		string name = r->name ? r->name : "";
+		o.push_string(name.c_str());
+		int rt = read_animation(item);
+		if (rt != 0)
+			return failed ? FAILED : -300 + rt;
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
-		push_varint(Json_getInt(ikMap, "order", 0), 1);
-				
-		Json *bones = Json_getItem(ikMap, "bones");
-		if (!bones)
+// The timeline groups of an animation may come in any order, each is written to its own output and they are appended
+// in the binary's order. Errors are reported in that order too, like parse_animation meets them.
+int StreamConverter::read_animation(int ev)
+{
+	int depth = r->depth;
+	bool seen[GROUP_COUNT] = {};
+	int errors[GROUP_COUNT] = {};
+	for (int i = 0; i < GROUP_COUNT; ++i)
+		groups[i].clear();
+
+	for (int item; is_open(ev) && next_member(item);)
+	{
+		int group = -1;
+		switch (r->key)
 		{
-			Json_dispose(root);
-			return -11;
+		case KEY_SLOTS: group = GROUP_SLOTS; break;
+		case KEY_BONES: group = GROUP_BONES; break;
+		case KEY_IK: group = GROUP_IK; break;
+		case KEY_TRANSFORM: group = GROUP_TRANSFORM; break;
+		case KEY_PATHS: group = GROUP_PATHS; break;
+		case KEY_DEFORM: group = GROUP_DEFORM; break;
+		case KEY_DRAW_ORDER: group = GROUP_DRAW_ORDER; break;
+		case KEY_EVENTS: group = GROUP_EVENTS; break;
+		default: break;
 		}
-		push_varint(bones->size, 1);
-		for (Json *bone = bones->child; bone; bone = bone->next)
+		if (group == -1 || seen[group])
 		{
-			int boneIndex = find_bone(vcBones, bone->valueString);
-			if (boneIndex == -1) {
-				Json_dispose(root);
-				return -12;
-			}
-			push_varint(boneIndex, 1);
+			skip_value(item);
+			continue;
 		}
-				
-		string targetName = Json_getString(ikMap, "target", "");
-		int boneIndex = find_bone(vcBones, targetName);
-		if (boneIndex == -1)
+		seen[group] = true;
+
+		StreamOutput &o = groups[group];
+		int rt = 0;
+		switch (group)
 		{
-			Json_dispose(root);
-			return -13;
+		case GROUP_SLOTS: rt = read_slot_timelines(item, o); break;
+		case GROUP_BONES: rt = read_bone_timelines(item, o); break;
+		case GROUP_IK: /* fallthrough */
+		case GROUP_TRANSFORM: rt = read_constraint_timelines(item, o, (Group)group); break;
+		case GROUP_PATHS: rt = read_path_timelines(item, o); break;
+		case GROUP_DEFORM: rt = read_deform_timelines(item, o); break;
+		case GROUP_DRAW_ORDER: rt = read_draw_order(item, o); break;
+		default: rt = read_event_timeline(item, o); break;
 		}
-		push_varint(boneIndex, 1);
-
-		push_float(Json_getFloat(ikMap, "mix", 1));
-		push_byte(Json_getInt(ikMap, "bendPositive", 1) ? 1 : -1);
+		if (failed)
+			return FAILED;
+		if (deferred)
+			return rt;
+		errors[group] = rt;
+		if (!skip_to(depth))
+			return FAILED;
 	}
+	if (failed)
+		return FAILED;
 
-		
-	/* Transform constraints. */
-	vector<string> vcTransform;
-	Json *transform = Json_getItem(root, "transform");
-	push_varint(transform ? transform->size : 0, 1);
-	for (Json *transformMap = transform ? transform->child : 0; transformMap; transformMap = transformMap->next)
+	for (int i = 0; i < GROUP_COUNT; ++i)
+	{
+		if (errors[i])
+			return errors[i];
+	}
+	StreamOutput &o = out[SECTION_ANIMATIONS];
+	for (int i = 0; i < GROUP_COUNT; ++i)
 	{
-		push_string(Json_getString(transformMap, "name", ""));
-		vcTransform.push_back(Json_getString(transformMap, "name", ""));
+		if (seen[i])
+			o.append(groups[i]);
+		else
+			o.push_varint(0, 1);
+	}
+	return 0;
+}
 
-		push_varint(Json_getInt(transformMap, "order", 0), 1);
+int StreamConverter::read_slot_timelines(int ev, StreamOutput &o)
+{
+	StreamField attachmentFields[] = { KEY_TIME, KEY_NAME };
+	StreamField colorFields[] = { KEY_TIME, KEY_COLOR };
+	StreamField twoColorFields[] = { KEY_TIME, KEY_LIGHT, KEY_DARK };
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int slotMap; is_open(ev) && next_member(slotMap); ++n)
+	{
+		int slotIndex = lookup(tables.slots, r->name ? r->name : "", SECTION_SLOTS);
+		if (slotIndex == -1)
+			return -1;
+		o.push_varint(slotIndex, 1);
 
-		Json *bones = Json_getItem(transformMap, "bones");
-		if (!bones)
+		size_t timelineCount = o.begin_count();
+		int timelines = 0;
+		for (int timelineMap; is_open(slotMap) && next_member(timelineMap); ++timelines)
 		{
-			Json_dispose(root);
-			return -15;
-		}
-		push_varint(bones->size, 1);
-		for (Json *bone = bones->child; bone; bone = bone->next)
-		{
-			int boneIndex = find_bone(vcBones, bone->valueString);
-			if (boneIndex == -1) {
-				Json_dispose(root);
-				return -15;
+			string name = r->name ? r->name : "";
+			int rt;
+			if (name == "attachment")
+			{
+				o.push_byte(0);
+				rt = read_keys(timelineMap, o, attachmentFields, 2, 0, 0, false, [&]() {
+					o.push_float(attachmentFields[0].get_float(0));
+					o.push_string(attachmentFields[1].get_string(""));
+				});
 			}
-			push_varint(boneIndex, 1);
-		}
-		string targetName = Json_getString(transformMap, "target", "");
-		int boneIndex = find_bone(vcBones, targetName);
-		if (boneIndex == -1) {
-			Json_dispose(root);
-			return -16;
+			else if (name == "color")
+			{
+				o.push_byte(1);
+				rt = read_keys(timelineMap, o, colorFields, 2, 0, 0, true, [&]() {
+					o.push_float(colorFields[0].get_float(0));
+					o.push_color(colorFields[1].get_string(0));
+				});
+			}
+			else if (name == "twoColor")
+			{
+				o.push_byte(2);
+				rt = read_keys(timelineMap, o, twoColorFields, 3, 0, 0, true, [&]() {
+					o.push_float(twoColorFields[0].get_float(0));
+					o.push_color(twoColorFields[1].get_string(0));
+					o.push_color(twoColorFields[2].get_string(0));
+				});
+			}
+			else
+				return -2;
+			if (rt != 0)
+				return rt;
 		}
-		push_varint(boneIndex, 1);
-
-		push_boolen(Json_getInt(transformMap, "local", 0));
-		push_boolen(Json_getInt(transformMap, "relative", 0));
-
-		push_float(Json_getFloat(transformMap, "rotation", 0));
-		push_float(Json_getFloat(transformMap, "x", 0));
-		push_float(Json_getFloat(transformMap, "y", 0));
-		push_float(Json_getFloat(transformMap, "scaleX", 0));
-		push_float(Json_getFloat(transformMap, "scaleY", 0));
-		push_float(Json_getFloat(transformMap, "shearY", 0));
-		push_float(Json_getFloat(transformMap, "rotateMix", 1));
-		push_float(Json_getFloat(transformMap, "translateMix", 1));
-		push_float(Json_getFloat(transformMap, "scaleMix", 1));
-		push_float(Json_getFloat(transformMap, "shearMix", 1));
+		o.end_count(timelineCount, timelines);
 	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
-	/* Path constraints */
-	vector<string> vcPaths;
-	Json *path = Json_getItem(root, "path");
-	push_varint(path ? path->size : 0, 1);
-	for (Json *pathMap = path ? path->child : 0; pathMap; pathMap = pathMap->next)
+int StreamConverter::read_bone_timelines(int ev, StreamOutput &o)
+{
+	StreamField rotateFields[] = { KEY_TIME, KEY_ANGLE };
+	StreamField fields[] = { KEY_TIME, KEY_X, KEY_Y };
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int boneMap; is_open(ev) && next_member(boneMap); ++n)
 	{
-		push_string(Json_getString(pathMap, "name", ""));
-		vcPaths.push_back(Json_getString(pathMap, "name", ""));
-
-		push_varint(Json_getInt(pathMap, "order", 0), 1);
+		int boneIndex = bone_index(r->name ? r->name : "");
+		if (boneIndex == -1)
+			return -3;
+		o.push_varint(boneIndex, 1);
 
-		Json *bones = Json_getItem(pathMap, "bones");
-		if (!bones)
-		{
-			Json_dispose(root);
-			return -17;
-		}
-		push_varint(bones->size, 1);
-		for (Json *bone = bones->child; bone; bone = bone->next)
+		size_t timelineCount = o.begin_count();
+		int timelines = 0;
+		for (int timelineMap; is_open(boneMap) && next_member(timelineMap); ++timelines)
 		{
-			int boneIndex = find_bone(vcBones, bone->valueString);
-			if (boneIndex == -1) {
-				Json_dispose(root);
-				return -18;
+			string name = r->name ? r->name : "";
+			int rt;
+			if (name == "rotate")
+			{
+				o.push_byte(0);
+				rt = read_keys(timelineMap, o, rotateFields, 2, 0, 0, true, [&]() {
+					o.push_float(rotateFields[0].get_float(0));
+					o.push_float(rotateFields[1].get_float(0));
+				});
 			}
-			push_varint(boneIndex, 1);
-		}
+			else
+			{
+				if (name == "scale")
+					o.push_byte(2);
+				else if (name == "translate")
+					o.push_byte(1);
+				else if (name == "shear")
+					o.push_byte(3);
+				else
+					return -4;
 
-		string targetName = Json_getString(pathMap, "target", "");
-		int slotIndex = find_string(vcSlots, targetName);
-		if (slotIndex == -1) {
-			Json_dispose(root);
-			return -19;
+				rt = read_keys(timelineMap, o, fields, 3, 0, 0, true, [&]() {
+					o.push_float(fields[0].get_float(0));
+					o.push_float(fields[1].get_float(0));
+					o.push_float(fields[2].get_float(0));
+				});
+			}
+			if (rt != 0)
+				return rt;
 		}
-		push_varint(slotIndex, 1);
-
-		string positionMode = Json_getString(pathMap, "positionMode", "percent");
-		if (positionMode == "fixed")
-			push_varint(0, 1);
-		else
-			push_varint(1, 1);
-
-		string spacingMode = Json_getString(pathMap, "spacingMode", "length");
-		if (spacingMode == "fixed")
-			push_varint(1, 1);
-		else if (spacingMode == "percent")
-			push_varint(2, 1);
-		else
-			push_varint(0, 1);
+		o.end_count(timelineCount, timelines);
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
-		string rotateMode = Json_getString(pathMap, "rotateMode", "tangent");
-		if (rotateMode == "chain")
-			push_varint(1, 1);
-		else if (rotateMode == "chainScale")
-			push_varint(2, 1);
+int StreamConverter::read_constraint_timelines(int ev, StreamOutput &o, Group group)
+{
+	StreamField ikFields[] = { KEY_TIME, KEY_MIX, KEY_BEND_POSITIVE };
+	StreamField transformFields[] = { KEY_TIME, KEY_ROTATE_MIX, KEY_TRANSLATE_MIX, KEY_SCALE_MIX, KEY_SHEAR_MIX };
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int constraintMap; is_open(ev) && next_member(constraintMap); ++n)
+	{
+		string name = r->name ? r->name : "";
+		int rt;
+		if (group == GROUP_IK)
+		{
+			int ikIndex = lookup(tables.ik, name, SECTION_IK);
+			if (ikIndex == -1)
+				return -5;
+			o.push_varint(ikIndex, 1);
+
+			rt = read_keys(constraintMap, o, ikFields, 3, 0, 0, true, [&]() {
+				o.push_float(ikFields[0].get_float(0));
+				o.push_float(ikFields[1].get_float(1));
+				o.push_byte(ikFields[2].get_int(1) ? 1 : -1);
+			});
+		}
 		else
-			push_varint(0, 1);
-
-		push_float(Json_getFloat(pathMap, "rotation", 0));
-		push_float(Json_getFloat(pathMap, "position", 0));
-		push_float(Json_getFloat(pathMap, "spacing", 0));
-		push_float(Json_getFloat(pathMap, "rotateMix", 1));
-		push_float(Json_getFloat(pathMap, "translateMix", 1));
+		{
+			int index = lookup(tables.transform, name, SECTION_TRANSFORM);
+			if (index == -1)
+				return -6;
+			o.push_varint(index, 1);
+
+			rt = read_keys(constraintMap, o, transformFields, 5, 0, 0, true, [&]() {
+				o.push_float(transformFields[0].get_float(0));
+				o.push_float(transformFields[1].get_float(1));
+				o.push_float(transformFields[2].get_float(1));
+				o.push_float(transformFields[3].get_float(1));
+				o.push_float(transformFields[4].get_float(1));
+			});
+		}
+		if (rt != 0)
+			return rt;
 	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
+int StreamConverter::read_path_timelines(int ev, StreamOutput &o)
+{
+	StreamField positionFields[] = { KEY_TIME, KEY_POSITION };
+	StreamField spacingFields[] = { KEY_TIME, KEY_SPACING };
+	StreamField mixFields[] = { KEY_TIME, KEY_ROTATE_MIX, KEY_TRANSLATE_MIX };
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int pathMap; is_open(ev) && next_member(pathMap); ++n)
+	{
+		int pathIndex = lookup(tables.paths, r->name ? r->name : "", SECTION_PATH);
+		if (pathIndex == -1)
+			return -7;
+		o.push_varint(pathIndex, 1);
 
-	/* Skins. */
-	vector<string> vcSkins;
-	Json *skins = Json_getItem(root, "skins");
-	if (!skins || skins->size <= 0) {
-		Json_dispose(root);
-		return -20;
-	}
-	Json *defaultSkin = NULL;
-	for (Json *skin = skins->child; skin; skin = skin->next)
-	{ 
-		if (string(skin->name) == "default")
+		size_t timelineCount = o.begin_count();
+		int timelines = 0;
+		for (int timelineMap; is_open(pathMap) && next_member(timelineMap); ++timelines)
 		{
-			defaultSkin = skin;
-			break;
+			string timelineName = r->name ? r->name : "";
+			int rt;
+			if (timelineName == "position" || timelineName == "spacing")
+			{
+				StreamField *fields = timelineName == "position" ? positionFields : spacingFields;
+				o.push_byte(timelineName == "position" ? 0 : 1);
+				rt = read_keys(timelineMap, o, fields, 2, 0, 0, true, [&]() {
+					o.push_float(fields[0].get_float(0));
+					o.push_float(fields[1].get_float(0));
+				});
+			}
+			else if (timelineName == "mix")
+			{
+				o.push_byte(2);
+				rt = read_keys(timelineMap, o, mixFields, 3, 0, 0, true, [&]() {
+					o.push_float(mixFields[0].get_float(0));
+					o.push_float(mixFields[1].get_float(1));
+					o.push_float(mixFields[2].get_float(1));
+				});
+			}
+			else
+				return -8;
+			if (rt != 0)
+				return rt;
 		}
+		o.end_count(timelineCount, timelines);
 	}
-	if (defaultSkin)
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+int StreamConverter::read_deform_timelines(int ev, StreamOutput &o)
+{
+	StreamField fields[] = { KEY_TIME, KEY_OFFSET };
+	StreamArray vertices(KEY_VERTICES);
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int deformMap; is_open(ev) && next_member(deformMap); ++n)
 	{
-		int rt = parse_skin(defaultSkin, vcSlots);
-		if (rt != 0)
+		int skinIndex = lookup(tables.skins, r->name ? r->name : "", SECTION_SKINS);
+		if (skinIndex == -1)
+			return -9;
+		o.push_varint(skinIndex, 1);
+
+		size_t slotCount = o.begin_count();
+		int slots = 0;
+		for (int slotMap; is_open(deformMap) && next_member(slotMap); ++slots)
 		{
-			Json_dispose(root);
-			return -100+ rt;
+			int slotIndex = lookup(tables.slots, r->name ? r->name : "", SECTION_SLOTS);
+			if (slotIndex == -1)
+				return -10;
+			o.push_varint(slotIndex, 1);
+
+			size_t timelineCount = o.begin_count();
+			int timelines = 0;
+			for (int timelineMap; is_open(slotMap) && next_member(timelineMap); ++timelines)
+			{
+				o.push_string(r->name);
+				int rt = read_keys(timelineMap, o, fields, 2, &vertices, 1, true, [&]() {
+					o.push_float(fields[0].get_float(0));
+					if (!vertices.present)
+					{
+						o.push_varint(0, 1);
+					}
+					else
+					{
+						o.push_varint(vertices.floats.size(), 1);
+						o.push_varint(fields[1].get_int(0), 1);
+						o.push_floats(vertices.floats.data(), vertices.floats.size());
+					}
+				});
+				if (rt != 0)
+					return rt;
+			}
+			o.end_count(timelineCount, timelines);
 		}
-		vcSkins.push_back("default");
+		o.end_count(slotCount, slots);
 	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
-	push_varint(skins->size-1, 1);
-	for (Json *skin = skins->child; skin; skin = skin->next)
+int StreamConverter::read_draw_order(int ev, StreamOutput &o)
+{
+	StreamField time(KEY_TIME);
+	StreamField offsetFields[] = { KEY_SLOT, KEY_OFFSET };
+	vector<pair<string, int> > offsets;
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int valueMap; is_open(ev) && next_member(valueMap); ++n)
 	{
-		if (string(skin->name) != "default")
+		// the offsets may come before the time, keep them until the key has been read
+		bool haveOffsets = false;
+		time.present = false;
+		offsets.clear();
+		for (int item; is_open(valueMap) && next_member(item);)
 		{
-			vcSkins.push_back(skin->name);
-			push_string(skin->name);
-			int rt = parse_skin(skin, vcSlots);
-			if (rt != 0)
+			if (r->key == KEY_TIME && !time.present)
+				capture(item, time);
+			else if (r->key == KEY_OFFSETS && !haveOffsets)
 			{
-				Json_dispose(root);
-				return -200 + rt;
+				haveOffsets = true;
+				for (int offsetMap; is_open(item) && next_member(offsetMap);)
+				{
+					if (read_object(offsetMap, offsetFields, 2))
+						return FAILED;
+					const char *slot = offsetFields[0].get_string(0);
+					offsets.push_back(make_pair(string(slot ? slot : ""), offsetFields[1].get_int(0)));
+				}
 			}
+			else
+				skip_value(item);
+		}
+		if (failed)
+			return FAILED;
+
+		o.push_float(time.get_float(0));
+		o.push_varint(offsets.size(), 1);
+		for (const auto &offset : offsets)
+		{
+			int slotIndex = lookup(tables.slots, offset.first, SECTION_SLOTS);
+			if (slotIndex == -1)
+				return -11;
+			o.push_varint(slotIndex, 1);
+			o.push_varint(offset.second, 1);
 		}
 	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
 
+int StreamConverter::read_event_timeline(int ev, StreamOutput &o)
+{
+	StreamField fields[] = { KEY_NAME, KEY_TIME, KEY_INT, KEY_FLOAT, KEY_STRING };
+	size_t count = o.begin_count();
+	int n = 0;
+	for (int valueMap; is_open(ev) && next_member(valueMap); ++n)
+	{
+		if (read_object(valueMap, fields, 5))
+			return FAILED;
+		const char * name = fields[0].get_string(0);
+		if (!name)
+			return -12;
+		o.push_float(fields[1].get_float(0));
 
-	/* Events. */
-	vector<EventData> vcEvents;
-	Json *events = Json_getItem(root, "events");
-	push_varint(events ? events->size : 0, 1);
-	for (Json *eventMap = events ? events->child : 0; eventMap; eventMap = eventMap->next)
+		int eventIndex = tables.eventNames.find(name);
+		if (eventIndex == -1)
+		{
+			if (!done[SECTION_EVENTS])
+				deferred = true;
+			return -13;
+		}
+		o.push_varint(eventIndex, 1);
+
+		o.push_varint(fields[2].get_int(tables.events[eventIndex].intValue), 0);
+		o.push_float(fields[3].get_float(tables.events[eventIndex].floatValue));
+		const char * str = fields[4].get_string(0);
+		o.push_boolen(str ? 1 : 0);
+		if (str)
+			o.push_string(str);
+	}
+	o.end_count(count, n);
+	return failed ? FAILED : 0;
+}
+
+int StreamConverter::convert(const char *json, const char *end, SpineSink &sink)
+{
+	Json_Reader reader;
+	Json_Reader_initRange(&reader, json, end);
+	r = &reader;
+
+	const char *pending[SECTION_COUNT] = {};
+	bool present[SECTION_COUNT] = {};
+	int errors[SECTION_COUNT] = {};
+	if (Json_Reader_next(r) != Json_Object)
+		failed = true;
+	for (int item; !failed && next_member(item);)
 	{
-		EventData ed;
-		ed.name = eventMap->name;
-		ed.intValue = Json_getInt(eventMap, "int", 0);
-		ed.floatValue = Json_getFloat(eventMap, "float", 0);
-		ed.stringValue = Json_getString(eventMap, "string", "");
-		vcEvents.push_back(ed);
+		int section = section_of(r->key);
+		if (section == -1 || present[section])
+		{
+			skip_value(item);
+			continue;
+		}
+		present[section] = true;
 
-		push_string(ed.name.c_str());
-		push_varint(ed.intValue, 0);
-		push_float(ed.floatValue);
-		push_string(ed.stringValue.c_str());
+		const char *start = r->start;
+		int rt = read_section(section, item);
+		if (deferred)
+		{
+			reset_section(section);
+			pending[section] = start;
+			deferred = false;
+		}
+		else
+		{
+			errors[section] = rt;
+			done[section] = true;
+		}
+		skip_to(1); // the rest of a section left by an error or a deferral
+	}
+	Json_Reader_dispose(&reader);
+	if (failed)
+		return -4;
+
+	// Every table is complete now. The binary's order puts each table before its users, so reading the deferred
+	// sections again in that order resolves every name.
+	for (int section = 0; section < SECTION_COUNT; ++section)
+		done[section] = true;
+	for (int section = 0; section < SECTION_COUNT; ++section)
+	{
+		if (!pending[section])
+			continue;
+		Json_Reader_initRange(&reader, pending[section], end);
+		errors[section] = read_section(section, Json_Reader_next(r));
+		Json_Reader_dispose(&reader);
 	}
 
+	// Report errors in the order convert_skeleton meets them.
+	static const int missing[SECTION_COUNT] = { -5, -8, -9, 0, 0, 0, -20, 0, 0 };
+	for (int section = 0; section < SECTION_COUNT; ++section)
+	{
+		if (!present[section] && missing[section])
+			return missing[section];
+		if (errors[section])
+			return errors[section];
+	}
 
-	/* Animations. */
-	Json  *animations = Json_getItem(root, "animations");
-	push_varint(animations ? animations->size : 0, 1);	
-	for (Json *aniMap = animations ? animations->child : 0; aniMap; aniMap = aniMap->next) {
-		push_string(aniMap->name);
-		int rt = parse_animation(aniMap, vcSlots, vcBones, vcIK, vcTransform, vcPaths, vcSkins, vcEvents);
-		if (rt != 0)
+	SinkBuffer output(sink);
+	vector<int> stringIndex;
+	if (strings)
+	{
+		vector<const StreamOutput *> outputs;
+		for (int section = 0; section < SECTION_COUNT; ++section)
 		{
-			Json_dispose(root);
-			return -300 + rt;
+			if (present[section])
+				outputs.push_back(&out[section]);
 		}
+		write_string_table(output, *strings, outputs, stringIndex);
 	}
+	const unsigned char emptyCount = 0;
+	for (int section = 0; section < SECTION_COUNT; ++section)
+	{
+		if (present[section])
+			out[section].write(output, stringIndex);
+		else
+			output.put(&emptyCount, 1);
+	}
+	output.flush();
+	return output.ok ? (int)output.total : SINK_FAILED;
+}
+
+int SpineConverter::convert_stream(const char *json, size_t len, unsigned char *outBuff)
+{
+	SpineBufferSink sink(outBuff, (size_t)-1);
+	return convert_stream(json, len, sink);
+}
+
+int SpineConverter::convert_stream(const char *json, size_t len, SpineSink &sink)
+{
+	if (len < 16)
+		return -1;
+
+	if (json[0] != '{')
+		return -2;
+
+	string head(json, len < 18 ? len : 18);
+	if (head.find("\"skeleton\"") == head.npos)
+		return -3;
+
+	intern_json_keys();
+
+	ScopedState scope(state);
+	StringPool strings;
+	StreamConverter converter(state->stringTable ? &strings : 0);
+	return converter.convert(json, json + len, sink);
+}
 
-	Json_dispose(root);
-	return buff_pos;
+int convert_json_to_binary_stream(const char *json, size_t len, unsigned char *outBuff, const char *atlas)
+{
+	SpineConverter converter;
+	converter.set_atlas(atlas);
+	return converter.convert_stream(json, len, outBuff);
+}
+
+int convert_json_to_binary_stream(const char *json, size_t len, SpineSink &sink, const char *atlas)
+{
+	SpineConverter converter;
+	converter.set_atlas(atlas);
+	return converter.convert_stream(json, len, sink);
 }
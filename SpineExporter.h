@@ -23,6 +23,346 @@ SOFTWARE.
 #ifndef __SPINE_EXPORTER_H__
 #define __SPINE_EXPORTER_H__
 
-int convert_json_to_binary(const char *json, size_t len, unsigned char *outBuff,const char *atlas = 0);
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Json.h"
+
+// Receives the output of a conversion in order, a piece at a time. On error it may have received part of the output.
+class SpineSink
+{
+public:
+	virtual ~SpineSink() {}
+
+	// Returns false to stop, the conversion then returns -21.
+	virtual bool write(const unsigned char *data, size_t size) = 0;
+};
+
+// Copies the output to a buffer of capacity bytes. What doesn't fit is dropped but still counted, so the conversion
+// returns the size it needs: more than capacity means the output was cut. A 0 buffer of 0 capacity only measures.
+class SpineBufferSink : public SpineSink
+{
+public:
+	SpineBufferSink(unsigned char *buffer, size_t capacity) : buffer(buffer), capacity(capacity), total(0) {}
+	bool write(const unsigned char *data, size_t size) override;
+
+private:
+	unsigned char *buffer;
+	size_t capacity;
+	size_t total;
+};
+
+// Appends the output to a vector, which grows as needed.
+class SpineVectorSink : public SpineSink
+{
+public:
+	explicit SpineVectorSink(std::vector<unsigned char> &out) : out(out) {}
+	bool write(const unsigned char *data, size_t size) override;
+
+private:
+	std::vector<unsigned char> &out;
+};
+
+// Writes the output to a file. A file descriptor can be wrapped with fdopen.
+class SpineFileSink : public SpineSink
+{
+public:
+	explicit SpineFileSink(FILE *file) : file(file) {}
+	bool write(const unsigned char *data, size_t size) override;
+
+private:
+	FILE *file;
+};
+
+// The sections of the output, in its order.
+enum SpineSection
+{
+	SPINE_SECTION_HEADER, // the skeleton's hash, version and size
+	SPINE_SECTION_BONES,
+	SPINE_SECTION_SLOTS,
+	SPINE_SECTION_IK,
+	SPINE_SECTION_TRANSFORM,
+	SPINE_SECTION_PATH,
+	SPINE_SECTION_SKINS,
+	SPINE_SECTION_EVENTS,
+	SPINE_SECTION_ANIMATIONS,
+	SPINE_SECTION_COUNT
+};
+
+enum SpineTimelineType
+{
+	SPINE_TIMELINE_ATTACHMENT,
+	SPINE_TIMELINE_COLOR,
+	SPINE_TIMELINE_TWO_COLOR,
+	SPINE_TIMELINE_ROTATE,
+	SPINE_TIMELINE_TRANSLATE,
+	SPINE_TIMELINE_SCALE,
+	SPINE_TIMELINE_SHEAR,
+	SPINE_TIMELINE_IK,
+	SPINE_TIMELINE_TRANSFORM,
+	SPINE_TIMELINE_PATH_POSITION,
+	SPINE_TIMELINE_PATH_SPACING,
+	SPINE_TIMELINE_PATH_MIX,
+	SPINE_TIMELINE_DEFORM,
+	SPINE_TIMELINE_DRAW_ORDER,
+	SPINE_TIMELINE_EVENT,
+	SPINE_TIMELINE_COUNT
+};
+
+// Names for reports, "bones", "twoColor" and so on.
+const char *spine_section_name(int section);
+const char *spine_timeline_name(int type);
+
+struct SpineTimelineCount
+{
+	size_t timelines = 0;
+	size_t keys = 0;
+};
+
+// What the keyframe decimation dropped, see SpineConverter::set_decimation.
+struct SpineDecimationCount
+{
+	size_t keys = 0;
+	size_t timelines = 0; // dropped whole, their keys counted in keys
+	size_t bytes = 0; // as a plain output has them, a string table output saves the same but for attachment names
+};
+
+// What the dead data stripping removed, see SpineConverter::set_stripping.
+struct SpineStrippedCount
+{
+	size_t animations = 0;
+	size_t skins = 0;
+	size_t attachments = 0; // in the skins kept
+	size_t slots = 0;
+	size_t bones = 0;
+	size_t events = 0;
+	size_t timelines = 0; // of the animations kept, on what was removed
+	std::vector<std::string> unmatched; // keep list names the skeleton doesn't have, "animations/name" and so on
+};
+
+// What the vertex cache optimization of meshes did, see SpineConverter::set_vertex_cache. Misses are those of a FIFO
+// post-transform cache of the size optimized for, misses over triangles is the average cache miss ratio, ACMR.
+struct SpineVertexCacheCount
+{
+	size_t meshes = 0;
+	size_t triangles = 0;
+	size_t missesBefore = 0;
+	size_t missesAfter = 0;
+};
+
+// The influences of the weighted vertices of a mesh, see SpineConverter::set_influences. CPU skinning transforms each
+// vertex once per influence, the bones it follows.
+struct SpineMeshInfluences
+{
+	std::string name; // skin/slot/attachment
+	size_t vertices = 0;
+	size_t before = 0;
+	size_t after = 0;
+};
+
+struct SpineAnimationStats
+{
+	std::string name;
+	double seconds = 0; // encoding it, on whichever thread did
+	size_t bytes = 0;
+	SpineTimelineCount timelines[SPINE_TIMELINE_COUNT]; // as encoded, after the decimation
+	SpineDecimationCount decimated;
+};
+
+// Where a conversion spent its time and output, filled in by a converter given it with set_stats. Times are wall
+// times in seconds. With threads, the skins and animations are encoded on several threads at once, their times are
+// what each took on its thread, so the sections can add up to more than totalSeconds. In string table mode the bytes
+// leave out the strings, which are all in the table.
+struct SpineConverterStats
+{
+	double totalSeconds = 0;
+	double parseSeconds = 0; // the json text into a tree
+	double sectionSeconds[SPINE_SECTION_COUNT] = {};
+	size_t sectionBytes[SPINE_SECTION_COUNT] = {};
+	size_t jsonNodes = 0; // values in the tree, members' names not counted
+	size_t arenaBlocks = 0; // allocated by the parse, 0 once the converter's arena is warm
+	SpineTimelineCount timelines[SPINE_TIMELINE_COUNT]; // of all animations
+	SpineDecimationCount decimated; // of all animations
+	SpineStrippedCount stripped;
+	SpineVertexCacheCount vertexCache;
+	std::vector<SpineMeshInfluences> influences; // of the weighted meshes written, in skin order
+	std::vector<SpineAnimationStats> animations; // in output order
+
+	void clear();
+};
+
+// Tolerances of the keyframe decimation, see SpineConverter::set_decimation. Each bounds how far a value may end up
+// from the one the animator keyed, at any time.
+struct SpineDecimation
+{
+	float rotation = 0.1f; // degrees, rotate timelines
+	float translation = 0.1f; // skeleton units, translate timelines and fixed or length path positions and spacings
+	float scale = 0.001f;
+	float shear = 0.1f; // degrees
+	float color = 1 / 255.0f; // per channel, of 0..1
+	float mix = 0.001f; // constraint mixes, percent path positions and spacings
+};
+
+// What the dead data stripping keeps besides what the skeleton reaches, see SpineConverter::set_stripping. Names of
+// things the skeleton doesn't have keep nothing, stats list them in SpineStrippedCount::unmatched.
+struct SpineStripping
+{
+	std::vector<std::string> animations; // all when empty
+	std::vector<std::string> skins; // besides the default skin, all when empty
+	std::vector<std::string> bones; // kept with their parents, such as bones code follows
+};
+
+// Limits on the influences of weighted mesh vertices, see SpineConverter::set_influences.
+struct SpineInfluences
+{
+	int max = 4; // per vertex, 0 for no limit
+	float minWeight = 0.001f; // lighter influences are dropped
+};
+
+struct SpineConverterState;
+struct SpineChunksData;
+
+// The encoded skins and animations of one skeleton, kept from a conversion of it to the next, see
+// SpineConverter::set_chunks. Each chunk is keyed by a hash of its part's text and name and of what its encoding
+// depends on. Saved next to the output as a sidecar file, an edit to one animation of a large skeleton then only costs
+// the parse and the encoding of that animation.
+class SpineChunks
+{
+public:
+	SpineChunks();
+	~SpineChunks();
+	SpineChunks(const SpineChunks &) = delete;
+	SpineChunks &operator=(const SpineChunks &) = delete;
+
+	// Replaces the chunks with a sidecar's. false and no chunks when it is missing, damaged or of another converter.
+	bool load(const std::string &path);
+
+	// Writes a sidecar through a temporary file renamed into place. false when it couldn't be written.
+	bool save(const std::string &path) const;
+
+	void clear();
+	size_t size() const;
+
+	// The parts of the last conversion spliced from a chunk, and those parsed and encoded.
+	size_t reused() const;
+	size_t encoded() const;
+
+private:
+	friend class SpineConverter;
+	SpineChunksData *data;
+};
+
+// A conversion context. Converters on different threads run at the same time, one converter is used by one thread at
+// a time. Reusing a converter for a batch keeps its atlas, arena and buffers.
+class SpineConverter
+{
+public:
+	// arena: optional, as for convert_json_to_binary. Without one the converter makes its own on first use.
+	explicit SpineConverter(Json_Arena *arena = 0);
+	~SpineConverter();
+	SpineConverter(const SpineConverter &) = delete;
+	SpineConverter &operator=(const SpineConverter &) = delete;
+
+	// Filters the attachments of the next conversions by atlas, 0 for no filter. It is parsed now, not kept.
+	void set_atlas(const char *atlas);
+
+	// Same, with the atlas in the len bytes at atlas, which needn't be NUL terminated.
+	void set_atlas(const char *atlas, size_t len);
+
+	// Threads for the skins and animations of one skeleton, 0 for one per core. The default 1 encodes on the calling
+	// thread, leave it so when the calls themselves run in parallel. The output is the same either way.
+	void set_threads(int threads);
+
+	// String table mode, off by default. The output then starts with a 0 byte and a table of the distinct strings it
+	// uses, in the order they first appear: a varint count, then each string as usual. Every string after that is a
+	// varint, its table index plus one, 0 for null. The rest of the format is unchanged. SpineReader.h reads both.
+	void set_string_table(bool stringTable);
+
+	// Fills stats on each convert, 0 for none, the default. It is cleared first, a failed conversion leaves what it
+	// got to. convert_stream reads and encodes at once, it has no phases to tell apart and leaves stats alone.
+	void set_stats(SpineConverterStats *stats);
+
+	// Converts incrementally with chunks, 0 for none, the default. The skins and animations are then left out of the
+	// parse by a bracket matching scan. A part whose text and name, and the names and atlas its encoding depends on,
+	// are those of a chunk is spliced from it. Only the others are parsed and encoded. The output is the same either
+	// way, so is the error unless the json is malformed. A conversion that succeeds leaves its own chunks, one that
+	// fails leaves them alone. Stats count no time or timelines for spliced parts. convert_stream doesn't use chunks.
+	void set_chunks(SpineChunks *chunks);
+
+	// Keyframe decimation, 0 for none, the default. decimation is copied. Before an animation is encoded, the keys of
+	// its slot, bone, ik, transform and path timelines that the keys around them reproduce within the tolerances are
+	// dropped: keys inside runs of identical keys, keys linear interpolation passes close enough to, and the tail of a
+	// timeline that holds its value. A timeline that holds the setup pose is dropped whole, and so is a slot, bone or
+	// path left without timelines. Segments with bezier curves are kept, and so is a key the animation's duration
+	// depends on. Deform, draw order and event timelines aren't decimated. The output is in the same format, but an
+	// animation no longer forces the setup pose where it only held it, over a lower track it is mixed with. Stats
+	// count what was dropped. convert_stream doesn't decimate.
+	void set_decimation(const SpineDecimation *decimation);
+
+	// Dead data stripping, 0 for none, the default. stripping is copied. Once parsed, the skeleton is cut down to the
+	// animations and skins it keeps and what they reach. An attachment is reached when a kept skin has it and the
+	// slot's setup pose or an attachment key shows it, or a linked mesh reached uses it as its parent, whose skin is
+	// then kept too. An attachment the atlas filters out isn't reached. A slot is reached when it has an attachment
+	// reached, or a path constraint or clipping attachment reached names it, a bone when a slot, constraint, weighted
+	// vertex or the keep list names it, or it is the parent of one. The root bone, the default skin and the
+	// constraints are always kept. Events no animation kept fires go. The timelines of what was removed go with it,
+	// weighted vertices and draw order keys are remapped to what is left. Code that shows attachments or finds slots
+	// by name the skeleton never reaches finds them gone. Stats count what was removed. Incremental conversion is
+	// off while stripping, and convert_stream doesn't strip.
+	void set_stripping(const SpineStripping *stripping);
+
+	// Vertex cache optimization of meshes for a FIFO post-transform cache of cacheSize vertices, 0 for none, the
+	// default. Once parsed, the triangles of each mesh are reordered with Tipsify, kept as they were when that misses
+	// the cache more. Then its vertices are renumbered in the order the triangles first use them, hull vertices first
+	// and in place, so the hull is the same. Uvs, vertices and the deform keys of the mesh and its linked meshes
+	// follow, a deform key keeping only the span its non-zero values need. A mesh whose triangles overlap may draw
+	// them in another order. Meshes the atlas filters out are left alone. Stats count the cache misses of those
+	// written before and after. Incremental conversion is off while optimizing, and convert_stream doesn't optimize.
+	void set_vertex_cache(int cacheSize);
+
+	// Influence limits of weighted mesh vertices, 0 for none, the default. influences is copied. Once parsed, the
+	// influences of each weighted vertex lighter than minWeight are dropped, then the lightest past max, never the
+	// heaviest. The weights left are scaled back to the total they had. Then the influences are sorted by bone index.
+	// The deform keys of the mesh and its linked meshes, with values per influence, keep those of the influences
+	// left. Meshes the atlas filters out are left alone. Stats list the influences of each weighted mesh written
+	// before and after. Incremental conversion is off while limiting, and convert_stream doesn't limit.
+	void set_influences(const SpineInfluences *influences);
+
+	// The settings that change the output as bits, for keying stored outputs: 1 string table, 2 decimation,
+	// 4 stripping, 8 vertex cache optimization, 16 influence limits, then 59 bits of a hash of the decimation's
+	// tolerances, the keep lists, the cache size and the limits above those. The atlas isn't among them, it is kept
+	// parsed only. Threads don't change the output.
+	uint64_t output_options() const;
+
+	// The functions below, with the converter's atlas.
+	int convert(const char *json, size_t len, unsigned char *outBuff);
+	int convert(const char *json, size_t len, SpineSink &sink);
+	int convert_size(const char *json, size_t len);
+	int convert_stream(const char *json, size_t len, unsigned char *outBuff);
+	int convert_stream(const char *json, size_t len, SpineSink &sink);
+
+private:
+	SpineConverterState *state;
+};
+
+// Each call runs on a converter of its own, so these are thread safe too.
+// outBuff must hold the whole output, convert_json_to_binary_size tells how much that is.
+// arena: optional, nodes and strings of the parsed json are carved from it and it is reset before returning.
+// Pass the same arena to every call of a batch so the parser stops allocating once the arena is warm.
+int convert_json_to_binary(const char *json, size_t len, unsigned char *outBuff,const char *atlas = 0, Json_Arena *arena = 0);
+
+// Same, writing to sink. Returns the output size.
+int convert_json_to_binary(const char *json, size_t len, SpineSink &sink, const char *atlas = 0, Json_Arena *arena = 0);
+
+// The exact output size of convert_json_to_binary, or its error. Nothing is written.
+int convert_json_to_binary_size(const char *json, size_t len, const char *atlas = 0, Json_Arena *arena = 0);
+
+// Same output and errors as convert_json_to_binary, but encoded while the json is read instead of from a parsed tree.
+// Apart from the output, memory is bounded by the largest attachment or keyframe rather than by the input.
+// json is read in place up to len, like convert_json_to_binary it needn't be NUL terminated.
+int convert_json_to_binary_stream(const char *json, size_t len, unsigned char *outBuff, const char *atlas = 0);
+int convert_json_to_binary_stream(const char *json, size_t len, SpineSink &sink, const char *atlas = 0);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#include "SpineFile.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const int FILE_READ_FAILED = -22;
+const int FILE_WRITE_FAILED = -21; // as a sink that fails
+
+// Smaller files are read and written with plain calls, setting up and tearing down a mapping costs more than the copy
+// it saves.
+const size_t MAP_MIN = 1024 * 1024;
+
+// The output mapping grows in steps of this, and starts at half the json, about one and a half times what Spine's
+// json usually converts to, so it seldom grows at all.
+const size_t OUTPUT_STEP = 64 * 1024;
+
+static bool read_copy(const char *path, vector<char> &out)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return false;
+	char chunk[64 * 1024];
+	size_t n;
+	out.clear();
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+		out.insert(out.end(), chunk, chunk + n);
+	bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
+
+SpineMappedFile::SpineMappedFile(const char *path) : opened(false), bytes(""), length(0)
+{
+#ifndef _WIN32
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+	{
+		if (st.st_size == 0)
+			opened = true;
+		else if ((size_t)st.st_size >= MAP_MIN)
+		{
+			void *view = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED)
+			{
+				// parsed front to back once, read ahead of it and drop what's behind
+				madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+				bytes = (const char *)view;
+				length = (size_t)st.st_size;
+				opened = true;
+			}
+		}
+	}
+	close(fd);
+	if (opened)
+		return;
+#endif
+	if (read_copy(path, copy))
+	{
+		opened = true;
+		length = copy.size();
+		if (length)
+			bytes = copy.data();
+	}
+}
+
+SpineMappedFile::~SpineMappedFile()
+{
+#ifndef _WIN32
+	if (length && copy.empty())
+		munmap((void *)bytes, length);
+#endif
+}
+
+#ifndef _WIN32
+static size_t round_step(size_t n)
+{
+	return (n + OUTPUT_STEP - 1) / OUTPUT_STEP * OUTPUT_STEP;
+}
+
+// Writes the output into a shared mapping of the file, so it goes to the page cache without a write call's copy.
+class MappedFileSink : public SpineSink
+{
+public:
+	MappedFileSink(int fd, size_t estimate) : fd(fd), view(0), capacity(0), size(0), failed(false)
+	{
+		failed = !map(round_step(estimate + 1));
+	}
+
+	bool write(const unsigned char *data, size_t n) override
+	{
+		if (failed)
+			return false;
+		if (capacity - size < n && !map(round_step(2 * (size + n))))
+		{
+			failed = true;
+			return false;
+		}
+		memcpy(view + size, data, n);
+		size += n;
+		return true;
+	}
+
+	// Unmaps the file and cuts it to the output, false when it couldn't be written.
+	bool finish()
+	{
+		unmap();
+		return !failed && ftruncate(fd, (off_t)size) == 0;
+	}
+
+	~MappedFileSink() { unmap(); }
+
+private:
+	void unmap()
+	{
+		if (view)
+			munmap(view, capacity);
+		view = 0;
+	}
+
+	// Maps the file again at a size of newCapacity.
+	bool map(size_t newCapacity)
+	{
+		unmap();
+		capacity = newCapacity;
+		if (ftruncate(fd, (off_t)capacity) != 0)
+			return false;
+#if defined(__linux__)
+		// a sparse file that runs out of disk faults on the first write to a hole, reserve the blocks instead
+		int rt = posix_fallocate(fd, 0, (off_t)capacity);
+		if (rt != 0 && rt != EINVAL && rt != EOPNOTSUPP)
+			return false;
+#endif
+		void *mapped = mmap(0, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapped == MAP_FAILED)
+			return false;
+		madvise(mapped, capacity, MADV_SEQUENTIAL);
+		view = (unsigned char *)mapped;
+		return true;
+	}
+
+	int fd;
+	unsigned char *view;
+	size_t capacity;
+	size_t size;
+	bool failed;
+};
+#endif
+
+int convert_json_file(SpineConverter &converter, const char *jsonPath, const char *outPath, const char *atlasPath)
+{
+	SpineMappedFile json(jsonPath);
+	if (!json.ok())
+		return FILE_READ_FAILED;
+	if (atlasPath)
+	{
+		// parsed by set_atlas, not kept
+		SpineMappedFile atlas(atlasPath);
+		if (!atlas.ok())
+			return FILE_READ_FAILED;
+		converter.set_atlas(atlas.data(), atlas.size());
+	}
+	else
+		converter.set_atlas(0);
+
+	int rt;
+#ifdef _WIN32
+	FILE *f = fopen(outPath, "wb");
+	if (!f)
+		return FILE_WRITE_FAILED;
+	SpineFileSink sink(f);
+	rt = converter.convert(json.data(), json.size(), sink);
+	if (fclose(f) != 0 && rt >= 0)
+		rt = FILE_WRITE_FAILED;
+#else
+	int fd = open(outPath, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return FILE_WRITE_FAILED;
+	if (json.size() >= MAP_MIN)
+	{
+		MappedFileSink sink(fd, json.size() / 2);
+		rt = converter.convert(json.data(), json.size(), sink);
+		if (!sink.finish() && rt >= 0)
+			rt = FILE_WRITE_FAILED;
+	}
+	else
+	{
+		vector<unsigned char> out;
+		SpineVectorSink sink(out);
+		rt = converter.convert(json.data(), json.size(), sink);
+		if (rt >= 0 && ::write(fd, out.data(), out.size()) != (ssize_t)out.size())
+			rt = FILE_WRITE_FAILED;
+	}
+	if (close(fd) != 0 && rt >= 0)
+		rt = FILE_WRITE_FAILED;
+#endif
+	if (rt < 0)
+		remove(outPath);
+	return rt;
+}
+
+int convert_json_file_to_binary(const char *jsonPath, const char *outPath, const char *atlasPath)
+{
+	SpineConverter converter;
+	return convert_json_file(converter, jsonPath, outPath, atlasPath);
+}
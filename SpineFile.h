@@ -0,0 +1,64 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_FILE_H__
+#define __SPINE_FILE_H__
+
+#include <stddef.h>
+#include <vector>
+#include "SpineExporter.h"
+
+// File to file conversion. The json and the atlas are mapped read-only and used where they lie, the json isn't NUL
+// terminated and the converter reads only its bytes. The output goes straight into a mapping of the output file, which
+// is sized ahead, grown when the output outgrows it and cut to the output's size at the end. Both are read and
+// written front to back, and the mappings are hinted so, so the kernel reads ahead and drops pages behind. Files under
+// a megabyte, and every file where mapping isn't available, are read and written with plain calls instead.
+
+// A file mapped read-only, or read when it is small. Empty when it can't be read, and for an empty file.
+class SpineMappedFile
+{
+public:
+	explicit SpineMappedFile(const char *path);
+	~SpineMappedFile();
+	SpineMappedFile(const SpineMappedFile &) = delete;
+	SpineMappedFile &operator=(const SpineMappedFile &) = delete;
+
+	bool ok() const { return opened; }
+	const char *data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	bool opened;
+	const char *bytes;
+	size_t length;
+	std::vector<char> copy; // where mapping isn't available
+};
+
+// Converts the json file at jsonPath into the file at outPath with converter, filtered by the atlas file at atlasPath
+// unless it is 0. Returns what converter.convert does, -22 when the json or the atlas can't be read, and -21 when the
+// output can't be written. A failed conversion removes the output.
+int convert_json_file(SpineConverter &converter, const char *jsonPath, const char *outPath, const char *atlasPath = 0);
+
+// Same, on a converter of its own.
+int convert_json_file_to_binary(const char *jsonPath, const char *outPath, const char *atlasPath = 0);
+
+#endif
@@ -0,0 +1,89 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_HASH_H__
+#define __SPINE_HASH_H__
+
+// The hash that keys stored conversions, SpineCache's entries and the converter's chunks.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+const uint64_t SPINE_HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t SPINE_HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t SPINE_HASH_PRIME3 = 0x165667B19E3779F9ULL;
+
+static inline uint64_t spine_rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t spine_read64(const unsigned char *p)
+{
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t spine_hash_round(uint64_t acc, uint64_t word)
+{
+	return spine_rotl64(acc + word * SPINE_HASH_PRIME2, 31) * SPINE_HASH_PRIME1;
+}
+
+// A 64 bit hash in the manner of xxHash64, 32 bytes a round on four lanes, many times faster than parsing the json it
+// keys. Not cryptographic. Words are read in host order, so keys differ between byte orders, which only costs misses.
+static inline uint64_t spine_hash(const void *data, size_t len, uint64_t seed)
+{
+	const unsigned char *p = (const unsigned char *)data, *end = p + len;
+	uint64_t h = seed + SPINE_HASH_PRIME3;
+	if (len >= 32)
+	{
+		uint64_t v1 = seed + SPINE_HASH_PRIME1 + SPINE_HASH_PRIME2, v2 = seed + SPINE_HASH_PRIME2;
+		uint64_t v3 = seed, v4 = seed - SPINE_HASH_PRIME1;
+		for (; end - p >= 32; p += 32)
+		{
+			v1 = spine_hash_round(v1, spine_read64(p));
+			v2 = spine_hash_round(v2, spine_read64(p + 8));
+			v3 = spine_hash_round(v3, spine_read64(p + 16));
+			v4 = spine_hash_round(v4, spine_read64(p + 24));
+		}
+		h = spine_rotl64(v1, 1) + spine_rotl64(v2, 7) + spine_rotl64(v3, 12) + spine_rotl64(v4, 18);
+		h = (h ^ spine_hash_round(0, v1)) * SPINE_HASH_PRIME1 + SPINE_HASH_PRIME3;
+		h = (h ^ spine_hash_round(0, v2)) * SPINE_HASH_PRIME1 + SPINE_HASH_PRIME3;
+		h = (h ^ spine_hash_round(0, v3)) * SPINE_HASH_PRIME1 + SPINE_HASH_PRIME3;
+		h = (h ^ spine_hash_round(0, v4)) * SPINE_HASH_PRIME1 + SPINE_HASH_PRIME3;
+	}
+	h += len;
+	for (; end - p >= 8; p += 8)
+		h = spine_rotl64(h ^ spine_hash_round(0, spine_read64(p)), 27) * SPINE_HASH_PRIME1 + SPINE_HASH_PRIME3;
+	for (; p < end; ++p)
+		h = spine_rotl64(h ^ (*p * SPINE_HASH_PRIME3), 11) * SPINE_HASH_PRIME1;
+	h ^= h >> 33;
+	h *= SPINE_HASH_PRIME2;
+	h ^= h >> 29;
+	h *= SPINE_HASH_PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+#endif
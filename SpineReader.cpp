@@ -0,0 +1,769 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#include "SpineReader.h"
+#include <string.h>
+#include <tuple>
+#include <unordered_map>
+
+using namespace std;
+
+// Same values as the exporter's constants.
+const int ATTACHMENT_REGION = 0;
+const int ATTACHMENT_BOUNDING_BOX = 1;
+const int ATTACHMENT_MESH = 2;
+const int ATTACHMENT_LINKED_MESH = 3;
+const int ATTACHMENT_PATH = 4;
+const int ATTACHMENT_POINT = 5;
+const int ATTACHMENT_CLIPPING = 6;
+
+const int CURVE_BEZIER = 2;
+
+const unsigned char STRING_TABLE_MARKER = 0;
+
+bool SpineBoneData::operator==(const SpineBoneData &o) const
+{
+	return tie(name, parent, rotation, x, y, scaleX, scaleY, shearX, shearY, length, mode) ==
+		tie(o.name, o.parent, o.rotation, o.x, o.y, o.scaleX, o.scaleY, o.shearX, o.shearY, o.length, o.mode);
+}
+
+bool SpineSlotData::operator==(const SpineSlotData &o) const
+{
+	return tie(name, bone, attachment, blend) == tie(o.name, o.bone, o.attachment, o.blend) &&
+		memcmp(color, o.color, 4) == 0 && memcmp(dark, o.dark, 4) == 0;
+}
+
+bool SpineIkData::operator==(const SpineIkData &o) const
+{
+	return tie(name, order, bones, target, mix, bendDirection) ==
+		tie(o.name, o.order, o.bones, o.target, o.mix, o.bendDirection);
+}
+
+bool SpineTransformData::operator==(const SpineTransformData &o) const
+{
+	return tie(name, order, bones, target, local, relative, rotation, x, y, scaleX, scaleY, shearY) ==
+		tie(o.name, o.order, o.bones, o.target, o.local, o.relative, o.rotation, o.x, o.y, o.scaleX, o.scaleY, o.shearY) &&
+		tie(rotateMix, translateMix, scaleMix, shearMix) == tie(o.rotateMix, o.translateMix, o.scaleMix, o.shearMix);
+}
+
+bool SpinePathData::operator==(const SpinePathData &o) const
+{
+	return tie(name, order, bones, target, positionMode, spacingMode, rotateMode) ==
+		tie(o.name, o.order, o.bones, o.target, o.positionMode, o.spacingMode, o.rotateMode) &&
+		tie(rotation, position, spacing, rotateMix, translateMix) ==
+		tie(o.rotation, o.position, o.spacing, o.rotateMix, o.translateMix);
+}
+
+bool SpineVerticesData::operator==(const SpineVerticesData &o) const
+{
+	return tie(weighted, bones, values) == tie(o.weighted, o.bones, o.values);
+}
+
+bool SpineAttachmentData::operator==(const SpineAttachmentData &o) const
+{
+	return tie(key, name, type, path, rotation, x, y, scaleX, scaleY, width, height) ==
+		tie(o.key, o.name, o.type, o.path, o.rotation, o.x, o.y, o.scaleX, o.scaleY, o.width, o.height) &&
+		memcmp(color, o.color, 4) == 0 &&
+		tie(vertexCount, uvs, triangles, vertices, hull, skin, parent, deform, closed, constantSpeed, lengths, endSlot) ==
+		tie(o.vertexCount, o.uvs, o.triangles, o.vertices, o.hull, o.skin, o.parent, o.deform, o.closed,
+			o.constantSpeed, o.lengths, o.endSlot);
+}
+
+bool SpineSkinSlotData::operator==(const SpineSkinSlotData &o) const
+{
+	return tie(slot, attachments) == tie(o.slot, o.attachments);
+}
+
+bool SpineSkinData::operator==(const SpineSkinData &o) const
+{
+	return tie(name, slots) == tie(o.name, o.slots);
+}
+
+bool SpineEventData::operator==(const SpineEventData &o) const
+{
+	return tie(name, intValue, floatValue, stringValue) == tie(o.name, o.intValue, o.floatValue, o.stringValue);
+}
+
+bool SpineCurveData::operator==(const SpineCurveData &o) const
+{
+	return type == o.type && memcmp(values, o.values, sizeof(values)) == 0;
+}
+
+bool SpineTimelineData::operator==(const SpineTimelineData &o) const
+{
+	return tie(type, index, skin, attachment, frameCount, frames, curves, ints, deform) ==
+		tie(o.type, o.index, o.skin, o.attachment, o.frameCount, o.frames, o.curves, o.ints, o.deform);
+}
+
+bool SpineAnimationData::operator==(const SpineAnimationData &o) const
+{
+	return tie(name, timelines) == tie(o.name, o.timelines);
+}
+
+bool SpineSkeletonData::operator==(const SpineSkeletonData &o) const
+{
+	return tie(strings, hash, version, width, height, bones, slots, ik, transform, paths) ==
+		tie(o.strings, o.hash, o.version, o.width, o.height, o.bones, o.slots, o.ik, o.transform, o.paths) &&
+		tie(skins, events, animations) == tie(o.skins, o.events, o.animations);
+}
+
+// Decodes the primitives of the format. The first failure sticks: later reads return 0 and ok stays false.
+class SpineBinaryInput
+{
+public:
+	SpineBinaryInput(const unsigned char *data, size_t size, SpineSkeletonData &model)
+		: data(data), pos(0), size(size), model(model), ok(true) {}
+
+	bool good() const { return ok; }
+	bool at_end() const { return pos == size; }
+	size_t position() const { return pos; }
+	const char *error() const { return what; }
+
+	void fail(const char *reason)
+	{
+		if (ok)
+		{
+			what = reason;
+			ok = false;
+		}
+	}
+
+	unsigned char read_byte()
+	{
+		if (pos >= size)
+		{
+			fail("cut short");
+			return 0;
+		}
+		return data[pos++];
+	}
+
+	bool read_boolean()
+	{
+		return read_byte() != 0;
+	}
+
+	int read_varint(bool optimizePositive)
+	{
+		unsigned int v = 0;
+		for (int i = 0; i < 5; ++i)
+		{
+			unsigned char b = read_byte();
+			v |= (unsigned int)(b & 0x7F) << (i * 7);
+			if (!(b & 0x80))
+				break;
+		}
+		if (!optimizePositive)
+			v = (v >> 1) ^ (0 - (v & 1));
+		return (int)v;
+	}
+
+	// A count of things that take at least a byte each, so a corrupt count fails here instead of allocating.
+	int read_count()
+	{
+		int n = read_varint(true);
+		if (n < 0 || (size_t)n > size - pos)
+		{
+			fail("count past the end");
+			return 0;
+		}
+		return n;
+	}
+
+	float read_float()
+	{
+		if (size - pos < 4)
+		{
+			fail("cut short");
+			pos = size;
+			return 0;
+		}
+		unsigned char c[4] = { data[pos + 3], data[pos + 2], data[pos + 1], data[pos] };
+		pos += 4;
+		float v;
+		memcpy(&v, c, 4);
+		return v;
+	}
+
+	void read_floats(vector<float> &out, int n)
+	{
+		if (n < 0 || (size_t)n > (size - pos) / 4)
+		{
+			fail("cut short");
+			return;
+		}
+		size_t start = out.size();
+		out.resize(start + n);
+		for (int i = 0; i < n; ++i)
+			out[start + i] = read_float();
+	}
+
+	void read_color(unsigned char *out)
+	{
+		for (int i = 0; i < 4; ++i)
+			out[i] = read_byte();
+	}
+
+	void read_color(vector<float> &out)
+	{
+		for (int i = 0; i < 4; ++i)
+			out.push_back(read_byte() / 255.0f);
+	}
+
+	// An index that must be below limit.
+	int read_index(int limit, const char *what)
+	{
+		int index = read_varint(true);
+		if (index < 0 || index >= limit)
+		{
+			fail(what);
+			return 0;
+		}
+		return index;
+	}
+
+	void read_string_table()
+	{
+		int n = read_count();
+		for (int i = 0; i < n && ok; ++i)
+		{
+			string str;
+			if (!read_text(str))
+				fail("null in the string table");
+			model.strings.push_back(str);
+		}
+	}
+
+	// An id into the model's strings, -1 for null.
+	int read_string()
+	{
+		if (model.stringTable)
+		{
+			int index = read_varint(true);
+			if (index < 0 || index > (int)model.strings.size())
+			{
+				fail("string index out of range");
+				return -1;
+			}
+			model.stringReads += index > 0;
+			return index - 1;
+		}
+		string str;
+		if (!read_text(str))
+			return -1;
+		model.stringReads++;
+		auto it = ids.find(str);
+		if (it != ids.end())
+			return it->second;
+		int id = (int)model.strings.size();
+		ids.emplace(str, id);
+		model.strings.push_back(str);
+		return id;
+	}
+
+private:
+	const unsigned char *data;
+	size_t pos;
+	size_t size;
+	SpineSkeletonData &model;
+	unordered_map<string, int> ids; // plain mode
+	bool ok;
+	const char *what = 0;
+
+	// false for null
+	bool read_text(string &out)
+	{
+		int length = read_varint(true);
+		if (length == 0)
+			return false;
+		if (length < 0 || (size_t)length - 1 > size - pos)
+		{
+			fail("string past the end");
+			return false;
+		}
+		out.assign((const char *)data + pos, length - 1);
+		pos += length - 1;
+		return true;
+	}
+};
+
+static void read_curve(SpineBinaryInput &in, SpineTimelineData &timeline)
+{
+	SpineCurveData curve = {};
+	curve.type = in.read_byte();
+	if (curve.type == CURVE_BEZIER)
+	{
+		for (int i = 0; i < 4; ++i)
+			curve.values[i] = in.read_float();
+	}
+	else if (curve.type > CURVE_BEZIER)
+		in.fail("unknown curve");
+	timeline.curves.push_back(curve);
+}
+
+static SpineTimelineData new_timeline(int type, int index)
+{
+	SpineTimelineData timeline;
+	timeline.type = type;
+	timeline.index = index;
+	timeline.skin = 0;
+	timeline.attachment = -1;
+	timeline.frameCount = 0;
+	return timeline;
+}
+
+// Keys of stride floats with a curve between each, the layout of most timelines.
+static void read_curve_frames(SpineBinaryInput &in, SpineTimelineData &timeline, int stride)
+{
+	timeline.frameCount = in.read_count();
+	for (int frame = 0; frame < timeline.frameCount && in.good(); ++frame)
+	{
+		in.read_floats(timeline.frames, stride);
+		if (frame < timeline.frameCount - 1)
+			read_curve(in, timeline);
+	}
+}
+
+static void read_vertices(SpineBinaryInput &in, SpineVerticesData &vertices, int vertexCount, int boneCount)
+{
+	vertices.weighted = in.read_boolean();
+	if (!vertices.weighted)
+	{
+		in.read_floats(vertices.values, vertexCount << 1);
+		return;
+	}
+	for (int i = 0; i < vertexCount && in.good(); ++i)
+	{
+		int influences = in.read_count();
+		vertices.bones.push_back(influences);
+		for (int j = 0; j < influences && in.good(); ++j)
+		{
+			vertices.bones.push_back(in.read_index(boneCount, "vertex bone out of range"));
+			in.read_floats(vertices.values, 3);
+		}
+	}
+}
+
+static void read_attachment(SpineBinaryInput &in, const SpineSkeletonData &model, SpineAttachmentData &a)
+{
+	a = SpineAttachmentData();
+	a.key = in.read_string();
+	a.name = in.read_string();
+	a.path = a.skin = a.parent = -1;
+	a.type = in.read_byte();
+	int boneCount = (int)model.bones.size();
+	switch (a.type)
+	{
+	case ATTACHMENT_REGION:
+		a.path = in.read_string();
+		a.rotation = in.read_float();
+		a.x = in.read_float();
+		a.y = in.read_float();
+		a.scaleX = in.read_float();
+		a.scaleY = in.read_float();
+		a.width = in.read_float();
+		a.height = in.read_float();
+		in.read_color(a.color);
+		break;
+	case ATTACHMENT_BOUNDING_BOX:
+		a.vertexCount = in.read_count();
+		read_vertices(in, a.vertices, a.vertexCount, boneCount);
+		break;
+	case ATTACHMENT_MESH:
+	{
+		a.path = in.read_string();
+		in.read_color(a.color);
+		a.vertexCount = in.read_count();
+		in.read_floats(a.uvs, a.vertexCount << 1);
+		int triangles = in.read_count();
+		for (int i = 0; i < triangles && in.good(); ++i)
+		{
+			unsigned short hi = in.read_byte();
+			a.triangles.push_back((unsigned short)(hi << 8 | in.read_byte()));
+		}
+		read_vertices(in, a.vertices, a.vertexCount, boneCount);
+		a.hull = in.read_varint(true);
+		break;
+	}
+	case ATTACHMENT_LINKED_MESH:
+		a.path = in.read_string();
+		in.read_color(a.color);
+		a.skin = in.read_string();
+		a.parent = in.read_string();
+		a.deform = in.read_boolean();
+		break;
+	case ATTACHMENT_PATH:
+		a.closed = in.read_boolean();
+		a.constantSpeed = in.read_boolean();
+		a.vertexCount = in.read_count();
+		read_vertices(in, a.vertices, a.vertexCount, boneCount);
+		in.read_floats(a.lengths, a.vertexCount / 3);
+		break;
+	case ATTACHMENT_POINT:
+		a.x = in.read_float();
+		a.y = in.read_float();
+		a.rotation = in.read_float();
+		break;
+	case ATTACHMENT_CLIPPING:
+		a.endSlot = in.read_index((int)model.slots.size(), "clipping end slot out of range");
+		a.vertexCount = in.read_count();
+		read_vertices(in, a.vertices, a.vertexCount, boneCount);
+		break;
+	default:
+		in.fail("unknown attachment type");
+		break;
+	}
+}
+
+static void read_skin(SpineBinaryInput &in, SpineSkeletonData &model, int name)
+{
+	SpineSkinData skin;
+	skin.name = name;
+	int slots = in.read_count();
+	for (int i = 0; i < slots && in.good(); ++i)
+	{
+		SpineSkinSlotData slot;
+		slot.slot = in.read_index((int)model.slots.size(), "skin slot out of range");
+		int attachments = in.read_count();
+		slot.attachments.resize(attachments);
+		for (int j = 0; j < attachments && in.good(); ++j)
+			read_attachment(in, model, slot.attachments[j]);
+		skin.slots.push_back(std::move(slot));
+	}
+	model.skins.push_back(std::move(skin));
+}
+
+static void read_animation(SpineBinaryInput &in, const SpineSkeletonData &model, SpineAnimationData &animation)
+{
+	int slotCount = (int)model.slots.size(), boneCount = (int)model.bones.size();
+	vector<SpineTimelineData> &timelines = animation.timelines;
+
+	/* Slot timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		int slot = in.read_index(slotCount, "timeline slot out of range");
+		for (int t = in.read_count(); t > 0 && in.good(); --t)
+		{
+			int type = in.read_byte();
+			if (type == 0)
+			{
+				SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_ATTACHMENT, slot);
+				timeline.frameCount = in.read_count();
+				for (int frame = 0; frame < timeline.frameCount && in.good(); ++frame)
+				{
+					timeline.frames.push_back(in.read_float());
+					timeline.ints.push_back(in.read_string());
+				}
+				timelines.push_back(std::move(timeline));
+			}
+			else if (type == 1 || type == 2)
+			{
+				SpineTimelineData timeline = new_timeline(type == 1 ? SPINE_TIMELINE_COLOR : SPINE_TIMELINE_TWO_COLOR, slot);
+				timeline.frameCount = in.read_count();
+				for (int frame = 0; frame < timeline.frameCount && in.good(); ++frame)
+				{
+					timeline.frames.push_back(in.read_float());
+					in.read_color(timeline.frames);
+					if (type == 2)
+						in.read_color(timeline.frames);
+					if (frame < timeline.frameCount - 1)
+						read_curve(in, timeline);
+				}
+				timelines.push_back(std::move(timeline));
+			}
+			else
+				in.fail("unknown slot timeline");
+		}
+	}
+
+	/* Bone timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		int bone = in.read_index(boneCount, "timeline bone out of range");
+		for (int t = in.read_count(); t > 0 && in.good(); --t)
+		{
+			int type = in.read_byte();
+			if (type > 3)
+			{
+				in.fail("unknown bone timeline");
+				break;
+			}
+			SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_ROTATE + type, bone);
+			read_curve_frames(in, timeline, type == 0 ? 2 : 3);
+			timelines.push_back(std::move(timeline));
+		}
+	}
+
+	/* IK constraint timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_IK,
+			in.read_index((int)model.ik.size(), "ik timeline out of range"));
+		timeline.frameCount = in.read_count();
+		for (int frame = 0; frame < timeline.frameCount && in.good(); ++frame)
+		{
+			in.read_floats(timeline.frames, 2);
+			timeline.ints.push_back((signed char)in.read_byte());
+			if (frame < timeline.frameCount - 1)
+				read_curve(in, timeline);
+		}
+		timelines.push_back(std::move(timeline));
+	}
+
+	/* Transform constraint timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_TRANSFORM,
+			in.read_index((int)model.transform.size(), "transform timeline out of range"));
+		read_curve_frames(in, timeline, 5);
+		timelines.push_back(std::move(timeline));
+	}
+
+	/* Path constraint timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		int path = in.read_index((int)model.paths.size(), "path timeline out of range");
+		for (int t = in.read_count(); t > 0 && in.good(); --t)
+		{
+			int type = in.read_byte();
+			if (type > 2)
+			{
+				in.fail("unknown path timeline");
+				break;
+			}
+			SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_PATH_POSITION + type, path);
+			read_curve_frames(in, timeline, type == 2 ? 3 : 2);
+			timelines.push_back(std::move(timeline));
+		}
+	}
+
+	/* Deform timelines. */
+	for (int n = in.read_count(); n > 0 && in.good(); --n)
+	{
+		int skin = in.read_index((int)model.skins.size(), "deform skin out of range");
+		for (int s = in.read_count(); s > 0 && in.good(); --s)
+		{
+			int slot = in.read_index(slotCount, "deform slot out of range");
+			for (int t = in.read_count(); t > 0 && in.good(); --t)
+			{
+				SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_DEFORM, slot);
+				timeline.skin = skin;
+				timeline.attachment = in.read_string();
+				timeline.frameCount = in.read_count();
+				for (int frame = 0; frame < timeline.frameCount && in.good(); ++frame)
+				{
+					timeline.frames.push_back(in.read_float());
+					int count = in.read_varint(true);
+					int offset = count ? in.read_varint(true) : 0;
+					timeline.ints.push_back(offset);
+					timeline.ints.push_back(count);
+					in.read_floats(timeline.deform, count);
+					if (frame < timeline.frameCount - 1)
+						read_curve(in, timeline);
+				}
+				timelines.push_back(std::move(timeline));
+			}
+		}
+	}
+
+	/* Draw order timeline. */
+	int drawOrders = in.read_count();
+	if (drawOrders > 0)
+	{
+		SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_DRAW_ORDER, 0);
+		timeline.frameCount = drawOrders;
+		for (int frame = 0; frame < drawOrders && in.good(); ++frame)
+		{
+			timeline.frames.push_back(in.read_float());
+			int offsets = in.read_count();
+			timeline.ints.push_back(offsets);
+			for (int i = 0; i < offsets && in.good(); ++i)
+			{
+				timeline.ints.push_back(in.read_index(slotCount, "draw order slot out of range"));
+				timeline.ints.push_back(in.read_varint(true));
+			}
+		}
+		timelines.push_back(std::move(timeline));
+	}
+
+	/* Event timeline. */
+	int events = in.read_count();
+	if (events > 0)
+	{
+		SpineTimelineData timeline = new_timeline(SPINE_TIMELINE_EVENT, 0);
+		timeline.frameCount = events;
+		for (int frame = 0; frame < events && in.good(); ++frame)
+		{
+			timeline.frames.push_back(in.read_float());
+			timeline.ints.push_back(in.read_index((int)model.events.size(), "event out of range"));
+			timeline.ints.push_back(in.read_varint(false));
+			timeline.frames.push_back(in.read_float());
+			timeline.ints.push_back(in.read_boolean() ? in.read_string() : -1);
+		}
+		timelines.push_back(std::move(timeline));
+	}
+}
+
+static void read_bones(SpineBinaryInput &in, vector<int> &bones, int boneCount)
+{
+	int n = in.read_count();
+	for (int i = 0; i < n && in.good(); ++i)
+		bones.push_back(in.read_index(boneCount, "constraint bone out of range"));
+}
+
+static void read_skeleton(SpineBinaryInput &in, SpineSkeletonData &model)
+{
+	model.hash = in.read_string();
+	model.version = in.read_string();
+	model.width = in.read_float();
+	model.height = in.read_float();
+	if (in.read_boolean())
+		in.fail("nonessential data isn't written by the exporter");
+
+	int bones = in.read_count();
+	model.bones.resize(bones);
+	for (int i = 0; i < bones && in.good(); ++i)
+	{
+		SpineBoneData &bone = model.bones[i];
+		bone.name = in.read_string();
+		bone.parent = i > 0 ? in.read_index(i, "bone parent out of order") : -1;
+		bone.rotation = in.read_float();
+		bone.x = in.read_float();
+		bone.y = in.read_float();
+		bone.scaleX = in.read_float();
+		bone.scaleY = in.read_float();
+		bone.shearX = in.read_float();
+		bone.shearY = in.read_float();
+		bone.length = in.read_float();
+		bone.mode = in.read_varint(true);
+	}
+
+	int slots = in.read_count();
+	model.slots.resize(slots);
+	for (int i = 0; i < slots && in.good(); ++i)
+	{
+		SpineSlotData &slot = model.slots[i];
+		slot.name = in.read_string();
+		slot.bone = in.read_index(bones, "slot bone out of range");
+		in.read_color(slot.color);
+		in.read_color(slot.dark);
+		slot.attachment = in.read_string();
+		slot.blend = in.read_varint(true);
+	}
+
+	int n = in.read_count();
+	model.ik.resize(n);
+	for (int i = 0; i < n && in.good(); ++i)
+	{
+		SpineIkData &ik = model.ik[i];
+		ik.name = in.read_string();
+		ik.order = in.read_varint(true);
+		read_bones(in, ik.bones, bones);
+		ik.target = in.read_index(bones, "ik target out of range");
+		ik.mix = in.read_float();
+		ik.bendDirection = (signed char)in.read_byte();
+	}
+
+	n = in.read_count();
+	model.transform.resize(n);
+	for (int i = 0; i < n && in.good(); ++i)
+	{
+		SpineTransformData &transform = model.transform[i];
+		transform.name = in.read_string();
+		transform.order = in.read_varint(true);
+		read_bones(in, transform.bones, bones);
+		transform.target = in.read_index(bones, "transform target out of range");
+		transform.local = in.read_boolean();
+		transform.relative = in.read_boolean();
+		transform.rotation = in.read_float();
+		transform.x = in.read_float();
+		transform.y = in.read_float();
+		transform.scaleX = in.read_float();
+		transform.scaleY = in.read_float();
+		transform.shearY = in.read_float();
+		transform.rotateMix = in.read_float();
+		transform.translateMix = in.read_float();
+		transform.scaleMix = in.read_float();
+		transform.shearMix = in.read_float();
+	}
+
+	n = in.read_count();
+	model.paths.resize(n);
+	for (int i = 0; i < n && in.good(); ++i)
+	{
+		SpinePathData &path = model.paths[i];
+		path.name = in.read_string();
+		path.order = in.read_varint(true);
+		read_bones(in, path.bones, bones);
+		path.target = in.read_index(slots, "path target out of range");
+		path.positionMode = in.read_varint(true);
+		path.spacingMode = in.read_varint(true);
+		path.rotateMode = in.read_varint(true);
+		path.rotation = in.read_float();
+		path.position = in.read_float();
+		path.spacing = in.read_float();
+		path.rotateMix = in.read_float();
+		path.translateMix = in.read_float();
+	}
+
+	read_skin(in, model, -1);
+	n = in.read_count();
+	for (int i = 0; i < n && in.good(); ++i)
+		read_skin(in, model, in.read_string());
+
+	n = in.read_count();
+	model.events.resize(n);
+	for (int i = 0; i < n && in.good(); ++i)
+	{
+		SpineEventData &event = model.events[i];
+		event.name = in.read_string();
+		event.intValue = in.read_varint(false);
+		event.floatValue = in.read_float();
+		event.stringValue = in.read_string();
+	}
+
+	n = in.read_count();
+	model.animations.resize(n);
+	for (int i = 0; i < n && in.good(); ++i)
+	{
+		model.animations[i].name = in.read_string();
+		read_animation(in, model, model.animations[i]);
+	}
+}
+
+bool read_spine_binary(const unsigned char *data, size_t size, SpineSkeletonData &out, string *error)
+{
+	out = SpineSkeletonData();
+	out.stringTable = size > 0 && data[0] == STRING_TABLE_MARKER;
+	SpineBinaryInput in(data, size, out);
+	if (out.stringTable)
+	{
+		in.read_byte();
+		in.read_string_table();
+	}
+	read_skeleton(in, out);
+	if (in.good() && !in.at_end())
+		in.fail("bytes after the animations");
+	if (!in.good() && error)
+		*error = string(in.error()) + " at byte " + to_string(in.position());
+	return in.good();
+}
@@ -0,0 +1,221 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_READER_H__
+#define __SPINE_READER_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "SpineExporter.h" // SpineTimelineType
+
+// A reference reader for the binary the converter writes, plain or in string table mode. It decodes every field into
+// the model below, so tools can check an output and see what a runtime loader has to do.
+//
+// Strings are ids into SpineSkeletonData::strings, -1 for null. Both modes give the same model: a plain file's strings
+// are numbered as they are first read, which is the order of the string table.
+
+struct SpineBoneData
+{
+	int name;
+	int parent; // -1 for the root
+	float rotation, x, y, scaleX, scaleY, shearX, shearY, length;
+	int mode;
+
+	bool operator==(const SpineBoneData &o) const;
+};
+
+struct SpineSlotData
+{
+	int name;
+	int bone;
+	unsigned char color[4], dark[4];
+	int attachment;
+	int blend;
+
+	bool operator==(const SpineSlotData &o) const;
+};
+
+struct SpineIkData
+{
+	int name;
+	int order;
+	std::vector<int> bones;
+	int target;
+	float mix;
+	int bendDirection;
+
+	bool operator==(const SpineIkData &o) const;
+};
+
+struct SpineTransformData
+{
+	int name;
+	int order;
+	std::vector<int> bones;
+	int target;
+	bool local, relative;
+	float rotation, x, y, scaleX, scaleY, shearY;
+	float rotateMix, translateMix, scaleMix, shearMix;
+
+	bool operator==(const SpineTransformData &o) const;
+};
+
+struct SpinePathData
+{
+	int name;
+	int order;
+	std::vector<int> bones;
+	int target; // a slot
+	int positionMode, spacingMode, rotateMode;
+	float rotation, position, spacing, rotateMix, translateMix;
+
+	bool operator==(const SpinePathData &o) const;
+};
+
+// Vertices as the format has them. Unweighted: x, y pairs in values. Weighted: per vertex a count in bones, then
+// that many bone indices, with x, y, weight in values for each.
+struct SpineVerticesData
+{
+	bool weighted;
+	std::vector<int> bones;
+	std::vector<float> values;
+
+	bool operator==(const SpineVerticesData &o) const;
+};
+
+// Fields a type doesn't write stay 0.
+struct SpineAttachmentData
+{
+	int key; // the name in the skin
+	int name;
+	int type; // ATTACHMENT_* of the exporter
+	int path;
+	float rotation, x, y, scaleX, scaleY, width, height; // region, point has x, y, rotation
+	unsigned char color[4];
+	int vertexCount; // bounding box, path, clipping; the uv count of a mesh
+	std::vector<float> uvs;
+	std::vector<unsigned short> triangles;
+	SpineVerticesData vertices;
+	int hull;
+	int skin, parent; // linked mesh
+	bool deform;
+	bool closed, constantSpeed;
+	std::vector<float> lengths;
+	int endSlot;
+
+	bool operator==(const SpineAttachmentData &o) const;
+};
+
+struct SpineSkinSlotData
+{
+	int slot;
+	std::vector<SpineAttachmentData> attachments;
+
+	bool operator==(const SpineSkinSlotData &o) const;
+};
+
+struct SpineSkinData
+{
+	int name; // -1 for the default skin
+	std::vector<SpineSkinSlotData> slots;
+
+	bool operator==(const SpineSkinData &o) const;
+};
+
+struct SpineEventData
+{
+	int name;
+	int intValue;
+	float floatValue;
+	int stringValue;
+
+	bool operator==(const SpineEventData &o) const;
+};
+
+struct SpineCurveData
+{
+	int type; // CURVE_* of the exporter
+	float values[4]; // bezier only
+
+	bool operator==(const SpineCurveData &o) const;
+};
+
+// Keys are laid out like the runtime's frames. frames holds stride floats per key, the time then:
+//   color r g b a, two color r g b a and dark r g b a, all 0..1; rotate the angle; translate, scale, shear x y;
+//   ik the mix; transform the four mixes; path position or spacing the value; path mix rotate and translate.
+// The rest have only the time, plus in ints per key:
+//   attachment the name; ik the bend direction; deform the offset and the count of its values in deform;
+//   draw order the count of changed slots then slot, offset pairs; event the event, int value, string or -1, with
+//   its float value as the frame's second float.
+// curves has one entry per key but the last for the timelines that have curves.
+struct SpineTimelineData
+{
+	int type; // SpineTimelineType
+	int index; // the slot, bone or constraint, 0 for draw order and event
+	int skin; // deform only
+	int attachment; // deform only
+	int frameCount;
+	std::vector<float> frames;
+	std::vector<SpineCurveData> curves;
+	std::vector<int> ints;
+	std::vector<float> deform;
+
+	bool operator==(const SpineTimelineData &o) const;
+};
+
+struct SpineAnimationData
+{
+	int name;
+	std::vector<SpineTimelineData> timelines;
+
+	bool operator==(const SpineAnimationData &o) const;
+};
+
+struct SpineSkeletonData
+{
+	std::vector<std::string> strings;
+	bool stringTable; // read from a string table output
+	size_t stringReads; // non-null strings in the file, each one a copy for a loader without the table
+	int hash, version;
+	float width, height;
+	std::vector<SpineBoneData> bones;
+	std::vector<SpineSlotData> slots;
+	std::vector<SpineIkData> ik;
+	std::vector<SpineTransformData> transform;
+	std::vector<SpinePathData> paths;
+	std::vector<SpineSkinData> skins; // the default skin first
+	std::vector<SpineEventData> events;
+	std::vector<SpineAnimationData> animations;
+
+	// The string of an id, "" for null.
+	const char *str(int id) const { return id < 0 ? "" : strings[id].c_str(); }
+
+	// Same content, whichever mode each was read from. stringTable and stringReads aren't compared.
+	bool operator==(const SpineSkeletonData &o) const;
+};
+
+// Reads a whole output. Returns false when it is malformed: cut short, an index out of range, an unknown type or bytes
+// left over at the end. error then tells where.
+bool read_spine_binary(const unsigned char *data, size_t size, SpineSkeletonData &out, std::string *error = 0);
+
+#endif
@@ -0,0 +1,192 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_WRITER_H__
+#define __SPINE_WRITER_H__
+
+// Encoders of the binary's primitives: big endian floats and shorts, and varints. The converter writes through them,
+// tools/writer_bench.cpp measures them on their own.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SPINE_WRITER_SIMD
+// Define this to 0 to byte swap float arrays one at a time.
+#define SPINE_WRITER_SIMD 1
+#endif
+
+#if SPINE_WRITER_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define SPINE_WRITER_SIMD_WIDTH 32
+#elif SPINE_WRITER_SIMD && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define SPINE_WRITER_SIMD_WIDTH 16
+#elif SPINE_WRITER_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SPINE_WRITER_SIMD_WIDTH 16
+#define SPINE_WRITER_NO_SHUFFLE 1 // SSE2 has no byte shuffle, swap with shifts instead
+#else
+#define SPINE_WRITER_SIMD_WIDTH 0
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86) || \
+	defined(_M_ARM64)
+#define SPINE_WRITER_LITTLE_ENDIAN 1
+#else
+#define SPINE_WRITER_LITTLE_ENDIAN 0
+#undef SPINE_WRITER_SIMD_WIDTH
+#define SPINE_WRITER_SIMD_WIDTH 0
+#endif
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#define spine_bswap32(v) _byteswap_ulong(v)
+#else
+#define spine_bswap32(v) __builtin_bswap32(v)
+#endif
+
+// big endian
+static inline void encode_float(unsigned char *out, float v)
+{
+	uint32_t u;
+	memcpy(&u, &v, 4);
+#if SPINE_WRITER_LITTLE_ENDIAN
+	u = spine_bswap32(u);
+#endif
+	memcpy(out, &u, 4);
+}
+
+// n floats, big endian, 4 * n bytes
+static inline void encode_floats(unsigned char *out, const float *v, size_t n)
+{
+	size_t i = 0;
+#if SPINE_WRITER_SIMD_WIDTH == 32
+	const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i *)(v + i));
+		_mm256_storeu_si256((__m256i *)(out + 4 * i), _mm256_shuffle_epi8(x, swap));
+	}
+#elif SPINE_WRITER_SIMD_WIDTH == 16 && !defined(SPINE_WRITER_NO_SHUFFLE)
+	const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+		_mm_storeu_si128((__m128i *)(out + 4 * i), _mm_shuffle_epi8(x, swap));
+	}
+#elif SPINE_WRITER_SIMD_WIDTH == 16
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+		// swap the bytes of each short, then the shorts of each word
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+		_mm_storeu_si128((__m128i *)(out + 4 * i), x);
+	}
+#endif
+	for (; i < n; ++i)
+		encode_float(out + 4 * i, v[i]);
+}
+
+// big endian
+static inline void encode_int(unsigned char *out, int v)
+{
+	uint32_t u = (uint32_t)v;
+#if SPINE_WRITER_LITTLE_ENDIAN
+	u = spine_bswap32(u);
+#endif
+	memcpy(out, &u, 4);
+}
+
+// n values as big endian shorts, 2 * n bytes
+static inline void encode_shorts(unsigned char *out, const int *v, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		unsigned short s = (unsigned short)v[i];
+		out[2 * i] = (unsigned char)(s >> 8);
+		out[2 * i + 1] = (unsigned char)s;
+	}
+}
+
+// The varint's bytes in the low bytes of the word, in output order. Returns how many there are, at most 5.
+static inline int encode_varint_word(uint64_t &word, int value, int optimizePositive)
+{
+	uint32_t v = value;
+	if (!optimizePositive)
+		v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+	// spread the 7 bit groups a byte apart, then flag every byte but the last
+	if (v < 0x80)
+	{
+		word = v;
+		return 1;
+	}
+	uint64_t w = v;
+	w = (w & 0x7F) | ((w & 0x3F80) << 1) | ((w & 0x1FC000) << 2) | ((w & 0xFE00000) << 3) | ((w & 0xF0000000) << 4);
+	int n = v < (1u << 14) ? 2 : v < (1u << 21) ? 3 : v < (1u << 28) ? 4 : 5;
+	word = w | 0x80808080ull >> (8 * (5 - n));
+	return n;
+}
+
+// Returns the number of bytes written, at most 5. The fifth byte has no continuation bit, readers stop after it anyway.
+static inline int encode_varint(unsigned char *out, int value, int optimizePositive)
+{
+#if SPINE_WRITER_LITTLE_ENDIAN
+	uint64_t word;
+	int n = encode_varint_word(word, value, optimizePositive);
+	memcpy(out, &word, n);
+	return n;
+#else
+	unsigned int v = value;
+	if (!optimizePositive)
+		v = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+
+	int n = 0;
+	for (int i = 0; i < 5; ++i)
+	{
+		out[n++] = (v >> i * 7) & 0x7F;
+		if (i < 4 && v >> (i + 1) * 7)
+			out[n - 1] |= 0x80;
+		else
+			break;
+	}
+	return n;
+#endif
+}
+
+// Same, but stores a whole word: out must have room for 8 bytes, the ones after the varint are garbage.
+static inline int encode_varint_wide(unsigned char *out, int value, int optimizePositive)
+{
+#if SPINE_WRITER_LITTLE_ENDIAN
+	uint64_t word;
+	int n = encode_varint_word(word, value, optimizePositive);
+	memcpy(out, &word, 8);
+	return n;
+#else
+	return encode_varint(out, value, optimizePositive);
+#endif
+}
+
+#endif
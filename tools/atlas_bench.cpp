@@ -0,0 +1,167 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Atlas load time, text against binary.
+
+ atlas_bench [-n iterations] [-o dir] file.atlas...
+
+ Converts each atlas, reads the binary back with the reference reader and checks it gives what the text parser gives.
+ Then times a load both ways, and a lookup of every region by name as a loader resolving attachments does: a scan of
+ the regions like the runtimes' findRegion for the text, the name index for the binary. -o writes each binary to dir
+ as name.atlas.bin.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. atlas_bench.cpp ../SpineAtlas.cpp ../SpineExporter.cpp Json.o -o atlas_bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpineAtlas.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Finds every region, returns how many were found so the work isn't optimized away.
+static size_t look_up_all(const SpineAtlasData &atlas)
+{
+	size_t found = 0;
+	for (const SpineAtlasRegion &region : atlas.regions)
+		found += atlas.find(region.name.c_str()) != -1;
+	return found;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 200;
+	const char *outDir = 0;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-n") == 0)
+			iterations = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-o") == 0)
+			outDir = argv[i + 1];
+		else
+			break;
+	}
+	if (i >= argc || iterations <= 0)
+	{
+		fprintf(stderr, "usage: atlas_bench [-n iterations] [-o dir] file.atlas...\n");
+		return 1;
+	}
+
+	int failures = 0;
+	printf("%-32s %7s %9s %9s %11s %11s %7s %11s %11s\n", "file", "regions", "text", "binary", "text load",
+		"binary load", "faster", "scan", "index");
+	for (; i < argc; ++i)
+	{
+		string text;
+		if (!read_file(argv[i], text))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+
+		SpineAtlasData parsed, read;
+		string error;
+		vector<unsigned char> binary;
+		SpineVectorSink sink(binary);
+		if (!parse_spine_atlas(text.c_str(), text.size(), parsed, &error) ||
+			convert_atlas_to_binary(text.c_str(), text.size(), sink) != (int)binary.size())
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.empty() ? "conversion failed" : error.c_str());
+			++failures;
+			continue;
+		}
+		if (!read_spine_atlas_binary(binary.data(), binary.size(), read, &error))
+		{
+			fprintf(stderr, "%s: unreadable output, %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		if (!(parsed == read))
+		{
+			fprintf(stderr, "%s: the binary reads back differently\n", argv[i]);
+			++failures;
+			continue;
+		}
+		if (outDir)
+		{
+			string name = argv[i];
+			name = name.substr(name.find_last_of("/\\") + 1);
+			string path = string(outDir) + "/" + name + ".bin";
+			FILE *f = fopen(path.c_str(), "wb");
+			if (!f || fwrite(binary.data(), 1, binary.size(), f) != binary.size())
+			{
+				fprintf(stderr, "%s: can't write\n", path.c_str());
+				++failures;
+			}
+			if (f)
+				fclose(f);
+		}
+
+		auto start = chrono::steady_clock::now();
+		for (int it = 0; it < iterations; ++it)
+		{
+			SpineAtlasData atlas;
+			parse_spine_atlas(text.c_str(), text.size(), atlas);
+		}
+		double textTime = seconds_since(start) / iterations;
+		start = chrono::steady_clock::now();
+		for (int it = 0; it < iterations; ++it)
+		{
+			SpineAtlasData atlas;
+			read_spine_atlas_binary(binary.data(), binary.size(), atlas);
+		}
+		double binaryTime = seconds_since(start) / iterations;
+
+		size_t found = look_up_all(parsed) + look_up_all(read);
+		start = chrono::steady_clock::now();
+		found += look_up_all(parsed);
+		double scanTime = seconds_since(start);
+		start = chrono::steady_clock::now();
+		for (int it = 0; it < iterations; ++it)
+			found += look_up_all(read);
+		double indexTime = seconds_since(start) / iterations;
+		if (found != (3 + (size_t)iterations) * parsed.regions.size())
+		{
+			fprintf(stderr, "%s: a lookup failed\n", argv[i]);
+			++failures;
+			continue;
+		}
+
+		printf("%-32s %7zu %9zu %9zu %9.1fus %9.1fus %6.1fx %9.1fus %9.1fus\n", argv[i], parsed.regions.size(),
+			text.size(), binary.size(), textTime * 1e6, binaryTime * 1e6, textTime / binaryTime, scanTime * 1e6,
+			indexTime * 1e6);
+	}
+	return failures ? 1 : 0;
+}
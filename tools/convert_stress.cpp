@@ -0,0 +1,175 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Runs conversions on many threads at once and checks every output against a serial run.
+
+ convert_stress [-t threads] [-n rounds] file.json...
+
+ x.atlas next to x.json is used as its atlas. Each round converts every file with both engines, to a buffer and to a
+ vector, plus a truncated copy that must fail the same way. Exits with 1 on any difference.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. convert_stress.cpp ../SpineExporter.cpp Json.o -o convert_stress
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpineExporter.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+struct Input
+{
+	string path;
+	string json;
+	string atlas;
+	bool hasAtlas;
+	vector<unsigned char> expected;
+	int expectedRt;
+	int truncatedRt;
+};
+
+enum Variant
+{
+	DOM_BUFFER,
+	DOM_VECTOR,
+	STREAM_BUFFER,
+	STREAM_VECTOR,
+	TRUNCATED,
+	VARIANT_COUNT
+};
+
+// Runs one job with the converter of the calling thread, true when it matches the serial run.
+static bool run_job(SpineConverter &converter, const Input &input, int variant)
+{
+	const string &json = input.json;
+	converter.set_atlas(input.hasAtlas ? input.atlas.c_str() : 0);
+
+	if (variant == TRUNCATED)
+	{
+		string cut = json.substr(0, json.size() / 2);
+		vector<unsigned char> out;
+		SpineVectorSink sink(out);
+		return converter.convert(cut.c_str(), cut.size(), sink) == input.truncatedRt;
+	}
+
+	vector<unsigned char> out;
+	int rt;
+	if (variant == DOM_BUFFER || variant == STREAM_BUFFER)
+	{
+		out.resize(input.expected.size());
+		if (variant == DOM_BUFFER)
+			rt = converter.convert(json.c_str(), json.size(), out.data());
+		else
+			rt = converter.convert_stream(json.c_str(), json.size(), out.data());
+	}
+	else
+	{
+		SpineVectorSink sink(out);
+		if (variant == DOM_VECTOR)
+			rt = converter.convert(json.c_str(), json.size(), sink);
+		else
+			rt = converter.convert_stream(json.c_str(), json.size(), sink);
+	}
+	if (rt != input.expectedRt)
+		return false;
+	return rt < 0 || out == input.expected;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = (int)thread::hardware_concurrency();
+	int rounds = 20;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-t") == 0)
+			threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-n") == 0)
+			rounds = atoi(argv[i + 1]);
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: convert_stress [-t threads] [-n rounds] file.json...\n");
+		return 1;
+	}
+	if (threads < 2)
+		threads = 2;
+
+	// the serial reference
+	vector<Input> inputs;
+	for (; i < argc; ++i)
+	{
+		Input input;
+		input.path = argv[i];
+		if (!read_file(input.path, input.json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			continue;
+		}
+		string atlasPath = input.path.substr(0, input.path.rfind('.')) + ".atlas";
+		input.hasAtlas = read_file(atlasPath, input.atlas);
+		const char *atlas = input.hasAtlas ? input.atlas.c_str() : 0;
+
+		SpineVectorSink sink(input.expected);
+		input.expectedRt = convert_json_to_binary(input.json.c_str(), input.json.size(), sink, atlas);
+		string cut = input.json.substr(0, input.json.size() / 2);
+		input.truncatedRt = convert_json_to_binary_size(cut.c_str(), cut.size(), atlas);
+		inputs.push_back(input);
+	}
+	if (inputs.empty())
+		return 1;
+
+	// the jobs of all rounds, taken in turn by the threads so neighbouring jobs overlap on different threads
+	size_t jobCount = (size_t)rounds * inputs.size() * VARIANT_COUNT;
+	atomic<size_t> next(0);
+	atomic<int> failures(0);
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.push_back(thread([&]()
+		{
+			SpineConverter converter;
+			for (size_t job; (job = next++) < jobCount;)
+			{
+				const Input &input = inputs[job / VARIANT_COUNT % inputs.size()];
+				int variant = (int)(job % VARIANT_COUNT);
+				if (!run_job(converter, input, variant))
+				{
+					fprintf(stderr, "%s: variant %d differs from the serial run\n", input.path.c_str(), variant);
+					++failures;
+				}
+			}
+		}));
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	printf("%zu conversions on %d threads, %d differ\n", jobCount, threads, failures.load());
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,422 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks the keyframe decimation against the output without it.
+
+ decimate_check [-rotation deg] [-translation units] [-scale s] [-shear deg] [-color c] [-mix m] file.json...
+
+ x.atlas next to x.json is used as its atlas. Both outputs are read back with the reference reader. Everything but
+ the animations must be the same, and so must each animation's duration and its deform, draw order and event
+ timelines. The others are sampled like a runtime samples them, at every key of the output without decimation and
+ halfway between, and must stay within the tolerances, the setup pose standing in for a timeline that was dropped.
+ Prints the keys and bytes saved, and the bytes the stats counted, which must be the difference of the sizes. Exits
+ with 1 on any mismatch.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. decimate_check.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o -o decimate_check
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+// Floats per key of a timeline that has values, the time included, 0 for the others.
+static int stride_of(int type)
+{
+	switch (type)
+	{
+	case SPINE_TIMELINE_COLOR: return 5;
+	case SPINE_TIMELINE_TWO_COLOR: return 9;
+	case SPINE_TIMELINE_ROTATE: return 2;
+	case SPINE_TIMELINE_TRANSLATE: case SPINE_TIMELINE_SCALE: case SPINE_TIMELINE_SHEAR: return 3;
+	case SPINE_TIMELINE_IK: return 2;
+	case SPINE_TIMELINE_TRANSFORM: return 5;
+	case SPINE_TIMELINE_PATH_POSITION: case SPINE_TIMELINE_PATH_SPACING: return 2;
+	case SPINE_TIMELINE_PATH_MIX: return 3;
+	default: return 0;
+	}
+}
+
+// The runtime's bezier: the curve sampled at ten points and interpolated between.
+static float curve_percent(const SpineCurveData &curve, float percent)
+{
+	if (curve.type == 1)
+		return 0;
+	if (curve.type != 2)
+		return percent;
+	float cx1 = curve.values[0], cy1 = curve.values[1], cx2 = curve.values[2], cy2 = curve.values[3];
+	float tmpx = (-cx1 * 2 + cx2) * 0.03f, tmpy = (-cy1 * 2 + cy2) * 0.03f;
+	float dddfx = ((cx1 - cx2) * 3 + 1) * 0.006f, dddfy = ((cy1 - cy2) * 3 + 1) * 0.006f;
+	float ddfx = tmpx * 2 + dddfx, ddfy = tmpy * 2 + dddfy;
+	float dfx = cx1 * 0.3f + tmpx + dddfx * 0.16666667f, dfy = cy1 * 0.3f + tmpy + dddfy * 0.16666667f;
+	float x = dfx, y = dfy, prevX = 0, prevY = 0;
+	for (int i = 0; i < 9; ++i)
+	{
+		if (x >= percent)
+			return prevY + (y - prevY) * (percent - prevX) / (x - prevX);
+		prevX = x;
+		prevY = y;
+		dfx += ddfx;
+		dfy += ddfy;
+		ddfx += dddfx;
+		ddfy += dddfy;
+		x += dfx;
+		y += dfy;
+	}
+	return prevY + (1 - prevY) * (percent - prevX) / (1 - prevX);
+}
+
+static float wrap_angle(float angle)
+{
+	return angle - 360 * floorf(angle / 360 + 0.5f);
+}
+
+// A timeline's values at time, or setup before its first key. ints gets the attachment name or the bend direction.
+static void sample(const SpineTimelineData *timeline, float time, const float *setup, int setupInt, float *values,
+	int &valueInt)
+{
+	int type = timeline->type, stride = stride_of(type), channels = stride ? stride - 1 : 0;
+	int frameStride = stride ? stride : 1;
+	const vector<float> &frames = timeline->frames;
+	if (!timeline->frameCount || time < frames[0])
+	{
+		copy(setup, setup + channels, values);
+		valueInt = setupInt;
+		return;
+	}
+	int frame = 0;
+	while (frame + 1 < timeline->frameCount && frames[(frame + 1) * frameStride] <= time)
+		++frame;
+	valueInt = timeline->ints.empty() ? 0 : timeline->ints[frame];
+	if (!channels)
+		return;
+	const float *from = &frames[frame * frameStride + 1];
+	if (frame + 1 == timeline->frameCount)
+	{
+		copy(from, from + channels, values);
+		return;
+	}
+	const float *to = from + stride;
+	float t0 = frames[frame * frameStride], t1 = frames[(frame + 1) * frameStride];
+	float percent = curve_percent(timeline->curves[frame], (time - t0) / (t1 - t0));
+	for (int c = 0; c < channels; ++c)
+	{
+		float delta = to[c] - from[c];
+		if (type == SPINE_TIMELINE_ROTATE)
+			delta = wrap_angle(delta);
+		values[c] = from[c] + delta * percent;
+	}
+}
+
+struct Tolerances
+{
+	SpineDecimation decimation;
+	float epsilon = 1e-4f; // float error
+};
+
+// The setup pose of a timeline and the tolerance of each channel.
+static void setup_of(const SpineSkeletonData &skeleton, const SpineTimelineData &timeline,
+	const SpineDecimation &tolerances, float *setup, int &setupInt, float *tolerance)
+{
+	setupInt = 0;
+	fill(setup, setup + 8, 0.0f);
+	fill(tolerance, tolerance + 8, tolerances.mix);
+	switch (timeline.type)
+	{
+	case SPINE_TIMELINE_ATTACHMENT:
+		setupInt = skeleton.slots[timeline.index].attachment;
+		break;
+	case SPINE_TIMELINE_COLOR:
+	case SPINE_TIMELINE_TWO_COLOR:
+		for (int c = 0; c < 4; ++c)
+		{
+			setup[c] = skeleton.slots[timeline.index].color[c] / 255.0f;
+			setup[4 + c] = skeleton.slots[timeline.index].dark[c] / 255.0f;
+		}
+		fill(tolerance, tolerance + 8, tolerances.color);
+		break;
+	case SPINE_TIMELINE_ROTATE:
+		tolerance[0] = tolerances.rotation;
+		break;
+	case SPINE_TIMELINE_TRANSLATE:
+		tolerance[0] = tolerance[1] = tolerances.translation;
+		break;
+	case SPINE_TIMELINE_SCALE:
+		setup[0] = setup[1] = 1;
+		tolerance[0] = tolerance[1] = tolerances.scale;
+		break;
+	case SPINE_TIMELINE_SHEAR:
+		tolerance[0] = tolerance[1] = tolerances.shear;
+		break;
+	case SPINE_TIMELINE_IK:
+		setup[0] = skeleton.ik[timeline.index].mix;
+		setupInt = skeleton.ik[timeline.index].bendDirection;
+		break;
+	case SPINE_TIMELINE_TRANSFORM:
+	{
+		const SpineTransformData &transform = skeleton.transform[timeline.index];
+		setup[0] = transform.rotateMix;
+		setup[1] = transform.translateMix;
+		setup[2] = transform.scaleMix;
+		setup[3] = transform.shearMix;
+		break;
+	}
+	case SPINE_TIMELINE_PATH_POSITION:
+		setup[0] = skeleton.paths[timeline.index].position;
+		if (skeleton.paths[timeline.index].positionMode == 0) // fixed
+			tolerance[0] = tolerances.translation;
+		break;
+	case SPINE_TIMELINE_PATH_SPACING:
+		setup[0] = skeleton.paths[timeline.index].spacing;
+		if (skeleton.paths[timeline.index].spacingMode != 2) // length or fixed
+			tolerance[0] = tolerances.translation;
+		break;
+	case SPINE_TIMELINE_PATH_MIX:
+		setup[0] = skeleton.paths[timeline.index].rotateMix;
+		setup[1] = skeleton.paths[timeline.index].translateMix;
+		break;
+	}
+}
+
+static float duration_of(const SpineAnimationData &animation)
+{
+	float duration = 0;
+	for (const SpineTimelineData &timeline : animation.timelines)
+	{
+		if (!timeline.frameCount)
+			continue;
+		int stride = stride_of(timeline.type);
+		duration = max(duration, timeline.frames[(timeline.frameCount - 1) * (stride ? stride : 1)]);
+	}
+	return duration;
+}
+
+// Compares an animation with and without decimation, reports what differs to error. worst is the largest error seen
+// as a share of its tolerance.
+static bool check_animation(const SpineSkeletonData &skeleton, const SpineSkeletonData &decimatedSkeleton,
+	const SpineAnimationData &full, const SpineAnimationData &decimated, const Tolerances &tolerances, double &worst,
+	string &error)
+{
+	const char *name = skeleton.str(full.name);
+	if (duration_of(full) != duration_of(decimated))
+	{
+		error = string(name) + ": duration changed";
+		return false;
+	}
+	typedef tuple<int, int, int, int> Key;
+	map<Key, const SpineTimelineData *> kept;
+	for (const SpineTimelineData &timeline : decimated.timelines)
+		kept[Key(timeline.type, timeline.index, timeline.skin, timeline.attachment)] = &timeline;
+	for (const SpineTimelineData &timeline : full.timelines)
+	{
+		Key key(timeline.type, timeline.index, timeline.skin, timeline.attachment);
+		auto found = kept.find(key);
+		const SpineTimelineData *other = found == kept.end() ? 0 : found->second;
+		int stride = stride_of(timeline.type);
+		if (!stride && timeline.type != SPINE_TIMELINE_ATTACHMENT)
+		{
+			if (!other || !(*other == timeline))
+			{
+				error = string(name) + ": " + spine_timeline_name(timeline.type) + " timeline changed";
+				return false;
+			}
+			continue;
+		}
+		float setup[8], tolerance[8];
+		int setupInt, decimatedSetupInt; // strings are ids into each skeleton's own
+		setup_of(skeleton, timeline, tolerances.decimation, setup, setupInt, tolerance);
+		setup_of(decimatedSkeleton, timeline, tolerances.decimation, setup, decimatedSetupInt, tolerance);
+		SpineTimelineData dropped = timeline;
+		dropped.frameCount = 0; // samples as the setup pose
+		if (!other)
+			other = &dropped;
+
+		int channels = stride ? stride - 1 : 0, frameStride = stride ? stride : 1;
+		for (int frame = 0; frame < timeline.frameCount; ++frame)
+		{
+			float time = timeline.frames[frame * frameStride];
+			float times[2] = { time, time };
+			if (frame + 1 < timeline.frameCount)
+				times[1] = (time + timeline.frames[(frame + 1) * frameStride]) / 2;
+			for (float at : times)
+			{
+				float a[8], b[8];
+				int aInt, bInt;
+				sample(&timeline, at, setup, setupInt, a, aInt);
+				sample(other, at, setup, decimatedSetupInt, b, bInt);
+				bool same = timeline.type == SPINE_TIMELINE_ATTACHMENT ?
+					strcmp(skeleton.str(aInt), decimatedSkeleton.str(bInt)) == 0 : aInt == bInt;
+				for (int c = 0; c < channels; ++c)
+				{
+					float delta = fabsf(a[c] - b[c]);
+					if (timeline.type == SPINE_TIMELINE_ROTATE)
+						delta = fabsf(wrap_angle(a[c] - b[c]));
+					if (tolerance[c] > 0)
+						worst = max(worst, (double)delta / tolerance[c]);
+					same = same && delta <= tolerance[c] * (1 + tolerances.epsilon) + tolerances.epsilon;
+				}
+				if (!same)
+				{
+					char at_text[32];
+					snprintf(at_text, sizeof(at_text), "%g", at);
+					error = string(name) + ": " + spine_timeline_name(timeline.type) + " timeline off at " + at_text;
+					return false;
+				}
+			}
+		}
+	}
+	for (const SpineTimelineData &timeline : decimated.timelines)
+	{
+		bool found = false;
+		for (const SpineTimelineData &original : full.timelines)
+			found = found || (original.type == timeline.type && original.index == timeline.index &&
+				original.skin == timeline.skin && original.attachment == timeline.attachment);
+		if (!found)
+		{
+			error = string(name) + ": a timeline was added";
+			return false;
+		}
+	}
+	return true;
+}
+
+static size_t keys_of(const SpineConverterStats &stats)
+{
+	size_t keys = 0;
+	for (int i = 0; i < SPINE_TIMELINE_COUNT; ++i)
+		keys += stats.timelines[i].keys;
+	return keys;
+}
+
+int main(int argc, char **argv)
+{
+	Tolerances tolerances;
+	SpineDecimation &decimation = tolerances.decimation;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		float value = (float)atof(argv[i + 1]);
+		if (strcmp(argv[i], "-rotation") == 0)
+			decimation.rotation = value;
+		else if (strcmp(argv[i], "-translation") == 0)
+			decimation.translation = value;
+		else if (strcmp(argv[i], "-scale") == 0)
+			decimation.scale = value;
+		else if (strcmp(argv[i], "-shear") == 0)
+			decimation.shear = value;
+		else if (strcmp(argv[i], "-color") == 0)
+			decimation.color = value;
+		else if (strcmp(argv[i], "-mix") == 0)
+			decimation.mix = value;
+		else
+			break;
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: decimate_check [-rotation deg] [-translation units] [-scale s] [-shear deg] "
+			"[-color c] [-mix m] file.json...\n");
+		return 1;
+	}
+
+	printf("%-30s %10s %10s %8s %10s %10s %10s %8s\n", "file", "keys", "dropped", "whole", "bytes", "saved",
+		"counted", "worst");
+	int failures = 0;
+	SpineConverter converter, decimating;
+	SpineConverterStats fullStats, stats;
+	converter.set_stats(&fullStats);
+	decimating.set_stats(&stats);
+	decimating.set_decimation(&decimation);
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		decimating.set_atlas(hasAtlas ? atlas.c_str() : 0);
+
+		vector<unsigned char> full, decimated;
+		SpineVectorSink fullSink(full), sink(decimated);
+		int rt = converter.convert(json.c_str(), json.size(), fullSink);
+		int decimatedRt = decimating.convert(json.c_str(), json.size(), sink);
+		if (rt < 0 || decimatedRt < 0)
+		{
+			fprintf(stderr, "%s: conversion error %d, decimated %d\n", argv[i], rt, decimatedRt);
+			++failures;
+			continue;
+		}
+
+		SpineSkeletonData a, b;
+		string error;
+		if (!read_spine_binary(full.data(), full.size(), a, &error) ||
+			!read_spine_binary(decimated.data(), decimated.size(), b, &error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		vector<SpineAnimationData> animations = a.animations, decimatedAnimations = b.animations;
+		a.animations.clear();
+		b.animations.clear();
+		bool same = a == b && animations.size() == decimatedAnimations.size();
+		if (!same)
+			error = "the skeleton changed";
+		double worst = 0;
+		for (size_t k = 0; same && k < animations.size(); ++k)
+			same = check_animation(a, b, animations[k], decimatedAnimations[k], tolerances, worst, error);
+		size_t saved = full.size() - decimated.size();
+		if (same && saved != stats.decimated.bytes)
+		{
+			same = false;
+			error = "the stats counted " + to_string(stats.decimated.bytes) + " bytes";
+		}
+		if (same && keys_of(fullStats) - keys_of(stats) != stats.decimated.keys)
+		{
+			same = false;
+			error = "the stats counted " + to_string(stats.decimated.keys) + " keys";
+		}
+		string name = path.substr(path.find_last_of("/\\") + 1);
+		printf("%-30s %10zu %10zu %8zu %10zu %10zu %10zu %8.3f\n", name.c_str(), keys_of(fullStats),
+			stats.decimated.keys, stats.decimated.timelines, full.size(), saved, stats.decimated.bytes, worst);
+		if (!same)
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Compares file to file conversion through SpineFile.h's mappings with reading the json into memory, converting to a
+ buffer and writing it out.
+
+ file_bench [-n rounds] file.json...
+
+ x.atlas next to x.json is used as its atlas. The outputs go to x.json.skel and are removed after. Reports the best
+ time of each way over the rounds, 5 by default. Exits with 1 when the two outputs differ.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. file_bench.cpp ../SpineExporter.cpp ../SpineFile.cpp Json.o -o file_bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineFile.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+static bool file_exists(const string &path)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (f)
+		fclose(f);
+	return f != 0;
+}
+
+// The way callers converted before: the json into a string, the output into a buffer, then to the file.
+static int convert_buffered(SpineConverter &converter, const string &jsonPath, const string &outPath,
+	const string &atlasPath)
+{
+	string json, atlas;
+	if (!read_file(jsonPath, json) || (!atlasPath.empty() && !read_file(atlasPath, atlas)))
+		return -22;
+	converter.set_atlas(atlasPath.empty() ? 0 : atlas.c_str());
+	vector<unsigned char> out;
+	SpineVectorSink sink(out);
+	int rt = converter.convert(json.c_str(), json.size(), sink);
+	if (rt < 0)
+		return rt;
+	FILE *f = fopen(outPath.c_str(), "wb");
+	bool written = f && fwrite(out.data(), 1, out.size(), f) == out.size();
+	if (f && fclose(f) != 0)
+		written = false;
+	return written ? rt : -21;
+}
+
+int main(int argc, char **argv)
+{
+	int rounds = 5;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-n") == 0)
+			rounds = atoi(argv[i + 1]);
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: file_bench [-n rounds] file.json...\n");
+		return 1;
+	}
+	if (rounds < 1)
+		rounds = 1;
+
+	int failures = 0;
+	printf("%-30s %10s %12s %12s %8s\n", "file", "bytes", "buffered ms", "mapped ms", "faster");
+	for (; i < argc; ++i)
+	{
+		string jsonPath = argv[i];
+		string atlasPath = jsonPath.substr(0, jsonPath.rfind('.')) + ".atlas";
+		if (!file_exists(atlasPath))
+			atlasPath.clear();
+		string outPath = jsonPath + ".skel";
+
+		SpineConverter converter;
+		double best[2] = { 1e30, 1e30 };
+		string outputs[2];
+		int rts[2] = { 0, 0 };
+		for (int round = 0; round < rounds; ++round)
+		{
+			for (int way = 0; way < 2; ++way)
+			{
+				auto start = chrono::steady_clock::now();
+				if (way == 0)
+					rts[way] = convert_buffered(converter, jsonPath, outPath, atlasPath);
+				else
+					rts[way] = convert_json_file(converter, jsonPath.c_str(), outPath.c_str(),
+						atlasPath.empty() ? 0 : atlasPath.c_str());
+				double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+				if (ms < best[way])
+					best[way] = ms;
+				if (!read_file(outPath, outputs[way]))
+					outputs[way].clear();
+				remove(outPath.c_str());
+			}
+		}
+
+		bool same = rts[0] == rts[1] && (rts[0] < 0 || outputs[0] == outputs[1]);
+		printf("%-30s %10d %12.3f %12.3f %7.2fx%s\n", jsonPath.c_str(), rts[1], best[0], best[1], best[0] / best[1],
+			same ? "" : "  DIFFERS");
+		if (!same)
+			++failures;
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks the Json number parser against strtof bit for bit: random floats printed short and long, significands over
+ 19 digits, points halfway between two floats and just either side of them, then every number of the files given.
+ Exits 1 on any mismatch.
+
+ float_check [-n count] [-l locale] [file.json...]
+
+ -l parses under a locale like de_DE.UTF-8 whose decimal point is a comma, strtof still runs in the C locale.
+
+ cc -O2 -I.. float_check.c ../Json.c -o float_check
+*/
+
+#include <locale.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Json.h"
+
+static const char *locale = 0;
+static long checked, mismatches;
+
+static uint64_t state = 0x9E3779B97F4A7C15u;
+
+/* xorshift64*, the same sequence on every platform */
+static uint64_t next_random(void)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1Du;
+}
+
+static uint32_t float_bits(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static float bits_float(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+/* Parses the number text with Json_Reader, the way the converter does. 0 if it isn't one. */
+static int parse(const char *text, float *out)
+{
+	Json_Reader reader;
+	int number;
+	Json_Reader_init(&reader, text);
+	number = Json_Reader_next(&reader) == Json_Number;
+	*out = reader.valueFloat;
+	Json_Reader_dispose(&reader);
+	return number;
+}
+
+static void check(const char *text, const char *where)
+{
+	float expected, got;
+	if (locale)
+		setlocale(LC_NUMERIC, "C");
+	expected = strtof(text, 0);
+	if (locale)
+		setlocale(LC_NUMERIC, locale);
+
+	checked++;
+	if (parse(text, &got) && float_bits(got) == float_bits(expected))
+		return;
+	if (++mismatches <= 20)
+		printf("%s: %s parsed to %.9g (%08x), strtof gives %.9g (%08x)\n", where, text, got,
+			(unsigned)float_bits(got), expected, (unsigned)float_bits(expected));
+}
+
+static float random_float(void)
+{
+	uint32_t bits;
+	do
+		bits = (uint32_t)(next_random() >> 32);
+	while ((bits & 0x7F800000) == 0x7F800000); /* inf and nan aren't JSON */
+	return bits_float(bits);
+}
+
+static void check_random(long count)
+{
+	char text[256];
+	long i;
+	for (i = 0; i < count; ++i)
+	{
+		float f = random_float();
+		sprintf(text, "%.9g", f);
+		check(text, "shortest");
+		sprintf(text, "%.17g", (double)f * (1 + ((double)(int64_t)next_random() / 9.3e18) * 1e-7));
+		check(text, "between");
+	}
+}
+
+/* 20 to 120 random digits, the point anywhere in them, and an exponent that keeps most of them in float range. */
+static void check_long(long count)
+{
+	char text[256];
+	long i;
+	for (i = 0; i < count; ++i)
+	{
+		int digits = 20 + (int)(next_random() % 101), point = (int)(next_random() % (uint64_t)digits);
+		int exponent = (int)(next_random() % 90) - 45 - point, n = 0, d;
+		if (next_random() & 1)
+			text[n++] = '-';
+		for (d = 0; d < digits; ++d)
+		{
+			/* runs of zeros and nines reach the cases where the 19 digit cut rounds differently */
+			int run = (int)(next_random() % 4);
+			if (d == point && d)
+				text[n++] = '.';
+			text[n++] = (char)(run == 0 ? '0' : run == 1 ? '9' : '0' + next_random() % 10);
+		}
+		sprintf(text + n, "e%d", exponent);
+		check(text, "long");
+	}
+}
+
+/* The exact decimal halfway point between a float and the next, then with a digit more or fewer. */
+static void check_halfway(long count)
+{
+	char text[256];
+	long i;
+	for (i = 0; i < count; ++i)
+	{
+		float f = random_float();
+		uint32_t bits = float_bits(f) & 0x7FFFFFFF;
+		double middle;
+		char *e;
+		if (bits == 0x7F7FFFFF)
+			continue;
+		middle = ((double)bits_float(bits) + (double)bits_float(bits + 1)) / 2;
+		sprintf(text, "%.120e", middle); /* doubles print exactly, the halfway point has under 120 digits */
+		e = strchr(text, 'e');
+		while (e[-1] == '0')
+		{
+			memmove(e - 1, e, strlen(e) + 1);
+			--e;
+		}
+		check(text, "halfway");
+
+		memmove(e + 1, e, strlen(e) + 1);
+		*e = '1';
+		check(text, "above halfway");
+
+		memmove(e - 1, e + 1, strlen(e + 1) + 1);
+		check(text, "below halfway");
+	}
+}
+
+static char *read_file(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	char *data;
+	if (!f)
+		return 0;
+	fseek(f, 0, SEEK_END);
+	*len = (size_t)ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = (char *)malloc(*len + 1);
+	if (data && fread(data, 1, *len, f) != *len)
+	{
+		free(data);
+		data = 0;
+	}
+	if (data)
+		data[*len] = 0;
+	fclose(f);
+	return data;
+}
+
+static void check_file(const char *path)
+{
+	size_t len;
+	char *json = read_file(path, &len);
+	char text[256];
+	Json_Reader reader;
+	int event;
+	if (!json)
+	{
+		fprintf(stderr, "%s: can't read\n", path);
+		++mismatches;
+		return;
+	}
+	Json_Reader_init(&reader, json);
+	while ((event = Json_Reader_next(&reader)) != Json_End && event != Json_Error)
+	{
+		size_t n = 0;
+		if (event != Json_Number)
+			continue;
+		while (n + 1 < sizeof(text) && reader.start[n] && strchr("+-.0123456789eE", reader.start[n]))
+		{
+			text[n] = reader.start[n];
+			++n;
+		}
+		text[n] = 0;
+		check(text, path);
+	}
+	if (event == Json_Error)
+		fprintf(stderr, "%s: parse error near \"%.20s\"\n", path, Json_getError());
+	Json_Reader_dispose(&reader);
+	free(json);
+}
+
+int main(int argc, char **argv)
+{
+	long count = 200000;
+	int i = 1;
+
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-n") == 0)
+			count = atol(argv[i + 1]);
+		else if (strcmp(argv[i], "-l") == 0)
+			locale = argv[i + 1];
+		else
+			break;
+	}
+	if (i < argc && argv[i][0] == '-')
+	{
+		fprintf(stderr, "usage: float_check [-n count] [-l locale] [file.json...]\n");
+		return 1;
+	}
+	if (locale && !setlocale(LC_NUMERIC, locale))
+	{
+		fprintf(stderr, "%s: no such locale\n", locale);
+		return 1;
+	}
+
+	check_random(count);
+	check_long(count);
+	check_halfway(count);
+	for (; i < argc; ++i)
+		check_file(argv[i]);
+
+	printf("%ld numbers, %ld mismatches\n", checked, mismatches);
+	return mismatches ? 1 : 0;
+}
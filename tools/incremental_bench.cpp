@@ -0,0 +1,152 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Times incremental conversions against full ones and checks they give the same output.
+
+ incremental_bench [-threads n] file.json...
+
+ x.atlas next to x.json is used as its atlas. Each file is converted in both output modes: in full, incrementally
+ with no chunks, again from the chunks saved to a sidecar and loaded back, and after a key time of its last animation
+ is changed, which must only encode that animation again. Exits with 1 when an output differs from the full
+ conversion's or a part is encoded that didn't change.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. incremental_bench.cpp ../SpineExporter.cpp Json.o -o incremental_bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+// Changes a digit of the last key time, which is in the last animation. false when there are no keys.
+static bool edit_last_key(string &json)
+{
+	size_t at = json.rfind("\"time\"");
+	if (at == string::npos)
+		return false;
+	at = json.find_first_of("0123456789", at);
+	if (at == string::npos)
+		return false;
+	json[at] = json[at] == '9' ? '8' : json[at] + 1;
+	return true;
+}
+
+struct Run
+{
+	int rt;
+	vector<unsigned char> out;
+	double ms;
+};
+
+static Run convert(SpineConverter &converter, const string &json)
+{
+	Run run;
+	SpineVectorSink sink(run.out);
+	auto start = chrono::steady_clock::now();
+	run.rt = converter.convert(json.c_str(), json.size(), sink);
+	run.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	return run;
+}
+
+static bool same(const Run &a, const Run &b)
+{
+	return a.rt == b.rt && a.out == b.out;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = 1;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-threads") == 0)
+			threads = atoi(argv[i + 1]);
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: incremental_bench [-threads n] file.json...\n");
+		return 1;
+	}
+
+	int failures = 0;
+	printf("%-30s %5s %9s %9s %9s %9s %7s %7s\n", "file", "mode", "full ms", "cold ms", "warm ms", "edit ms", "parts",
+		"edited");
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", path.c_str());
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		string edited = json;
+		bool canEdit = edit_last_key(edited);
+		string sidecar = path + ".chunks";
+
+		for (int table = 0; table < 2; ++table)
+		{
+			SpineConverter full, incremental;
+			for (SpineConverter *converter : { &full, &incremental })
+			{
+				converter->set_atlas(hasAtlas ? atlas.c_str() : 0);
+				converter->set_threads(threads);
+				converter->set_string_table(table != 0);
+			}
+			SpineChunks chunks;
+			incremental.set_chunks(&chunks);
+
+			Run reference = convert(full, json);
+			Run cold = convert(incremental, json);
+			size_t parts = chunks.encoded();
+			bool ok = same(cold, reference) && chunks.reused() == 0;
+
+			SpineChunks loaded;
+			ok = ok && chunks.save(sidecar) && loaded.load(sidecar) && loaded.size() == chunks.size();
+			remove(sidecar.c_str());
+			incremental.set_chunks(&loaded);
+			Run warm = convert(incremental, json);
+			ok = ok && same(warm, reference) && loaded.encoded() == 0 && loaded.reused() == parts;
+
+			Run edit = { 0, {}, 0 };
+			if (canEdit)
+			{
+				edit = convert(incremental, edited);
+				ok = ok && same(edit, convert(full, edited)) && loaded.encoded() == 1;
+			}
+
+			printf("%-30s %5s %9.3f %9.3f %9.3f %9.3f %7zu %7zu%s\n", path.c_str(), table ? "table" : "plain",
+				reference.ms, cold.ms, warm.ms, edit.ms, parts, canEdit ? loaded.encoded() : 0, ok ? "" : "  DIFFERS");
+			if (!ok)
+				++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks the influence limits of weighted meshes against the output without them.
+
+ influence_check [-max n] [-min-weight w] file.json...
+
+ x.atlas next to x.json is used as its atlas, the limits are those of SpineInfluences unless the options say
+ otherwise. Both outputs are read back with the reference reader. Each weighted vertex must keep at most max
+ influences, sorted by bone index, each one authored, with the same bone and position and its weight scaled by
+ what the dropped ones weighed. Those dropped must be no heavier than those left, and lighter than min-weight
+ unless the vertex is at its limit. An influence left lighter than min-weight must be the only one. The deform keys
+ must have the values of the influences left. Everything else must be the same. Prints the weighted vertices
+ written and their influences before and after, which must be what the stats counted, those of meshes the atlas
+ filters out left out. Exits with 1 on any mismatch.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. influence_check.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o \
+     -o influence_check
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_meshes.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+// A bone of a weighted vertex, with its place among the mesh's.
+struct Influence
+{
+	int bone;
+	float x, y, weight;
+	int index;
+};
+
+// The influences of each vertex of a weighted mesh.
+static vector<vector<Influence>> influences_of(const SpineAttachmentData &mesh)
+{
+	vector<vector<Influence>> vertices(mesh.vertexCount);
+	size_t bones = 0, values = 0;
+	int index = 0;
+	for (int v = 0; v < mesh.vertexCount; ++v)
+	{
+		int count = mesh.vertices.bones[bones++];
+		for (int i = 0; i < count; ++i, values += 3)
+		{
+			const float *value = &mesh.vertices.values[values];
+			vertices[v].push_back(Influence{ mesh.vertices.bones[bones++], value[0], value[1], value[2], index++ });
+		}
+	}
+	return vertices;
+}
+
+// All values of a deform key of a mesh with influences values, 0 outside the span it sets.
+static vector<float> deform_values(const DeformKey &key, int influences)
+{
+	vector<float> values(influences * 2);
+	int offset = key.timeline->ints[key.key * 2], count = key.timeline->ints[key.key * 2 + 1];
+	for (int i = 0; i < count && offset + i < (int)values.size(); ++i)
+		values[offset + i] = key.timeline->deform[key.values + i];
+	return values;
+}
+
+static bool check_mesh(const SpineAttachmentData &a, const vector<DeformKey> &keysA, const SpineAttachmentData &b,
+	const vector<DeformKey> &keysB, const SpineInfluences &limits, SpineMeshInfluences &count, string &error)
+{
+	if (a.vertexCount != b.vertexCount || a.uvs != b.uvs || a.triangles != b.triangles || a.hull != b.hull ||
+		!b.vertices.weighted || keysA.size() != keysB.size())
+		return error = "the mesh changed", false;
+	vector<vector<Influence>> authored = influences_of(a), left = influences_of(b);
+	vector<pair<int, int>> matched; // the index of each influence left, with the one it was
+	for (int v = 0; v < a.vertexCount; ++v)
+	{
+		vector<Influence> &from = authored[v], &to = left[v];
+		count.vertices++;
+		count.before += from.size();
+		count.after += to.size();
+		if (to.size() > from.size() || (limits.max > 0 && (int)to.size() > limits.max) || (from.empty() != to.empty()))
+			return error = "vertex " + to_string(v) + " has too many influences", false;
+		vector<bool> used(from.size());
+		float total = 0, kept = 0;
+		for (const Influence &influence : from)
+			total += influence.weight;
+		for (size_t i = 0; i < to.size(); ++i)
+		{
+			if (i && to[i].bone < to[i - 1].bone)
+				return error = "vertex " + to_string(v) + " isn't sorted by bone", false;
+			size_t j = 0;
+			while (j < from.size() && (used[j] || from[j].bone != to[i].bone || from[j].x != to[i].x ||
+				from[j].y != to[i].y))
+				++j;
+			if (j == from.size())
+				return error = "vertex " + to_string(v) + " has an influence it didn't", false;
+			used[j] = true;
+			kept += from[j].weight;
+			matched.push_back(make_pair(to[i].index, from[j].index));
+		}
+		float lightest = 1e30f;
+		for (size_t j = 0; j < from.size(); ++j)
+		{
+			if (used[j] && from[j].weight < lightest)
+				lightest = from[j].weight;
+		}
+		for (size_t j = 0; j < from.size(); ++j)
+		{
+			if (used[j])
+			{
+				if (from[j].weight < limits.minWeight && to.size() > 1)
+					return error = "vertex " + to_string(v) + " keeps a light influence", false;
+				continue;
+			}
+			if (from[j].weight > lightest || (from[j].weight >= limits.minWeight && (int)to.size() != limits.max))
+				return error = "vertex " + to_string(v) + " dropped an influence it could keep", false;
+		}
+		for (size_t i = 0; i < to.size(); ++i)
+		{
+			const Influence &was = from[matched[matched.size() - to.size() + i].second - from[0].index];
+			float expected = to.size() == from.size() || kept <= 0 ? was.weight : was.weight * total / kept;
+			if (fabsf(to[i].weight - expected) > 1e-5f * fmaxf(1, fabsf(expected)))
+				return error = "vertex " + to_string(v) + " has a weight off", false;
+		}
+	}
+
+	int before = (int)count.before, after = (int)count.after;
+	for (size_t k = 0; k < keysA.size(); ++k)
+	{
+		vector<float> from = deform_values(keysA[k], before), to = deform_values(keysB[k], after);
+		for (const pair<int, int> &influence : matched)
+		{
+			if (to[influence.first * 2] != from[influence.second * 2] ||
+				to[influence.first * 2 + 1] != from[influence.second * 2 + 1])
+				return error = "a deform key changed", false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	SpineInfluences limits;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-max") == 0)
+			limits.max = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-min-weight") == 0)
+			limits.minWeight = (float)atof(argv[i + 1]);
+		else
+			break;
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: influence_check [-max n] [-min-weight w] file.json...\n");
+		return 1;
+	}
+
+	printf("%-30s %8s %10s %12s %12s %8s %8s\n", "file", "meshes", "vertices", "influences", "after", "average",
+		"after");
+	int failures = 0;
+	SpineConverter converter, limiting;
+	SpineConverterStats stats;
+	limiting.set_stats(&stats);
+	limiting.set_influences(&limits);
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		limiting.set_atlas(hasAtlas ? atlas.c_str() : 0);
+
+		vector<unsigned char> full, limited;
+		SpineVectorSink fullSink(full), sink(limited);
+		int rt = converter.convert(json.c_str(), json.size(), fullSink);
+		int limitedRt = limiting.convert(json.c_str(), json.size(), sink);
+		if (rt < 0 || limitedRt < 0)
+		{
+			fprintf(stderr, "%s: conversion error %d, limited %d\n", argv[i], rt, limitedRt);
+			++failures;
+			continue;
+		}
+
+		SpineSkeletonData a, b;
+		string error;
+		if (!read_spine_binary(full.data(), full.size(), a, &error) ||
+			!read_spine_binary(limited.data(), limited.size(), b, &error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		map<const SpineAttachmentData *, vector<DeformKey>> keysA = deform_keys(a), keysB = deform_keys(b);
+		map<string, SpineMeshInfluences> counted;
+		for (const SpineMeshInfluences &mesh : stats.influences)
+			counted[mesh.name] = mesh;
+		bool same = a.skins.size() == b.skins.size();
+		size_t meshes = 0;
+		SpineMeshInfluences total;
+		for (size_t skin = 0; same && skin < a.skins.size(); ++skin)
+		{
+			same = a.skins[skin].slots.size() == b.skins[skin].slots.size();
+			for (size_t slot = 0; same && slot < a.skins[skin].slots.size(); ++slot)
+			{
+				vector<SpineAttachmentData> &attachmentsA = a.skins[skin].slots[slot].attachments;
+				vector<SpineAttachmentData> &attachmentsB = b.skins[skin].slots[slot].attachments;
+				same = attachmentsA.size() == attachmentsB.size();
+				for (size_t k = 0; same && k < attachmentsA.size(); ++k)
+				{
+					SpineAttachmentData &meshA = attachmentsA[k], &meshB = attachmentsB[k];
+					if (meshA.type != ATTACHMENT_MESH || !meshA.vertices.weighted)
+						continue;
+					const char *skinName = a.skins[skin].name < 0 ? "default" : a.str(a.skins[skin].name);
+					string name = string(skinName) + '/' + a.str(a.slots[a.skins[skin].slots[slot].slot].name) + '/' +
+						a.str(meshA.key);
+					SpineMeshInfluences count;
+					same = meshB.type == ATTACHMENT_MESH &&
+						check_mesh(meshA, keysA[&meshA], meshB, keysB[&meshB], limits, count, error);
+					const SpineMeshInfluences &stat = counted[name];
+					if (same && (stat.vertices != count.vertices || stat.before != count.before ||
+						stat.after != count.after))
+						same = false, error = "the stats counted " + name + " otherwise";
+					if (!same)
+						error = name + ": " + error;
+					++meshes;
+					total.vertices += count.vertices;
+					total.before += count.before;
+					total.after += count.after;
+
+					// left out of the comparison of the rest
+					meshA.vertices = meshB.vertices = SpineVerticesData();
+					for (DeformKey &key : keysA[&meshA])
+						key.timeline->ints.clear(), key.timeline->deform.clear();
+					for (DeformKey &key : keysB[&meshB])
+						key.timeline->ints.clear(), key.timeline->deform.clear();
+				}
+			}
+		}
+		if (same && meshes != stats.influences.size())
+			same = false, error = "the stats counted " + to_string(stats.influences.size()) + " meshes";
+		if (same && !(a == b))
+			same = false, error = "the skeleton changed";
+		string name = path.substr(path.find_last_of("/\\") + 1);
+		printf("%-30s %8zu %10zu %12zu %12zu %8.3f %8.3f\n", name.c_str(), meshes, total.vertices, total.before,
+			total.after, total.vertices ? (double)total.before / total.vertices : 0.0,
+			total.vertices ? (double)total.after / total.vertices : 0.0);
+		if (!same)
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
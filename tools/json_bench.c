@@ -0,0 +1,134 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Json parse throughput on spine exports.
+
+ json_bench [-n iterations] file.json...
+
+ Build it twice to compare the scanners, e.g.
+   cc -O2 -I.. json_bench.c ../Json.c -o json_bench
+   cc -O2 -I.. -DSPINE_JSON_SIMD=0 json_bench.c ../Json.c -o json_bench_scalar
+ and -mavx2 for the AVX2 kernels.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Json.h"
+
+/* Json.c picks its scanner from the same flags. */
+#if defined(SPINE_JSON_SIMD) && !SPINE_JSON_SIMD
+#define SCANNER "scalar"
+#elif defined(__AVX2__)
+#define SCANNER "avx2"
+#else
+#define SCANNER "sse2 where available"
+#endif
+
+static char *read_file(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	char *data;
+	if (!f)
+		return 0;
+	fseek(f, 0, SEEK_END);
+	*len = (size_t)ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = (char *)malloc(*len + 1);
+	if (data && fread(data, 1, *len, f) != *len)
+	{
+		free(data);
+		data = 0;
+	}
+	if (data)
+		data[*len] = 0;
+	fclose(f);
+	return data;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 20;
+	int i = 1;
+	Json_Arena *arena = Json_Arena_create(1024 * 1024);
+
+	if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+	{
+		iterations = atoi(argv[i + 1]);
+		i += 2;
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: json_bench [-n iterations] file.json...\n");
+		return 1;
+	}
+
+	printf("scanner: %s\n", SCANNER);
+
+	for (; i < argc; ++i)
+	{
+		size_t len;
+		char *json = read_file(argv[i], &len);
+		char *text;
+		double seconds = 0, best = 0;
+		int n;
+		if (!json)
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			continue;
+		}
+		text = (char *)malloc(len + 1);
+
+		for (n = 0; n < iterations; ++n)
+		{
+			clock_t start;
+			double elapsed;
+			Json *root;
+			/* in place parsing eats the text, restore it outside the timed region */
+			memcpy(text, json, len + 1);
+			start = clock();
+			root = Json_createInSitu(arena, text);
+			elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+			seconds += elapsed;
+			if (n == 0 || elapsed < best)
+				best = elapsed;
+			if (!root)
+			{
+				fprintf(stderr, "%s: parse error near \"%.20s\"\n", argv[i], Json_getError());
+				break;
+			}
+			Json_Arena_reset(arena);
+		}
+
+		/* the best run is the stable figure on a busy machine, the mean shows the spread */
+		if (n == iterations && best > 0)
+			printf("%s: %zu bytes, %.3f ms/parse mean, %.1f MB/s best\n", argv[i], len,
+				seconds * 1000 / iterations, (double)len / best / (1024 * 1024));
+		free(text);
+		free(json);
+	}
+
+	Json_Arena_dispose(arena);
+	return 0;
+}
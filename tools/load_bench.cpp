@@ -0,0 +1,196 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Load time and allocations of each skeleton as json and as binary.
+
+ load_bench [-n iterations] file.json...
+
+ x.atlas next to x.json is used as its atlas. Each file is converted with both engines, which must agree, and the
+ output must read back with the reference reader, so a malformed output fails the run with exit code 1.
+
+ The json load parses the text with Json.c and visits every value, the least a json loader does before it builds
+ anything; the binary load decodes the whole skeleton into SpineReader.h's model. The json side is a lower bound, the
+ real gain is larger. Allocations count operator new and Json.c's block allocator during a load. "nodes" is the
+ number of json values and names, each an allocation of its own for a parser without an arena such as the runtimes'.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. load_bench.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o -o load_bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+void *operator new(size_t size)
+{
+	++allocations;
+	allocatedBytes += size;
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+static void *json_alloc(size_t size)
+{
+	++allocations;
+	allocatedBytes += size;
+	return malloc(size);
+}
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Visits every value like a loader reading its fields. Counts values and names in nodes.
+static double visit(const Json *json, size_t &nodes)
+{
+	double sum = 0;
+	for (; json; json = json->next)
+	{
+		nodes += json->name ? 2 : 1;
+		if (json->type == Json_String)
+			sum += strlen(json->valueString);
+		else if (json->type == Json_Number)
+			sum += json->valueFloat;
+		sum += visit(json->child, nodes);
+	}
+	return sum;
+}
+
+struct LoadCost
+{
+	double seconds = 0;
+	size_t allocations = 0;
+	size_t bytes = 0;
+};
+
+int main(int argc, char **argv)
+{
+	int iterations = 20;
+	int i = 1;
+	if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+	{
+		iterations = atoi(argv[i + 1]);
+		i += 2;
+	}
+	if (i >= argc || iterations <= 0)
+	{
+		fprintf(stderr, "usage: load_bench [-n iterations] file.json...\n");
+		return 1;
+	}
+	Json_setAllocator(json_alloc, free);
+
+	int failures = 0;
+	printf("%-32s %10s %10s %9s %9s %7s %9s %11s %11s\n", "file", "json", "binary", "json ms", "binary ms", "faster",
+		"nodes", "json allocs", "bin allocs");
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+
+		SpineConverter converter;
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		vector<unsigned char> binary, stream;
+		SpineVectorSink sink(binary), streamSink(stream);
+		int rt = converter.convert(json.c_str(), json.size(), sink);
+		if (rt < 0 || converter.convert_stream(json.c_str(), json.size(), streamSink) != rt || stream != binary)
+		{
+			fprintf(stderr, "%s: conversion failed or the engines differ\n", argv[i]);
+			++failures;
+			continue;
+		}
+		SpineSkeletonData model;
+		string error;
+		if (!read_spine_binary(binary.data(), binary.size(), model, &error))
+		{
+			fprintf(stderr, "%s: malformed output, %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+
+		LoadCost jsonCost, binaryCost;
+		size_t nodes = 0;
+		double checksum = 0;
+		for (int it = 0; it < iterations; ++it)
+		{
+			size_t before = allocations, beforeBytes = allocatedBytes;
+			auto start = chrono::steady_clock::now();
+			Json *root = Json_create(json.c_str());
+			nodes = 0;
+			checksum += visit(root, nodes);
+			Json_dispose(root);
+			jsonCost.seconds += seconds_since(start);
+			jsonCost.allocations = allocations - before;
+			jsonCost.bytes = allocatedBytes - beforeBytes;
+
+			before = allocations;
+			beforeBytes = allocatedBytes;
+			start = chrono::steady_clock::now();
+			{
+				SpineSkeletonData loaded;
+				read_spine_binary(binary.data(), binary.size(), loaded);
+				checksum += loaded.bones.size();
+			}
+			binaryCost.seconds += seconds_since(start);
+			binaryCost.allocations = allocations - before;
+			binaryCost.bytes = allocatedBytes - beforeBytes;
+		}
+		if (checksum == 0.5) // keeps the work from being optimized away
+			printf("\n");
+
+		double jsonMs = jsonCost.seconds * 1000 / iterations, binaryMs = binaryCost.seconds * 1000 / iterations;
+		printf("%-32s %10zu %10zu %9.3f %9.3f %6.1fx %9zu %5zu %4zuK %5zu %4zuK\n", argv[i], json.size(),
+			binary.size(), jsonMs, binaryMs, jsonMs / binaryMs, nodes, jsonCost.allocations, jsonCost.bytes / 1024,
+			binaryCost.allocations, binaryCost.bytes / 1024);
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ How parsing and conversion scale as one part of a skeleton grows.
+
+ scale_bench [-n iterations] [-steps n] [-only count] [-count value]...
+
+ Starts from spine_generator.h's default shape, changed by -count value, and doubles one count at a time, steps times
+ (5 by default): bones, slots, skins, attachments, vertices, influences, animations, keys, deforms, or only the one
+ given with -only. Each step generates the skeleton and its atlas in a process of its own and reports:
+   the json and output size; Json_create and convert_json_to_binary throughput, the best of the iterations;
+   allocations of one conversion, operator new plus Json.c's block allocator; the process' peak RSS, which holds the
+   text too; and "per byte", the conversion time per input byte relative to the first step. It stays near 1 while a
+   stage scales linearly, a stage that grows faster than its input shows up as a climbing value.
+ Uses fork, so it builds on POSIX systems only.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. scale_bench.cpp ../SpineExporter.cpp Json.o -o scale_bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "SpineExporter.h"
+#include "spine_generator.h"
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+	++allocations;
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+static void *json_alloc(size_t size)
+{
+	++allocations;
+	return malloc(size);
+}
+
+struct StepResult
+{
+	int error; // the conversion's error, 0 when it worked
+	size_t jsonSize, outputSize;
+	double parseSeconds, convertSeconds; // best of the iterations
+	size_t allocations; // of one conversion
+	long peakKb;
+};
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static StepResult measure(const SkeletonShape &shape, int iterations)
+{
+	StepResult result = StepResult();
+	SkeletonGenerator generator(shape, 1);
+	string json = generator.json(), atlas = generator.atlas();
+	result.jsonSize = json.size();
+
+	for (int it = 0; it < iterations; ++it)
+	{
+		auto start = chrono::steady_clock::now();
+		Json *root = Json_create(json.c_str());
+		double seconds = seconds_since(start);
+		Json_dispose(root);
+		if (it == 0 || seconds < result.parseSeconds)
+			result.parseSeconds = seconds;
+	}
+
+	SpineConverter converter;
+	converter.set_atlas(atlas.c_str());
+	vector<unsigned char> output;
+	for (int it = 0; it < iterations; ++it)
+	{
+		output.clear();
+		SpineVectorSink sink(output);
+		size_t before = allocations;
+		auto start = chrono::steady_clock::now();
+		int rt = converter.convert(json.c_str(), json.size(), sink);
+		double seconds = seconds_since(start);
+		if (rt < 0)
+		{
+			result.error = rt;
+			return result;
+		}
+		// the first one warms the converter's arena and buffers, count the second when there is one
+		if (it <= 1)
+			result.allocations = allocations - before;
+		if (it == 0 || seconds < result.convertSeconds)
+			result.convertSeconds = seconds;
+	}
+	result.outputSize = output.size();
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	result.peakKb = usage.ru_maxrss / 1024;
+#else
+	result.peakKb = usage.ru_maxrss;
+#endif
+	return result;
+}
+
+// Runs measure in a child, so each step's peak RSS is its own.
+static bool measure_isolated(const SkeletonShape &shape, int iterations, StepResult &result)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+	fflush(stdout); // or the child prints it again
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		StepResult child = measure(shape, iterations);
+		bool ok = write(fds[1], &child, sizeof(child)) == (ssize_t)sizeof(child);
+		_exit(ok ? 0 : 1);
+	}
+	close(fds[1]);
+	bool ok = read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+	close(fds[0]);
+	int status;
+	waitpid(pid, &status, 0);
+	return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *const dimensions[] = { "bones", "slots", "skins", "attachments", "vertices", "influences",
+		"animations", "keys", "deforms" };
+	SkeletonShape base;
+	int iterations = 5, steps = 5;
+	const char *only = 0;
+	bool usage = false;
+	for (int i = 1; i < argc && !usage; i += 2)
+	{
+		if (i + 1 >= argc || argv[i][0] != '-')
+			usage = true;
+		else if (strcmp(argv[i], "-n") == 0)
+			iterations = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-steps") == 0)
+			steps = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-only") == 0)
+			only = argv[i + 1];
+		else
+			usage = !set_shape_count(base, argv[i] + 1, atoi(argv[i + 1]));
+	}
+	if (usage || iterations <= 0 || steps <= 0 || (only && !shape_count(base, only)))
+	{
+		fprintf(stderr, "usage: scale_bench [-n iterations] [-steps n] [-only count] [-count value]...\n");
+		return 1;
+	}
+	Json_setAllocator(json_alloc, free);
+
+	int failures = 0;
+	for (const char *dimension : dimensions)
+	{
+		if (only && strcmp(only, dimension) != 0)
+			continue;
+		printf("%-11s %6s %10s %10s %9s %9s %9s %9s %8s %8s\n", dimension, "value", "json", "output", "parse MB/s",
+			"conv MB/s", "conv ms", "allocs", "peak MB", "per byte");
+
+		SkeletonShape shape = base;
+		int *count = shape_count(shape, dimension);
+		int start = *count > 0 ? *count : 1;
+
+		double firstPerByte = 0;
+		for (int step = 0; step < steps; ++step)
+		{
+			*count = start << step;
+			StepResult r = StepResult();
+			if (!measure_isolated(shape, iterations, r) || r.error)
+			{
+				if (r.error)
+					fprintf(stderr, "%s %d: conversion error %d\n", dimension, *count, r.error);
+				else
+					fprintf(stderr, "%s %d: the measuring process failed\n", dimension, *count);
+				++failures;
+				break;
+			}
+			double perByte = r.convertSeconds / r.jsonSize;
+			if (step == 0)
+				firstPerByte = perByte;
+			double mb = 1024.0 * 1024.0;
+			printf("%-11s %6d %9zuK %9zuK %10.1f %9.1f %9.2f %9zu %8.1f %8.2f\n", "", *count, r.jsonSize / 1024,
+				r.outputSize / 1024, r.jsonSize / mb / r.parseSeconds, r.jsonSize / mb / r.convertSeconds,
+				r.convertSeconds * 1000, r.allocations, r.peakKb / 1024.0, perByte / firstPerByte);
+		}
+		printf("\n");
+	}
+	return failures ? 1 : 0;
+}
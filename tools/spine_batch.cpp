@@ -0,0 +1,431 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Converts many skeletons at once, one converter per core.
+
+ spine_batch [-j threads] [-o outdir] [-cache dir] [-cache-mb n] [-incremental 1] [-decimate 1] [-strip 1]
+   [-keep-animations a,b] [-keep-skins a,b] [-keep-bones a,b] [-vertex-cache n] [-influences n] (dir | @manifest)...
+
+ A directory is searched recursively for .json files. A manifest lists one skeleton per line, optionally followed by
+ its atlas, separated by a tab. Without one, x.atlas next to x.json is used if it exists. The output is x.skel, next
+ to the json or in outdir. Without -cache, the files are mapped instead of read and written, see SpineFile.h.
+
+ -cache keeps the outputs in dir, a SpineCache, so a skeleton whose json and atlas haven't changed since a build is
+ copied instead of converted. -cache-mb bounds the cache's size in megabytes, unbounded by default.
+
+ -incremental 1 keeps the encoded skins and animations of each skeleton in x.skel.chunks next to its output, a
+ SpineChunks sidecar, so a skeleton that changed only encodes the skins and animations that did.
+
+ -decimate 1 drops the keys interpolation reproduces within the default tolerances, see SpineDecimation.
+
+ -strip 1 drops what no skin or animation reaches, see SpineConverter::set_stripping, keeping every
+ animation and skin. -keep-animations, -keep-skins and -keep-bones strip too, keeping only the animations and skins
+ listed, and the bones listed besides those reached. Names a skeleton doesn't have are reported for each skeleton
+ converted, a cache hit isn't.
+
+ -vertex-cache n reorders the triangles and vertices of meshes for a post-transform cache of n vertices, see
+ SpineConverter::set_vertex_cache.
+
+ -influences n keeps at most n influences per weighted mesh vertex, dropping the lightest and those under the default
+ minimum weight, see SpineConverter::set_influences.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. spine_batch.cpp ../SpineCache.cpp ../SpineExporter.cpp ../SpineFile.cpp Json.o \
+     -o spine_batch
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include "SpineCache.h"
+#include "SpineExporter.h"
+#include "SpineFile.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+struct Job
+{
+	string json;
+	string atlas; // empty for none
+	string output;
+	size_t size; // of the json, big ones go first
+};
+
+// Jobs of one worker. It takes from the front, idle workers steal from the back, so the big jobs dealt to a worker
+// stay with it and the small ones even out the end.
+struct WorkQueue
+{
+	mutex lock;
+	deque<size_t> jobs;
+};
+
+static size_t file_size(const string &path)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return 0;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	return size > 0 ? (size_t)size : 0;
+}
+
+static bool file_exists(const string &path)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (f)
+		fclose(f);
+	return f != 0;
+}
+
+static bool ends_with(const string &str, const char *suffix)
+{
+	size_t n = strlen(suffix);
+	return str.size() >= n && str.compare(str.size() - n, n, suffix) == 0;
+}
+
+static string strip_extension(const string &path)
+{
+	size_t dot = path.rfind('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == string::npos || (slash != string::npos && dot < slash))
+		return path;
+	return path.substr(0, dot);
+}
+
+static void add_job(vector<Job> &jobs, const string &json, const string &atlas, const string &outdir)
+{
+	Job job;
+	job.json = json;
+	job.atlas = atlas;
+	if (job.atlas.empty() && file_exists(strip_extension(json) + ".atlas"))
+		job.atlas = strip_extension(json) + ".atlas";
+	string base = strip_extension(json);
+	if (!outdir.empty())
+	{
+		size_t slash = base.find_last_of("/\\");
+		base = outdir + "/" + (slash == string::npos ? base : base.substr(slash + 1));
+	}
+	job.output = base + ".skel";
+	job.size = file_size(json);
+	jobs.push_back(job);
+}
+
+static void add_directory(vector<Job> &jobs, const string &dir, const string &outdir)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &entry);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		string name = entry.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			add_directory(jobs, dir + "\\" + name, outdir);
+		else if (ends_with(name, ".json"))
+			add_job(jobs, dir + "\\" + name, "", outdir);
+	} while (FindNextFileA(find, &entry));
+	FindClose(find);
+#else
+	DIR *d = opendir(dir.c_str());
+	if (!d)
+		return;
+	while (dirent *entry = readdir(d))
+	{
+		string name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+		string path = dir + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+			continue;
+		if (S_ISDIR(st.st_mode))
+			add_directory(jobs, path, outdir);
+		else if (ends_with(name, ".json"))
+			add_job(jobs, path, "", outdir);
+	}
+	closedir(d);
+#endif
+}
+
+static bool add_manifest(vector<Job> &jobs, const string &manifest, const string &outdir)
+{
+	string text;
+	if (!read_file(manifest, text))
+		return false;
+	size_t pos = 0;
+	while (pos < text.size())
+	{
+		size_t end = text.find_first_of("\r\n", pos);
+		if (end == string::npos)
+			end = text.size();
+		string line = text.substr(pos, end - pos);
+		pos = end + 1;
+		if (line.empty() || line[0] == '#')
+			continue;
+		size_t tab = line.find('\t');
+		if (tab == string::npos)
+			add_job(jobs, line, "", outdir);
+		else
+			add_job(jobs, line.substr(0, tab), line.substr(tab + 1), outdir);
+	}
+	return true;
+}
+
+// Converts one job through cache. Returns false and says why when it fails.
+static bool convert_cached(SpineConverter &converter, SpineCache &cache, const Job &job, vector<unsigned char> &out)
+{
+	string json, atlas;
+	if (!read_file(job.json, json))
+	{
+		fprintf(stderr, "%s: can't read\n", job.json.c_str());
+		return false;
+	}
+	if (!job.atlas.empty() && !read_file(job.atlas, atlas))
+	{
+		fprintf(stderr, "%s: can't read\n", job.atlas.c_str());
+		return false;
+	}
+	const char *jobAtlas = job.atlas.empty() ? 0 : atlas.c_str();
+
+	int rt = cache.convert(converter, json.c_str(), json.size(), jobAtlas, out);
+	if (rt < 0)
+	{
+		fprintf(stderr, "%s: conversion failed with %d\n", job.json.c_str(), rt);
+		return false;
+	}
+
+	FILE *f = fopen(job.output.c_str(), "wb");
+	bool written = f && fwrite(out.data(), 1, out.size(), f) == out.size();
+	if (f && fclose(f) != 0)
+		written = false;
+	if (!written)
+		fprintf(stderr, "%s: can't write\n", job.output.c_str());
+	return written;
+}
+
+// Converts one job, through cache unless it is 0, incrementally with a sidecar if asked. Without a cache the files are
+// mapped, see SpineFile.h. Returns false and says why when it fails.
+static bool convert_job(SpineConverter &converter, SpineCache *cache, bool incremental, const Job &job,
+	vector<unsigned char> &out)
+{
+	// a missing or stale sidecar only costs encoding everything
+	SpineChunks chunks;
+	string sidecar = job.output + ".chunks";
+	if (incremental)
+	{
+		chunks.load(sidecar);
+		converter.set_chunks(&chunks);
+	}
+
+	bool converted;
+	if (cache)
+		converted = convert_cached(converter, *cache, job, out);
+	else
+	{
+		int rt = convert_json_file(converter, job.json.c_str(), job.output.c_str(),
+			job.atlas.empty() ? 0 : job.atlas.c_str());
+		converted = rt >= 0;
+		if (rt == -22)
+			fprintf(stderr, "%s: can't read it or its atlas\n", job.json.c_str());
+		else if (rt == -21)
+			fprintf(stderr, "%s: can't write\n", job.output.c_str());
+		else if (rt < 0)
+			fprintf(stderr, "%s: conversion failed with %d\n", job.json.c_str(), rt);
+	}
+	converter.set_chunks(0);
+
+	// a cache hit doesn't convert, the sidecar it has is left
+	if (converted && incremental && chunks.size() && !chunks.save(sidecar))
+		fprintf(stderr, "%s: can't write\n", sidecar.c_str());
+	return converted;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = (int)thread::hardware_concurrency();
+	string outdir, cacheDir;
+	size_t cacheMb = 0;
+	bool incremental = false, decimate = false, strip = false;
+	SpineStripping keep;
+	int vertexCache = 0, influences = 0;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-j") == 0)
+			threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-o") == 0)
+			outdir = argv[i + 1];
+		else if (strcmp(argv[i], "-cache") == 0)
+			cacheDir = argv[i + 1];
+		else if (strcmp(argv[i], "-cache-mb") == 0)
+			cacheMb = (size_t)atol(argv[i + 1]);
+		else if (strcmp(argv[i], "-incremental") == 0)
+			incremental = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-decimate") == 0)
+			decimate = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-strip") == 0)
+			strip = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-keep-animations") == 0)
+			keep.animations = split(argv[i + 1]);
+		else if (strcmp(argv[i], "-keep-skins") == 0)
+			keep.skins = split(argv[i + 1]);
+		else if (strcmp(argv[i], "-keep-bones") == 0)
+			keep.bones = split(argv[i + 1]);
+		else if (strcmp(argv[i], "-vertex-cache") == 0)
+			vertexCache = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-influences") == 0)
+			influences = atoi(argv[i + 1]);
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: spine_batch [-j threads] [-o outdir] [-cache dir] [-cache-mb n] [-incremental 1] "
+			"[-decimate 1] [-strip 1] [-keep-animations a,b] [-keep-skins a,b] [-keep-bones a,b] [-vertex-cache n] "
+			"[-influences n] (dir | @manifest)...\n");
+		return 1;
+	}
+	if (!keep.animations.empty() || !keep.skins.empty() || !keep.bones.empty())
+		strip = true;
+	unique_ptr<SpineCache> cache;
+	if (!cacheDir.empty())
+	{
+		cache.reset(new SpineCache(cacheDir, cacheMb * 1024 * 1024));
+		if (!cache->ok())
+			fprintf(stderr, "%s: can't use as a cache, converting everything\n", cacheDir.c_str());
+	}
+	if (threads < 1)
+		threads = 1;
+
+	vector<Job> jobs;
+	for (; i < argc; ++i)
+	{
+		if (argv[i][0] == '@')
+		{
+			if (!add_manifest(jobs, argv[i] + 1, outdir))
+				fprintf(stderr, "%s: can't read\n", argv[i] + 1);
+		}
+		else if (ends_with(argv[i], ".json"))
+			add_job(jobs, argv[i], "", outdir);
+		else
+			add_directory(jobs, argv[i], outdir);
+	}
+	if (jobs.empty())
+	{
+		fprintf(stderr, "no skeletons found\n");
+		return 1;
+	}
+
+	// biggest first, dealt round robin so every worker starts on a big one
+	stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.size > b.size; });
+	if (threads > (int)jobs.size())
+		threads = (int)jobs.size();
+	vector<WorkQueue> queues(threads);
+	for (size_t job = 0; job < jobs.size(); ++job)
+		queues[job % threads].jobs.push_back(job);
+
+	atomic<int> failures(0);
+	atomic<size_t> bytes(0);
+	auto start = chrono::steady_clock::now();
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.push_back(thread([&, t]()
+		{
+			SpineConverter converter;
+			SpineDecimation decimation;
+			converter.set_decimation(decimate ? &decimation : 0);
+			converter.set_stripping(strip ? &keep : 0);
+			SpineConverterStats stats; // for the names kept that aren't there
+			converter.set_stats(strip ? &stats : 0);
+			converter.set_vertex_cache(vertexCache);
+			SpineInfluences limits;
+			limits.max = influences;
+			converter.set_influences(influences > 0 ? &limits : 0);
+			vector<unsigned char> out;
+			for (;;)
+			{
+				size_t job = jobs.size();
+				{
+					lock_guard<mutex> guard(queues[t].lock);
+					if (!queues[t].jobs.empty())
+					{
+						job = queues[t].jobs.front();
+						queues[t].jobs.pop_front();
+					}
+				}
+				for (int v = 1; job == jobs.size() && v < threads; ++v)
+				{
+					WorkQueue &victim = queues[(t + v) % threads];
+					lock_guard<mutex> guard(victim.lock);
+					if (!victim.jobs.empty())
+					{
+						job = victim.jobs.back();
+						victim.jobs.pop_back();
+					}
+				}
+				// nothing left anywhere, and nothing is ever added
+				if (job == jobs.size())
+					break;
+
+				stats.clear();
+				if (convert_job(converter, cache.get(), incremental, jobs[job], out))
+					bytes += jobs[job].size;
+				else
+					++failures;
+				for (const string &name : stats.stripped.unmatched)
+					fprintf(stderr, "%s: no %s to keep\n", jobs[job].json.c_str(), name.c_str());
+			}
+		}));
+	}
+	for (auto &worker : workers)
+		worker.join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	size_t converted = jobs.size() - failures;
+	printf("%zu of %zu skeletons on %d threads in %.2f s, %.1f files/s, %.1f MB/s\n", converted, jobs.size(), threads,
+		seconds, converted / seconds, bytes / seconds / (1024 * 1024));
+	if (cache)
+	{
+		printf("cache: %zu hits, %zu misses, %zu stored, %zu evicted\n", cache->hits(), cache->misses(),
+			cache->stores(), cache->evictions());
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Writes a synthetic skeleton and its atlas, test data of any size.
+
+ spine_gen [-seed n] [-count value]... out.json
+
+ count is one of spine_generator.h's: bones, slots, skins, attachments, meshes, vertices, weighted, influences,
+ animations, keys, deforms, e.g. spine_gen -bones 200 -deforms 20 big.json. The atlas goes to out.atlas.
+   c++ -O2 -std=c++11 spine_gen.cpp -o spine_gen
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "spine_generator.h"
+
+using namespace std;
+
+static bool write_file(const string &path, const string &text)
+{
+	FILE *f = fopen(path.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+	return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+	SkeletonShape shape;
+	unsigned seed = 1;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-seed") == 0)
+			seed = (unsigned)strtoul(argv[i + 1], 0, 10);
+		else if (!set_shape_count(shape, argv[i] + 1, atoi(argv[i + 1])))
+		{
+			fprintf(stderr, "unknown count %s\n", argv[i] + 1);
+			return 1;
+		}
+	}
+	if (i + 1 != argc)
+	{
+		fprintf(stderr, "usage: spine_gen [-seed n] [-count value]... out.json\n");
+		return 1;
+	}
+
+	string path = argv[i];
+	SkeletonGenerator generator(shape, seed);
+	string atlasPath = path.substr(0, path.rfind('.')) + ".atlas";
+	if (!write_file(path, generator.json()) || !write_file(atlasPath, generator.atlas()))
+	{
+		fprintf(stderr, "can't write %s\n", path.c_str());
+		return 1;
+	}
+	return 0;
+}
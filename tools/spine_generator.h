@@ -0,0 +1,394 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_GENERATOR_H__
+#define __SPINE_GENERATOR_H__
+
+// Writes synthetic spine json of a chosen shape, for spine_gen and scale_bench. The same shape and seed give the same
+// text. Every count scales one part of the file:
+//   bones, slots; skins, each with attachments per slot; meshes is the percent of attachments that are meshes, the
+//   rest regions, with vertices each; weighted is the percent of meshes that are weighted, with influences bones per
+//   vertex; animations, each with keys keys on every bone and slot timeline and deforms deformed meshes.
+
+#include <stdio.h>
+#include <string>
+
+struct SkeletonShape
+{
+	int bones = 30;
+	int slots = 20;
+	int skins = 2;
+	int attachments = 2;
+	int meshes = 50;
+	int vertices = 16;
+	int weighted = 50;
+	int influences = 3;
+	int animations = 4;
+	int keys = 10;
+	int deforms = 4;
+};
+
+// The count called name, 0 if there is none.
+static inline int *shape_count(SkeletonShape &shape, const char *name)
+{
+	struct Count
+	{
+		const char *name;
+		int SkeletonShape::*field;
+	};
+	static const Count counts[] = { { "bones", &SkeletonShape::bones }, { "slots", &SkeletonShape::slots },
+		{ "skins", &SkeletonShape::skins }, { "attachments", &SkeletonShape::attachments },
+		{ "meshes", &SkeletonShape::meshes }, { "vertices", &SkeletonShape::vertices },
+		{ "weighted", &SkeletonShape::weighted }, { "influences", &SkeletonShape::influences },
+		{ "animations", &SkeletonShape::animations }, { "keys", &SkeletonShape::keys },
+		{ "deforms", &SkeletonShape::deforms } };
+	for (const Count &count : counts)
+	{
+		if (std::string(name) == count.name)
+			return &(shape.*count.field);
+	}
+	return 0;
+}
+
+// Sets the count called name, false if there is none.
+static inline bool set_shape_count(SkeletonShape &shape, const char *name, int value)
+{
+	int *count = shape_count(shape, name);
+	if (count)
+		*count = value < 0 ? 0 : value;
+	return count != 0;
+}
+
+class SkeletonGenerator
+{
+public:
+	SkeletonGenerator(const SkeletonShape &shape, unsigned seed) : shape(shape), seed(seed ? seed : 1)
+	{
+		// the converter needs a bone, a slot and a skin
+		if (this->shape.bones < 1)
+			this->shape.bones = 1;
+		if (this->shape.slots < 1)
+			this->shape.slots = 1;
+		if (this->shape.skins < 1)
+			this->shape.skins = 1;
+		if (this->shape.vertices < 3)
+			this->shape.vertices = 3;
+		if (this->shape.influences < 1)
+			this->shape.influences = 1;
+	}
+
+	std::string json()
+	{
+		out.clear();
+		state = seed;
+		out += "{\n\"skeleton\": { \"hash\": \"synthetic\", \"spine\": \"3.8.99\", \"width\": 256, \"height\": 512 },\n";
+		write_bones();
+		write_slots();
+		write_constraints();
+		write_skins();
+		out += "\"events\": { \"step\": { \"int\": 1 }, \"sound\": { \"string\": \"hit\", \"float\": 0.5 } },\n";
+		write_animations();
+		out += "}\n";
+		return out;
+	}
+
+	// An atlas with a region for every attachment name, so a conversion with it keeps everything.
+	std::string atlas() const
+	{
+		std::string text = "\nsynthetic.png\nsize: 4096,4096\nformat: RGBA8888\nfilter: Linear,Linear\nrepeat: none\n";
+		for (int slot = 0; slot < shape.slots; ++slot)
+		{
+			for (int i = 0; i < shape.attachments; ++i)
+			{
+				text += attachment_name(slot, i);
+				text += "\n  rotate: false\n  xy: 0, 0\n  size: 32, 32\n  orig: 32, 32\n  offset: 0, 0\n  index: -1\n";
+			}
+		}
+		return text;
+	}
+
+private:
+	SkeletonShape shape;
+	unsigned seed;
+	unsigned state = 1;
+	std::string out;
+
+	unsigned next()
+	{
+		// xorshift32, the same everywhere unlike rand()
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	int below(int n) { return n > 0 ? (int)(next() % (unsigned)n) : 0; }
+	float uniform(float lo, float hi) { return lo + (hi - lo) * (next() % 100000) / 100000.0f; }
+
+	void number(float v)
+	{
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.3f", v);
+		out += buffer;
+	}
+
+	void number(int v) { out += std::to_string(v); }
+
+	static std::string attachment_name(int slot, int i) { return "a" + std::to_string(slot) + "_" + std::to_string(i); }
+
+	// Whether attachment i of slot in skin is a mesh, and a weighted one.
+	bool is_mesh(int skin, int slot, int i) const
+	{
+		return (unsigned)(skin * 7919 + slot * 131 + i * 17) % 100 < (unsigned)shape.meshes;
+	}
+
+	bool is_weighted(int skin, int slot, int i) const
+	{
+		return (unsigned)(skin * 31 + slot * 97 + i * 53) % 100 < (unsigned)shape.weighted;
+	}
+
+	void write_bones()
+	{
+		out += "\"bones\": [\n\t{ \"name\": \"root\" }";
+		for (int i = 1; i < shape.bones; ++i)
+		{
+			out += ",\n\t{ \"name\": \"bone" + std::to_string(i) + "\", \"parent\": \"";
+			int parent = below(i);
+			out += parent ? "bone" + std::to_string(parent) : std::string("root");
+			out += "\", \"length\": ";
+			number(uniform(5, 80));
+			out += ", \"rotation\": ";
+			number(uniform(-180, 180));
+			out += ", \"x\": ";
+			number(uniform(-50, 50));
+			out += ", \"y\": ";
+			number(uniform(-50, 50));
+			out += " }";
+		}
+		out += "\n],\n";
+	}
+
+	std::string bone_name(int i) const { return i ? "bone" + std::to_string(i) : std::string("root"); }
+
+	void write_slots()
+	{
+		out += "\"slots\": [";
+		for (int i = 0; i < shape.slots; ++i)
+		{
+			out += i ? ",\n\t" : "\n\t";
+			out += "{ \"name\": \"slot" + std::to_string(i) + "\", \"bone\": \"" + bone_name(i % shape.bones) + "\"";
+			if (shape.attachments > 0)
+				out += ", \"attachment\": \"" + attachment_name(i, 0) + "\"";
+			out += " }";
+		}
+		out += "\n],\n";
+	}
+
+	void write_constraints()
+	{
+		if (shape.bones < 3)
+			return;
+		out += "\"ik\": [ { \"name\": \"ik0\", \"bones\": [ \"bone1\", \"bone2\" ], \"target\": \"bone" +
+			std::to_string(shape.bones - 1) + "\", \"mix\": 0.8 } ],\n";
+		out += "\"transform\": [ { \"name\": \"tr0\", \"order\": 1, \"bones\": [ \"bone2\" ], \"target\": \"bone1\", "
+			"\"rotateMix\": 0.5, \"translateMix\": 0.5 } ],\n";
+	}
+
+	void write_mesh(bool weighted)
+	{
+		int n = shape.vertices;
+		out += "\"type\": \"mesh\", \"width\": 32, \"height\": 32, \"hull\": 6,\n\t\t\t\t\"uvs\": [ ";
+		for (int v = 0; v < 2 * n; ++v)
+		{
+			if (v)
+				out += ", ";
+			number(uniform(0, 1));
+		}
+		out += " ],\n\t\t\t\t\"triangles\": [ ";
+		for (int t = 0; t < 3 * (n - 2); ++t)
+		{
+			if (t)
+				out += ", ";
+			number(t % 3 == 0 ? 0 : t / 3 + t % 3);
+		}
+		out += " ],\n\t\t\t\t\"vertices\": [ ";
+		for (int v = 0; v < n; ++v)
+		{
+			if (v)
+				out += ", ";
+			if (!weighted)
+			{
+				number(uniform(-100, 100));
+				out += ", ";
+				number(uniform(-100, 100));
+				continue;
+			}
+			number(shape.influences);
+			for (int k = 0; k < shape.influences; ++k)
+			{
+				out += ", ";
+				number(below(shape.bones));
+				out += ", ";
+				number(uniform(-50, 50));
+				out += ", ";
+				number(uniform(-50, 50));
+				out += ", ";
+				number(1.0f / shape.influences);
+			}
+		}
+		out += " ]";
+	}
+
+	std::string skin_name(int skin) const { return skin ? "skin" + std::to_string(skin) : std::string("default"); }
+
+	void write_skins()
+	{
+		out += "\"skins\": {";
+		for (int skin = 0; skin < shape.skins; ++skin)
+		{
+			out += skin ? ",\n\t\"" : "\n\t\"";
+			out += skin_name(skin) + "\": {";
+			for (int slot = 0; slot < shape.slots; ++slot)
+			{
+				out += slot ? ",\n\t\t\"" : "\n\t\t\"";
+				out += "slot" + std::to_string(slot) + "\": {";
+				for (int i = 0; i < shape.attachments; ++i)
+				{
+					out += i ? ",\n\t\t\t\"" : "\n\t\t\t\"";
+					out += attachment_name(slot, i) + "\": { ";
+					if (is_mesh(skin, slot, i))
+						write_mesh(is_weighted(skin, slot, i));
+					else
+					{
+						out += "\"x\": ";
+						number(uniform(-20, 20));
+						out += ", \"y\": ";
+						number(uniform(-20, 20));
+						out += ", \"rotation\": 90, \"width\": 32, \"height\": 32";
+					}
+					out += " }";
+				}
+				out += " }";
+			}
+			out += " }";
+		}
+		out += "\n},\n";
+	}
+
+	// keys frames of a timeline, value writes the fields of a key after its time
+	template <typename Value>
+	void write_keys(Value value)
+	{
+		out += "[";
+		for (int k = 0; k < shape.keys; ++k)
+		{
+			out += k ? ", { \"time\": " : " { \"time\": ";
+			number(k / 30.0f);
+			value(k);
+			if (k % 4 == 1)
+				out += ", \"curve\": [ 0.25, 0, 0.75, 1 ]";
+			else if (k % 4 == 3)
+				out += ", \"curve\": \"stepped\"";
+			out += " }";
+		}
+		out += " ]";
+	}
+
+	void write_animations()
+	{
+		out += "\"animations\": {";
+		for (int a = 0; a < shape.animations; ++a)
+		{
+			out += a ? ",\n\t\"anim" : "\n\t\"anim";
+			out += std::to_string(a) + "\": {\n\t\t\"bones\": {";
+			for (int b = 0; b < shape.bones; ++b)
+			{
+				out += b ? ",\n\t\t\t\"" : "\n\t\t\t\"";
+				out += bone_name(b) + "\": { \"rotate\": ";
+				write_keys([&](int) { out += ", \"angle\": "; number(uniform(-90, 90)); });
+				out += ", \"translate\": ";
+				write_keys([&](int) {
+					out += ", \"x\": ";
+					number(uniform(-10, 10));
+					out += ", \"y\": ";
+					number(uniform(-10, 10));
+				});
+				out += " }";
+			}
+			out += "\n\t\t},\n\t\t\"slots\": {";
+			for (int s = 0; s < shape.slots; ++s)
+			{
+				out += s ? ",\n\t\t\t\"slot" : "\n\t\t\t\"slot";
+				out += std::to_string(s) + "\": { \"color\": ";
+				write_keys([&](int k) { out += ", \"color\": \"ffff" + std::string(k % 2 ? "80" : "ff") + "ff\""; });
+				out += " }";
+			}
+			out += "\n\t\t},\n\t\t\"deform\": {";
+			write_deforms(a);
+			out += " },\n\t\t\"events\": [ { \"time\": 0, \"name\": \"step\" }, { \"time\": 0.5, \"name\": \"sound\" } ]\n\t}";
+		}
+		out += "\n}\n";
+	}
+
+	// The first deforms meshes of the skins, from a different place for each animation.
+	void write_deforms(int animation)
+	{
+		int total = shape.skins * shape.slots * shape.attachments, written = 0;
+		int lastSkin = -1, lastSlot = -1;
+		for (int n = 0; n < total && written < shape.deforms; ++n)
+		{
+			int index = (n + animation * 3) % total;
+			int skin = index / (shape.slots * shape.attachments);
+			int slot = index / shape.attachments % shape.slots;
+			int i = index % shape.attachments;
+			if (!is_mesh(skin, slot, i) || skin < lastSkin || (skin == lastSkin && slot <= lastSlot))
+				continue;
+			if (skin != lastSkin)
+			{
+				if (lastSkin != -1)
+					out += " } },";
+				out += "\n\t\t\t\"" + skin_name(skin) + "\": { ";
+			}
+			else
+				out += " },";
+			out += "\"slot" + std::to_string(slot) + "\": { \"" + attachment_name(slot, i) + "\": ";
+			int length = is_weighted(skin, slot, i) ? 2 * shape.vertices * shape.influences : 2 * shape.vertices;
+			write_keys([&](int) {
+				out += ", \"vertices\": [ ";
+				for (int v = 0; v < length; ++v)
+				{
+					if (v)
+						out += ", ";
+					number(uniform(-3, 3));
+				}
+				out += " ]";
+			});
+			lastSkin = skin;
+			lastSlot = slot;
+			++written;
+		}
+		if (lastSkin != -1)
+			out += " } }";
+	}
+};
+
+#endif
@@ -0,0 +1,100 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_MESHES_H__
+#define __SPINE_MESHES_H__
+
+// Finds the meshes of an output read back by the reference reader and their deform keys, for the checks that compare
+// meshes before and after a pass.
+
+#include <string.h>
+#include <map>
+#include <vector>
+#include "SpineReader.h"
+
+// The attachment types of the exporter these look at.
+const int ATTACHMENT_MESH = 2;
+const int ATTACHMENT_LINKED_MESH = 3;
+
+// A deform key of a mesh, with its timeline and where its values start in it.
+struct DeformKey
+{
+	SpineTimelineData *timeline;
+	int key;
+	size_t values;
+};
+
+static inline const SpineAttachmentData *find_attachment(const SpineSkeletonData &model, const SpineSkinData &skin,
+	int slot, const char *key)
+{
+	for (const SpineSkinSlotData &slotData : skin.slots)
+	{
+		for (size_t i = 0; slotData.slot == slot && i < slotData.attachments.size(); ++i)
+		{
+			if (strcmp(model.str(slotData.attachments[i].key), key) == 0)
+				return &slotData.attachments[i];
+		}
+	}
+	return 0;
+}
+
+static inline const SpineSkinData *find_skin(const SpineSkeletonData &model, const char *name)
+{
+	for (const SpineSkinData &skin : model.skins)
+	{
+		if (strcmp(model.str(skin.name), strcmp(name, "default") ? name : "") == 0)
+			return &skin;
+	}
+	return 0;
+}
+
+// The deform keys of each mesh, a linked mesh's going to its parent.
+static inline std::map<const SpineAttachmentData *, std::vector<DeformKey>> deform_keys(SpineSkeletonData &model)
+{
+	std::map<const SpineAttachmentData *, std::vector<DeformKey>> keys;
+	for (SpineAnimationData &animation : model.animations)
+	{
+		for (SpineTimelineData &timeline : animation.timelines)
+		{
+			if (timeline.type != SPINE_TIMELINE_DEFORM)
+				continue;
+			const SpineAttachmentData *mesh = find_attachment(model, model.skins[timeline.skin], timeline.index,
+				model.str(timeline.attachment));
+			if (mesh && mesh->type == ATTACHMENT_LINKED_MESH)
+			{
+				const SpineSkinData *skin = find_skin(model, mesh->skin < 0 ? "default" : model.str(mesh->skin));
+				mesh = skin ? find_attachment(model, *skin, timeline.index, model.str(mesh->parent)) : 0;
+			}
+			if (!mesh || mesh->type != ATTACHMENT_MESH)
+				continue;
+			size_t values = 0;
+			for (int key = 0; key < timeline.frameCount; ++key)
+			{
+				keys[mesh].push_back(DeformKey{ &timeline, key, values });
+				values += timeline.ints[key * 2 + 1];
+			}
+		}
+	}
+	return keys;
+}
+
+#endif
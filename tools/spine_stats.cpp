@@ -0,0 +1,216 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Where the conversion of each skeleton spends its time and output, from SpineConverterStats.
+
+ spine_stats [-threads n] [-top n] [-decimate 1] [-strip 1] [-vertex-cache n] [-influences n] file.json...
+
+ x.atlas next to x.json is used as its atlas. Prints the parse, each section's time and bytes, the animations that
+ take longest, 10 unless -top says otherwise, and the timelines and keys of each type. -decimate 1 converts with
+ the keyframe decimation at its default tolerances and prints what it dropped, -strip 1 with the dead data stripping
+ keeping every animation and skin and prints what it removed, -vertex-cache n with the vertex cache optimization of
+ meshes for a cache of n vertices and prints the average cache misses per triangle before and after, -influences n
+ with at most n influences per weighted vertex and prints the influences CPU skinning transforms before and after, of
+ all weighted meshes and of the top ones. The section bytes must add up to the output size, a file where they don't fails the run with exit code 1.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. spine_stats.cpp ../SpineExporter.cpp Json.o -o spine_stats
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+static size_t keys_of(const SpineTimelineCount *timelines)
+{
+	size_t keys = 0;
+	for (int i = 0; i < SPINE_TIMELINE_COUNT; ++i)
+		keys += timelines[i].keys;
+	return keys;
+}
+
+static void print_stats(const SpineConverterStats &stats, size_t top)
+{
+	printf("  %-12s %9.3f ms %8zu nodes %3zu arena blocks\n", "parse", stats.parseSeconds * 1000, stats.jsonNodes,
+		stats.arenaBlocks);
+	for (int i = 0; i < SPINE_SECTION_COUNT; ++i)
+	{
+		printf("  %-12s %9.3f ms %10zu bytes\n", spine_section_name(i), stats.sectionSeconds[i] * 1000,
+			stats.sectionBytes[i]);
+	}
+
+	vector<const SpineAnimationStats *> slowest;
+	for (const SpineAnimationStats &animation : stats.animations)
+		slowest.push_back(&animation);
+	sort(slowest.begin(), slowest.end(), [](const SpineAnimationStats *a, const SpineAnimationStats *b) {
+		return a->seconds > b->seconds;
+	});
+	if (slowest.size() > top)
+		slowest.resize(top);
+	for (const SpineAnimationStats *animation : slowest)
+	{
+		printf("  animation %-32s %9.3f ms %10zu bytes %8zu keys\n", animation->name.c_str(), animation->seconds * 1000,
+			animation->bytes, keys_of(animation->timelines));
+	}
+
+	if (stats.decimated.keys)
+	{
+		printf("  decimated %8zu keys %8zu timelines %10zu bytes\n", stats.decimated.keys, stats.decimated.timelines,
+			stats.decimated.bytes);
+	}
+	const SpineStrippedCount &stripped = stats.stripped;
+	if (stripped.animations || stripped.skins || stripped.attachments || stripped.slots || stripped.bones ||
+		stripped.events || stripped.timelines)
+	{
+		printf("  stripped  %zu animations %zu skins %zu attachments %zu slots %zu bones %zu events %zu timelines\n",
+			stripped.animations, stripped.skins, stripped.attachments, stripped.slots, stripped.bones, stripped.events,
+			stripped.timelines);
+	}
+	const SpineVertexCacheCount &vertexCache = stats.vertexCache;
+	if (vertexCache.triangles)
+	{
+		printf("  vertex cache %zu meshes %zu triangles, acmr %.3f before %.3f after\n", vertexCache.meshes,
+			vertexCache.triangles, (double)vertexCache.missesBefore / vertexCache.triangles,
+			(double)vertexCache.missesAfter / vertexCache.triangles);
+	}
+	if (!stats.influences.empty())
+	{
+		SpineMeshInfluences total;
+		vector<const SpineMeshInfluences *> heaviest;
+		for (const SpineMeshInfluences &mesh : stats.influences)
+		{
+			total.vertices += mesh.vertices;
+			total.before += mesh.before;
+			total.after += mesh.after;
+			heaviest.push_back(&mesh);
+		}
+		printf("  influences %zu meshes %zu vertices, %zu before %zu after\n", stats.influences.size(), total.vertices,
+			total.before, total.after);
+		sort(heaviest.begin(), heaviest.end(), [](const SpineMeshInfluences *a, const SpineMeshInfluences *b) {
+			return a->before > b->before;
+		});
+		if (heaviest.size() > top)
+			heaviest.resize(top);
+		for (const SpineMeshInfluences *mesh : heaviest)
+		{
+			printf("  mesh %-37s %8zu vertices %8zu before %8zu after\n", mesh->name.c_str(), mesh->vertices,
+				mesh->before, mesh->after);
+		}
+	}
+	for (int i = 0; i < SPINE_TIMELINE_COUNT; ++i)
+	{
+		if (stats.timelines[i].timelines)
+		{
+			printf("  timeline  %-12s %8zu timelines %10zu keys\n", spine_timeline_name(i), stats.timelines[i].timelines,
+				stats.timelines[i].keys);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int threads = 1;
+	size_t top = 10;
+	bool decimate = false, strip = false;
+	int vertexCache = 0, influences = 0;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-threads") == 0)
+			threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-top") == 0)
+			top = (size_t)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-decimate") == 0)
+			decimate = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-strip") == 0)
+			strip = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-vertex-cache") == 0)
+			vertexCache = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-influences") == 0)
+			influences = atoi(argv[i + 1]);
+		else
+			break;
+	}
+	if (i >= argc || threads < 0)
+	{
+		fprintf(stderr, "usage: spine_stats [-threads n] [-top n] [-decimate 1] [-strip 1] [-vertex-cache n] "
+			"[-influences n] file.json...\n");
+		return 1;
+	}
+
+	int failures = 0;
+	SpineConverter converter;
+	converter.set_threads(threads);
+	SpineConverterStats stats;
+	converter.set_stats(&stats);
+	SpineDecimation decimation;
+	converter.set_decimation(decimate ? &decimation : 0);
+	SpineStripping stripping;
+	converter.set_stripping(strip ? &stripping : 0);
+	converter.set_vertex_cache(vertexCache);
+	SpineInfluences limits;
+	limits.max = influences;
+	converter.set_influences(influences > 0 ? &limits : 0);
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+
+		vector<unsigned char> output;
+		SpineVectorSink sink(output);
+		int rt = converter.convert(json.c_str(), json.size(), sink);
+		if (rt < 0)
+		{
+			fprintf(stderr, "%s: conversion error %d\n", argv[i], rt);
+			++failures;
+			continue;
+		}
+		size_t sectionBytes = 0;
+		for (int section = 0; section < SPINE_SECTION_COUNT; ++section)
+			sectionBytes += stats.sectionBytes[section];
+
+		printf("%s: %zu bytes of json, %d bytes of output, %.3f ms\n", argv[i], json.size(), rt,
+			stats.totalSeconds * 1000);
+		print_stats(stats, top);
+		printf("\n");
+		if (sectionBytes != (size_t)rt)
+		{
+			fprintf(stderr, "%s: the sections hold %zu bytes, not %d\n", argv[i], sectionBytes, rt);
+			++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+#ifndef __SPINE_TOOL_H__
+#define __SPINE_TOOL_H__
+
+// What most tools need: reading their input files and the comma separated lists of their options.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// The whole file at path into out, false when it can't be read.
+static inline bool read_file(const std::string &path, std::string &out)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return false;
+	char chunk[64 * 1024];
+	size_t n;
+	out.clear();
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+		out.append(chunk, n);
+	fclose(f);
+	return true;
+}
+
+// The names of a list like "a,b", empty ones left out.
+static inline std::vector<std::string> split(const char *list)
+{
+	std::vector<std::string> names;
+	std::string name;
+	for (const char *c = list; ; ++c)
+	{
+		if (*c == ',' || !*c)
+		{
+			if (!name.empty())
+				names.push_back(name);
+			name.clear();
+			if (!*c)
+				break;
+		}
+		else
+			name += *c;
+	}
+	return names;
+}
+
+#endif
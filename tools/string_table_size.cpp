@@ -0,0 +1,115 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Compares the plain and the string table output of each file.
+
+ string_table_size file.json...
+
+ x.atlas next to x.json is used as its atlas. Both outputs are read back with the reference reader and must give the
+ same skeleton, and both engines must agree. Prints both sizes, the share saved, how many strings a loader of the
+ plain output copies (reads) and how many the table holds. Exits with 1 on any mismatch.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. string_table_size.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o -o string_table_size
+*/
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+// Converts with both engines, false unless they agree.
+static bool convert(SpineConverter &converter, const string &json, vector<unsigned char> &out)
+{
+	vector<unsigned char> stream;
+	SpineVectorSink sink(out), streamSink(stream);
+	int rt = converter.convert(json.c_str(), json.size(), sink);
+	return rt >= 0 && converter.convert_stream(json.c_str(), json.size(), streamSink) == rt && stream == out;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: string_table_size file.json...\n");
+		return 1;
+	}
+
+	int failures = 0;
+	size_t plainTotal = 0, tableTotal = 0;
+	printf("%-40s %10s %10s %7s %8s %8s\n", "file", "plain", "table", "saved", "reads", "strings");
+	for (int i = 1; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+
+		SpineConverter converter;
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		vector<unsigned char> plain, table;
+		bool converted = convert(converter, json, plain);
+		converter.set_string_table(true);
+		converted = converted && convert(converter, json, table);
+		if (!converted)
+		{
+			fprintf(stderr, "%s: conversion failed or the engines differ\n", argv[i]);
+			++failures;
+			continue;
+		}
+
+		SpineSkeletonData plainData, tableData;
+		string error;
+		if (!read_spine_binary(plain.data(), plain.size(), plainData, &error) ||
+			!read_spine_binary(table.data(), table.size(), tableData, &error))
+		{
+			fprintf(stderr, "%s: unreadable output, %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		if (!(plainData == tableData))
+		{
+			fprintf(stderr, "%s: the outputs read back differently\n", argv[i]);
+			++failures;
+			continue;
+		}
+
+		plainTotal += plain.size();
+		tableTotal += table.size();
+		printf("%-40s %10zu %10zu %6.1f%% %8zu %8zu\n", argv[i], plain.size(), table.size(),
+			100.0 * ((double)plain.size() - table.size()) / plain.size(), plainData.stringReads, tableData.strings.size());
+	}
+	if (plainTotal)
+	{
+		printf("%-40s %10zu %10zu %6.1f%%\n", "total", plainTotal, tableTotal,
+			100.0 * ((double)plainTotal - tableTotal) / plainTotal);
+	}
+	return failures ? 1 : 0;
+}
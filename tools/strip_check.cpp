@@ -0,0 +1,580 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks the dead data stripping against the output without it.
+
+ strip_check [-animations a,b] [-skins a,b] [-bones a,b] file.json...
+
+ x.atlas next to x.json is used as its atlas, the lists are the keep lists of SpineStripping. Both outputs are read
+ back with the reference reader and matched by name. What the stripped output has must be what the full one has, with
+ its indices remapped: bones, slots, constraints, events, the attachments of its skins and the animations kept, each
+ with the timelines whose bone, slot or attachment is left, draw order keys ordering the slots left like the full
+ ones. Each attachment left must be shown by its slot's setup pose or an attachment key, or be the parent of a linked
+ mesh left, and each event must be fired. Prints what was removed and the bytes saved, and the names kept that the
+ skeleton doesn't have, which the stats must list. Exits with 1 on any mismatch.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. strip_check.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o -o strip_check
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+// The attachment types of the exporter this looks at.
+const int ATTACHMENT_LINKED_MESH = 3;
+const int ATTACHMENT_CLIPPING = 6;
+
+// The full output, the stripped one and the indices of the full one by name.
+struct Pair
+{
+	const SpineSkeletonData &full, &stripped;
+	map<string, int> bones, slots, skins, events;
+	string error;
+
+	Pair(const SpineSkeletonData &full, const SpineSkeletonData &stripped) : full(full), stripped(stripped)
+	{
+		for (size_t i = 0; i < full.bones.size(); ++i)
+			bones[full.str(full.bones[i].name)] = (int)i;
+		for (size_t i = 0; i < full.slots.size(); ++i)
+			slots[full.str(full.slots[i].name)] = (int)i;
+		for (size_t i = 0; i < full.skins.size(); ++i)
+			skins[full.str(full.skins[i].name)] = (int)i;
+		for (size_t i = 0; i < full.events.size(); ++i)
+			events[full.str(full.events[i].name)] = (int)i;
+	}
+
+	bool fail(const string &what)
+	{
+		error = what;
+		return false;
+	}
+
+	// The full index of a stripped bone, slot or event, -1 when it isn't there.
+	static int find(const map<string, int> &names, const string &name)
+	{
+		auto found = names.find(name);
+		return found == names.end() ? -1 : found->second;
+	}
+	int bone(int index) const { return index < 0 ? index : find(bones, stripped.str(stripped.bones[index].name)); }
+	int slot(int index) const { return index < 0 ? index : find(slots, stripped.str(stripped.slots[index].name)); }
+
+	bool same_strings(int a, int b) const { return strcmp(full.str(a), stripped.str(b)) == 0; }
+};
+
+static bool check_bones(Pair &p)
+{
+	if (p.stripped.bones.empty() || p.bone(0) != 0)
+		return p.fail("the root bone is gone");
+	int last = -1;
+	for (size_t i = 0; i < p.stripped.bones.size(); ++i)
+	{
+		SpineBoneData bone = p.stripped.bones[i];
+		int index = p.bone((int)i);
+		if (index <= last)
+			return p.fail(string("bone ") + p.stripped.str(bone.name) + " isn't in the full order");
+		last = index;
+		bone.name = p.full.bones[index].name;
+		bone.parent = p.bone(bone.parent);
+		if (!(bone == p.full.bones[index]))
+			return p.fail(string("bone ") + p.stripped.str(p.stripped.bones[i].name) + " changed");
+	}
+	return true;
+}
+
+static bool check_slots(Pair &p)
+{
+	int last = -1;
+	for (size_t i = 0; i < p.stripped.slots.size(); ++i)
+	{
+		const SpineSlotData &slot = p.stripped.slots[i];
+		int index = p.slot((int)i);
+		if (index <= last)
+			return p.fail(string("slot ") + p.stripped.str(slot.name) + " isn't in the full order");
+		last = index;
+		const SpineSlotData &full = p.full.slots[index];
+		if (p.bone(slot.bone) != full.bone || !p.same_strings(full.attachment, slot.attachment) ||
+			memcmp(slot.color, full.color, 4) || memcmp(slot.dark, full.dark, 4) || slot.blend != full.blend)
+			return p.fail(string("slot ") + p.stripped.str(slot.name) + " changed");
+	}
+	return true;
+}
+
+// A constraint of the stripped output with the full indices.
+template <class T>
+static T full_constraint(const Pair &p, T constraint, bool targetSlot)
+{
+	constraint.name = -1;
+	for (int &bone : constraint.bones)
+		bone = p.bone(bone);
+	constraint.target = targetSlot ? p.slot(constraint.target) : p.bone(constraint.target);
+	return constraint;
+}
+
+template <class T>
+static bool check_constraints(Pair &p, const vector<T> &full, const vector<T> &stripped, bool targetSlot)
+{
+	if (full.size() != stripped.size())
+		return p.fail("constraints were removed");
+	for (size_t i = 0; i < full.size(); ++i)
+	{
+		T a = full[i];
+		a.name = -1;
+		if (!p.same_strings(full[i].name, stripped[i].name) || !(a == full_constraint(p, stripped[i], targetSlot)))
+			return p.fail(string("constraint ") + p.stripped.str(stripped[i].name) + " changed");
+	}
+	return true;
+}
+
+static bool check_events(Pair &p)
+{
+	for (const SpineEventData &event : p.stripped.events)
+	{
+		int index = Pair::find(p.events, p.stripped.str(event.name));
+		if (index == -1)
+			return p.fail(string("event ") + p.stripped.str(event.name) + " isn't in the full output");
+		const SpineEventData &full = p.full.events[index];
+		if (event.intValue != full.intValue || event.floatValue != full.floatValue ||
+			!p.same_strings(full.stringValue, event.stringValue))
+			return p.fail(string("event ") + p.stripped.str(event.name) + " changed");
+	}
+	return true;
+}
+
+static const SpineSkinSlotData *find_slot(const SpineSkinData &skin, int slot)
+{
+	for (const SpineSkinSlotData &slotData : skin.slots)
+	{
+		if (slotData.slot == slot)
+			return &slotData;
+	}
+	return 0;
+}
+
+static const SpineAttachmentData *find_attachment(const SpineSkeletonData &model, const SpineSkinSlotData *slot,
+	const char *key)
+{
+	for (size_t i = 0; slot && i < slot->attachments.size(); ++i)
+	{
+		if (strcmp(model.str(slot->attachments[i].key), key) == 0)
+			return &slot->attachments[i];
+	}
+	return 0;
+}
+
+static bool check_attachment(Pair &p, const SpineAttachmentData *full, const SpineAttachmentData &stripped)
+{
+	if (!full)
+		return false;
+	SpineAttachmentData a = *full, b = stripped;
+	if (!p.same_strings(a.key, b.key) || !p.same_strings(a.name, b.name) || !p.same_strings(a.path, b.path) ||
+		!p.same_strings(a.skin, b.skin) || !p.same_strings(a.parent, b.parent))
+		return false;
+	a.key = a.name = a.path = a.skin = a.parent = b.key = b.name = b.path = b.skin = b.parent = 0;
+	if (b.type == ATTACHMENT_CLIPPING)
+		b.endSlot = p.slot(b.endSlot);
+	for (size_t i = 0; b.vertices.weighted && i < b.vertices.bones.size(); i += b.vertices.bones[i] + 1)
+	{
+		for (int j = 1; j <= b.vertices.bones[i]; ++j)
+			b.vertices.bones[i + j] = p.bone(b.vertices.bones[i + j]);
+	}
+	return a == b;
+}
+
+// The attachment names each stripped slot shows.
+static vector<set<string>> shown_attachments(const SpineSkeletonData &model)
+{
+	vector<set<string>> shown(model.slots.size());
+	for (size_t i = 0; i < model.slots.size(); ++i)
+		shown[i].insert(model.str(model.slots[i].attachment));
+	for (const SpineAnimationData &animation : model.animations)
+	{
+		for (const SpineTimelineData &timeline : animation.timelines)
+		{
+			if (timeline.type != SPINE_TIMELINE_ATTACHMENT)
+				continue;
+			for (int name : timeline.ints)
+				shown[timeline.index].insert(model.str(name));
+		}
+	}
+	return shown;
+}
+
+static bool check_skins(Pair &p)
+{
+	vector<set<string>> shown = shown_attachments(p.stripped);
+	set<string> linkedParents; // skin, slot and attachment name
+
+	for (const SpineSkinData &skin : p.stripped.skins)
+	{
+		for (const SpineSkinSlotData &slot : skin.slots)
+		{
+			for (const SpineAttachmentData &attachment : slot.attachments)
+			{
+				if (attachment.type != ATTACHMENT_LINKED_MESH)
+					continue;
+				string parentSkin = p.stripped.str(attachment.skin);
+				if (parentSkin == "default")
+					parentSkin = ""; // the name the default skin is read with
+				linkedParents.insert(parentSkin + '\n' + p.stripped.str(p.stripped.slots[slot.slot].name) +
+					'\n' + p.stripped.str(attachment.parent));
+			}
+		}
+	}
+	for (const SpineSkinData &skin : p.stripped.skins)
+	{
+		string skinName = p.stripped.str(skin.name);
+		int full = Pair::find(p.skins, skinName);
+		if (full == -1)
+			return p.fail("skin " + skinName + " isn't in the full output");
+		for (const SpineSkinSlotData &slot : skin.slots)
+		{
+			string slotName = p.stripped.str(p.stripped.slots[slot.slot].name);
+			const SpineSkinSlotData *fullSlot = find_slot(p.full.skins[full], p.slot(slot.slot));
+			for (const SpineAttachmentData &attachment : slot.attachments)
+			{
+				const char *key = p.stripped.str(attachment.key);
+				if (!check_attachment(p, find_attachment(p.full, fullSlot, key), attachment))
+					return p.fail("attachment " + skinName + "/" + slotName + "/" + key + " changed");
+				if (!shown[slot.slot].count(key) && !linkedParents.count(skinName + '\n' + slotName + '\n' + key))
+					return p.fail("attachment " + skinName + "/" + slotName + "/" + key + " is never shown");
+			}
+		}
+	}
+	return true;
+}
+
+// The slots a draw order key orders, as the runtime reads ints from at, by index.
+static vector<int> draw_order(const SpineTimelineData &timeline, size_t &at, int slotCount)
+{
+	vector<int> order(slotCount, -1), unchanged;
+	int count = timeline.ints[at++], original = 0;
+	for (int i = 0; i < count; ++i, at += 2)
+	{
+		int slot = timeline.ints[at], offset = timeline.ints[at + 1];
+		while (original != slot)
+			unchanged.push_back(original++);
+		order[original + offset] = original;
+		++original;
+	}
+	while (original < slotCount)
+		unchanged.push_back(original++);
+	for (int i = slotCount - 1; i >= 0; --i)
+	{
+		if (order[i] == -1)
+			order[i] = unchanged.back(), unchanged.pop_back();
+	}
+	return order;
+}
+
+// Whether a timeline of the full output keeps its bone, slot or attachment in the stripped one.
+static bool kept(const Pair &p, const SpineTimelineData &timeline)
+{
+	const SpineSkeletonData &full = p.full, &stripped = p.stripped;
+	auto has = [](const vector<int> &names, const SpineSkeletonData &model, const char *name) {
+		for (int id : names)
+		{
+			if (strcmp(model.str(id), name) == 0)
+				return true;
+		}
+		return false;
+	};
+	vector<int> names;
+	switch (timeline.type)
+	{
+	case SPINE_TIMELINE_ATTACHMENT: case SPINE_TIMELINE_COLOR: case SPINE_TIMELINE_TWO_COLOR:
+		for (const SpineSlotData &slot : stripped.slots)
+			names.push_back(slot.name);
+		return has(names, stripped, full.str(full.slots[timeline.index].name));
+	case SPINE_TIMELINE_ROTATE: case SPINE_TIMELINE_TRANSLATE: case SPINE_TIMELINE_SCALE: case SPINE_TIMELINE_SHEAR:
+		for (const SpineBoneData &bone : stripped.bones)
+			names.push_back(bone.name);
+		return has(names, stripped, full.str(full.bones[timeline.index].name));
+	case SPINE_TIMELINE_DEFORM:
+	{
+		const char *skinName = full.str(full.skins[timeline.skin].name);
+		const char *slotName = full.str(full.slots[timeline.index].name);
+		for (const SpineSkinData &skin : stripped.skins)
+		{
+			for (size_t slot = 0; strcmp(stripped.str(skin.name), skinName) == 0 && slot < skin.slots.size(); ++slot)
+			{
+				const SpineSkinSlotData &slotData = skin.slots[slot];
+				if (strcmp(stripped.str(stripped.slots[slotData.slot].name), slotName) == 0 &&
+					find_attachment(stripped, &slotData, full.str(timeline.attachment)))
+					return true;
+			}
+		}
+		return false;
+	}
+	default:
+		return true;
+	}
+}
+
+static bool check_timeline(Pair &p, const SpineTimelineData &full, const SpineTimelineData &stripped)
+{
+	SpineTimelineData a = full, b = stripped;
+	if (a.type != b.type)
+		return false;
+	switch (a.type)
+	{
+	case SPINE_TIMELINE_ATTACHMENT: case SPINE_TIMELINE_COLOR: case SPINE_TIMELINE_TWO_COLOR:
+		b.index = p.slot(b.index);
+		break;
+	case SPINE_TIMELINE_ROTATE: case SPINE_TIMELINE_TRANSLATE: case SPINE_TIMELINE_SCALE: case SPINE_TIMELINE_SHEAR:
+		b.index = p.bone(b.index);
+		break;
+	case SPINE_TIMELINE_DEFORM:
+		b.index = p.slot(b.index);
+		if (strcmp(p.full.str(p.full.skins[a.skin].name), p.stripped.str(p.stripped.skins[b.skin].name)) ||
+			!p.same_strings(a.attachment, b.attachment))
+			return false;
+		a.skin = b.skin = a.attachment = b.attachment = 0;
+		break;
+	default:
+		break;
+	}
+	if (a.type == SPINE_TIMELINE_ATTACHMENT || a.type == SPINE_TIMELINE_EVENT)
+	{
+		if (a.ints.size() != b.ints.size())
+			return false;
+		size_t stride = a.type == SPINE_TIMELINE_EVENT ? 3 : 1;
+		for (size_t i = 0; i < a.ints.size(); i += stride)
+		{
+			if (stride == 1 && !p.same_strings(a.ints[i], b.ints[i]))
+				return false;
+			if (stride == 3 && (strcmp(p.full.str(p.full.events[a.ints[i]].name),
+				p.stripped.str(p.stripped.events[b.ints[i]].name)) || a.ints[i + 1] != b.ints[i + 1] ||
+				!p.same_strings(a.ints[i + 2], b.ints[i + 2])))
+				return false;
+		}
+		a.ints.clear();
+		b.ints.clear();
+	}
+	else if (a.type == SPINE_TIMELINE_DRAW_ORDER)
+	{
+		size_t at = 0, bt = 0;
+		while (at < a.ints.size() && bt < b.ints.size())
+		{
+			vector<int> orderA = draw_order(a, at, (int)p.full.slots.size());
+			vector<int> orderB = draw_order(b, bt, (int)p.stripped.slots.size());
+			vector<int> left;
+			for (int slot : orderB)
+				left.push_back(p.slot(slot));
+			size_t next = 0;
+			for (int slot : orderA)
+			{
+				if (next < left.size() && slot == left[next])
+					++next;
+			}
+			if (next != left.size())
+				return false;
+		}
+		if (at != a.ints.size() || bt != b.ints.size())
+			return false;
+		a.ints.clear();
+		b.ints.clear();
+	}
+	return a == b;
+}
+
+static bool check_animations(Pair &p, const vector<string> &keep, size_t &timelines)
+{
+	size_t next = 0;
+	for (const SpineAnimationData &animation : p.full.animations)
+	{
+		string name = p.full.str(animation.name);
+		bool keeps = keep.empty();
+		for (const string &kept : keep)
+			keeps = keeps || kept == name;
+		if (!keeps)
+			continue;
+		if (next >= p.stripped.animations.size() || name != p.stripped.str(p.stripped.animations[next].name))
+			return p.fail("animation " + name + " is gone");
+		const SpineAnimationData &stripped = p.stripped.animations[next++];
+		size_t at = 0;
+		for (const SpineTimelineData &timeline : animation.timelines)
+		{
+			if (!kept(p, timeline))
+			{
+				++timelines;
+				continue;
+			}
+			if (at >= stripped.timelines.size() || !check_timeline(p, timeline, stripped.timelines[at++]))
+				return p.fail("a timeline of animation " + name + " changed");
+		}
+		if (at != stripped.timelines.size())
+			return p.fail("animation " + name + " has more timelines");
+	}
+	if (next != p.stripped.animations.size())
+		return p.fail("animations weren't removed");
+	return true;
+}
+
+// Events no animation left fires.
+static size_t unfired_events(const SpineSkeletonData &model)
+{
+	vector<bool> fired(model.events.size());
+	for (const SpineAnimationData &animation : model.animations)
+	{
+		for (const SpineTimelineData &timeline : animation.timelines)
+		{
+			for (size_t i = 0; timeline.type == SPINE_TIMELINE_EVENT && i < timeline.ints.size(); i += 3)
+				fired[timeline.ints[i]] = true;
+		}
+	}
+	size_t unfired = 0;
+	for (bool f : fired)
+		unfired += !f;
+	return unfired;
+}
+
+// The names of the keep lists full doesn't have, as SpineStrippedCount::unmatched lists them.
+static vector<string> unmatched(const SpineSkeletonData &full, const SpineStripping &keep)
+{
+	set<string> animations, skins, bones;
+	for (const SpineAnimationData &animation : full.animations)
+		animations.insert(full.str(animation.name));
+	for (const SpineSkinData &skin : full.skins)
+		skins.insert(skin.name < 0 ? "default" : full.str(skin.name));
+	for (const SpineBoneData &bone : full.bones)
+		bones.insert(full.str(bone.name));
+	vector<string> names;
+	for (const string &name : keep.animations)
+	{
+		if (!animations.count(name))
+			names.push_back("animations/" + name);
+	}
+	for (const string &name : keep.skins)
+	{
+		if (!skins.count(name))
+			names.push_back("skins/" + name);
+	}
+	for (const string &name : keep.bones)
+	{
+		if (!bones.count(name))
+			names.push_back("bones/" + name);
+	}
+	return names;
+}
+
+int main(int argc, char **argv)
+{
+	SpineStripping keep;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-animations") == 0)
+			keep.animations = split(argv[i + 1]);
+		else if (strcmp(argv[i], "-skins") == 0)
+			keep.skins = split(argv[i + 1]);
+		else if (strcmp(argv[i], "-bones") == 0)
+			keep.bones = split(argv[i + 1]);
+		else
+			break;
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr, "usage: strip_check [-animations a,b] [-skins a,b] [-bones a,b] file.json...\n");
+		return 1;
+	}
+
+	printf("%-30s %5s %5s %6s %5s %5s %5s %9s %10s %10s\n", "file", "anims", "skins", "attach", "slots", "bones",
+		"evnts", "timelines", "bytes", "saved");
+	int failures = 0;
+	SpineConverter converter, stripping;
+	SpineConverterStats stats;
+	stripping.set_stats(&stats);
+	stripping.set_stripping(&keep);
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		stripping.set_atlas(hasAtlas ? atlas.c_str() : 0);
+
+		vector<unsigned char> full, stripped;
+		SpineVectorSink fullSink(full), sink(stripped);
+		int rt = converter.convert(json.c_str(), json.size(), fullSink);
+		int strippedRt = stripping.convert(json.c_str(), json.size(), sink);
+		if (rt < 0 || strippedRt < 0)
+		{
+			fprintf(stderr, "%s: conversion error %d, stripped %d\n", argv[i], rt, strippedRt);
+			++failures;
+			continue;
+		}
+
+		SpineSkeletonData a, b;
+		string error;
+		if (!read_spine_binary(full.data(), full.size(), a, &error) ||
+			!read_spine_binary(stripped.data(), stripped.size(), b, &error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		Pair p(a, b);
+		size_t timelines = 0;
+		bool same = check_bones(p) && check_slots(p) && check_constraints(p, a.ik, b.ik, false) &&
+			check_constraints(p, a.transform, b.transform, false) && check_constraints(p, a.paths, b.paths, true) &&
+			check_events(p) && check_skins(p) && check_animations(p, keep.animations, timelines);
+		if (same && unfired_events(b))
+			same = p.fail("an event is never fired");
+		const SpineStrippedCount &count = stats.stripped;
+		if (same && (count.animations != a.animations.size() - b.animations.size() ||
+			count.slots != a.slots.size() - b.slots.size() || count.bones != a.bones.size() - b.bones.size() ||
+			count.events != a.events.size() - b.events.size() || count.skins != a.skins.size() - b.skins.size() ||
+			count.timelines != timelines))
+			same = p.fail("the stats don't count what was removed");
+		if (same && unmatched(a, keep) != count.unmatched)
+			same = p.fail("the stats don't list the names kept that aren't there");
+		if (same && stripped.size() > full.size())
+			same = p.fail("the output grew");
+		string name = path.substr(path.find_last_of("/\\") + 1);
+		printf("%-30s %5zu %5zu %6zu %5zu %5zu %5zu %9zu %10zu %10lld\n", name.c_str(), count.animations, count.skins,
+			count.attachments, count.slots, count.bones, count.events, count.timelines, full.size(),
+			(long long)full.size() - (long long)stripped.size());
+		for (const string &unmatchedName : count.unmatched)
+			printf("  no %s to keep\n", unmatchedName.c_str());
+		if (!same)
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], p.error.c_str());
+			++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
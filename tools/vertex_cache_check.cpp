@@ -0,0 +1,274 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks the vertex cache optimization of meshes against the output without it.
+
+ vertex_cache_check [-cache n] file.json...
+
+ x.atlas next to x.json is used as its atlas, the cache holds 16 vertices unless -cache says otherwise. Both outputs
+ are read back with the reference reader. Each vertex of a mesh is described by its uv, its vertex or weights and its
+ values in every deform key of the mesh and its linked meshes. The meshes must have the same vertices, hull vertices
+ in place, and the same triangles, each with its winding, in those terms. Everything else must be the same. The
+ FIFO cache misses of the triangles are counted before and after, and must be what the stats counted. Prints them
+ and the average cache miss ratio, ACMR, of each. Exits with 1 on any mismatch.
+   cc -O2 -c ../Json.c
+   c++ -O2 -std=c++11 -pthread -I.. vertex_cache_check.cpp ../SpineExporter.cpp ../SpineReader.cpp Json.o \
+     -o vertex_cache_check
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "SpineExporter.h"
+#include "SpineReader.h"
+#include "spine_meshes.h"
+#include "spine_tool.h"
+
+using namespace std;
+
+typedef vector<float> Vertex;
+
+// Each vertex of mesh described by its uv, vertex or weights and deform values.
+static vector<Vertex> describe(const SpineAttachmentData &mesh, const vector<DeformKey> &keys)
+{
+	vector<Vertex> vertices(mesh.vertexCount);
+	vector<size_t> deformStarts(1, 0);
+	size_t values = 0, bones = 0;
+	for (int v = 0; v < mesh.vertexCount; ++v)
+	{
+		Vertex &vertex = vertices[v];
+		vertex.assign(mesh.uvs.begin() + v * 2, mesh.uvs.begin() + v * 2 + 2);
+		if (!mesh.vertices.weighted)
+		{
+			vertex.insert(vertex.end(), mesh.vertices.values.begin() + v * 2, mesh.vertices.values.begin() + v * 2 + 2);
+			deformStarts.push_back(deformStarts.back() + 2);
+			continue;
+		}
+		int influences = mesh.vertices.bones[bones++];
+		vertex.push_back((float)influences);
+		for (int i = 0; i < influences; ++i, values += 3)
+		{
+			vertex.push_back((float)mesh.vertices.bones[bones++]);
+			vertex.insert(vertex.end(), mesh.vertices.values.begin() + values, mesh.vertices.values.begin() + values + 3);
+		}
+		deformStarts.push_back(deformStarts.back() + influences * 2);
+	}
+	for (const DeformKey &key : keys)
+	{
+		int offset = key.timeline->ints[key.key * 2], count = key.timeline->ints[key.key * 2 + 1];
+		vector<float> full(deformStarts.back());
+		for (int i = 0; i < count && offset + i < (int)full.size(); ++i)
+			full[offset + i] = key.timeline->deform[key.values + i];
+		for (int v = 0; v < mesh.vertexCount; ++v)
+			vertices[v].insert(vertices[v].end(), full.begin() + deformStarts[v], full.begin() + deformStarts[v + 1]);
+	}
+	return vertices;
+}
+
+// The triangles of mesh in terms of its vertices, each starting at its least vertex with its winding kept, sorted.
+static vector<vector<Vertex>> triangles_of(const SpineAttachmentData &mesh, const vector<Vertex> &vertices)
+{
+	vector<vector<Vertex>> triangles;
+	for (size_t i = 0; i + 2 < mesh.triangles.size(); i += 3)
+	{
+		vector<Vertex> triangle;
+		for (int corner = 0; corner < 3; ++corner)
+			triangle.push_back(vertices[mesh.triangles[i + corner]]);
+		rotate(triangle.begin(), min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+static size_t cache_misses(const vector<unsigned short> &triangles, int vertexCount, int cacheSize)
+{
+	vector<size_t> stamp(vertexCount);
+	size_t misses = 0;
+	for (unsigned short v : triangles)
+	{
+		if (!stamp[v] || misses - stamp[v] >= (size_t)cacheSize)
+			stamp[v] = ++misses;
+	}
+	return misses;
+}
+
+static bool same_mesh(const SpineAttachmentData &a, const vector<DeformKey> &keysA, const SpineAttachmentData &b,
+	const vector<DeformKey> &keysB)
+{
+	if (a.vertexCount != b.vertexCount || a.hull != b.hull || a.triangles.size() != b.triangles.size() ||
+		a.vertices.weighted != b.vertices.weighted || keysA.size() != keysB.size())
+		return false;
+	vector<Vertex> verticesA = describe(a, keysA), verticesB = describe(b, keysB);
+	if (!equal(verticesA.begin(), verticesA.begin() + a.hull, verticesB.begin()) ||
+		triangles_of(a, verticesA) != triangles_of(b, verticesB))
+		return false;
+	sort(verticesA.begin(), verticesA.end());
+	sort(verticesB.begin(), verticesB.end());
+	return verticesA == verticesB;
+}
+
+int main(int argc, char **argv)
+{
+	int cacheSize = 16;
+	int i = 1;
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp(argv[i], "-cache") == 0)
+			cacheSize = atoi(argv[i + 1]);
+		else
+			break;
+	}
+	if (i >= argc || cacheSize < 1)
+	{
+		fprintf(stderr, "usage: vertex_cache_check [-cache n] file.json...\n");
+		return 1;
+	}
+
+	printf("%-30s %8s %10s %10s %10s %8s %8s\n", "file", "meshes", "triangles", "misses", "after", "acmr", "after");
+	int failures = 0;
+	SpineConverter converter, optimizing;
+	SpineConverterStats stats;
+	optimizing.set_stats(&stats);
+	optimizing.set_vertex_cache(cacheSize);
+	for (; i < argc; ++i)
+	{
+		string path = argv[i], json, atlas;
+		if (!read_file(path, json))
+		{
+			fprintf(stderr, "%s: can't read\n", argv[i]);
+			++failures;
+			continue;
+		}
+		bool hasAtlas = read_file(path.substr(0, path.rfind('.')) + ".atlas", atlas);
+		converter.set_atlas(hasAtlas ? atlas.c_str() : 0);
+		optimizing.set_atlas(hasAtlas ? atlas.c_str() : 0);
+
+		vector<unsigned char> full, optimized;
+		SpineVectorSink fullSink(full), sink(optimized);
+		int rt = converter.convert(json.c_str(), json.size(), fullSink);
+		int optimizedRt = optimizing.convert(json.c_str(), json.size(), sink);
+		if (rt < 0 || optimizedRt < 0)
+		{
+			fprintf(stderr, "%s: conversion error %d, optimized %d\n", argv[i], rt, optimizedRt);
+			++failures;
+			continue;
+		}
+
+		SpineSkeletonData a, b;
+		string error;
+		if (!read_spine_binary(full.data(), full.size(), a, &error) ||
+			!read_spine_binary(optimized.data(), optimized.size(), b, &error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+			continue;
+		}
+		bool same = a.skins.size() == b.skins.size();
+		size_t meshes = 0, triangles = 0, before = 0, after = 0;
+		map<const SpineAttachmentData *, vector<DeformKey>> keysA = deform_keys(a), keysB = deform_keys(b);
+		for (size_t skin = 0; same && skin < a.skins.size(); ++skin)
+		{
+			same = a.skins[skin].slots.size() == b.skins[skin].slots.size();
+			for (size_t slot = 0; same && slot < a.skins[skin].slots.size(); ++slot)
+			{
+				const vector<SpineAttachmentData> &attachmentsA = a.skins[skin].slots[slot].attachments;
+				const vector<SpineAttachmentData> &attachmentsB = b.skins[skin].slots[slot].attachments;
+				same = attachmentsA.size() == attachmentsB.size();
+				for (size_t k = 0; same && k < attachmentsA.size(); ++k)
+				{
+					const SpineAttachmentData &meshA = attachmentsA[k], &meshB = attachmentsB[k];
+					if (meshA.type != ATTACHMENT_MESH)
+						continue;
+					same = meshB.type == ATTACHMENT_MESH && same_mesh(meshA, keysA[&meshA], meshB, keysB[&meshB]);
+					if (!same)
+						error = string("mesh ") + a.str(meshA.key) + " changed";
+					++meshes;
+					triangles += meshA.triangles.size() / 3;
+					before += cache_misses(meshA.triangles, meshA.vertexCount, cacheSize);
+					after += cache_misses(meshB.triangles, meshB.vertexCount, cacheSize);
+				}
+			}
+		}
+		if (same)
+		{
+			// the rest, with the arrays the optimization reorders left out
+			for (SpineSkeletonData *model : { &a, &b })
+			{
+				for (SpineSkinData &skin : model->skins)
+				{
+					for (SpineSkinSlotData &slot : skin.slots)
+					{
+						for (SpineAttachmentData &mesh : slot.attachments)
+						{
+							if (mesh.type != ATTACHMENT_MESH)
+								continue;
+							mesh.uvs.clear();
+							mesh.triangles.clear();
+							mesh.vertices = SpineVerticesData();
+						}
+					}
+				}
+				for (SpineAnimationData &animation : model->animations)
+				{
+					for (SpineTimelineData &timeline : animation.timelines)
+					{
+						if (timeline.type != SPINE_TIMELINE_DEFORM)
+							continue;
+						timeline.ints.clear();
+						timeline.deform.clear();
+					}
+				}
+			}
+			same = a == b;
+			if (!same)
+				error = "the skeleton changed";
+		}
+		const SpineVertexCacheCount &count = stats.vertexCache;
+		if (same && (count.meshes != meshes || count.triangles != triangles || count.missesBefore != before ||
+			count.missesAfter != after))
+		{
+			same = false;
+			error = "the stats counted " + to_string(count.missesBefore) + " misses, " + to_string(count.missesAfter) +
+				" after";
+		}
+		if (same && after > before)
+		{
+			same = false;
+			error = "the cache misses more";
+		}
+		string name = path.substr(path.find_last_of("/\\") + 1);
+		printf("%-30s %8zu %10zu %10zu %10zu %8.3f %8.3f\n", name.c_str(), meshes, triangles, before, after,
+			triangles ? (double)before / triangles : 0.0, triangles ? (double)after / triangles : 0.0);
+		if (!same)
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+			++failures;
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+/****************************************************************************
+Copyright (c) 2021 pietrofeng
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+
+/*
+ Output encoder throughput, the encoders of SpineWriter.h against the byte at a time ones they replaced.
+
+ writer_bench [-n iterations] [-c values]
+
+ Encodes vertex like float arrays and a mix of varints the size of counts, indices and string lengths, checks that
+ both give the same bytes and prints MB/s of output. Build it twice to compare the float kernels, e.g.
+   c++ -O2 -I.. writer_bench.cpp -o writer_bench
+   c++ -O2 -I.. -DSPINE_WRITER_SIMD=0 writer_bench.cpp -o writer_bench_scalar
+ and -mssse3 or -mavx2 for the shuffle kernels.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "SpineWriter.h"
+
+using namespace std;
+
+#if SPINE_WRITER_SIMD_WIDTH == 32
+#define KERNEL "avx2"
+#elif SPINE_WRITER_SIMD_WIDTH == 16 && !defined(SPINE_WRITER_NO_SHUFFLE)
+#define KERNEL "ssse3"
+#elif SPINE_WRITER_SIMD_WIDTH == 16
+#define KERNEL "sse2"
+#else
+#define KERNEL "scalar"
+#endif
+
+// The encoders as they were, one byte at a time.
+static size_t old_float(unsigned char *out, float v)
+{
+	union
+	{
+		float f;
+		unsigned int i;
+	} u;
+	u.f = v;
+	out[0] = (unsigned char)(u.i >> 24);
+	out[1] = (unsigned char)(u.i >> 16);
+	out[2] = (unsigned char)(u.i >> 8);
+	out[3] = (unsigned char)u.i;
+	return 4;
+}
+
+static size_t old_varint(unsigned char *out, int value, int optimizePositive)
+{
+	unsigned int v = value;
+	if (!optimizePositive)
+		v = (unsigned int)((value << 1) ^ (value >> 31));
+
+	size_t n = 0;
+	for (int i = 0; i < 5; ++i)
+	{
+		out[n++] = (v >> i * 7) & 0x7F;
+		if (i < 4 && v >> (i + 1) * 7)
+			out[n - 1] |= 0x80;
+		else
+			break;
+	}
+	return n;
+}
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char *name, size_t bytes, int iterations, double before, double after)
+{
+	double mb = (double)bytes * iterations / (1024.0 * 1024.0);
+	printf("%-8s %8.1f MB/s before %8.1f MB/s after %6.2fx\n", name, mb / before, mb / after, before / after);
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 200;
+	size_t count = 1 << 20;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "-n") == 0)
+			iterations = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-c") == 0)
+			count = (size_t)atol(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "usage: writer_bench [-n iterations] [-c values]\n");
+			return 1;
+		}
+	}
+	if (iterations <= 0 || count == 0)
+	{
+		fprintf(stderr, "usage: writer_bench [-n iterations] [-c values]\n");
+		return 1;
+	}
+
+	// meshes are hundreds of floats, walk them in runs of that size like the converter does
+	const size_t run = 300;
+	vector<float> floats(count);
+	vector<int> ints(count);
+	srand(1);
+	for (size_t i = 0; i < count; ++i)
+	{
+		floats[i] = (rand() % 200000 - 100000) / 37.0f;
+		int r = rand();
+		// mostly small, some need 2 or 3 bytes, a few are negative or zigzag encoded
+		ints[i] = r % 8 ? r % 100 : r % 4 ? r % 100000 : -(r % 1000);
+	}
+
+	vector<unsigned char> before(5 * count + 8), after(5 * count + 8);
+	printf("kernel %s, %zu values, %d iterations\n", KERNEL, count, iterations);
+
+	auto start = chrono::steady_clock::now();
+	for (int it = 0; it < iterations; ++it)
+	{
+		unsigned char *out = before.data();
+		for (size_t i = 0; i < count; ++i)
+			out += old_float(out, floats[i]);
+	}
+	double oldTime = seconds_since(start);
+	start = chrono::steady_clock::now();
+	for (int it = 0; it < iterations; ++it)
+	{
+		for (size_t i = 0; i < count; i += run)
+			encode_floats(after.data() + 4 * i, &floats[i], count - i < run ? count - i : run);
+	}
+	double newTime = seconds_since(start);
+	if (memcmp(before.data(), after.data(), 4 * count) != 0)
+	{
+		fprintf(stderr, "floats differ\n");
+		return 1;
+	}
+	report("floats", 4 * count, iterations, oldTime, newTime);
+
+	size_t oldSize = 0, newSize = 0;
+	start = chrono::steady_clock::now();
+	for (int it = 0; it < iterations; ++it)
+	{
+		unsigned char *out = before.data();
+		for (size_t i = 0; i < count; ++i)
+			out += old_varint(out, ints[i], ints[i] >= 0);
+		oldSize = out - before.data();
+	}
+	oldTime = seconds_since(start);
+	start = chrono::steady_clock::now();
+	for (int it = 0; it < iterations; ++it)
+	{
+		unsigned char *out = after.data();
+		for (size_t i = 0; i < count; ++i)
+			out += encode_varint_wide(out, ints[i], ints[i] >= 0);
+		newSize = out - after.data();
+	}
+	newTime = seconds_since(start);
+	if (oldSize != newSize || memcmp(before.data(), after.data(), oldSize) != 0)
+	{
+		fprintf(stderr, "varints differ\n");
+		return 1;
+	}
+	report("varints", oldSize, iterations, oldTime, newTime);
+	return 0;
+}